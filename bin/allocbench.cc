@@ -1,60 +1,70 @@
-#if defined(XV6_USER)
-#include "pthread.h"
-#else
-#include <pthread.h>
-#endif
-#include "xsys.h"
-#include <inttypes.h>
+// Benchmark concurrent mmaps of anonymous memory.  Each operation maps
+// a region without touching it, then unmaps it so a timed run doesn't
+// run out of address space.
+
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/mman.h>
 #include <unistd.h>
-#include <sys/wait.h>
+#include <sys/mman.h>
 
-static pthread_barrier_t bar;
-static int niter;
+#include "libutil.h"
+#include "bench.hh"
 
-void*
-thr(void *arg)
+class allocbench : public bench::benchmark
 {
-  int tid = (uintptr_t)arg;
+  size_t len_;
 
-  if (setaffinity(tid) < 0)
-    die("setaffinity err");
+public:
+  allocbench(size_t len) : len_(len) { }
 
-  pthread_barrier_wait(&bar);
-
-  for (int i = 0; i < niter; i++) {
-    if ((i % 100) == 0)
-      printf("%d: %d ops\n", tid, i);
-
-    char *p = (char*) mmap(0, 256 * 1024, PROT_READ|PROT_WRITE,
+  void
+  op(int id) override
+  {
+    char *p = (char*) mmap(0, len_, PROT_READ|PROT_WRITE,
                            MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
     if (p == MAP_FAILED)
-      die("%d: map failed", tid);
+      die("%d: map failed", id);
+    if (munmap(p, len_) < 0)
+      die("%d: unmap failed", id);
   }
-  return 0;
+};
+
+static void
+usage(const char *argv0)
+{
+  fprintf(stderr, "Usage: %s [options] [nthreads]\n", argv0);
+  bench::config::usage();
+  fprintf(stderr, "  -s kbytes     Size of each mapping (default 256)\n");
+  exit(2);
 }
 
 int
-main(int ac, char **av)
+main(int argc, char **argv)
 {
-  if (ac < 2)
-    die("usage: %s nthreads [nloop]", av[0]);
-
-  int nthread = atoi(av[1]);
-  niter = 100;
-  if (ac > 2)
-    niter = atoi(av[2]);
+  bench::config cfg("allocbench");
+  const char *kbytes = "256";
 
-  pthread_t* tid = (pthread_t*) malloc(sizeof(*tid)*nthread);
-
-  pthread_barrier_init(&bar, 0, nthread);
-
-  for(uint64_t i = 0; i < nthread; i++)
-    xthread_create(&tid[i], 0, thr, (void*) i);
+  int opt;
+  while ((opt = getopt(argc, argv, BENCH_OPTS "s:")) != -1) {
+    if (cfg.option(opt, optarg))
+      continue;
+    switch (opt) {
+    case 's':
+      kbytes = optarg;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (argc - optind > 1)
+    usage(argv[0]);
+  if (argc - optind == 1 && !cfg.set_cores(argv[optind]))
+    usage(argv[0]);
+  if (atoi(kbytes) <= 0)
+    usage(argv[0]);
+  cfg.add_param("kbytes", kbytes);
 
-  for(int i = 0; i < nthread; i++)
-    xpthread_join(tid[i]);
+  allocbench b(atoi(kbytes) * 1024);
+  bench::run(cfg, &b);
   return 0;
 }
@@ -34,7 +34,7 @@ int
 main(int ac, char **av)
 {
   const char* hello = "append:\n";
-  pthread_t tid;
+  pthread_t tid[4];
   int fd;
 
   fd = open("/append.x", O_CREAT|O_RDWR, 0666);
@@ -47,10 +47,10 @@ main(int ac, char **av)
   pthread_barrier_init(&bar, nullptr, 4);
 
   for (int i = 0; i < 4; i++)
-    pthread_create(&tid, nullptr, thread, (void*)(long)i);
+    pthread_create(&tid[i], nullptr, thread, (void*)(long)i);
 
   for (int i = 0; i < 4; i++)
-    wait(NULL);
+    pthread_join(tid[i], nullptr);
 
   return 0;
 }
@@ -142,14 +142,15 @@ main(int ac, char **av)
 
   if (op) {
     barrier = ncore + 1;
+    pthread_t *tid = new pthread_t[ncore];
     for (u64 i = 0; i < ncore; i++) {
       next();
-      pthread_t tid;
-      pthread_create(&tid, 0, op, (void*) i);
+      pthread_create(&tid[i], 0, op, (void*) i);
     }
 
     for (u64 i = 0; i < ncore; i++)
-      wait(NULL);
+      pthread_join(tid[i], nullptr);
+    delete[] tid;
     if (barrier)
       die("forgot to call ready()");
     mtdisable("xv6-asharing");
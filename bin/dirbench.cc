@@ -1,64 +1,67 @@
+// Benchmark concurrent creates, lookups, and unlinks in one shared
+// directory.  Each operation has a worker create its files, look them
+// up, and unlink them again.
+
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include "libutil.h"
-#include "amd64.h"
-#include "xsys.h"
-
-// To build on Linux:
-//  make HW=linux
-
-#if !defined(XV6_USER)
-//#include "user/util.h"
-//#include "types.h"
-
-#include <errno.h>
-#include <pthread.h>
-#include <assert.h>
 #include <sys/stat.h>
-#include <sys/wait.h>
-#else
-#include "types.h"
-#include "user.h"
-#include "pthread.h"
+
+#if defined(XV6_USER)
 #include "mtrace.h"
-#include "amd64.h"
-#include "xsys.h"
 #endif
+#include "libutil.h"
+#include "xsys.h"
+#include "bench.hh"
 
-static const bool pinit = true;
-
-enum { nfile = MTRACE ? 2 : 10 };
+// Files per thread.  Raise this to grow the directory and exercise
+// its hash table resizing.
+static int nfile = MTRACE ? 2 : 10;
 enum { nlookup = MTRACE ? 2 : 100 };
 
-// XXX(austin) Totally lame.  Put this buffer in the BSS so we don't
-// have to COW fault the stack.
-static char pn[32]
-__attribute__((aligned(4096)));
+struct worker_state
+{
+  char pn[32];
+  __padout__;
+};
 
-void
-bench(uint32_t tid, int nloop, const char* path)
+class dirbench : public bench::benchmark
 {
-//  char pn[32];
+  const char *path_;
+  int ncores_;
+  worker_state *workers_;
+
+public:
+  dirbench(const char *path) : path_(path), ncores_(0), workers_(nullptr) { }
+
+  void
+  setup(int ncores) override
+  {
+    ncores_ = ncores;
+    workers_ = bench::new_array<worker_state>(ncores);
+    mtenable_type(mtrace_record_ascope, "xv6-dirbench");
+  }
 
-  if (pinit)
-    setaffinity(tid);
+  void
+  op(int id) override
+  {
+    char *pn = workers_[id].pn;
 
-  for (uint32_t x = 0; x < nloop; x++) {
-    for (uint32_t i = 0; i < nfile; i++) {
-      snprintf(pn, sizeof(pn), "%s/f:%d:%d", path, tid, i);
+    for (int i = 0; i < nfile; i++) {
+      snprintf(pn, sizeof(workers_[id].pn), "%s/f:%d:%d", path_, id, i);
 
       int fd = open(pn, O_CREAT|O_RDWR, S_IRUSR|S_IWUSR);
       if (fd < 0)
-	die("create failed\n");
+        die("create failed\n");
 
       close(fd);
     }
 
-    for (uint32_t i = 0; i < nlookup; i++) {
-      snprintf(pn, sizeof(pn), "%s/f:%d:%d", path, tid, (i % nfile));
+    for (int i = 0; i < nlookup; i++) {
+      snprintf(pn, sizeof(workers_[id].pn), "%s/f:%d:%d", path_, id,
+               (i % nfile));
       int fd = open(pn, O_RDWR);
       if (fd < 0)
         die("open failed %s", pn);
@@ -66,57 +69,72 @@ bench(uint32_t tid, int nloop, const char* path)
       close(fd);
     }
 
-    for (uint32_t i = 0; i < nfile; i++) {
-      snprintf(pn, sizeof(pn), "%s/f:%d:%d", path, tid, i);
+    for (int i = 0; i < nfile; i++) {
+      snprintf(pn, sizeof(workers_[id].pn), "%s/f:%d:%d", path_, id, i);
       if (unlink(pn) < 0)
-	die("unlink failed\n");
+        die("unlink failed\n");
     }
   }
 
-  exit(0);
+  void
+  teardown() override
+  {
+    mtdisable("xv6-dirbench");
+    bench::delete_array(workers_, ncores_);
+  }
+};
+
+static void
+usage(const char *argv0)
+{
+  fprintf(stderr, "Usage: %s [options] [nthreads]\n", argv0);
+  bench::config::usage();
+  fprintf(stderr,
+          "  -p path       Shared directory (default /dbx)\n"
+          "  -f nfile      Files per thread (default %d)\n", nfile);
+  exit(2);
 }
 
 int
-main(int ac, char** av)
+main(int argc, char **argv)
 {
-  const char* path;
-  int nthread;
-  int nloop;
-  
-#ifdef HW_qemu
-  nloop = 50;
-#else
-  nloop = 1000;
-#endif
-  path = "/dbx";
-
-  if (ac < 2)
-    die("usage: %s nthreads [nloop] [path]", av[0]);
-
-  nthread = atoi(av[1]);
-  if (ac > 2)
-    nloop = atoi(av[2]);
-  if (ac > 3)
-    path = av[3];
-
-  mkdir(path, 0777);
-
-  mtenable_type(mtrace_record_ascope, "xv6-dirbench");
-
-  uint64_t t0 = rdtsc();
-  for(uint32_t i = 0; i < nthread; i++) {
-    int pid = fork();
-    if (pid == 0) {
-      bench(i, nloop, path);
-    } else if (pid < 0)
-      die("fork");
+  bench::config cfg("dirbench");
+  const char *path = "/dbx";
+  const char *nfiles = nullptr;
+
+  int opt;
+  while ((opt = getopt(argc, argv, BENCH_OPTS "p:f:")) != -1) {
+    if (cfg.option(opt, optarg))
+      continue;
+    switch (opt) {
+    case 'p':
+      path = optarg;
+      break;
+    case 'f':
+      nfiles = optarg;
+      nfile = atoi(optarg);
+      if (nfile <= 0)
+        usage(argv[0]);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (argc - optind > 1)
+    usage(argv[0]);
+  if (argc - optind == 1 && !cfg.set_cores(argv[optind]))
+    usage(argv[0]);
+
+  char buf[16];
+  if (!nfiles) {
+    snprintf(buf, sizeof(buf), "%d", nfile);
+    nfiles = buf;
   }
+  cfg.add_param("nfile", nfiles);
 
-  for (uint32_t i = 0; i < nthread; i++)
-    wait(NULL);
-  uint64_t t1 = rdtsc();
-  mtdisable("xv6-dirbench");
+  mkdir(path, 0777);
 
-  printf("dirbench: %lu\n", t1-t0);
+  dirbench b(path);
+  bench::run(cfg, &b);
   return 0;
 }
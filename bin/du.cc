@@ -2,6 +2,7 @@
 #include <sys/stat.h>
 #include "user.h"
 #include "fs.h"
+#include "dirit.hh"
 
 #include <fcntl.h>
 #include <stdio.h>
@@ -19,19 +20,12 @@ du(int fd)
 
   int size = st.st_size;
   if (S_ISDIR(st.st_mode)) {
-    struct dirent de;
-    while (read(fd, &de, sizeof(de)) == sizeof(de)) {
-      if (de.inum == 0)
+    dirit di(fd);
+    while (const struct kdirent *de = di.next()) {
+      if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, ".."))
         continue;
 
-      char buf[DIRSIZ+1];
-      memmove(buf, de.name, DIRSIZ);
-      buf[DIRSIZ] = 0;
-
-      if (!strcmp(buf, ".") || !strcmp(buf, ".."))
-        continue;
-
-      int nfd = openat(fd, buf, 0);
+      int nfd = openat(fd, de->d_name, 0);
       if (nfd >= 0)
         size += du(nfd);  // should go into work queue
     }
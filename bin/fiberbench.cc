@@ -0,0 +1,282 @@
+// Compare fibers against kernel threads.
+//
+//   pingpong: two fibers (threads) hand a token back and forth
+//             through semaphores.
+//   pipepong: the same, through a pair of pipes, so fibers wait with
+//             fiber::read instead of blocking their worker.
+//   fanout:   start n fibers (threads) that each do a little work,
+//             and wait for all of them.
+
+#include "types.h"
+#include "user.h"
+#include "pthread.h"
+#include "futex.h"
+#include "fiber.hh"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+
+enum { fanout_work = 1000 };
+
+static int nworkers = 1;
+static long n;
+
+static void
+work(int n)
+{
+  for (volatile int i = 0; i < n; i++)
+    ;
+}
+
+// A futex semaphore for the kernel thread versions.
+struct tsem {
+  u64 count;
+
+  tsem() : count(0) { }
+
+  void wait()
+  {
+    for (;;) {
+      u64 c = __atomic_load_n(&count, __ATOMIC_ACQUIRE);
+      if (c && __atomic_compare_exchange_n(&count, &c, c - 1, false,
+                                           __ATOMIC_ACQUIRE,
+                                           __ATOMIC_RELAXED))
+        return;
+      if (!c)
+        futex(&count, FUTEX_WAIT, 0, 0);
+    }
+  }
+
+  void post()
+  {
+    __atomic_fetch_add(&count, 1, __ATOMIC_RELEASE);
+    futex(&count, FUTEX_WAKE, 1, 0);
+  }
+};
+
+//
+// pingpong
+//
+
+static fiber::semaphore fping, fpong;
+static fiber::semaphore fdone;
+static tsem tping, tpong;
+
+static void
+fiber_ponger(void *arg)
+{
+  for (long i = 0; i < n; i++) {
+    fping.wait();
+    fpong.post();
+  }
+  fdone.post();
+}
+
+static void
+fiber_pingpong(void *arg)
+{
+  fiber::spawn(fiber_ponger, nullptr);
+  for (long i = 0; i < n; i++) {
+    fping.post();
+    fpong.wait();
+  }
+  fdone.wait();
+}
+
+static void*
+thread_ponger(void *arg)
+{
+  for (long i = 0; i < n; i++) {
+    tping.wait();
+    tpong.post();
+  }
+  return nullptr;
+}
+
+static void
+thread_pingpong(void)
+{
+  pthread_t tid;
+  if (xthread_create(&tid, 0, thread_ponger, nullptr) < 0)
+    die("xthread_create");
+  for (long i = 0; i < n; i++) {
+    tping.post();
+    tpong.wait();
+  }
+  pthread_join(tid, nullptr);
+}
+
+//
+// pipepong
+//
+
+static int ping_fds[2], pong_fds[2];
+
+static void
+fiber_pipeponger(void *arg)
+{
+  char c;
+  for (long i = 0; i < n; i++) {
+    if (fiber::read(ping_fds[0], &c, 1) != 1)
+      die("fiber read");
+    if (fiber::write(pong_fds[1], &c, 1) != 1)
+      die("fiber write");
+  }
+  fdone.post();
+}
+
+static void
+fiber_pipepong(void *arg)
+{
+  char c = 'x';
+  fiber::spawn(fiber_pipeponger, nullptr);
+  for (long i = 0; i < n; i++) {
+    if (fiber::write(ping_fds[1], &c, 1) != 1)
+      die("fiber write");
+    if (fiber::read(pong_fds[0], &c, 1) != 1)
+      die("fiber read");
+  }
+  fdone.wait();
+}
+
+static void*
+thread_pipeponger(void *arg)
+{
+  char c;
+  for (long i = 0; i < n; i++) {
+    if (read(ping_fds[0], &c, 1) != 1)
+      die("read");
+    if (write(pong_fds[1], &c, 1) != 1)
+      die("write");
+  }
+  return nullptr;
+}
+
+static void
+thread_pipepong(void)
+{
+  char c = 'x';
+  pthread_t tid;
+  if (xthread_create(&tid, 0, thread_pipeponger, nullptr) < 0)
+    die("xthread_create");
+  for (long i = 0; i < n; i++) {
+    if (write(ping_fds[1], &c, 1) != 1)
+      die("write");
+    if (read(pong_fds[0], &c, 1) != 1)
+      die("read");
+  }
+  pthread_join(tid, nullptr);
+}
+
+//
+// fanout
+//
+
+static void
+fiber_child(void *arg)
+{
+  work(fanout_work);
+  fdone.post();
+}
+
+static void
+fiber_fanout(void *arg)
+{
+  for (long i = 0; i < n; i++)
+    if (fiber::spawn(fiber_child, nullptr) < 0)
+      die("fiber::spawn");
+  for (long i = 0; i < n; i++)
+    fdone.wait();
+}
+
+static void*
+thread_child(void *arg)
+{
+  work(fanout_work);
+  return nullptr;
+}
+
+static void
+thread_fanout(void)
+{
+  pthread_t *tid = new pthread_t[n];
+  for (long i = 0; i < n; i++) {
+    if (xthread_create(&tid[i], 0, thread_child, nullptr) < 0)
+      die("xthread_create");
+    // Spread children over the cores the fibers would use
+    setaffinity(i % nworkers);
+  }
+  setaffinity(0);
+  for (long i = 0; i < n; i++)
+    pthread_join(tid[i], nullptr);
+  delete[] tid;
+}
+
+static void
+usage(const char *argv0)
+{
+  die("usage: %s [-w nworkers] pingpong|pipepong|fanout fiber|thread n",
+      argv0);
+}
+
+int
+main(int argc, char **argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "w:")) != -1) {
+    switch (opt) {
+    case 'w':
+      nworkers = atoi(optarg);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (argc - optind != 3 || nworkers < 1)
+    usage(argv[0]);
+
+  const char *bench = argv[optind];
+  bool fibers;
+  if (strcmp(argv[optind + 1], "fiber") == 0)
+    fibers = true;
+  else if (strcmp(argv[optind + 1], "thread") == 0)
+    fibers = false;
+  else
+    usage(argv[0]);
+  n = atol(argv[optind + 2]);
+
+  void (*fiber_fn)(void*);
+  void (*thread_fn)(void);
+  if (strcmp(bench, "pingpong") == 0) {
+    fiber_fn = fiber_pingpong;
+    thread_fn = thread_pingpong;
+  } else if (strcmp(bench, "pipepong") == 0) {
+    fiber_fn = fiber_pipepong;
+    thread_fn = thread_pipepong;
+    if (pipe(ping_fds) < 0 || pipe(pong_fds) < 0)
+      die("pipe");
+  } else if (strcmp(bench, "fanout") == 0) {
+    fiber_fn = fiber_fanout;
+    thread_fn = thread_fanout;
+  } else {
+    usage(argv[0]);
+  }
+
+  u64 t0 = time_nsec();
+  if (fibers) {
+    if (fiber::run(nworkers, fiber_fn, nullptr) < 0)
+      die("fiber::run");
+  } else {
+    thread_fn();
+  }
+  u64 t1 = time_nsec();
+
+  printf("%s %s: %ld iterations on %d cores, %lu ns/iteration\n",
+         bench, fibers ? "fiber" : "thread", n, nworkers,
+         (t1 - t0) / (n ? n : 1));
+  return 0;
+}
@@ -1,105 +1,130 @@
+// Benchmark concurrent preads and pwrites of one shared file.  Each
+// worker has its own FD and reads and writes its own chunk of the
+// file.
+
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/stat.h>
-#include <sys/wait.h>
 
 #if defined(XV6_USER)
 #include "mtrace.h"
 #endif
-#include "amd64.h"
+#include "libutil.h"
 #include "xsys.h"
+#include "bench.hh"
 
 #define CHUNKSZ 512
-#define FILESZ  (NCPU*CHUNKSZ)
-
-static const bool pinit = true;
 
 // XXX(austin) Totally lame.  Align chunkbuf so that we don't have to
 // COW fault on a mapped file page in bench.
 static char chunkbuf[CHUNKSZ]
 __attribute__((aligned(4096)));
 
-static void
-bench(int tid, int nloop, const char* path)
+struct worker_state
 {
-  if (pinit)
-    setaffinity(tid);
+  int fd;
+  __padout__;
+};
 
-  int fd = open(path, O_RDWR);
-  if (fd < 0)
-    die("open");
+class filebench : public bench::benchmark
+{
+  const char *path_;
+  int ncores_;
+  worker_state *workers_;
+
+public:
+  filebench(const char *path) : path_(path), ncores_(0), workers_(nullptr) { }
+
+  void
+  setup(int ncores) override
+  {
+    ncores_ = ncores;
+    workers_ = bench::new_array<worker_state>(ncores);
+
+    // Set up shared file
+    unlink(path_);
+    int fd = open(path_, O_CREAT|O_RDWR, S_IRUSR|S_IWUSR);
+    if (fd < 0)
+      die("open O_CREAT failed");
+    for (int i = 0; i < ncores; i++) {
+      int r = write(fd, chunkbuf, CHUNKSZ);
+      if (r < CHUNKSZ)
+        die("write");
+    }
+    close(fd);
 
-  for (int i = 0; i < nloop; i++) {
+    mtenable_type(mtrace_record_ascope, "xv6-filebench");
+  }
+
+  void
+  thread_setup(int id) override
+  {
+    workers_[id].fd = open(path_, O_RDWR);
+    if (workers_[id].fd < 0)
+      die("open");
+  }
+
+  void
+  op(int id) override
+  {
+    int fd = workers_[id].fd;
     ssize_t r;
 
-    r = pread(fd, chunkbuf, CHUNKSZ, CHUNKSZ*tid);
+    r = pread(fd, chunkbuf, CHUNKSZ, CHUNKSZ*id);
     if (r != CHUNKSZ)
       die("pread");
 
-    r = pwrite(fd, chunkbuf, CHUNKSZ, CHUNKSZ*tid);
+    r = pwrite(fd, chunkbuf, CHUNKSZ, CHUNKSZ*id);
     if (r != CHUNKSZ)
       die("pwrite");
   }
 
-  close(fd);
-  exit(0);
+  void
+  teardown() override
+  {
+    mtdisable("xv6-filebench");
+    for (int i = 0; i < ncores_; i++)
+      close(workers_[i].fd);
+    bench::delete_array(workers_, ncores_);
+  }
+};
+
+static void
+usage(const char *argv0)
+{
+  fprintf(stderr, "Usage: %s [options] [nthreads]\n", argv0);
+  bench::config::usage();
+  fprintf(stderr, "  -p path       Shared file (default fbx)\n");
+  exit(2);
 }
 
 int
-main(int ac, char **av)
+main(int argc, char **argv)
 {
-  const char* path;
-  int nthread;
-  int nloop;
-
-#ifdef HW_qemu
-  nloop = 50;
-#else
-  nloop = 1000;
-#endif
-  path = "fbx";
-
-  if (ac < 2)
-    die("usage: %s nthreads [nloop] [path]", av[0]);
-
-  nthread = atoi(av[1]);
-  if (ac > 2)
-    nloop = atoi(av[2]);
-  if (ac > 3)
-    path = av[3];
-
-  mtenable_type(mtrace_record_ascope, "xv6-filebench");
-
-  // Setup shared file
-  unlink(path);
-  int fd = open(path, O_CREAT|O_RDWR, S_IRUSR|S_IWUSR);
-  if (fd < 0)
-    die("open O_CREAT failed");
-  for (int i = 0; i < FILESZ; i += CHUNKSZ) {
-    int r = write(fd, chunkbuf, CHUNKSZ); 
-    if (r < CHUNKSZ)
-      die("write");
-  }
-  close(fd);
-
-  //mtenable("xv6-filebench");
-  uint64_t t0 = rdtsc();
-  for (int i = 0; i < nthread; i++) {
-    int pid = fork();
-    if (pid == 0) {
-      bench(i, nloop, path);
+  bench::config cfg("filebench");
+  const char *path = "fbx";
+
+  int opt;
+  while ((opt = getopt(argc, argv, BENCH_OPTS "p:")) != -1) {
+    if (cfg.option(opt, optarg))
+      continue;
+    switch (opt) {
+    case 'p':
+      path = optarg;
+      break;
+    default:
+      usage(argv[0]);
     }
-    else if (pid < 0)
-      die("fork");
   }
+  if (argc - optind > 1)
+    usage(argv[0]);
+  if (argc - optind == 1 && !cfg.set_cores(argv[optind]))
+    usage(argv[0]);
 
-  for (int i = 0; i < nthread; i++)
-    wait(NULL);
-  uint64_t t1 = rdtsc();
-  mtdisable("xv6-filebench");
-
-  printf("filebench: %lu\n", t1-t0);
+  filebench b(path);
+  bench::run(cfg, &b);
+  unlink(path);
   return 0;
 }
@@ -1,42 +1,130 @@
+// Benchmark process creation.  Each operation creates a process that
+// execs this program, which exits immediately, and waits for it.
+
 #include "types.h"
 #include "user.h"
 #include "mtrace.h"
 #include "amd64.h"
+#include "libutil.h"
+#include "bench.hh"
+#include <fcntl.h>
+#include <spawn.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/wait.h>
 
-#define NITERS 1024
+enum class mode { fork, vfork, spawn };
 
-static void
-execbench(void)
+class forkexecbench : public bench::benchmark
 {
-  u64 s = rdtsc();
-  mtenable("xv6-forkexecbench");
-  for (int i = 0; i < NITERS; i++) {
-    int pid = fork();
-    if (pid < 0) {
-      die("fork error");
-    }
-    if (pid == 0) {
-      const char *av[] = { "forkexecbench", "x", 0 };
-      execv("forkexecbench", const_cast<char * const *>(av));
-      die("exec failed\n");
+  mode m_;
+
+public:
+  forkexecbench(mode m) : m_(m) { }
+
+  void
+  setup(int ncores) override
+  {
+    mtenable("xv6-forkexecbench");
+  }
+
+  void
+  op(int id) override
+  {
+    const char *av[] = { "forkexecbench", "x", 0 };
+    int pid;
+
+    if (m_ == mode::spawn) {
+      if (posix_spawn(&pid, av[0], nullptr, nullptr,
+                      const_cast<char * const *>(av), nullptr))
+        die("spawn error");
     } else {
-      wait(NULL);
+      pid = m_ == mode::vfork ? vfork() : fork();
+      if (pid < 0) {
+        die("fork error");
+      }
+      if (pid == 0) {
+        execv(av[0], const_cast<char * const *>(av));
+        die("exec failed\n");
+      }
     }
+    // Other workers have children of their own, so wait for this one
+    if (waitpid(pid, nullptr, 0) < 0)
+      die("waitpid failed");
+    mtops(1);
+  }
+
+  void
+  teardown() override
+  {
+    mtdisable("xv6-forkexecbench");
   }
-  mtops(NITERS);
-  mtdisable("xv6-forkexecbench");
+};
 
-  u64 e = rdtsc();
-  printf("%lu\n", (e-s) / NITERS);
+static void
+usage(const char *argv0)
+{
+  fprintf(stderr, "Usage: %s [options] [nthreads]\n", argv0);
+  bench::config::usage();
+  fprintf(stderr,
+          "  -m fork       Create processes with fork (default)\n"
+          "     vfork      ... with vfork\n"
+          "     spawn      ... with posix_spawn\n"
+          "  -f nfds       Extra FDs to hold open (default 0)\n");
+  exit(2);
 }
 
 int
 main(int ac, char **av)
 {
-  if (ac == 2)
+  if (ac == 2 && strcmp(av[1], "x") == 0)
     exit(0);
-  execbench();
+
+  bench::config cfg("forkexecbench");
+  const char *modename = "fork";
+  const char *nfds = "0";
+
+  int opt;
+  while ((opt = getopt(ac, av, BENCH_OPTS "m:f:")) != -1) {
+    if (cfg.option(opt, optarg))
+      continue;
+    switch (opt) {
+    case 'm':
+      modename = optarg;
+      break;
+    case 'f':
+      nfds = optarg;
+      break;
+    default:
+      usage(av[0]);
+    }
+  }
+  if (ac - optind > 1)
+    usage(av[0]);
+  if (ac - optind == 1 && !cfg.set_cores(av[optind]))
+    usage(av[0]);
+
+  mode m;
+  if (strcmp(modename, "fork") == 0)
+    m = mode::fork;
+  else if (strcmp(modename, "vfork") == 0)
+    m = mode::vfork;
+  else if (strcmp(modename, "spawn") == 0)
+    m = mode::spawn;
+  else
+    usage(av[0]);
+  cfg.add_param("mode", modename);
+  cfg.add_param("nfds", nfds);
+
+  // Hold extra FDs open so process creation has file table entries
+  // to copy and close.
+  for (int i = 0; i < atoi(nfds); i++)
+    if (open("/", O_RDONLY) < 0)
+      die("open failed");
+
+  forkexecbench b(m);
+  bench::run(cfg, &b);
   return 0;
 }
@@ -1,10 +1,13 @@
 #include "types.h"
 #include "user.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
-#define NCHILD 2
-#define NDEPTH 5
+// The defaults make a small tree; "forktree 4 7" creates 21844
+// processes, most of them alive at once.
+static int nchild = 2;
+static int ndepth = 5;
 
 void
 forktree(void)
@@ -15,10 +18,10 @@ forktree(void)
 
  next_level:
   //printf(1, "pid %d, depth %d\n", getpid(), depth);
-  if (depth >= NDEPTH)
+  if (depth >= ndepth)
     exit(0);
 
-  for (int i = 0; i < NCHILD; i++) {
+  for (int i = 0; i < nchild; i++) {
     int pid = fork();
     if (pid < 0) {
       die("fork error");
@@ -30,7 +33,7 @@ forktree(void)
     }
   }
 
-  for (int i = 0; i < NCHILD; i++) {
+  for (int i = 0; i < nchild; i++) {
     if (wait(NULL) < 0) {
       die("wait stopped early");
     }
@@ -48,8 +51,14 @@ forktree(void)
 }
 
 int
-main(void)
+main(int argc, char **argv)
 {
+  if (argc > 3)
+    die("usage: %s [nchild] [ndepth]", argv[0]);
+  if (argc > 1)
+    nchild = atoi(argv[1]);
+  if (argc > 2)
+    ndepth = atoi(argv[2]);
   forktree();
   return 0;
 }
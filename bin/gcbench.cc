@@ -1,36 +1,26 @@
+// Benchmark delayed freeing through the kernel GC.  Each operation
+// opens and closes a file, which frees the file structure after a
+// grace period.
+
 #include "types.h"
 #include "user.h"
 #include "amd64.h"
 #include "lib.h"
-#include <xv6/perf.h>
+#include "libutil.h"
+#include "bench.hh"
 
 #include <fcntl.h>
 #include <uk/gcstat.h>
-#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
-static int cpu = 0;
-static int sec = 2;
-static int fd_ctrl;
+#include <vector>
 
-#ifdef PROFILE
-static u64 selector = 
-  0UL << 32 |
-  1 << 24 | 
-  1 << 22 | 
-  1 << 20 |
-  1 << 17 | 
-  1 << 16 | 
-  0x00 << 8 | 
-  0x76;
-static u64 period = 100000;
-#else
-static u64 selector = 0;
-static u64 period = 0;
-#endif
+// The kernel's own batch size
+static const char *default_batchsize = "100000000";
+static int fd_ctrl;
 
 static void
 ctrl_init(void)
@@ -60,14 +50,15 @@ ctrl(int ncore, int size, int op)
     die("gc: write failed");
 }
 
-static void
-stats(int print)
+// Read every core's GC statistics, which also resets them
+static std::vector<gc_stat>
+stats(void)
 {
   static const u64 sz = sizeof(struct gc_stat);
+  std::vector<gc_stat> res;
   struct gc_stat gs;
   int fd;
   int r;
-  int c = 0;
 
   fd = open("/dev/gc", O_RDONLY);
   if (fd < 0)
@@ -81,103 +72,139 @@ stats(int print)
       break;
     if (r != sz)
       die("gct: unexpected read");
-
-    if (print)
-      printf("%d: ndelay %" PRId64 " nfree %" PRId64 " nrun %" PRId64 " ncycles %lu nop %lu cycles/op %lu\n",
-            c++, gs.ndelay, gs.nfree, gs.nrun, gs.ncycles, gs.nop, 
-              (gs.nop > 0) ? gs.ncycles/gs.nop : 0);
+    res.push_back(gs);
   }
 
   close(fd);
+  return res;
 }
 
-//
-// Each core open and closes a file, delay freeing the file structure.
-//
-
-void gctest(char *fn)
+struct worker_state
 {
-  int fd;
-  if((fd = open(fn, O_RDONLY)) < 0){
-    die("cat: cannot open %s", "cat");
-  }
-  close(fd);
+  char filename[32];
+  __padout__;
+};
 
-}
+// The workers share one FD table, so they open with O_ANYFD to keep
+// FD allocation from serializing them.
 
-void
-child()
+class gcbench : public bench::benchmark
 {
-  u64 s = 5; // use integer instead of float (e.g., 2.5)!
-  u64 nsec = sec*s*1000*1000*1000L; 
-  int n = 0;
-  char filename[32];
-  int fd;
-
-  if (setaffinity(cpu) < 0) {
-    die("sys_setaffinity(%d) failed", 0);
+  int batchsize_, ncores_;
+  worker_state *workers_;
+  std::vector<gc_stat> stats_;
+  u64 sync_cycles_;
+
+public:
+  gcbench(int batchsize)
+    : batchsize_(batchsize), ncores_(0), workers_(nullptr), sync_cycles_(0) { }
+
+  void
+  setup(int ncores) override
+  {
+    ncores_ = ncores;
+    workers_ = bench::new_array<worker_state>(ncores);
+
+    ctrl_init();
+    ctrl(ncores, batchsize_, GC_OP_NONE);
+    ctrl_done();
+    stats();
   }
-  snprintf(filename, sizeof(filename), "f%d", cpu);
-  fd = open(filename, O_CREAT|O_RDWR, 0666);
-  if (fd < 0)
-    die("gc: open failed");
-  close(fd);
 
-  if (cpu == 0) { 
-    stats(0);
+  void
+  thread_setup(int id) override
+  {
+    char *fn = workers_[id].filename;
+    snprintf(fn, sizeof(workers_[id].filename), "f%d", id);
+    int fd = open(fn, O_CREAT|O_RDWR, 0666);
+    if (fd < 0)
+      die("gc: open failed");
+    close(fd);
   }
-  if (cpu == 0) perf_start(selector, period);
-  u64 t0 = rdtsc();
-  u64 t1;
-  do {
-    for(int i = 0; i < 10; i++) {
-      gctest(filename);
-      n++;
+
+  void
+  op(int id) override
+  {
+    int fd;
+    if((fd = open(workers_[id].filename, O_RDONLY|O_ANYFD)) < 0){
+      die("gc: cannot open %s", workers_[id].filename);
     }
-    t1 = rdtsc();
-  } while((t1 - t0) < nsec);
+    close(fd);
+  }
 
-  // printf("%d: %d ops in %d sec\n", cpu, n, s);
+  void
+  teardown() override
+  {
+    for (int i = 0; i < ncores_; i++)
+      if (unlink(workers_[i].filename) < 0)
+        die("unlink failed\n");
+    bench::delete_array(workers_, ncores_);
+
+    // Time an expedited grace period, which also frees everything the
+    // workers left behind
+    u64 t0 = rdtsc();
+    ctrl_init();
+    ctrl(ncores_, batchsize_, GC_OP_SYNC);
+    ctrl_done();
+    sync_cycles_ = rdtsc() - t0;
+    stats_ = stats();
+  }
 
-  if (cpu == 0) { 
-    printf("stats for %" PRId64 " sec\n", s);
-    stats(1);
+  void
+  report() override
+  {
+    printf(",\"sync_cycles\":%lu,\"gc\":[", sync_cycles_);
+    const char *sep = "";
+    for (size_t c = 0; c < stats_.size(); c++) {
+      const gc_stat &gs = stats_[c];
+      if (!gs.ndelay && !gs.nfree && !gs.nrun)
+        continue;
+      printf("%s{\"cpu\":%zu,\"ndelay\":%lu,\"nfree\":%lu,\"nrun\":%lu"
+             ",\"ncycles\":%lu,\"nop\":%lu}",
+             sep, c, gs.ndelay, gs.nfree, gs.nrun, gs.ncycles, gs.nop);
+      sep = ",";
+    }
+    printf("]");
   }
-  if (cpu == 0) perf_stop();
-  if (unlink(filename) < 0)
-    die("unlink failed\n");
+};
+
+static void
+usage(const char *argv0)
+{
+  fprintf(stderr, "Usage: %s [options] [nthreads]\n", argv0);
+  bench::config::usage();
+  fprintf(stderr, "  -b batchsize  GC batch size (default %s)\n",
+          default_batchsize);
+  exit(2);
 }
 
 int
 main(int argc, char *argv[])
 {
-  if (argc < 3)
-    die("usage: %s nproc batchsize [nsec]", argv[0]);
-
-  int nproc = atoi(argv[1]);
-  int batchsize = atoi(argv[2]);
-  if (argc > 3)
-    sec = atoi(argv[3]);
-
-  printf("%s: %d %d\n", argv[0], nproc, batchsize);
-
-  ctrl_init();
-  ctrl(nproc, batchsize, 0);
-  ctrl_done();
-
-  for (int i = 0; i < nproc; i++) {
-    int pid = fork();
-    if (pid < 0)
-      die("time_this: fork failed %s", argv[0]);
-    if (pid == 0) {
-      child();
-      exit(0);
-    } else {
-      cpu++;
+  bench::config cfg("gcbench");
+  const char *batchsize = default_batchsize;
+
+  int opt;
+  while ((opt = getopt(argc, argv, BENCH_OPTS "b:")) != -1) {
+    if (cfg.option(opt, optarg))
+      continue;
+    switch (opt) {
+    case 'b':
+      batchsize = optarg;
+      if (atoi(batchsize) <= 0)
+        usage(argv[0]);
+      break;
+    default:
+      usage(argv[0]);
     }
   }
-  for (int i = 0; i < nproc; i++)
-    wait(NULL);
-  printf("done %d %s\n", getpid(), argv[0]);
+  if (argc - optind > 1)
+    usage(argv[0]);
+  if (argc - optind == 1 && !cfg.set_cores(argv[optind]))
+    usage(argv[0]);
+  cfg.add_param("batchsize", batchsize);
+
+  gcbench b(atoi(batchsize));
+  bench::run(cfg, &b);
   return 0;
 }
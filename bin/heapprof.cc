@@ -0,0 +1,236 @@
+// Control the kernel heap profiler and report its results.
+//
+//   heapprof start [rate] | stop | clear
+//   heapprof snap file
+//   heapprof [-n top] top [file]
+//   heapprof [-n top] diff old new
+//
+// top lists the call stacks with the most live bytes, either now or
+// in a snapshot saved with snap.  diff compares two snapshots, listing
+// the stacks whose live bytes changed the most, which is how to find
+// a leak: snap, run the workload, snap again, and diff.  Stacks are
+// kernel return addresses, innermost first; resolve them with
+// addr2line against the kernel.
+
+#include "types.h"
+#include "user.h"
+#include "uk/heapprof.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+struct profile {
+  struct heapprof_hdr hdr;
+  std::vector<heapprof_rec> recs;
+};
+
+static void
+ctl(const char *cmd)
+{
+  int fd = open("/dev/heapprof", O_WRONLY);
+  if (fd < 0)
+    die("heapprof: open failed");
+  if (write(fd, cmd, strlen(cmd)) != strlen(cmd))
+    die("heapprof: %s failed", cmd);
+  close(fd);
+}
+
+// Load a profile from the device or a snapshot file.
+static profile
+load(const char *path)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    die("heapprof: cannot open %s", path);
+
+  profile p;
+  if (read(fd, &p.hdr, sizeof(p.hdr)) != sizeof(p.hdr))
+    die("heapprof: %s: short header", path);
+  struct heapprof_rec r;
+  int n;
+  while ((n = read(fd, &r, sizeof(r))) == sizeof(r))
+    p.recs.push_back(r);
+  if (n < 0)
+    die("heapprof: %s: read failed", path);
+  close(fd);
+  return p;
+}
+
+static void
+snap(const char *path)
+{
+  profile p = load("/dev/heapprof");
+  // The stack count may have changed since the header was read
+  p.hdr.nrecs = p.recs.size();
+
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    die("heapprof: cannot create %s", path);
+  if (write(fd, &p.hdr, sizeof(p.hdr)) != sizeof(p.hdr))
+    die("heapprof: %s: write failed", path);
+  for (auto &r : p.recs)
+    if (write(fd, &r, sizeof(r)) != sizeof(r))
+      die("heapprof: %s: write failed", path);
+  close(fd);
+  printf("%lu stacks\n", p.recs.size());
+}
+
+static bool
+same_stack(const heapprof_rec &a, const heapprof_rec &b)
+{
+  return a.arena == b.arena && memcmp(a.pcs, b.pcs, sizeof(a.pcs)) == 0;
+}
+
+static void
+print_stack(const heapprof_rec &r)
+{
+  printf("  %s", r.arena == HEAPPROF_ARENA_KALLOC ? "kalloc " : "kmalloc");
+  for (u64 pc : r.pcs)
+    if (pc)
+      printf(" %016lx", pc);
+  printf("\n");
+}
+
+static void
+print_hdr(const char *what, const heapprof_hdr &h)
+{
+  printf("# %s: sampling every %lu bytes%s", what, h.rate,
+         h.enabled ? "" : " (stopped)");
+  if (h.dropped)
+    printf(", %lu samples dropped", h.dropped);
+  printf("\n");
+}
+
+static void
+top(size_t n, const char *path)
+{
+  profile p = load(path);
+  std::sort(p.recs.begin(), p.recs.end(),
+            [](const heapprof_rec &a, const heapprof_rec &b) {
+              return (s64)a.live_bytes > (s64)b.live_bytes;
+            });
+
+  print_hdr(path, p.hdr);
+  printf("## live-bytes live-count alloc-bytes alloc-count\n");
+  for (size_t i = 0; i < p.recs.size() && i < n; i++) {
+    heapprof_rec &r = p.recs[i];
+    printf("%ld %ld %lu %lu\n", (s64)r.live_bytes, (s64)r.live_count,
+           r.alloc_bytes, r.alloc_count);
+    print_stack(r);
+  }
+}
+
+struct delta {
+  heapprof_rec rec;
+  s64 live_bytes, live_count;
+  u64 alloc_bytes;
+};
+
+static void
+diff(size_t n, const char *oldpath, const char *newpath)
+{
+  profile o = load(oldpath), p = load(newpath);
+  if (p.hdr.nsec <= o.hdr.nsec)
+    die("heapprof: %s is not newer than %s", newpath, oldpath);
+
+  std::vector<delta> ds;
+  std::vector<bool> matched;
+  for (size_t i = 0; i < o.recs.size(); i++)
+    matched.push_back(false);
+  for (auto &r : p.recs) {
+    delta d{r, (s64)r.live_bytes, (s64)r.live_count, r.alloc_bytes};
+    for (size_t i = 0; i < o.recs.size(); i++) {
+      if (matched[i] || !same_stack(o.recs[i], r))
+        continue;
+      matched[i] = true;
+      d.live_bytes -= o.recs[i].live_bytes;
+      d.live_count -= o.recs[i].live_count;
+      // Counters restart if the profiler was cleared in between
+      if (r.alloc_bytes >= o.recs[i].alloc_bytes)
+        d.alloc_bytes -= o.recs[i].alloc_bytes;
+      break;
+    }
+    ds.push_back(d);
+  }
+  // Stacks that disappeared were cleared, so nothing of theirs is
+  // known to be live anymore
+  for (size_t i = 0; i < o.recs.size(); i++)
+    if (!matched[i])
+      ds.push_back(delta{o.recs[i], -(s64)o.recs[i].live_bytes,
+                         -(s64)o.recs[i].live_count, 0});
+
+  std::sort(ds.begin(), ds.end(), [](const delta &a, const delta &b) {
+      return (a.live_bytes < 0 ? -a.live_bytes : a.live_bytes) >
+        (b.live_bytes < 0 ? -b.live_bytes : b.live_bytes);
+    });
+
+  u64 nsec = p.hdr.nsec - o.hdr.nsec;
+  s64 total = 0;
+  for (auto &d : ds)
+    total += d.live_bytes;
+  print_hdr(oldpath, o.hdr);
+  print_hdr(newpath, p.hdr);
+  printf("# %lu ms apart, %+ld live bytes\n", nsec / 1000000, total);
+  printf("## delta-live-bytes delta-live-count alloc-bytes/s\n");
+  for (size_t i = 0; i < ds.size() && i < n; i++) {
+    delta &d = ds[i];
+    if (!d.live_bytes && !d.alloc_bytes)
+      break;
+    printf("%+ld %+ld %lu\n", d.live_bytes, d.live_count,
+           (u64)(d.alloc_bytes * 1000000000.0 / nsec));
+    print_stack(d.rec);
+  }
+}
+
+static void
+usage(const char *argv0)
+{
+  die("usage: %s start [rate] | stop | clear | snap file |\n"
+      "       %s [-n top] top [file] | [-n top] diff old new",
+      argv0, argv0);
+}
+
+int
+main(int argc, char **argv)
+{
+  size_t n = 10;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:")) != -1) {
+    switch (opt) {
+    case 'n':
+      n = atoi(optarg);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (optind == argc)
+    usage(argv[0]);
+
+  const char *cmd = argv[optind];
+  int nargs = argc - optind - 1;
+  char **args = argv + optind + 1;
+  if (strcmp(cmd, "start") == 0 && nargs <= 1) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "start %s", nargs ? args[0] : "");
+    ctl(nargs ? buf : "start");
+  } else if ((strcmp(cmd, "stop") == 0 || strcmp(cmd, "clear") == 0) &&
+             nargs == 0) {
+    ctl(cmd);
+  } else if (strcmp(cmd, "snap") == 0 && nargs == 1) {
+    snap(args[0]);
+  } else if (strcmp(cmd, "top") == 0 && nargs <= 1) {
+    top(n, nargs ? args[0] : "/dev/heapprof");
+  } else if (strcmp(cmd, "diff") == 0 && nargs == 2) {
+    diff(n, args[0], args[1]);
+  } else {
+    usage(argv[0]);
+  }
+  return 0;
+}
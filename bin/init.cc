@@ -35,6 +35,12 @@ static struct {
   { "/dev/netif",     MAJ_NETIF },
   { "/dev/sampler",   MAJ_SAMPLER },
   { "/dev/lockstat",  MAJ_LOCKSTAT },
+  { "/dev/lockprof",  MAJ_LOCKPROF },
+  { "/dev/syscallstats", MAJ_SYSCALLSTATS },
+  { "/dev/heapprof", MAJ_HEAPPROF },
+  { "/dev/numabalance", MAJ_NUMABALANCE },
+  { "/dev/refcache", MAJ_REFCACHE },
+  { "/dev/zswap", MAJ_ZSWAP },
   { "/dev/stat",      MAJ_STAT },
   { "/dev/cmdline",   MAJ_CMDLINE},
   { "/dev/gc",   MAJ_GC},
@@ -82,7 +82,7 @@ thread(void* x)
 int
 main (int argc, char *argv[])
 {
-  pthread_t tid;
+  pthread_t *tid;
   int nthread;
      
   unlink (SERVER);
@@ -94,11 +94,12 @@ main (int argc, char *argv[])
      
   sock = make_named_socket (SERVER);
 
+  tid = new pthread_t[nthread];
   for (int i = 0; i < nthread; i++)
-    pthread_create(&tid, nullptr, thread, (void*)(long)i);
+    pthread_create(&tid[i], nullptr, thread, (void*)(long)i);
 
   for (int i = 0; i < nthread; i++)
-    wait(NULL);
+    pthread_join(tid[i], nullptr);
 
   return 0;
 }
@@ -0,0 +1,158 @@
+// Benchmark pthread mutexes and rwlocks with more threads than
+// cores.  A lock that spins waiting for a descheduled holder burns
+// whole scheduling quanta, so throughput under oversubscription
+// shows whether waiters get out of the way.
+
+#include "types.h"
+#include "user.h"
+#include "amd64.h"
+#include "pthread.h"
+#include "xsys.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+
+enum { duration = 5 };
+
+enum class mode { spin, mutex, rdlock, rwlock };
+
+static mode bench_mode;
+static int ncore = 1;
+static int write_pct = 10;
+static int cs_work = 100;
+
+static pthread_barrier_t bar;
+static volatile bool stop __mpalign__;
+static __padout__ __attribute__((unused));
+
+static volatile int spinlock __mpalign__;
+static pthread_mutex_t mutex __mpalign__;
+static pthread_rwlock_t rwlock __mpalign__;
+static volatile u64 counter __mpalign__;
+static std::atomic<u64> total_ops;
+
+static void
+work(int n)
+{
+  for (volatile int i = 0; i < n; i++)
+    ;
+}
+
+static void*
+thr(void *arg)
+{
+  int tid = (uintptr_t)arg;
+  if (setaffinity(tid % ncore) < 0)
+    die("setaffinity err");
+  pthread_barrier_wait(&bar);
+
+  u64 ops = 0;
+  unsigned seed = tid;
+  while (!stop) {
+    switch (bench_mode) {
+    case mode::spin:
+      // What pthread_mutex_lock used to do
+      while (!__sync_bool_compare_and_swap(&spinlock, 0, 1))
+        ;
+      counter++;
+      work(cs_work);
+      spinlock = 0;
+      break;
+    case mode::mutex:
+      pthread_mutex_lock(&mutex);
+      counter++;
+      work(cs_work);
+      pthread_mutex_unlock(&mutex);
+      break;
+    case mode::rdlock:
+      pthread_rwlock_rdlock(&rwlock);
+      work(cs_work);
+      pthread_rwlock_unlock(&rwlock);
+      break;
+    case mode::rwlock:
+      seed = seed * 1103515245 + 12345;
+      if ((seed >> 16) % 100 < write_pct) {
+        pthread_rwlock_wrlock(&rwlock);
+        counter++;
+        work(cs_work);
+      } else {
+        pthread_rwlock_rdlock(&rwlock);
+        work(cs_work);
+      }
+      pthread_rwlock_unlock(&rwlock);
+      break;
+    }
+    ++ops;
+    work(cs_work);
+  }
+  total_ops += ops;
+  return nullptr;
+}
+
+static void
+usage(const char *argv0)
+{
+  die("usage: %s [-c ncores] [-w write%%] [-l cswork] "
+      "spin|mutex|rdlock|rwlock nthreads", argv0);
+}
+
+int
+main(int argc, char **argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "c:w:l:")) != -1) {
+    switch (opt) {
+    case 'c':
+      ncore = atoi(optarg);
+      break;
+    case 'w':
+      write_pct = atoi(optarg);
+      break;
+    case 'l':
+      cs_work = atoi(optarg);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (argc - optind != 2 || ncore < 1)
+    usage(argv[0]);
+
+  const char *m = argv[optind];
+  if (strcmp(m, "spin") == 0)
+    bench_mode = mode::spin;
+  else if (strcmp(m, "mutex") == 0)
+    bench_mode = mode::mutex;
+  else if (strcmp(m, "rdlock") == 0)
+    bench_mode = mode::rdlock;
+  else if (strcmp(m, "rwlock") == 0)
+    bench_mode = mode::rwlock;
+  else
+    usage(argv[0]);
+  int nthread = atoi(argv[optind + 1]);
+
+  pthread_mutex_init(&mutex, nullptr);
+  pthread_rwlock_init(&rwlock, nullptr);
+  pthread_barrier_init(&bar, 0, nthread + 1);
+
+  pthread_t* tid = (pthread_t*) malloc(sizeof(*tid)*nthread);
+  for (uintptr_t i = 0; i < nthread; i++)
+    xthread_create(&tid[i], 0, thr, (void*) i);
+
+  pthread_barrier_wait(&bar);
+  u64 start = rdtsc();
+  sleep(duration);
+  stop = true;
+  for (int i = 0; i < nthread; i++)
+    xpthread_join(tid[i]);
+  u64 stop_tsc = rdtsc();
+
+  printf("%s: %d threads on %d cores: %lu ops/sec, %lu cycles/op\n",
+         m, nthread, ncore, total_ops.load() / duration,
+         (stop_tsc - start) / (total_ops.load() ? total_ops.load() : 1));
+  return 0;
+}
@@ -0,0 +1,206 @@
+// Report the most contended spinlocks from /dev/lockprof.
+//
+//   lockprof [-n top] [command...]
+//
+// With a command, profile just that command; otherwise report what
+// the profiler has collected so far.  Sites and addresses are kernel
+// return addresses; resolve them with addr2line against the kernel.
+
+#include "types.h"
+#include "user.h"
+#include "uk/lockprof.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+struct cpuwait {
+  u32 cpu;
+  u64 wait_cycles;
+};
+
+// A lock's records summed over all CPUs
+struct lockinfo {
+  u64 lock;
+  char name[16];
+  u64 acquires, contends, wait_cycles, hold_cycles;
+  u64 wait_hist[LOCKPROF_BUCKETS], hold_hist[LOCKPROF_BUCKETS];
+  std::vector<lockprof_site> sites;
+  std::vector<cpuwait> cpus;
+};
+
+static void
+ctl(const char *cmd)
+{
+  int fd = open("/dev/lockprof", O_WRONLY);
+  if (fd < 0)
+    die("lockprof: open failed");
+  if (write(fd, cmd, strlen(cmd)) != strlen(cmd))
+    die("lockprof: %s failed", cmd);
+  close(fd);
+}
+
+// Return the upper bound of the bucket holding the p'th percentile.
+static u64
+percentile(const u64 *hist, double p)
+{
+  u64 total = 0;
+  for (int i = 0; i < LOCKPROF_BUCKETS; i++)
+    total += hist[i];
+  if (!total)
+    return 0;
+  u64 want = total * p, sum = 0;
+  for (int i = 0; i < LOCKPROF_BUCKETS; i++) {
+    sum += hist[i];
+    if (sum > want)
+      return 2ull << i;
+  }
+  return 2ull << (LOCKPROF_BUCKETS - 1);
+}
+
+static std::vector<lockinfo>
+collect(void)
+{
+  int fd = open("/dev/lockprof", O_RDONLY);
+  if (fd < 0)
+    die("lockprof: open failed");
+
+  std::vector<lockinfo> locks;
+  struct lockprof_rec r;
+  int n;
+  while ((n = read(fd, &r, sizeof(r))) == sizeof(r)) {
+    size_t i;
+    for (i = 0; i < locks.size(); i++)
+      if (locks[i].lock == r.lock)
+        break;
+    if (i == locks.size()) {
+      locks.push_back(lockinfo{});
+      locks[i].lock = r.lock;
+    }
+    lockinfo &li = locks[i];
+    if (r.name[0])
+      memcpy(li.name, r.name, sizeof(li.name));
+    li.acquires += r.acquires;
+    li.contends += r.contends;
+    li.wait_cycles += r.wait_cycles;
+    li.hold_cycles += r.hold_cycles;
+    for (int i = 0; i < LOCKPROF_BUCKETS; i++) {
+      li.wait_hist[i] += r.wait_hist[i];
+      li.hold_hist[i] += r.hold_hist[i];
+    }
+    for (auto &s : r.sites) {
+      if (!s.pc)
+        continue;
+      size_t j;
+      for (j = 0; j < li.sites.size(); j++)
+        if (li.sites[j].pc == s.pc)
+          break;
+      if (j == li.sites.size())
+        li.sites.push_back(lockprof_site{s.pc, 0, 0});
+      li.sites[j].contends += s.contends;
+      li.sites[j].wait_cycles += s.wait_cycles;
+    }
+    if (r.wait_cycles)
+      li.cpus.push_back(cpuwait{r.cpu, r.wait_cycles});
+  }
+  if (n < 0)
+    die("lockprof: read failed");
+  close(fd);
+
+  std::sort(locks.begin(), locks.end(),
+            [](const lockinfo &a, const lockinfo &b) {
+              return a.wait_cycles > b.wait_cycles;
+            });
+  return locks;
+}
+
+static void
+report(size_t top)
+{
+  std::vector<lockinfo> locks = collect();
+  while (!locks.empty() && !locks.back().contends)
+    locks.pop_back();
+  if (locks.empty()) {
+    printf("no contended locks\n");
+    return;
+  }
+
+  printf("## lock name acquires contends contend%% wait-cycles "
+         "wait-p50 wait-p99 hold-mean hold-p99\n");
+  for (size_t i = 0; i < locks.size() && i < top; i++) {
+    lockinfo &li = locks[i];
+    u64 holds = 0;
+    for (int b = 0; b < LOCKPROF_BUCKETS; b++)
+      holds += li.hold_hist[b];
+    printf("%016lx %-16.16s %lu %lu %lu%% %lu <%lu <%lu %lu <%lu\n",
+           li.lock, li.name[0] ? li.name : "-",
+           li.acquires, li.contends, li.contends * 100 / li.acquires,
+           li.wait_cycles,
+           percentile(li.wait_hist, 0.5), percentile(li.wait_hist, 0.99),
+           holds ? li.hold_cycles / holds : 0,
+           percentile(li.hold_hist, 0.99));
+
+    std::vector<lockprof_site> &sites = li.sites;
+    std::sort(sites.begin(), sites.end(),
+              [](const lockprof_site &a, const lockprof_site &b) {
+                return a.wait_cycles > b.wait_cycles;
+              });
+    for (size_t s = 0; s < sites.size() && s < LOCKPROF_SITES; s++)
+      printf("  site %016lx contends %lu wait-cycles %lu\n",
+             sites[s].pc, sites[s].contends, sites[s].wait_cycles);
+
+    std::sort(li.cpus.begin(), li.cpus.end(),
+              [](const cpuwait &a, const cpuwait &b) {
+                return a.wait_cycles > b.wait_cycles;
+              });
+    printf("  cpus");
+    for (size_t c = 0; c < li.cpus.size() && c < 8; c++)
+      printf(" %u:%lu%%", li.cpus[c].cpu,
+             li.cpus[c].wait_cycles * 100 / li.wait_cycles);
+    printf("\n");
+  }
+}
+
+static void
+usage(const char *argv0)
+{
+  die("usage: %s [-n top] [command...]", argv0);
+}
+
+int
+main(int argc, char **argv)
+{
+  size_t top = 10;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:")) != -1) {
+    switch (opt) {
+    case 'n':
+      top = atoi(optarg);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  if (optind < argc) {
+    ctl("clear");
+    ctl("start");
+    int pid = fork();
+    if (pid < 0)
+      die("lockprof: fork failed");
+    if (pid == 0) {
+      execv(argv[optind], argv + optind);
+      die("lockprof: exec failed");
+    }
+    wait(NULL);
+    ctl("stop");
+  }
+
+  report(top);
+  return 0;
+}
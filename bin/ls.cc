@@ -12,6 +12,7 @@
 #ifdef XV6_USER
 #include "fs.h"
 #include "sysstubs.h"
+#include "dirit.hh"
 #else
 #include <dirent.h>
 #endif
@@ -70,12 +71,9 @@ ls(const std::string &path)
   case S_IFDIR:
     std::vector<std::string> names;
 #ifdef XV6_USER
-    char namebuf[DIRSIZ+1];
-    char *prev = nullptr;
-    while(readdir(fd, prev, namebuf) > 0) {
-      prev = namebuf;
-      names.push_back(path + '/' + namebuf);
-    }
+    dirit di(fd);
+    while (const struct kdirent *de = di.next())
+      names.push_back(path + '/' + de->d_name);
 #else
     DIR *dir = fdopendir(fd);
     struct dirent *de;
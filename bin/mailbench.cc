@@ -1,8 +1,7 @@
 #include "amd64.h"
-#include "distribution.hh"
-#include "spinbarrier.hh"
 #include "libutil.h"
 #include "xsys.h"
+#include "bench.hh"
 
 #include <fcntl.h>
 #include <spawn.h>
@@ -14,7 +13,6 @@
 #include <sys/wait.h>
 
 #include <string>
-#include <thread>
 
 // Set to 1 to manage the queue manager's life time from this program.
 // Set to 0 if the queue manager is started and stopped outside of
@@ -23,9 +21,6 @@
 
 using std::string;
 
-enum { warmup_secs = 1 };
-enum { duration = 5 };
-
 const char *message =
   "Received: from incoming.csail.mit.edu (incoming.csail.mit.edu [128.30.2.16])\n"
   "        by metroplex (Cyrus v2.2.13-Debian-2.2.13-14+lenny5) with LMTPA;\n"
@@ -65,27 +60,6 @@ const char *message =
 
 extern char **environ;
 
-static spin_barrier bar;
-
-static concurrent_distribution<uint64_t> start_tsc, stop_tsc;
-static concurrent_distribution<uint64_t> start_usec, stop_usec;
-static concurrent_distribution<uint64_t> count;
-
-static volatile bool stop __mpalign__;
-static volatile bool warmup;
-static __padout__ __attribute__((unused));
-
-static void
-timer_thread(void)
-{
-  warmup = true;
-  bar.join();
-  sleep(warmup_secs);
-  warmup = false;
-  sleep(duration);
-  stop = true;
-}
-
 static void
 xwaitpid(int pid, const char *cmd)
 {
@@ -96,57 +70,6 @@ xwaitpid(int pid, const char *cmd)
     die("status %d from %s", status, cmd);
 }
 
-static void
-do_mua(int cpu, string spooldir, string msgpath)
-{
-  const char *argv[] = {"./mail-enqueue", spooldir.c_str(), "user", nullptr};
-#if defined(XV6_USER)
-  int errno;
-#endif
-  setaffinity(cpu);
-
-  // Open message file (alternatively, we could use an open spawn
-  // action)
-  int msgfd = open(msgpath.c_str(), O_RDONLY|O_CLOEXEC|O_ANYFD);
-  if (msgfd < 0)
-    edie("open %s failed", msgpath.c_str());
-
-  bar.join();
-
-  bool mywarmup = true;
-  uint64_t mycount = 0;
-  while (!stop) {
-    if (__builtin_expect(warmup != mywarmup, 0)) {
-      mywarmup = warmup;
-      mycount = 0;
-      start_usec.add(now_usec());
-      start_tsc.add(rdtsc());
-    }
-
-    if (lseek(msgfd, 0, SEEK_SET) < 0)
-      edie("lseek failed");
-
-    pid_t pid;
-    posix_spawn_file_actions_t actions;
-    if ((errno = posix_spawn_file_actions_init(&actions)))
-      edie("posix_spawn_file_actions_init failed");
-    if ((errno = posix_spawn_file_actions_adddup2(&actions, msgfd, 0)))
-      edie("posix_spawn_file_actions_adddup2 failed");
-    if ((errno = posix_spawn(&pid, argv[0], &actions, nullptr,
-                             const_cast<char *const*>(argv), environ)))
-      edie("posix_spawn failed");
-    if ((errno = posix_spawn_file_actions_destroy(&actions)))
-      edie("posix_spawn_file_actions_destroy failed");
-    xwaitpid(pid, argv[0]);
-
-    ++mycount;
-  }
-
-  stop_usec.add(now_usec());
-  stop_tsc.add(rdtsc());
-  count.add(mycount);
-}
-
 static void
 xmkdir(const string &d)
 {
@@ -172,23 +95,128 @@ create_maildir(const string &base)
   xmkdir(base + "/cur");
 }
 
+struct worker_state
+{
+  int msgfd;
+  __padout__;
+};
+
+// Each operation delivers one message through mail-enqueue, which
+// hands it to a mail-qman with one delivery thread per core.
+class mailbench : public bench::benchmark
+{
+  const char *alt_str_;
+  string spooldir_, mailroot_, msgpath_;
+  pid_t qman_pid_;
+  int ncores_;
+  worker_state *workers_;
+
+public:
+  mailbench(const char *alt_str, const string &basedir)
+    : alt_str_(alt_str), spooldir_(basedir + "/spool"),
+      mailroot_(basedir + "/mail"), msgpath_(basedir + "/msg"),
+      qman_pid_(-1), ncores_(0), workers_(nullptr) { }
+
+  void
+  setup(int ncores) override
+  {
+    ncores_ = ncores;
+    workers_ = bench::new_array<worker_state>(ncores);
+
+    if (START_QMAN) {
+      // Start queue manager
+      char nthreads_str[16];
+      snprintf(nthreads_str, sizeof(nthreads_str), "%d", ncores);
+      const char *qman[] = {"./mail-qman", "-a", alt_str_,
+                            spooldir_.c_str(), mailroot_.c_str(),
+                            nthreads_str, nullptr};
+      if (posix_spawn(&qman_pid_, qman[0], nullptr, nullptr,
+                      const_cast<char *const*>(qman), environ) != 0)
+        die("posix_spawn %s failed", qman[0]);
+      sleep(1);
+    }
+  }
+
+  void
+  thread_setup(int id) override
+  {
+    // Open message file (alternatively, we could use an open spawn
+    // action)
+    workers_[id].msgfd = open(msgpath_.c_str(), O_RDONLY|O_CLOEXEC|O_ANYFD);
+    if (workers_[id].msgfd < 0)
+      edie("open %s failed", msgpath_.c_str());
+  }
+
+  void
+  op(int id) override
+  {
+    const char *argv[] = {"./mail-enqueue", spooldir_.c_str(), "user", nullptr};
+#if defined(XV6_USER)
+    int errno;
+#endif
+
+    if (lseek(workers_[id].msgfd, 0, SEEK_SET) < 0)
+      edie("lseek failed");
+
+    pid_t pid;
+    posix_spawn_file_actions_t actions;
+    if ((errno = posix_spawn_file_actions_init(&actions)))
+      edie("posix_spawn_file_actions_init failed");
+    if ((errno = posix_spawn_file_actions_adddup2(&actions,
+                                                  workers_[id].msgfd, 0)))
+      edie("posix_spawn_file_actions_adddup2 failed");
+    if ((errno = posix_spawn(&pid, argv[0], &actions, nullptr,
+                             const_cast<char *const*>(argv), environ)))
+      edie("posix_spawn failed");
+    if ((errno = posix_spawn_file_actions_destroy(&actions)))
+      edie("posix_spawn_file_actions_destroy failed");
+    xwaitpid(pid, argv[0]);
+  }
+
+  void
+  teardown() override
+  {
+    for (int i = 0; i < ncores_; i++)
+      close(workers_[i].msgfd);
+    bench::delete_array(workers_, ncores_);
+
+    if (START_QMAN) {
+      // Kill qman and wait for it to exit
+      const char *enq[] = {"./mail-enqueue", "--exit", spooldir_.c_str(),
+                           nullptr};
+      pid_t enq_pid;
+      if (posix_spawn(&enq_pid, enq[0], nullptr, nullptr,
+                      const_cast<char *const*>(enq), environ) != 0)
+        die("posix_spawn %s failed", enq[0]);
+      xwaitpid(enq_pid, "mail-enqueue --exit");
+      xwaitpid(qman_pid_, "mail-qman");
+    }
+  }
+};
+
 void
 usage(const char *argv0)
 {
-  fprintf(stderr, "Usage: %s [options] basedir nthreads\n", argv0);
-  fprintf(stderr, "  -a none   Use regular APIs (default)\n");
-  fprintf(stderr, "     all    Use alternate APIs\n");
+  fprintf(stderr, "Usage: %s [options] basedir [nthreads]\n", argv0);
+  bench::config::usage();
+  fprintf(stderr, "  -a none       Use regular APIs (default)\n");
+  fprintf(stderr, "     all        Use alternate APIs\n");
   exit(2);
 }
 
 int
 main(int argc, char **argv)
 {
-  const char *alt_str = "false";
+  bench::config cfg("mailbench");
+  const char *alt_str = "none";
   int opt;
-  while ((opt = getopt(argc, argv, "a:")) != -1) {
+  while ((opt = getopt(argc, argv, BENCH_OPTS "a:")) != -1) {
+    if (cfg.option(opt, optarg))
+      continue;
     switch (opt) {
     case 'a':
+      if (strcmp(optarg, "none") != 0 && strcmp(optarg, "all") != 0)
+        usage(argv[0]);
       alt_str = optarg;
       break;
     default:
@@ -196,37 +224,23 @@ main(int argc, char **argv)
     }
   }
 
-  if (argc - optind != 2)
+  if (argc - optind < 1 || argc - optind > 2)
     usage(argv[0]);
+  if (argc - optind == 2 && !cfg.set_cores(argv[optind+1]))
+    usage(argv[0]);
+  cfg.add_param("alt", alt_str);
 
   string basedir(argv[optind]);
-  const char *nthreads_str = argv[optind+1];
-  int nthreads = atoi(nthreads_str);
-  if (nthreads <= 0)
-    usage(argv[0]);
 
-  // Create spool and inboxes
+  // Create spool and inboxes.  Every run in the sweep shares them.
   // XXX This terminology is wrong.  The spool is where mail
   // ultimately gets delivered to.
-  string spooldir = basedir + "/spool";
   if (START_QMAN)
-    create_spool(spooldir);
+    create_spool(basedir + "/spool");
   string mailroot = basedir + "/mail";
   xmkdir(mailroot);
   create_maildir(mailroot + "/user");
 
-  pid_t qman_pid;
-  if (START_QMAN) {
-    // Start queue manager
-    const char *qman[] = {"./mail-qman", "-a", alt_str,
-                          spooldir.c_str(), mailroot.c_str(),
-                          nthreads_str, nullptr};
-    if (posix_spawn(&qman_pid, qman[0], nullptr, nullptr,
-                    const_cast<char *const*>(qman), environ) != 0)
-      die("posix_spawn %s failed", qman[0]);
-    sleep(1);
-  }
-
   // Write message to a file
   int fd = open((basedir + "/msg").c_str(), O_CREAT|O_WRONLY, 0666);
   if (fd < 0)
@@ -234,47 +248,7 @@ main(int argc, char **argv)
   xwrite(fd, message, strlen(message));
   close(fd);
 
-  printf("# --cores=%d --duration=%ds --alt=%s\n", nthreads, duration, alt_str);
-
-  // Run benchmark
-  bar.init(nthreads + 1);
-
-  std::thread timer(timer_thread);
-
-  std::thread *threads = new std::thread[nthreads];
-  for (int i = 0; i < nthreads; ++i)
-    threads[i] = std::thread(do_mua, i, basedir + "/spool", basedir + "/msg");
-
-  // Wait
-  timer.join();
-  for (int i = 0; i < nthreads; ++i)
-    threads[i].join();
-
-  if (START_QMAN) {
-    // Kill qman and wait for it to exit
-    const char *enq[] = {"./mail-enqueue", "--exit", spooldir.c_str(), nullptr};
-    pid_t enq_pid;
-    if (posix_spawn(&enq_pid, enq[0], nullptr, nullptr,
-                    const_cast<char *const*>(enq), environ) != 0)
-      die("posix_spawn %s failed", enq[0]);
-    xwaitpid(enq_pid, "mail-enqueue --exit");
-    xwaitpid(qman_pid, "mail-qman");
-  }
-
-  // Summarize
-  printf("%lu start usec skew\n", start_usec.span());
-  printf("%lu stop usec skew\n", stop_usec.span());
-  uint64_t usec = stop_usec.mean() - start_usec.mean();
-  printf("%f secs\n", (double)usec / 1e6);
-  printf("%lu cycles\n", stop_tsc.mean() - start_tsc.mean());
-
-  uint64_t messages = count.sum();
-  printf("%lu messages\n", messages);
-  if (messages) {
-    printf("%lu cycles/message\n",
-           (stop_tsc.sum() - start_tsc.sum()) / messages);
-    printf("%lu messages/sec\n", messages * 1000000 / usec);
-  }
-
-  printf("\n");
+  mailbench b(alt_str, basedir);
+  bench::run(cfg, &b);
+  return 0;
 }
@@ -1,41 +1,37 @@
+// Benchmark mmap, page faults, and munmap under different sharing
+// patterns:
+//   local         Each worker maps, faults, and unmaps its own region
+//   pipeline      Each worker maps and faults a region that the next
+//                 worker faults and unmaps
+//   global        Workers map parts of one shared region and fault
+//                 random pages of all of it
+//   global-fixed  Like global, but the region has a fixed total size
+//                 and each round unmaps it
+//
 // To build on Linux:
 //  make HW=linux
 
 #include <atomic>
-#include <fcntl.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/mman.h>
-#include <sys/types.h>
 
 #include "libutil.h"
 #include "amd64.h"
 #include "rnd.hh"
 #include "xsys.h"
+#include "bench.hh"
 
-#if !defined(XV6_USER)
-#include <pthread.h>
-#include <sys/wait.h>
-#else
+#if defined(XV6_USER)
 #include "types.h"
 #include "user.h"
-#include "pthread.h"
-#include "bits.hh"
-#include "kstats.hh"
-#include <xv6/perf.h>
 #endif
 
 #define PGSIZE 4096
 
-#define XSTR(x) #x
-#define STR(x) XSTR(x)
-
-enum { verbose = 0 };
-enum { warmup_secs = 1 };
-enum { duration = 5 };
 enum { fault = 1 };
 
 enum class bench_mode
@@ -43,53 +39,8 @@ enum class bench_mode
   LOCAL, PIPELINE, GLOBAL, GLOBAL_FIXED
 };
 
-// XXX(Austin) Do this right.  Put these in a proper PMC library.
-#if defined(HW_tom)
-#define PERF_amd
-#elif defined(HW_josmp) || defined(HW_ben)
-#define PERF_intel
-#endif
-
-// PMCs
-enum {
-  pmc_llc_misses = 0x2e|(0x41<<8),
-  pmc_instruction_retired = 0xc0,
-
-#if defined(PERF_intel)
-  pmc_l2_cache_misses = 0x24|(0xAA<<8), // L2_RQSTS.MISS
-  pmc_l2_prefetch_misses = 0x24|(0x80<<8), // L2_RQSTS.PREFETCH_MISS
-  pmc_mem_load_retired_other_core_l2_hit_hitm = 0xcb|(0x08<<8),
-  pmc_mem_load_retired_l3_miss = 0xcb|(0x10<<8),
-
-  pmc_cache_lock_cycles_l1d_l2 = 0x63|(0x01<<8),
-  pmc_resource_stalls_any = 0xa2|(0x01<<8),
-  pmc_offcore_requests_sq_full = 0xb2|(0x01<<8),
-  pmc_machine_clears_cycles = 0xc3|(0x01<<8),
-  pmc_rat_stalls_any = 0xd2|(0x0f<<8),
-  pmc_rat_stalls_scoreboard = 0xd2|(0x08<<8),
-  pmc_sq_full_stall_cycles  = 0xf6|(0x01<<8),
-
-#elif defined(PERF_amd)
-  pmc_l2_cache_misses = 0x7e|((0x2|0x8)<<8),
-#endif
-};
-
-#if defined(XV6_USER) && !defined(HW_qemu)
-#define RECORD_PMC pmc_llc_misses
-#define PMCNO 0
-#endif
-
 char * const base = (char*)0x100000000UL;
 
-static int nthread, npg;
-static bench_mode mode;
-
-static pthread_barrier_t bar;
-
-static volatile bool stop __mpalign__;
-static volatile bool warmup;
-static __padout__ __attribute__((unused));
-
 // For PIPELINE mode
 static struct
 {
@@ -102,6 +53,8 @@ static struct
 {
   std::atomic<uint64_t> round __mpalign__;
   std::atomic<uint64_t> left __mpalign__;
+  std::atomic<bool> stop __mpalign__;
+  int nthread;
   __padout__;
 
   void wait()
@@ -117,12 +70,6 @@ static struct
   }
 } gbarrier;
 
-static uint64_t start_tscs[NCPU], stop_tscs[NCPU], iters[NCPU], pages[NCPU];
-static std::atomic<uint64_t> total_underflows;
-#ifdef RECORD_PMC
-static uint64_t pmcs[NCPU];
-#endif
-
 #if defined(XV6_USER) && defined(HW_ben)
 int get_cpu_order(int thread)
 {
@@ -154,396 +101,299 @@ int get_cpu_order(int thread)
 }
 #endif
 
-void*
-timer_thread(void *)
+struct worker_state
 {
-  warmup = true;
-  pthread_barrier_wait(&bar);
-  sleep(warmup_secs);
-  warmup = false;
-  sleep(duration);
-  stop = true;
-  return NULL;
-}
+  uint64_t round;
+  // Over the whole run, including warmup, for pages_per_op
+  uint64_t ops, pages;
+  __padout__;
+};
 
-#ifndef XV6_USER
-struct kstats
+class mapbench : public bench::benchmark
 {
-  kstats operator-(const kstats &o) {
-    return kstats{};
+  bench_mode mode_;
+  int npg_, nthread_;
+  worker_state *workers_;
+  uint64_t ops_, pages_, pt_pages_;
+
+  static void
+  map(volatile char *p, size_t len, int id)
+  {
+    if (mmap((void *) p, len, PROT_READ|PROT_WRITE,
+             MAP_PRIVATE|MAP_FIXED|MAP_ANONYMOUS, -1, 0) == MAP_FAILED)
+      die("%d: map failed", id);
   }
-};
-#endif
 
-static void
-read_kstats(kstats *out)
-{
-#ifdef XV6_USER
-  int fd = open("/dev/kstats", O_RDONLY);
-  if (fd < 0)
-    die("Couldn't open /dev/kstats");
-  int r = xread(fd, out, sizeof *out);
-  if (r != sizeof *out)
-    die("Short read from /dev/kstats");
-  close(fd);
-#endif
-}
+  static void
+  unmap(volatile char *p, size_t len, int id)
+  {
+    if (munmap((void *) p, len) < 0)
+      die("%d: unmap failed\n", id);
+  }
 
-void*
-thr(void *arg)
-{
-  const int cpu = (uintptr_t)arg;
+  void
+  touch(volatile char *p)
+  {
+    if (fault)
+      for (int j = 0; j < npg_ * PGSIZE; j += PGSIZE)
+        p[j] = '\0';
+  }
 
-  if (setaffinity(get_cpu_order(cpu)) < 0)
-    die("setaffinity err");
+  // Fault in random pages of the first npg pages at base, returning
+  // how many distinct pages were touched.
+  static uint64_t
+  touch_random(int npg)
+  {
+    uint64_t touched[npg / 64 + 1];
+    uint64_t n = 0;
+    memset(touched, 0, sizeof(touched));
+    for (int i = 0; i < npg; ++i) {
+      size_t pg = rnd() % npg;
+      if (!(touched[pg / 64] & (1ull << (pg % 64)))) {
+        base[PGSIZE * pg] = '\0';
+        touched[pg / 64] |= 1ull << (pg % 64);
+        ++n;
+      }
+    }
+    return n;
+  }
 
-  bool mywarmup = true;
-  uint64_t tsc1 = 0;
-  uint64_t myiters = 0, mypages = 0, myunderflows = 0;
-#ifdef RECORD_PMC
-  uint64_t pmc1 = 0;
-# define CHECK_STAGE_PMC() pmc1 = rdpmc(PMCNO)
-#else
-# define CHECK_STAGE_PMC()
-#endif
-#define CHECK_STAGE()                                   \
-  if (__builtin_expect(mywarmup, 0) && !warmup) {       \
-    mywarmup = false;                                   \
-    myiters = mypages = myunderflows = 0;               \
-    tsc1 = rdtsc();                                     \
-    CHECK_STAGE_PMC();                                  \
+  // The region worker id's part of the global-fixed table covers
+  volatile char *
+  fixed_start(int id)
+  {
+    return base + (id * npg_ / nthread_) * PGSIZE;
   }
 
-  pthread_barrier_wait(&bar);
+  volatile char *
+  fixed_end(int id)
+  {
+    if (id == nthread_ - 1)
+      return base + npg_ * PGSIZE;
+    return fixed_start(id + 1);
+  }
 
-  switch (mode) {
-  case bench_mode::LOCAL:
-    while (!stop) {
-      CHECK_STAGE();
-      volatile char *p = base + cpu * npg * 0x100000;
-      if (mmap((void *) p, npg * PGSIZE, PROT_READ|PROT_WRITE,
-               MAP_PRIVATE|MAP_FIXED|MAP_ANONYMOUS, -1, 0) == MAP_FAILED)
-        die("%d: map failed", cpu);
+public:
+  mapbench(bench_mode mode, int npg)
+    : mode_(mode), npg_(npg), nthread_(0), workers_(nullptr),
+      ops_(0), pages_(0), pt_pages_(0) { }
 
-      if (fault)
-        for (int j = 0; j < npg * PGSIZE; j += PGSIZE)
-          p[j] = '\0';
+  void
+  setup(int ncores) override
+  {
+    nthread_ = ncores;
+    workers_ = bench::new_array<worker_state>(ncores);
+    for (int i = 0; i < ncores; i++)
+      channels[i].round = 0;
+    gbarrier.round = 0;
+    gbarrier.left = ncores;
+    gbarrier.stop = false;
+    gbarrier.nthread = ncores;
+  }
 
-      if (munmap((void *) p, npg * PGSIZE) < 0)
-        die("%d: unmap failed\n", cpu);
+  void
+  thread_setup(int id) override
+  {
+    if (setaffinity(get_cpu_order(id)) < 0)
+      die("setaffinity err");
+  }
 
-      ++myiters;
+  void
+  op(int id) override
+  {
+    worker_state &w = workers_[id];
+
+    switch (mode_) {
+    case bench_mode::LOCAL: {
+      volatile char *p = base + id * npg_ * 0x100000;
+      map(p, npg_ * PGSIZE, id);
+      touch(p);
+      unmap(p, npg_ * PGSIZE, id);
+      w.pages += npg_;
+      break;
     }
-    mypages = myiters * npg;
-    break;
-
-  case bench_mode::PIPELINE: {
-    const uintptr_t sibling = (cpu + 1) % nthread;
-    uint64_t myround = 0;
-    while (!stop) {
-      CHECK_STAGE();
-      volatile char *p = (base +
-                          cpu * NCPU *       0x10000000ull +
-                          (myround % NCPU) * 0x100000ull);
-      if (mmap((void *) p, npg * PGSIZE, PROT_READ|PROT_WRITE,
-               MAP_PRIVATE|MAP_FIXED|MAP_ANONYMOUS, -1, 0) == MAP_FAILED)
-        die("%d: map failed", cpu);
 
-      if (fault)
-        for (int j = 0; j < npg * PGSIZE; j += PGSIZE)
-          p[j] = '\0';
+    case bench_mode::PIPELINE: {
+      const int sibling = (id + 1) % nthread_;
+      volatile char *p = (base +
+                          id * NCPU *          0x10000000ull +
+                          (w.round % NCPU) * 0x100000ull);
+      map(p, npg_ * PGSIZE, id);
+      touch(p);
 
       // Indicate that my mapping is ready
-      channels[cpu].round = ++myround;
+      channels[id].round = ++w.round;
 
       // Wait for sibling to finish its mapping
-      while (channels[sibling].round < myround && !stop)
+      while (channels[sibling].round < w.round && !gbarrier.stop)
         ;
-      if (stop)
-        break;
+      if (gbarrier.stop)
+        return;
 
       // Access and unmap the mapping from our sibling
       p = (base +
-           sibling * NCPU *   0x10000000 +
-           ((myround-1) % NCPU) * 0x100000);
-
-      if (fault)
-        for (int j = 0; j < npg * PGSIZE; j += PGSIZE)
-          p[j] = '\0';
-
-      if (munmap((void *) p, npg * PGSIZE) < 0)
-        die("%d: unmap failed\n", cpu);
-
-      ++myiters;
+           sibling * NCPU *       0x10000000ull +
+           ((w.round-1) % NCPU) * 0x100000ull);
+      touch(p);
+      unmap(p, npg_ * PGSIZE, id);
+      w.pages += npg_ * 2;
+      break;
     }
-    mypages = myiters * npg * 2;
-    break;
-  }
-
-  case bench_mode::GLOBAL: {
-    while (!stop) {
-      CHECK_STAGE();
 
+    case bench_mode::GLOBAL: {
       // Map my part of the "hash table".  After the first iteration,
       // this will also clear the old mapping.
-      volatile char *p = (base + cpu * npg * PGSIZE);
-      if (mmap((void *) p, npg * PGSIZE, PROT_READ|PROT_WRITE,
-               MAP_PRIVATE|MAP_FIXED|MAP_ANONYMOUS, -1, 0) == MAP_FAILED)
-        die("%d: map failed", cpu);
+      map(base + id * npg_ * PGSIZE, npg_ * PGSIZE, id);
 
       // Wait for all cores to finish mapping the "hash table".
       gbarrier.wait();
-      if (stop)
-        break;
-
-      // Fault in random pages
-      uint64_t touched[nthread * npg / 64 + 1];
-      memset(touched, 0, sizeof(touched));
-      for (int i = 0; i < nthread * npg; ++i) {
-        size_t pg = rnd() % (nthread * npg);
-        if (!(touched[pg / 64] & (1ull << (pg % 64)))) {
-          base[PGSIZE * pg] = '\0';
-          touched[pg / 64] |= 1ull << (pg % 64);
-          ++mypages;
-        }
-      }
+      if (gbarrier.stop)
+        return;
+
+      w.pages += touch_random(nthread_ * npg_);
 
       // Wait for all cores to finish faulting
       gbarrier.wait();
-
-      ++myiters;
+      break;
     }
-    break;
-  }
-
-  case bench_mode::GLOBAL_FIXED: {
-    volatile char *p = (base + (cpu * npg / nthread) * PGSIZE);
-    volatile char *p2 = (base + ((cpu + 1) * npg / nthread) * PGSIZE);
-    if (cpu == nthread - 1)
-      p2 = base + npg * PGSIZE;
 
-    while (!stop) {
-      CHECK_STAGE();
+    case bench_mode::GLOBAL_FIXED: {
+      volatile char *p = fixed_start(id), *p2 = fixed_end(id);
 
       // Map my part of the "hash table".
-      if (mmap((void *) p, p2 - p, PROT_READ|PROT_WRITE,
-               MAP_PRIVATE|MAP_FIXED|MAP_ANONYMOUS, -1, 0) == MAP_FAILED)
-        die("%d: map failed", cpu);
+      map(p, p2 - p, id);
 
       // Wait for all cores to finish mapping the "hash table".
       gbarrier.wait();
-      if (stop)
-        break;
-
-      // Fault in random pages
-      uint64_t touched[npg / 64 + 1];
-      memset(touched, 0, sizeof(touched));
-      for (int i = 0; i < npg; ++i) {
-        size_t pg = rnd() % npg;
-        if (!(touched[pg / 64] & (1ull << (pg % 64)))) {
-          base[PGSIZE * pg] = '\0';
-          touched[pg / 64] |= 1ull << (pg % 64);
-          ++mypages;
-        }
-      }
+      if (gbarrier.stop)
+        return;
+
+      w.pages += touch_random(npg_);
 
       // Wait for all cores to finish faulting
       gbarrier.wait();
-      if (stop)
-        break;
-
-      // Unmap
-      if (munmap((void *) p, p2 - p) < 0)
-        die("%d: unmap failed\n", cpu);
+      if (gbarrier.stop)
+        return;
 
-      ++myiters;
+      unmap(p, p2 - p, id);
+      break;
+    }
     }
-    break;
+    ++w.ops;
   }
+
+  void
+  stop() override
+  {
+    gbarrier.stop = true;
   }
-  stop_tscs[cpu] = rdtsc();
-  start_tscs[cpu] = tsc1;
-#ifdef RECORD_PMC
-  pmcs[cpu] = rdpmc(PMCNO) - pmc1;
+
+  void
+  teardown() override
+  {
+#if defined(XV6_USER)
+    pt_pages_ = pt_pages();
 #endif
-  iters[cpu] = myiters;
-  pages[cpu] = mypages;
-  total_underflows += myunderflows;
-  return nullptr;
-}
+    ops_ = pages_ = 0;
+    for (int i = 0; i < nthread_; i++) {
+      ops_ += workers_[i].ops;
+      pages_ += workers_[i].pages;
+    }
+    bench::delete_array(workers_, nthread_);
+
+    // Clear what the run left mapped, so it doesn't carry over into
+    // the next one
+    switch (mode_) {
+    case bench_mode::LOCAL:
+      break;
+    case bench_mode::PIPELINE:
+      for (int i = 0; i < nthread_; i++)
+        munmap(base + i * NCPU * 0x10000000ull,
+               NCPU * 0x100000ull + npg_ * PGSIZE);
+      break;
+    case bench_mode::GLOBAL:
+      munmap(base, (size_t)nthread_ * npg_ * PGSIZE);
+      break;
+    case bench_mode::GLOBAL_FIXED:
+      munmap(base, (size_t)npg_ * PGSIZE);
+      break;
+    }
+  }
 
-uint64_t
-summarize_tsc(const char *label, uint64_t tscs[], unsigned count)
-{
-  uint64_t min = tscs[0], max = tscs[0], total = 0;
-  for (unsigned i = 0; i < count; ++i) {
-    if (tscs[i] < min)
-      min = tscs[i];
-    if (tscs[i] > max)
-      max = tscs[i];
-    total += tscs[i];
+  void
+  report() override
+  {
+    printf(",\"pages_per_op\":%f", ops_ ? (double)pages_ / ops_ : 0.0);
+#if defined(XV6_USER)
+    printf(",\"pt_pages\":%lu", pt_pages_);
+#endif
   }
-  printf("%lu cycles %s skew\n", max - min, label);
-  return total/count;
-}
+};
 
-template<class T>
-T
-sum(T v[], unsigned count)
+static void
+usage(const char *argv0)
 {
-  T res{};
-  for (unsigned i = 0; i < count; ++i)
-    res += v[i];
-  return res;
+  fprintf(stderr, "Usage: %s [options] [nthreads]\n", argv0);
+  bench::config::usage();
+  fprintf(stderr,
+          "  -m mode       local, pipeline, global, or global-fixed\n"
+          "                (default local)\n"
+          "  -p npg        Pages per worker, or in total for global-fixed\n"
+          "                (default 1, or 5120 for global-fixed)\n");
+  exit(2);
 }
 
 int
 main(int argc, char **argv)
 {
-  if (argc < 3)
-    die("usage: %s nthreads local|pipeline|global [npg]", argv[0]);
-
-  nthread = atoi(argv[1]);
+  bench::config cfg("mapbench");
+  const char *modename = "local";
+  const char *npgs = nullptr;
+  bench_mode mode;
+
+  int opt;
+  while ((opt = getopt(argc, argv, BENCH_OPTS "m:p:")) != -1) {
+    if (cfg.option(opt, optarg))
+      continue;
+    switch (opt) {
+    case 'm':
+      modename = optarg;
+      break;
+    case 'p':
+      npgs = optarg;
+      if (atoi(npgs) <= 0)
+        usage(argv[0]);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (argc - optind > 1)
+    usage(argv[0]);
+  if (argc - optind == 1 && !cfg.set_cores(argv[optind]))
+    usage(argv[0]);
 
-  if (strcmp(argv[2], "local") == 0)
+  if (strcmp(modename, "local") == 0)
     mode = bench_mode::LOCAL;
-  else if (strcmp(argv[2], "pipeline") == 0)
+  else if (strcmp(modename, "pipeline") == 0)
     mode = bench_mode::PIPELINE;
-  else if (strcmp(argv[2], "global") == 0)
+  else if (strcmp(modename, "global") == 0)
     mode = bench_mode::GLOBAL;
-  else if (strcmp(argv[2], "global-fixed") == 0)
+  else if (strcmp(modename, "global-fixed") == 0)
     mode = bench_mode::GLOBAL_FIXED;
   else
-    die("bad mode argument");
-
-  if (argc >= 4)
-    npg = atoi(argv[3]);
-  else if (mode == bench_mode::GLOBAL_FIXED)
-    npg = 64 * 80;
-  else
-    npg = 1;
-
-  printf("# --cores=%d --duration=%ds --warmup=%ds --mode=%s --fault=%s",
-         nthread, duration, warmup_secs,
-         mode == bench_mode::LOCAL ? "local" :
-         mode == bench_mode::PIPELINE ? "pipeline" :
-         mode == bench_mode::GLOBAL ? "global" :
-         mode == bench_mode::GLOBAL_FIXED ? "global-fixed" : "UNKNOWN",
-         fault ? "true" : "false");
-  if (mode == bench_mode::GLOBAL_FIXED)
-    printf(" --totalpg=%d", npg);
-  else
-    printf(" --npg=%d", npg);
-  printf("\n");
-
-#ifdef RECORD_PMC
-  perf_start(PERF_SEL_USR|PERF_SEL_OS|PERF_SEL_ENABLE|RECORD_PMC, 0);
-#endif
-
-  gbarrier.left = nthread;
-  pthread_barrier_init(&bar, 0, nthread+1);
-
-  pthread_t timer;
-  pthread_create(&timer, NULL, timer_thread, NULL);
-
-  pthread_t* tid = (pthread_t*) malloc(sizeof(*tid)*nthread);
-
-  for(int i = 0; i < nthread; i++) {
-    if (setaffinity(get_cpu_order(i)) < 0)
-      die("setaffinity err");
-    xthread_create(&tid[i], 0, thr, (void*)(uintptr_t) i);
-  }
-  if (setaffinity(get_cpu_order(0)) < 0)
-    die("setaffinity err");
-
-  struct kstats kstats_before, kstats_after;
-  read_kstats(&kstats_before);
-
-  xpthread_join(timer);
-  for(int i = 0; i < nthread; i++)
-    xpthread_join(tid[i]);
-
-  read_kstats(&kstats_after);
-
-#ifdef RECORD_PMC
-  perf_stop();
-#endif
-
-  // Summarize
-  uint64_t start_avg = summarize_tsc("start", start_tscs, nthread);
-  uint64_t stop_avg = summarize_tsc("stop", stop_tscs, nthread);
-  uint64_t iter = sum(iters, nthread);
-
-  printf("%lu cycles\n", stop_avg - start_avg);
-  printf("%lu iterations\n", iter);
-  printf("%lu page touches\n", sum(pages, nthread));
-  if (mode == bench_mode::PIPELINE)
-    printf("%lu underflows\n", total_underflows.load());
-#ifdef RECORD_PMC
-  printf("%lu total %s\n", sum(pmcs, nthread), STR(RECORD_PMC)+4);
-#endif
-
-#ifdef XV6_USER
-  double secs = (double)(stop_avg - start_avg) / cpuhz();
-  printf("%f secs\n", secs);
-  printf("%f iterations/sec\n", iter / secs);
-  printf("%f page touches/sec\n", sum(pages, nthread) / secs);
-
-  struct kstats kstats = kstats_after - kstats_before;
-
-  printf("%lu TLB shootdowns\n", kstats.tlb_shootdown_count);
-  printf("%f TLB shootdowns/page touch\n",
-         (double)kstats.tlb_shootdown_count / sum(pages, nthread));
-  printf("%f TLB shootdowns/iteration\n",
-         (double)kstats.tlb_shootdown_count / iter);
-  if (kstats.tlb_shootdown_count) {
-    printf("%f targets/TLB shootdown\n",
-           (double)kstats.tlb_shootdown_targets / kstats.tlb_shootdown_count);
-    printf("%lu cycles/TLB shootdown\n",
-           kstats.tlb_shootdown_cycles / kstats.tlb_shootdown_count);
-  }
-
-  printf("%lu page faults\n", kstats.page_fault_count);
-  printf("%f page faults/page touch\n",
-         (double)kstats.page_fault_count / sum(pages, nthread));
-  printf("%f page faults/iteration\n",
-         (double)kstats.page_fault_count / iter);
-  if (kstats.page_fault_count)
-    printf("%lu cycles/page fault\n",
-           kstats.page_fault_cycles / kstats.page_fault_count);
-
-  printf("%lu alloc page faults\n", kstats.page_fault_alloc_count);
-  if (kstats.page_fault_alloc_count)
-    printf("%lu cycles/alloc page fault\n",
-           kstats.page_fault_alloc_cycles / kstats.page_fault_alloc_count);
-
-  printf("%lu fill page faults\n", kstats.page_fault_fill_count);
-  if (kstats.page_fault_fill_count)
-    printf("%lu cycles/fill page fault\n",
-           kstats.page_fault_fill_cycles / kstats.page_fault_fill_count);
-
-  printf("%lu mmaps\n", kstats.mmap_count);
-  printf("%f mmaps/page touch\n",
-         (double)kstats.mmap_count / sum(pages, nthread));
-  printf("%f mmaps/iteration\n",
-         (double)kstats.mmap_count / iter);
-  if (kstats.mmap_count)
-    printf("%lu cycles/mmap\n",
-           kstats.mmap_cycles / kstats.mmap_count);
-
-  printf("%lu munmaps\n", kstats.munmap_count);
-  printf("%f munmaps/page touch\n",
-         (double)kstats.munmap_count / sum(pages, nthread));
-  printf("%f munmaps/iteration\n",
-         (double)kstats.munmap_count / iter);
-  if (kstats.munmap_count)
-    printf("%lu cycles/munmap\n",
-           kstats.munmap_cycles / kstats.munmap_count);
-
-  printf("%lu PT pages\n", pt_pages());
-#endif
-
-  printf("%lu cycles/iteration\n",
-         (sum(stop_tscs, nthread) - sum(start_tscs, nthread))/iter);
-  printf("\n");
+    usage(argv[0]);
+
+  if (!npgs)
+    npgs = mode == bench_mode::GLOBAL_FIXED ? "5120" : "1";
+  for (int c : cfg.cores)
+    if (c > NCPU)
+      die("mapbench: at most %d cores", NCPU);
+  cfg.add_param("mode", modename);
+  cfg.add_param("fault", fault ? "true" : "false");
+  cfg.add_param(mode == bench_mode::GLOBAL_FIXED ? "totalpg" : "npg", npgs);
+
+  mapbench b(mode, atoi(npgs));
+  bench::run(cfg, &b);
+  return 0;
 }
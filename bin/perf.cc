@@ -3,6 +3,8 @@
 #include "sampler.h"
 #include "bits.hh"
 #include "pmcdb.hh"
+#include "futex.h"
+#include "pthread.h"
 
 #include <fcntl.h>
 #include <unistd.h>
@@ -16,7 +18,28 @@ conf(int fd, const struct perf_selector &c)
 {
   if (write(fd, &c, sizeof(c)) != sizeof(c))
     die("perf: write failed");
-  close(fd);
+}
+
+static int sampfd, outfd;
+static u64 done;
+
+// Copy samples from /dev/sampler to outfd while the command runs, so
+// the per-CPU rings don't fill up.
+static void*
+drain(void *)
+{
+  char buf[4096];
+  for (;;) {
+    bool last = __atomic_load_n(&done, __ATOMIC_ACQUIRE);
+    int n;
+    while ((n = read(sampfd, buf, sizeof(buf))) > 0)
+      if (write(outfd, buf, n) != n)
+        die("perf: write to output failed");
+    if (last)
+      return nullptr;
+    // Poll every 10 ms, or right away when the command exits
+    futex(&done, FUTEX_WAIT, 0, 10*1000*1000);
+  }
 }
 
 void
@@ -26,7 +49,9 @@ usage(const char *argv0)
   printf("  -e event   Event to sample\n"
          "  -p period  Specify sampling period\n"
          "  -P         Precise sampling\n"
-         "  -l cycles  Sample loads longer than CYCLES\n");
+         "  -l cycles  Sample loads longer than CYCLES\n"
+         "  -d depth   Record DEPTH return addresses per sample\n"
+         "  -o file    Stream samples to FILE while the command runs\n");
 }
 
 int
@@ -34,12 +59,13 @@ main(int ac, char *av[])
 {
   struct perf_selector c{};
   const char *event = "CPU cycle unhalted";
+  const char *out = nullptr;
 
   c.enable = true;
   c.period = 100000;
 
   int opt;
-  while ((opt = getopt(ac, av, "e:p:Pl:")) != -1) {
+  while ((opt = getopt(ac, av, "e:p:Pl:d:o:")) != -1) {
     switch (opt) {
     case 'e':                   // Event name
       event = optarg;
@@ -61,6 +87,14 @@ main(int ac, char *av[])
       if (!c.load_latency)
         die("perf: bad -l argument");
       break;
+    case 'd':                   // Stack trace depth
+      c.trace_depth = atoi(optarg);
+      if (!c.trace_depth || c.trace_depth > NTRACE_MAX)
+        die("perf: bad -d argument");
+      break;
+    case 'o':                   // Output file
+      out = optarg;
+      break;
     default:
       usage(av[0]);
       return -1;
@@ -82,18 +116,37 @@ main(int ac, char *av[])
   if (fd < 0)
     die("perf: open failed");
 
+  pthread_t drainer;
+  if (out) {
+    sampfd = fd;
+    outfd = open(out, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (outfd < 0)
+      die("perf: cannot open %s", out);
+  }
+
   int pid = fork();
   if (pid < 0)
     die("perf: fork failed");
 
   if (pid == 0) {
     conf(fd, c);
+    close(fd);
     execv(av[optind], av+optind);
     die("perf: exec failed");
   }
 
+  if (out && pthread_create(&drainer, nullptr, drain, nullptr) != 0)
+    die("perf: pthread_create failed");
+
   wait(NULL);
   c.enable = false;
   conf(fd, c);
+  if (out) {
+    __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+    futex(&done, FUTEX_WAKE, 1, 0);
+    pthread_join(drainer, nullptr);
+    close(outfd);
+  }
+  close(fd);
   return 0;
 }
@@ -1,7 +1,8 @@
 #include "types.h"
 #include "user.h"
-#include "fs.h"                 // DIRSIZ
+#include "fs.h"
 #include "libutil.h"
+#include "dirit.hh"
 
 #include <fcntl.h>
 #include <unistd.h>
@@ -25,19 +26,14 @@ rmtree(const char *base)
     int fd = open(base, O_RDONLY);
     if (fd < 0)
       edie("rm: failed to open %s", base);
-    char buf[DIRSIZ];
-    char *prev = nullptr;
-    while (true) {
-      int r = readdir(fd, prev, buf);
-      prev = buf;
-      if (r < 0)
-        edie("rm: failed to readdir %s", base);
-      if (r == 0)
-        break;
-      if (strcmp(buf, ".") == 0 || strcmp(buf, "..") == 0)
+    dirit di(fd);
+    while (const struct kdirent *de = di.next()) {
+      if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
         continue;
-      names.push_back(string(base).append("/").append(buf));
+      names.push_back(string(base).append("/").append(de->d_name));
     }
+    if (di.failed())
+      edie("rm: failed to readdir %s", base);
     close(fd);
     // Delete children
     for (auto &name : names)
@@ -1,3 +1,7 @@
+// Benchmark futex wait and wake by ping-ponging a futex between pairs
+// of workers.  Each operation is one round trip, so every worker of a
+// pair completes the same number of operations.
+
 #include "types.h"
 #include "user.h"
 #include "amd64.h"
@@ -5,130 +9,137 @@
 #include "futex.h"
 #include "errno.h"
 #include "mtrace.h"
+#include "libutil.h"
+#include "bench.hh"
 
 #include <atomic>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
-static volatile std::atomic<u64> waiting;
-static volatile std::atomic<u64> waking __attribute__((unused));
-static int iters;
-static int nworkers;
-static volatile int go;
+// Set in a futex word to make both workers of its pair give up
+#define STOPPED (~0ull)
 
 static struct {
-  u64 mem;
+  std::atomic<u64> mem;
   __padout__;
 } ftx[256] __mpalign__;
 
-static
-void* worker0(void* x)
+struct worker_state
 {
-  // Ping pong a futex between a pair of workers
-  u64 id = (u64)x;
-  u64* f = &(ftx[id>>1].mem);
-  long r;
-
-  setaffinity(id);
-
-  while (go == 0)
-    yield();
+  u64 round;
+  __padout__;
+};
 
-  if (id & 0x1) {
-    for (u64 i = 0; i < iters; i++) {
-      r = futex(f, FUTEX_WAIT, (u64)(i<<1), 0);
-      if (r < 0 && r != -EWOULDBLOCK)
-        die("futex: %ld", r);
-      *f = (i<<1)+2;
-      r = futex(f, FUTEX_WAKE, 1, 0);
-      assert(r == 0);
-    }
-  } else {
-    for (u64 i = 0; i < iters; i++) {
-      *f = (i<<1)+1;
-      r = futex(f, FUTEX_WAKE, 1, 0);
-      assert(r == 0);
-      r = futex(f, FUTEX_WAIT, (u64)(i<<1)+1, 0);
+class schedbench : public bench::benchmark
+{
+  int npairs_;
+  worker_state *workers_;
+
+  // Wait until *f is want.  Returns false if the run stopped first.
+  static bool
+  wait_for(std::atomic<u64> *f, u64 want)
+  {
+    for (;;) {
+      u64 v = f->load();
+      if (v == want)
+        return true;
+      if (v == STOPPED)
+        return false;
+      long r = futex((u64*)f, FUTEX_WAIT, v, 0);
       if (r < 0 && r != -EWOULDBLOCK)
         die("futex: %ld", r);
     }
   }
 
-  return nullptr;
-}
-
-static
-void master0(void)
-{
-  go = 1;
-  for (int i = 0; i < nworkers; i++)
-    wait(NULL);
-}
-
-int
-main(int ac, char** av)
-{
-  long r;
-
-  if (ac < 3)
-    die("usage: %s iters nworkers", av[0]);
-
-  iters = atoi(av[1]);
-  nworkers = atoi(av[2]);
-  waiting.store(0);
+  // Advance *f from old to old+1 and wake the other worker of the
+  // pair.  Returns false if the run stopped first.
+  static bool
+  signal(std::atomic<u64> *f, u64 old)
+  {
+    if (!f->compare_exchange_strong(old, old + 1))
+      return false;
+    long r = futex((u64*)f, FUTEX_WAKE, 1, 0);
+    assert(r == 0);
+    return true;
+  }
 
-  for (int i = 0; i < nworkers; i++) {
-    pthread_t th;
+public:
+  schedbench() : npairs_(0), workers_(nullptr) { }
+
+  void
+  setup(int ncores) override
+  {
+    if (ncores % 2)
+      die("schedbench: needs an even number of cores, not %d", ncores);
+    npairs_ = ncores / 2;
+    if (npairs_ > sizeof(ftx) / sizeof(ftx[0]))
+      die("schedbench: too many cores");
+    for (int i = 0; i < npairs_; i++)
+      ftx[i].mem = 0;
+    workers_ = bench::new_array<worker_state>(ncores);
+    mtenable("xv6-schedbench");
+  }
 
-    r = pthread_create(&th, nullptr, worker0, (void*)(u64)i);
-    if (r < 0)
-      die("pthread_create");
+  void
+  op(int id) override
+  {
+    std::atomic<u64> *f = &ftx[id>>1].mem;
+    u64 i = workers_[id].round;
+
+    if (id & 0x1) {
+      if (!wait_for(f, (i<<1)+1) || !signal(f, (i<<1)+1))
+        return;
+    } else {
+      if (!signal(f, i<<1) || !wait_for(f, (i<<1)+2))
+        return;
+    }
+    workers_[id].round = i + 1;
   }
-  nsleep(1000*1000);
-
-  mtenable("xv6-schedbench");
-  u64 t0 = rdtsc();
-  master0();
-  u64 t1 = rdtsc();
-  mtdisable("xv6-schedbench");
-  printf("%lu\n", (t1-t0)/iters);
-}
 
-#if 0
-static volatile u64 ftx;
+  void
+  stop() override
+  {
+    // A worker may be waiting on a partner that has already returned
+    for (int i = 0; i < npairs_; i++) {
+      ftx[i].mem = STOPPED;
+      futex((u64*)&ftx[i].mem, FUTEX_WAKE, 2, 0);
+    }
+  }
 
-static
-void* worker0(void* x)
-{
-  long r;
-  int i;
-
-  for (i = 0; i < iters; i++) {
-    ++waiting;
-    r = futex((u64*)&ftx, FUTEX_WAIT, (u64)i, 0);
-    if (r < 0 && r != -EWOULDBLOCK)
-      die("FUTEX_WAIT: %d", r);
-    while (waking.load() == 1)
-      nop_pause();
+  void
+  teardown() override
+  {
+    mtdisable("xv6-schedbench");
+    bench::delete_array(workers_, npairs_ * 2);
   }
+};
 
-  return nullptr;
+static void
+usage(const char *argv0)
+{
+  fprintf(stderr, "Usage: %s [options] [nthreads]\n", argv0);
+  bench::config::usage();
+  exit(2);
 }
 
-static
-void master0(void)
+int
+main(int argc, char **argv)
 {
-  long r;
-
-  for (int i = 0; i < iters; i++) {
-    while (waiting.load() < (i+1)*nworkers)
-      nop_pause();
-    
-    waking.store(1);
-    ftx = i+1;
-    r = futex((u64*)&ftx, FUTEX_WAKE, nworkers, 0);  
-    assert(r == 0);
-    waking.store(0);
+  bench::config cfg("schedbench");
+  cfg.cores = {2};
+
+  int opt;
+  while ((opt = getopt(argc, argv, BENCH_OPTS)) != -1) {
+    if (!cfg.option(opt, optarg))
+      usage(argv[0]);
   }
+  if (argc - optind > 1)
+    usage(argv[0]);
+  if (argc - optind == 1 && !cfg.set_cores(argv[optind]))
+    usage(argv[0]);
+
+  schedbench b;
+  bench::run(cfg, &b);
+  return 0;
 }
-#endif
@@ -7,6 +7,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <fcntl.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -79,10 +80,11 @@ public:
     cloexec.pop_back();
   }
 
-  static void preexec()
+  static void preexec(posix_spawn_file_actions_t *actions)
   {
     for (int fd : cloexec)
-      close(fd);
+      if (posix_spawn_file_actions_addclose(actions, fd))
+        die("posix_spawn_file_actions_addclose failed");
   }
 };
 vector<int> savefd::cloexec;
@@ -159,12 +161,19 @@ public:
       argstrs.push_back(arg.c_str());
     argstrs.push_back(nullptr);
 
-    // XXX posix_spawn
-    int child;
-    if ((child = fork1()) == 0) {
-      savefd::preexec();
-      execv(argstrs[0], const_cast<char * const *>(argstrs.data()));
-      edie("exec %s failed", argstrs[0]);
+    // Spawn rather than fork and exec, so we never copy our address
+    // space only to throw it away.
+    posix_spawn_file_actions_t actions;
+    if (posix_spawn_file_actions_init(&actions))
+      die("posix_spawn_file_actions_init failed");
+    savefd::preexec(&actions);
+    pid_t child;
+    int err = posix_spawn(&child, argstrs[0], &actions, nullptr,
+                          const_cast<char * const *>(argstrs.data()), nullptr);
+    posix_spawn_file_actions_destroy(&actions);
+    if (err) {
+      fprintf(stderr, "sh: exec %s failed\n", argstrs[0]);
+      return 1;
     }
     int status;
     if (waitpid(child, &status, 0) < 0)
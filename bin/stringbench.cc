@@ -0,0 +1,286 @@
+// Benchmark libu's string and memory routines.
+//
+// Each operation calls one routine on a buffer of the given size,
+// once per size in the sweep.  With -o, the benchmark runs the simple
+// byte-at-a-time versions these routines replaced instead, as a
+// baseline.  For memcmp and strcmp the two buffers are equal, and
+// for memchr and strchr the byte isn't found, so each call scans the
+// whole buffer.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libutil.h"
+#include "bench.hh"
+
+#include <vector>
+
+//
+// Baseline versions
+//
+
+static void*
+old_memmove(void *dst, const void *src, size_t n)
+{
+  const char *s = (const char*)src;
+  char *d = (char*)dst;
+
+  if (s < d && s + n > d) {
+    s += n;
+    d += n;
+    if ((intptr_t)s%4 == 0 && (intptr_t)d%4 == 0 && n%4 == 0)
+      __asm volatile("std; rep movsl\n"
+              :: "D" (d-4), "S" (s-4), "c" (n/4) : "cc", "memory");
+    else
+      __asm volatile("std; rep movsb\n"
+              :: "D" (d-1), "S" (s-1), "c" (n) : "cc", "memory");
+    __asm volatile("cld" ::: "cc");
+  } else {
+    if ((intptr_t)s%4 == 0 && (intptr_t)d%4 == 0 && n%4 == 0)
+      __asm volatile("cld; rep movsl\n"
+              :: "D" (d), "S" (s), "c" (n/4) : "cc", "memory");
+    else
+      __asm volatile("cld; rep movsb\n"
+              :: "D" (d), "S" (s), "c" (n) : "cc", "memory");
+  }
+  return dst;
+}
+
+static int
+old_memcmp(const void* s1, const void* s2, size_t n)
+{
+  const uint8_t* p1 = (const uint8_t*)s1;
+  const uint8_t* p2 = (const uint8_t*)s2;
+  for (size_t i = 0; i < n; i++)
+    if (p1[i] != p2[i])
+      return p1[i] - p2[i];
+  return 0;
+}
+
+static const void*
+old_memchr(const void *s, int c, size_t n)
+{
+  for (size_t i = 0; i < n; ++i)
+    if (((unsigned char*)s)[i] == c)
+      return &((unsigned char*)s)[i];
+  return NULL;
+}
+
+static const char*
+old_strchr(const char *s, int c)
+{
+  for (; *s; s++)
+    if (*s == c)
+      return s;
+  return 0;
+}
+
+static size_t
+old_strlen(const char *s)
+{
+  size_t n;
+
+  for (n = 0; s[n]; n++)
+    ;
+  return n;
+}
+
+static int
+old_strcmp(const char *p, const char *q)
+{
+  while (*p && *p == *q)
+    p++, q++;
+  return (uint8_t)*p - (uint8_t)*q;
+}
+
+enum func { MEMCPY, MEMMOVE, MEMCMP, MEMCHR, STRLEN, STRCHR, STRCMP };
+
+static const char * const func_names[] = {
+  "memcpy", "memmove", "memcmp", "memchr", "strlen", "strchr", "strcmp",
+};
+
+struct worker_state
+{
+  char *a, *b;
+  // Keeps results live
+  uintptr_t sink;
+  __padout__;
+};
+
+class stringbench : public bench::benchmark
+{
+  func func_;
+  bool old_;
+  size_t size_;
+  int ncores_;
+  worker_state *workers_;
+
+public:
+  stringbench(func f, bool old)
+    : func_(f), old_(old), size_(0), ncores_(0), workers_(nullptr) { }
+
+  void set_size(size_t size) { size_ = size; }
+
+  void
+  setup(int ncores) override
+  {
+    ncores_ = ncores;
+    workers_ = bench::new_array<worker_state>(ncores);
+  }
+
+  void
+  thread_setup(int id) override
+  {
+    // Allocate on the worker's own core.  Offset b so copies aren't
+    // mutually aligned, as most real copies aren't.
+    worker_state &w = workers_[id];
+    w.a = (char*)malloc(size_ + 64);
+    w.b = (char*)malloc(size_ + 64) + 3;
+    memset(w.a, 'x', size_);
+    memset(w.b, 'x', size_);
+    if (size_) {
+      w.a[size_ - 1] = 0;
+      w.b[size_ - 1] = 0;
+    }
+    w.sink = 0;
+  }
+
+  void
+  op(int id) override
+  {
+    worker_state &w = workers_[id];
+    uintptr_t r = 0;
+    switch (func_) {
+    case MEMCPY:
+      r = (uintptr_t)(old_ ? old_memmove(w.b, w.a, size_) :
+                      memcpy(w.b, w.a, size_));
+      break;
+    case MEMMOVE:
+      // Overlapping, so the copy runs backward
+      r = (uintptr_t)(old_ ? old_memmove(w.a + 1, w.a, size_ - 1) :
+                      memmove(w.a + 1, w.a, size_ - 1));
+      break;
+    case MEMCMP:
+      r = old_ ? old_memcmp(w.a, w.b, size_) : memcmp(w.a, w.b, size_);
+      break;
+    case MEMCHR:
+      r = (uintptr_t)(old_ ? old_memchr(w.a, 'y', size_) :
+                      memchr(w.a, 'y', size_));
+      break;
+    case STRLEN:
+      r = old_ ? old_strlen(w.a) : strlen(w.a);
+      break;
+    case STRCHR:
+      r = (uintptr_t)(old_ ? old_strchr(w.a, 'y') : strchr(w.a, 'y'));
+      break;
+    case STRCMP:
+      r = old_ ? old_strcmp(w.a, w.b) : strcmp(w.a, w.b);
+      break;
+    }
+    w.sink += r;
+  }
+
+  void
+  teardown() override
+  {
+    for (int i = 0; i < ncores_; i++) {
+      free(workers_[i].a);
+      free(workers_[i].b - 3);
+    }
+    bench::delete_array(workers_, ncores_);
+  }
+};
+
+// Parse a size with an optional K or M suffix, or return 0.
+static size_t
+parse_size(const char *s, const char **end)
+{
+  char *e;
+  size_t n = strtol(s, &e, 10);
+  if (e == s)
+    return 0;
+  if (*e == 'K' || *e == 'k')
+    n <<= 10, e++;
+  else if (*e == 'M' || *e == 'm')
+    n <<= 20, e++;
+  *end = e;
+  return n;
+}
+
+static void
+usage(const char *argv0)
+{
+  fprintf(stderr, "Usage: %s [options]\n", argv0);
+  bench::config::usage();
+  fprintf(stderr,
+          "  -f func       memcpy, memmove, memcmp, memchr, strlen, strchr,\n"
+          "                or strcmp (default memcpy)\n"
+          "  -s sizes      Buffer sizes to sweep (default 8,64,512,4K,32K,"
+          "256K,1M)\n"
+          "  -o            Run the old byte-at-a-time versions\n");
+  exit(2);
+}
+
+int
+main(int argc, char **argv)
+{
+  bench::config cfg("stringbench");
+  const char *fname = "memcpy", *sizes = "8,64,512,4K,32K,256K,1M";
+  bool old = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, BENCH_OPTS "f:s:o")) != -1) {
+    if (cfg.option(opt, optarg))
+      continue;
+    switch (opt) {
+    case 'f':
+      fname = optarg;
+      break;
+    case 's':
+      sizes = optarg;
+      break;
+    case 'o':
+      old = true;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (optind != argc)
+    usage(argv[0]);
+
+  int f;
+  for (f = 0; f <= STRCMP; f++)
+    if (strcmp(fname, func_names[f]) == 0)
+      break;
+  if (f > STRCMP)
+    usage(argv[0]);
+
+  std::vector<size_t> sizelist;
+  for (const char *p = sizes; *p; ) {
+    size_t n = parse_size(p, &p);
+    if (n < 2)
+      usage(argv[0]);
+    sizelist.push_back(n);
+    if (*p == ',')
+      p++;
+    else if (*p)
+      usage(argv[0]);
+  }
+
+  cfg.add_param("func", fname);
+  cfg.add_param("impl", old ? "old" : "new");
+  cfg.add_param("size", nullptr);
+
+  stringbench b((func)f, old);
+  for (size_t size : sizelist) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lu", size);
+    cfg.params.back().value = buf;
+    b.set_size(size);
+    bench::run(cfg, &b);
+  }
+  return 0;
+}
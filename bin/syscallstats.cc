@@ -0,0 +1,149 @@
+// Report system call rates and latencies from /dev/syscallstats.
+//
+//   syscallstats [-n top] [-s secs | command...]
+//
+// With a command, report the system calls made while it runs;
+// otherwise report those made over the next secs seconds (default 1).
+// Calls are counted system-wide either way.  Latencies are in cycles,
+// from dispatch to return, so they include time spent blocked.
+
+#include "types.h"
+#include "user.h"
+#include "uk/syscallstats.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+static std::vector<syscallstats_rec>
+snapshot(void)
+{
+  int fd = open("/dev/syscallstats", O_RDONLY);
+  if (fd < 0)
+    die("syscallstats: open failed");
+
+  std::vector<syscallstats_rec> recs;
+  struct syscallstats_rec r;
+  int n;
+  while ((n = read(fd, &r, sizeof(r))) == sizeof(r))
+    recs.push_back(r);
+  if (n < 0)
+    die("syscallstats: read failed");
+  close(fd);
+  return recs;
+}
+
+// Subtract the matching record in before from each record in after.
+static std::vector<syscallstats_rec>
+delta(const std::vector<syscallstats_rec> &before,
+      std::vector<syscallstats_rec> after)
+{
+  std::vector<syscallstats_rec> res;
+  for (auto &a : after) {
+    for (auto &b : before) {
+      if (b.num != a.num)
+        continue;
+      a.count -= b.count;
+      a.errors -= b.errors;
+      a.cycles -= b.cycles;
+      for (int i = 0; i < SYSCALLSTATS_BUCKETS; i++)
+        a.hist[i] -= b.hist[i];
+      break;
+    }
+    if (a.count)
+      res.push_back(a);
+  }
+  return res;
+}
+
+// Return the upper bound of the bucket holding the p'th percentile.
+static u64
+percentile(const u64 *hist, double p)
+{
+  u64 total = 0;
+  for (int i = 0; i < SYSCALLSTATS_BUCKETS; i++)
+    total += hist[i];
+  if (!total)
+    return 0;
+  u64 want = total * p, sum = 0;
+  for (int i = 0; i < SYSCALLSTATS_BUCKETS; i++) {
+    sum += hist[i];
+    if (sum > want)
+      return 2ull << i;
+  }
+  return 2ull << (SYSCALLSTATS_BUCKETS - 1);
+}
+
+static void
+report(std::vector<syscallstats_rec> recs, u64 nsec, size_t top)
+{
+  if (recs.empty()) {
+    printf("no system calls\n");
+    return;
+  }
+  std::sort(recs.begin(), recs.end(),
+            [](const syscallstats_rec &a, const syscallstats_rec &b) {
+              return a.cycles > b.cycles;
+            });
+
+  printf("## %lu ms\n", nsec / 1000000);
+  printf("## syscall calls calls/s errors cycles mean p50 p90 p99\n");
+  for (size_t i = 0; i < recs.size() && i < top; i++) {
+    syscallstats_rec &r = recs[i];
+    printf("%-16s %lu %lu %lu %lu %lu <%lu <%lu <%lu\n",
+           r.name, r.count, nsec ? r.count * 1000000000 / nsec : 0,
+           r.errors, r.cycles, r.cycles / r.count,
+           percentile(r.hist, 0.5), percentile(r.hist, 0.9),
+           percentile(r.hist, 0.99));
+  }
+}
+
+static void
+usage(const char *argv0)
+{
+  die("usage: %s [-n top] [-s secs | command...]", argv0);
+}
+
+int
+main(int argc, char **argv)
+{
+  size_t top = 20;
+  unsigned secs = 1;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+    switch (opt) {
+    case 'n':
+      top = atoi(optarg);
+      break;
+    case 's':
+      secs = atoi(optarg);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  std::vector<syscallstats_rec> before = snapshot();
+  u64 t0 = time_nsec();
+  if (optind < argc) {
+    int pid = fork();
+    if (pid < 0)
+      die("syscallstats: fork failed");
+    if (pid == 0) {
+      execv(argv[optind], argv + optind);
+      die("syscallstats: exec failed");
+    }
+    wait(NULL);
+  } else {
+    sleep(secs);
+  }
+  u64 t1 = time_nsec();
+
+  report(delta(before, snapshot()), t1 - t0, top);
+  return 0;
+}
@@ -25,10 +25,10 @@ main(int argc, char *argv[])
 {
   th(0);
 
-  pthread_t tid;
-  pthread_create(&tid, 0, th, 0);
-  pthread_create(&tid, 0, th, 0);
-  wait(NULL);
-  wait(NULL);
+  pthread_t tid[2];
+  pthread_create(&tid[0], 0, th, 0);
+  pthread_create(&tid[1], 0, th, 0);
+  pthread_join(tid[0], nullptr);
+  pthread_join(tid[1], nullptr);
   exit(0);
 }
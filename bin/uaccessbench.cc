@@ -0,0 +1,193 @@
+// Benchmark the kernel's user-copy routines through system calls that
+// do little besides the copy.
+//
+//   fetch: pwrite to a pipe.  The kernel copies the buffer in, then
+//          fails because pipes don't support pwrite.
+//   put:   pread from a cached file, which copies the buffer out.
+//   path:  unlink a nonexistent path of the given length, which
+//          copies the path in with the string routine and then fails
+//          after one lookup.
+//
+// Run each at several sizes; the growth in cost with size is the cost
+// of the copy.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libutil.h"
+#include "bench.hh"
+
+#include <vector>
+
+enum mode { FETCH, PUT, PATH };
+
+static const char * const mode_names[] = { "fetch", "put", "path" };
+
+struct worker_state
+{
+  char *buf;
+  int fd;
+  __padout__;
+};
+
+class uaccessbench : public bench::benchmark
+{
+  mode mode_;
+  size_t size_;
+  int ncores_;
+  worker_state *workers_;
+  int pipe_[2];
+
+public:
+  uaccessbench(mode m, size_t size)
+    : mode_(m), size_(size), ncores_(0), workers_(nullptr) { }
+
+  void
+  setup(int ncores) override
+  {
+    ncores_ = ncores;
+    workers_ = bench::new_array<worker_state>(ncores);
+    if (mode_ == FETCH && pipe(pipe_) < 0)
+      die("uaccessbench: pipe failed");
+  }
+
+  void
+  thread_setup(int id) override
+  {
+    worker_state &w = workers_[id];
+    w.buf = (char*)malloc(size_ + 1);
+    memset(w.buf, 'x', size_);
+    w.fd = -1;
+    switch (mode_) {
+    case FETCH:
+      w.fd = pipe_[1];
+      break;
+    case PUT: {
+      char name[32];
+      snprintf(name, sizeof(name), "uaccessbench.%d", id);
+      w.fd = open(name, O_CREAT | O_RDWR | O_TRUNC, 0666);
+      if (w.fd < 0)
+        die("uaccessbench: open %s failed", name);
+      if (pwrite(w.fd, w.buf, size_, 0) != size_)
+        die("uaccessbench: write %s failed", name);
+      break;
+    }
+    case PATH:
+      w.buf[0] = '/';
+      w.buf[size_ - 1] = 0;
+      break;
+    }
+  }
+
+  void
+  op(int id) override
+  {
+    worker_state &w = workers_[id];
+    switch (mode_) {
+    case FETCH:
+      if (pwrite(w.fd, w.buf, size_, 0) >= 0)
+        die("uaccessbench: pwrite to a pipe succeeded");
+      break;
+    case PUT:
+      if (pread(w.fd, w.buf, size_, 0) != size_)
+        die("uaccessbench: pread failed");
+      break;
+    case PATH:
+      if (unlink(w.buf) == 0)
+        die("uaccessbench: unlink succeeded");
+      break;
+    }
+  }
+
+  void
+  teardown() override
+  {
+    for (int i = 0; i < ncores_; i++) {
+      if (mode_ == PUT) {
+        char name[32];
+        snprintf(name, sizeof(name), "uaccessbench.%d", i);
+        close(workers_[i].fd);
+        unlink(name);
+      }
+      free(workers_[i].buf);
+    }
+    if (mode_ == FETCH) {
+      close(pipe_[0]);
+      close(pipe_[1]);
+    }
+    bench::delete_array(workers_, ncores_);
+  }
+};
+
+static void
+usage(const char *argv0)
+{
+  fprintf(stderr, "Usage: %s [options]\n", argv0);
+  bench::config::usage();
+  fprintf(stderr,
+          "  -m mode       fetch, put, or path (default fetch)\n"
+          "  -s sizes      Copy sizes to sweep (default 16,256,4096,65536;\n"
+          "                at most 256 for path)\n");
+  exit(2);
+}
+
+int
+main(int argc, char **argv)
+{
+  bench::config cfg("uaccessbench");
+  const char *mname = "fetch", *sizes = "16,256,4096,65536";
+
+  int opt;
+  while ((opt = getopt(argc, argv, BENCH_OPTS "m:s:")) != -1) {
+    if (cfg.option(opt, optarg))
+      continue;
+    switch (opt) {
+    case 'm':
+      mname = optarg;
+      break;
+    case 's':
+      sizes = optarg;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (optind != argc)
+    usage(argv[0]);
+
+  int m;
+  for (m = 0; m <= PATH; m++)
+    if (strcmp(mname, mode_names[m]) == 0)
+      break;
+  if (m > PATH)
+    usage(argv[0]);
+
+  std::vector<size_t> sizelist;
+  for (const char *p = sizes; *p; ) {
+    char *end;
+    size_t n = strtol(p, &end, 10);
+    if (end == p || n < 2 || (m == PATH && n > 256))
+      usage(argv[0]);
+    sizelist.push_back(n);
+    p = end;
+    if (*p == ',')
+      p++;
+    else if (*p)
+      usage(argv[0]);
+  }
+
+  cfg.add_param("mode", mname);
+  cfg.add_param("size", nullptr);
+
+  for (size_t size : sizelist) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lu", size);
+    cfg.params.back().value = buf;
+    uaccessbench b((mode)m, size);
+    bench::run(cfg, &b);
+  }
+  return 0;
+}
@@ -0,0 +1,265 @@
+// Benchmark the ugc collector against concurrent mutators.
+//
+// Each worker owns nlive subtrees hanging off a shared root.  Every
+// operation replaces one of them, chosen at random, with a freshly
+// allocated chain of depth objects, which turns the old chain into
+// garbage.  A collector thread collects every -i milliseconds with
+// -g marker threads.  With -s, collections stop the world instead:
+// workers park between operations while the collector runs, which is
+// what a collector without write barriers requires.
+//
+// Besides the harness's results, each run reports a histogram of
+// collector pauses: the whole collection with -s, or only the
+// handshakes that start and finish marking otherwise.  -L shows the
+// same pauses as the workers see them.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(XV6_USER)
+#include "user.h"
+#endif
+#include "libutil.h"
+#include "xsys.h"
+#include "amd64.h"
+#include "compiler.h"
+#include "bench.hh"
+#include "histogram.hh"
+#include "rnd.hh"
+#include "ugc.hh"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+typedef histogram_log2<uint64_t, (1ull << 40)> cycle_hist;
+
+class node : public gcptr { };
+
+struct worker_state
+{
+  gcptr *slot;
+  std::vector<gcptr_ref*> refs;
+  // Set while in an operation, with -s
+  std::atomic<bool> in_op;
+  __padout__;
+
+  worker_state() : slot(nullptr), in_op(false) { }
+};
+
+class ugcbench : public bench::benchmark
+{
+  int gcthreads_;
+  bool stw_;
+  int interval_ms_;
+  int nlive_, depth_;
+
+  gcptr *root_;
+  int ncores_;
+  worker_state *workers_;
+  std::thread collector_;
+  std::atomic<bool> done_, stop_;
+
+  // Collector results
+  uint64_t collections_, marked_, freed_, steals_;
+  cycle_hist pauses_, collection_cycles_;
+
+  gcptr*
+  make_chain()
+  {
+    gcptr *head = new node();
+    gcptr *p = head;
+    for (int i = 1; i < depth_; i++) {
+      gcptr *c = new node();
+      p->ref(c);
+      p = c;
+    }
+    return head;
+  }
+
+  void
+  collect()
+  {
+    gcstats st;
+    uint64_t t0 = rdtsc();
+    if (stw_) {
+      stop_.store(true);
+      for (int i = 0; i < ncores_; i++)
+        while (workers_[i].in_op.load())
+          nop_pause();
+    }
+    gcollect(root_, gcthreads_, &st);
+    if (stw_)
+      stop_.store(false, std::memory_order_release);
+    uint64_t t1 = rdtsc();
+
+    collections_++;
+    marked_ += st.marked;
+    freed_ += st.freed;
+    steals_ += st.steals;
+    pauses_ += stw_ ? t1 - t0 : st.handshake_cycles;
+    collection_cycles_ += t1 - t0;
+  }
+
+  void
+  collector()
+  {
+    for (;;) {
+      nsleep(interval_ms_ * 1000000ull);
+      if (done_.load(std::memory_order_relaxed))
+        return;
+      collect();
+    }
+  }
+
+  static void
+  print_hist(const char *name, const cycle_hist &h)
+  {
+    printf(",\"%s\":{\"mean\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu"
+           ",\"max\":%lu}", name, h.mean(), h.percentile(0.5),
+           h.percentile(0.9), h.percentile(0.99), h.max());
+  }
+
+public:
+  ugcbench(int gcthreads, bool stw, int interval_ms, int nlive, int depth)
+    : gcthreads_(gcthreads), stw_(stw), interval_ms_(interval_ms),
+      nlive_(nlive), depth_(depth),
+      root_(nullptr), ncores_(0), workers_(nullptr) { }
+
+  void
+  setup(int ncores) override
+  {
+    ncores_ = ncores;
+    root_ = gcptr::new_root();
+    workers_ = bench::new_array<worker_state>(ncores);
+    for (int i = 0; i < ncores; i++) {
+      worker_state &w = workers_[i];
+      w.slot = new node();
+      root_->ref(w.slot);
+      for (int j = 0; j < nlive_; j++)
+        w.refs.push_back(w.slot->ref(make_chain()));
+    }
+
+    collections_ = marked_ = freed_ = steals_ = 0;
+    pauses_ = cycle_hist();
+    collection_cycles_ = cycle_hist();
+    done_ = false;
+    stop_ = false;
+    collector_ = std::thread([this]() { collector(); });
+  }
+
+  void
+  op(int id) override
+  {
+    worker_state &w = workers_[id];
+    if (stw_) {
+      for (;;) {
+        w.in_op.store(true);
+        if (!stop_.load())
+          break;
+        w.in_op.store(false, std::memory_order_release);
+        while (stop_.load(std::memory_order_relaxed))
+          nop_pause();
+      }
+    }
+
+    {
+      // Keep the new chain alive until it's linked in
+      gcpin pin;
+      size_t i = rnd() % w.refs.size();
+      w.slot->uref(w.refs[i]);
+      w.refs[i] = w.slot->ref(make_chain());
+    }
+
+    if (stw_)
+      w.in_op.store(false, std::memory_order_release);
+  }
+
+  void
+  teardown() override
+  {
+    done_ = true;
+    collector_.join();
+    delete root_;
+    // Everything is unreachable now
+    gcptr *empty = gcptr::new_root();
+    gcollect(empty, gcthreads_);
+    delete empty;
+    bench::delete_array(workers_, ncores_);
+  }
+
+  void
+  report() override
+  {
+    printf(",\"gc\":{\"collections\":%lu,\"marked\":%lu,\"freed\":%lu"
+           ",\"steals\":%lu", collections_, marked_, freed_, steals_);
+    if (collections_) {
+      print_hist("pause_cycles", pauses_);
+      print_hist("collection_cycles", collection_cycles_);
+    }
+    printf("}");
+  }
+};
+
+static void
+usage(const char *argv0)
+{
+  fprintf(stderr, "Usage: %s [options]\n", argv0);
+  bench::config::usage();
+  fprintf(stderr,
+          "  -g threads    Marker threads per collection (default 1)\n"
+          "  -s            Stop the world during collections\n"
+          "  -i ms         Time between collections (default 10)\n"
+          "  -k nlive      Live chains per worker (default 1000)\n"
+          "  -D depth      Objects per chain (default 4)\n");
+  exit(2);
+}
+
+int
+main(int argc, char **argv)
+{
+  bench::config cfg("ugcbench");
+  const char *gcthreads = "1", *interval = "10", *nlive = "1000";
+  const char *depth = "4";
+  bool stw = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, BENCH_OPTS "g:si:k:D:")) != -1) {
+    if (cfg.option(opt, optarg))
+      continue;
+    switch (opt) {
+    case 'g':
+      gcthreads = optarg;
+      break;
+    case 's':
+      stw = true;
+      break;
+    case 'i':
+      interval = optarg;
+      break;
+    case 'k':
+      nlive = optarg;
+      break;
+    case 'D':
+      depth = optarg;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (optind != argc || atoi(gcthreads) < 1 || atoi(nlive) < 1 ||
+      atoi(depth) < 1)
+    usage(argv[0]);
+
+  cfg.add_param("gcthreads", gcthreads);
+  cfg.add_param("stw", stw ? "true" : "false");
+  cfg.add_param("interval_ms", interval);
+  cfg.add_param("nlive", nlive);
+  cfg.add_param("depth", depth);
+
+  ugcbench b(atoi(gcthreads), stw, atoi(interval), atoi(nlive), atoi(depth));
+  bench::run(cfg, &b);
+  return 0;
+}
@@ -14,6 +14,10 @@
 #include <setjmp.h>
 #include <unistd.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <poll.h>
 
 #include <utility>
 
@@ -1657,7 +1661,7 @@ ftabletest(void)
     die("open");
 
   pthread_barrier_wait(&ftable_bar);
-  wait(NULL);
+  pthread_join(th, nullptr);
   printf("ftabletest ok\n");
 }
 
@@ -1678,7 +1682,7 @@ thr(void *arg)
     fprintf(stderr, "thr: arg %p getspec %p\n", arg, pthread_getspecific(tkey));
 
   pthread_barrier_wait(&bar1);
-  return 0;
+  return arg;
 }
 
 void
@@ -1690,15 +1694,20 @@ thrtest(void)
   pthread_barrier_init(&bar0, 0, nthread);
   pthread_barrier_init(&bar1, 0, nthread+1);
 
+  pthread_t tid[nthread];
   for(int i = 0; i < nthread; i++) {
-    pthread_t tid;
-    pthread_create(&tid, 0, &thr, (void*) (0xc0ffee00ULL | i));
+    pthread_create(&tid[i], 0, &thr, (void*) (0xc0ffee00ULL | i));
   }
 
   pthread_barrier_wait(&bar1);
 
-  for(int i = 0; i < nthread; i++)
-    wait(NULL);
+  for(int i = 0; i < nthread; i++) {
+    void *ret;
+    if (pthread_join(tid[i], &ret) != 0)
+      die("thrtest: pthread_join");
+    if (ret != (void*) (0xc0ffee00ULL | i))
+      die("thrtest: retval %p", ret);
+  }
 
   printf("thrtest ok\n");
 }
@@ -1844,13 +1853,13 @@ vmconcurrent(void)
 {
   printf("vmconcurrent\n");
 
+  pthread_t tid[nthread];
   for (int i = 0; i < nthread; i++) {
-    pthread_t tid;
-    pthread_create(&tid, 0, &vmconcurrent_thr, (void*)(uintptr_t)i);
+    pthread_create(&tid[i], 0, &vmconcurrent_thr, (void*)(uintptr_t)i);
   }
 
   for(int i = 0; i < nthread; i++)
-    wait(NULL);
+    pthread_join(tid[i], nullptr);
 
   printf("vmconcurrent ok\n");
 }
@@ -1886,13 +1895,13 @@ tlb(void)
 {
   printf("tlb\n");
 
+  pthread_t tid[nthread];
   for (int i = 0; i < nthread; i++) {
-    pthread_t tid;
-    pthread_create(&tid, 0, &tlb_thr, (void*)(uintptr_t)i);
+    pthread_create(&tid[i], 0, &tlb_thr, (void*)(uintptr_t)i);
   }
 
   for(int i = 0; i < nthread; i++)
-    wait(NULL);
+    pthread_join(tid[i], nullptr);
 
   printf("tlb ok\n");
 }
@@ -1924,13 +1933,13 @@ floattest(void)
   printf("floattest\n");
 
   std::atomic<int> success(0);
+  pthread_t tid[nthread];
   for (int i = 0; i < nthread; i++) {
-    pthread_t tid;
-    pthread_create(&tid, 0, &float_thr, (void*)&success);
+    pthread_create(&tid[i], 0, &float_thr, (void*)&success);
   }
 
   for(int i = 0; i < nthread; i++)
-    wait(NULL);
+    pthread_join(tid[i], nullptr);
 
   if (success != nthread)
     die("not all float_thrs succeeded");
@@ -2038,6 +2047,78 @@ cloexec(void)
   printf("cloexec ok\n");
 }
 
+// poll a unix datagram socket that a child sends to after a delay.
+// poll must wake when the datagram arrives, not at its timeout.
+
+static int
+bound_socket(const char *path)
+{
+  struct sockaddr_un addr;
+  int sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (sock < 0)
+    die("polltest: socket failed");
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path));
+  addr.sun_path[sizeof(addr.sun_path) - 1] = 0;
+  if (bind(sock, (struct sockaddr*)&addr, SUN_LEN(&addr)) < 0)
+    die("polltest: bind %s failed", path);
+  return sock;
+}
+
+void
+polltest(void)
+{
+  const char *msg = "polltest";
+  struct sockaddr_un addr;
+  struct pollfd pfd;
+
+  printf("polltest\n");
+  unlink("polltest.srv");
+  unlink("polltest.cli");
+  int sock = bound_socket("polltest.srv");
+
+  pfd.fd = sock;
+  pfd.events = POLLIN;
+  if (poll(&pfd, 1, 0) != 0)
+    die("polltest: empty socket is readable");
+
+  int pid = fork();
+  if (pid < 0)
+    die("polltest: fork failed");
+  if (pid == 0) {
+    int csock = bound_socket("polltest.cli");
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, "polltest.srv");
+    sleep(1);
+    if (sendto(csock, msg, strlen(msg), 0, (struct sockaddr*)&addr,
+               SUN_LEN(&addr)) != strlen(msg))
+      die("polltest: sendto failed");
+    exit(0);
+  }
+
+  // Wait well past the child's delay, and make sure the wakeup came
+  // from the datagram rather than the timeout
+  struct timeval t0, t1;
+  gettimeofday(&t0, nullptr);
+  pfd.revents = 0;
+  int r = poll(&pfd, 1, 10000);
+  gettimeofday(&t1, nullptr);
+  if (r != 1 || !(pfd.revents & POLLIN))
+    die("polltest: poll returned %d revents %x", r, pfd.revents);
+  if (t1.tv_sec - t0.tv_sec >= 5)
+    die("polltest: poll took %ld secs", (long)(t1.tv_sec - t0.tv_sec));
+
+  char rbuf[32];
+  if (recv(sock, rbuf, sizeof(rbuf), 0) != strlen(msg) ||
+      memcmp(rbuf, msg, strlen(msg)) != 0)
+    die("polltest: wrong datagram");
+  wait(NULL);
+  close(sock);
+  unlink("polltest.srv");
+  unlink("polltest.cli");
+  printf("polltest ok\n");
+}
+
 static int nenabled;
 static char **enabled;
 
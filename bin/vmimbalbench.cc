@@ -179,16 +179,13 @@ main(int argc, char * argv[])
       }
       consumer();
       for (int j = 0; j < MAXCPU; j++) {
-#if defined(LINUX)
+        if (!(producermap[i][j])) {
+          continue;
+        }
         int r = xpthread_join(tids[j]);
-        if (r < 0) {
+        if (r != 0) {
           printf("error joining producer %d for consumer %d\n",j,i);
         }
-#else
-        // xv6 will always return -1 after the first join because of how wait() is implemented.
-        // / xpthread_join is defined (as wait()). so do nothing for xv6.
-        xpthread_join(tids[j]);
-#endif
       }
       exit(0);
     }
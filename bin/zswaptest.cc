@@ -0,0 +1,149 @@
+// Test zswap's compress and decompress-on-fault round trip.
+//
+// Fills anonymous memory with pages of zeroes, repeated text, runs of
+// random letters, and random bytes, pushes it out with MADV_PAGEOUT,
+// and checks that it reads back intact, in this process and in a
+// forked child that shares the compressed pages.  Also checks that
+// unmapping the memory releases every compressed page.
+
+#include "types.h"
+#include "user.h"
+#include "mmu.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+enum { NPAGES = 64 };
+
+// Pages that should compress: the text and letter-run pages
+enum { NCOMPRESSIBLE = NPAGES / 2 };
+
+static void
+fill(char *page, int i)
+{
+  u64 x = i * 6364136223846793005ull + 1442695040888963407ull;
+  for (int j = 0; j < PGSIZE; j++) {
+    x = x * 6364136223846793005ull + 1442695040888963407ull;
+    switch (i % 4) {
+    case 0:
+      page[j] = 0;
+      break;
+    case 1:
+      page[j] = "zswap round trip "[(j + i) % 17];
+      break;
+    case 2:
+      page[j] = j && (x >> 58) % 16 ? page[j - 1] : 'a' + (x >> 40) % 26;
+      break;
+    case 3:
+      page[j] = x >> 56;
+      break;
+    }
+  }
+}
+
+static void
+check(const char *p, const char *who)
+{
+  char want[PGSIZE];
+  for (int i = 0; i < NPAGES; i++) {
+    fill(want, i);
+    if (memcmp(p + i * PGSIZE, want, PGSIZE) != 0)
+      die("zswaptest: %s: page %d differs", who, i);
+  }
+}
+
+// Return the number of pages zswap holds, or -1 if /dev/zswap
+// couldn't be read.  If enabled isn't null, store whether zswap is on.
+static long
+stored(bool *enabled)
+{
+  char buf[256];
+  int fd = open("/dev/zswap", O_RDONLY);
+  if (fd < 0)
+    return -1;
+  int n = read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+  if (n <= 0)
+    return -1;
+  buf[n] = 0;
+  char *s = strstr(buf, "stored ");
+  if (!s)
+    return -1;
+  if (enabled)
+    *enabled = strstr(buf, "enabled 1") != nullptr;
+  return atol(s + strlen("stored "));
+}
+
+static void
+set_enabled(bool on)
+{
+  int fd = open("/dev/zswap", O_WRONLY);
+  if (fd < 0)
+    die("zswaptest: open /dev/zswap failed");
+  if (write(fd, on ? "1\n" : "0\n", 2) != 2)
+    die("zswaptest: enabling zswap failed");
+  close(fd);
+}
+
+static void
+pageout(char *p)
+{
+  if (madvise(p, NPAGES * PGSIZE, MADV_PAGEOUT) < 0)
+    die("zswaptest: madvise(MADV_PAGEOUT) failed");
+}
+
+int
+main(int argc, char **argv)
+{
+  bool was_enabled;
+  long base = stored(&was_enabled);
+  if (base < 0)
+    die("zswaptest: can't read /dev/zswap");
+  set_enabled(true);
+
+  char *p = (char*)mmap(nullptr, NPAGES * PGSIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    die("zswaptest: mmap failed");
+  for (int i = 0; i < NPAGES; i++)
+    fill(p + i * PGSIZE, i);
+
+  // Text and letter-run pages compress, zero pages need no copy, and
+  // random pages stay resident
+  pageout(p);
+  long n = stored(nullptr) - base;
+  if (n < NCOMPRESSIBLE)
+    die("zswaptest: %ld pages stored, expected %d", n, NCOMPRESSIBLE);
+  check(p, "after pageout");
+
+  // A child shares the compressed pages and faults in its own copies
+  pageout(p);
+  int pid = fork();
+  if (pid < 0)
+    die("zswaptest: fork failed");
+  if (pid == 0) {
+    check(p, "child");
+    memset(p, 'c', NPAGES * PGSIZE);
+    exit(0);
+  }
+  int status;
+  if (wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    die("zswaptest: child failed");
+  check(p, "parent after fork");
+
+  pageout(p);
+  if (munmap(p, NPAGES * PGSIZE) < 0)
+    die("zswaptest: munmap failed");
+  n = stored(nullptr) - base;
+  if (n != 0)
+    die("zswaptest: %ld pages still stored after munmap", n);
+
+  set_enabled(was_enabled);
+  printf("zswaptest: ok\n");
+  return 0;
+}
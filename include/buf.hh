@@ -7,12 +7,17 @@
 #include "atomic_util.hh"
 #include "lockwrap.hh"
 #include "weakcache.hh"
+#include "page_info.hh"
 
+// A cached disk block.  Blocks are page-sized and each lives in its
+// own page, so the page itself can be handed to the file system's
+// page cache (see mfsload) and mapped into user space without a copy.
 class buf : public refcache::weak_referenced {
 public:
   struct bufdata {
     char data[BSIZE];
   };
+  static_assert(sizeof(bufdata) == PGSIZE, "blocks must be page-sized");
 
   typedef pair<u32, u64> key_t;
 
@@ -23,8 +28,12 @@ public:
   u64 block() { return block_; }
   bool dirty() { return dirty_; }
 
+  // The page holding this block.  Writes through the page bypass the
+  // seqlock and do not mark the block dirty.
+  sref<page_info> page() { return page_; }
+
   seq_reader<bufdata> read() {
-    return seq_reader<bufdata>(&data_, &seq_);
+    return seq_reader<bufdata>(data_, &seq_);
   }
 
   class buf_dirty {
@@ -49,7 +58,7 @@ public:
   };
 
   buf_writer write() {
-    return buf_writer(&data_, &write_lock_, &seq_, this);
+    return buf_writer(data_, &write_lock_, &seq_, this);
   }
 
 private:
@@ -61,10 +70,12 @@ private:
   sleeplock writeback_lock_;
   std::atomic<bool> dirty_;
 
-  bufdata data_;
+  const sref<page_info> page_;
+  bufdata* const data_;
 
-  buf(u32 dev, u64 block)
-    : dev_(dev), block_(block), dirty_(false) {}
+  buf(u32 dev, u64 block, sref<page_info> page)
+    : dev_(dev), block_(block), dirty_(false), page_(std::move(page)),
+      data_((bufdata*)page_->va()) {}
   void onzero() override;
   NEW_DELETE_OPS(buf);
 
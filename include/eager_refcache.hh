@@ -66,6 +66,13 @@ namespace eager_refcache {
     void inc();
     void dec();
 
+    // Like inc, but fail and return false if this object is in eager
+    // mode and its count has already reached zero.  This lets a caller
+    // that found this object without holding a reference take one, so
+    // long as something (such as a gc epoch) keeps the object's memory
+    // from being freed in the mean time.
+    bool tryinc();
+
     // Switch this object into eager mode.  The caller must ensure
     // that the object's reference count cannot be zero or become zero
     // during this call.
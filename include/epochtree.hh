@@ -0,0 +1,101 @@
+#pragma once
+
+// A two-level combining tree for ending epochs.
+//
+// Each core reports once per epoch that it has reached it.  Rather
+// than have every core decrement one shared counter, each leaf of
+// the tree covers up to fanout cores of one NUMA node and counts the
+// cores that have yet to report.  The last core of a leaf to report
+// decrements the root's count of unfinished leaves, and the last leaf
+// ends the epoch.  Thus a report only writes shared state within its
+// own socket, except once per leaf per epoch.
+//
+// It's safe to reset a counter as soon as it reaches zero, since the
+// caller guarantees that no core it covers reports again until the
+// epoch has ended.
+//
+// Leaf adds per-leaf state for the caller (such as a sum to combine
+// up the tree), which it can reach through my_leaf.
+
+#include "kernel.hh"
+#include "cpu.hh"
+#include "numa.hh"
+#include <atomic>
+#include <cstddef>
+
+struct epoch_tree_empty { };
+
+template<class Leaf = epoch_tree_empty>
+class epoch_tree
+{
+  struct leaf : Leaf
+  {
+    // The number of this leaf's cores that have not reported for the
+    // current epoch.
+    std::atomic<std::size_t> left;
+    // The number of cores in this leaf.
+    std::size_t ncpu;
+    __padout__;
+  } __mpalign__;
+
+  std::size_t nleaves_;
+  // Each core's leaf.  (Not in per-CPU state, which each core
+  // reconstructs when it boots.)
+  std::size_t leaf_of_[NCPU];
+  leaf leaves_[NCPU];
+  // The number of leaves with cores that have not reported for the
+  // current epoch.
+  std::atomic<std::size_t> leaves_left_ __mpalign__;
+  __padout__;
+
+public:
+  // Build the tree over cores [0, ncpu).  Each leaf covers up to
+  // fanout cores of one NUMA node.
+  void init(std::size_t fanout)
+  {
+    std::size_t n = 0;
+    for (auto &node : numa_nodes) {
+      std::size_t incpu = 0;
+      for (auto c : node.cpus) {
+        if (c->id >= ncpu)
+          continue;
+        if (incpu++ % fanout == 0)
+          leaves_[n++].ncpu = 0;
+        leaves_[n - 1].ncpu++;
+        leaves_[n - 1].left = leaves_[n - 1].ncpu;
+        leaf_of_[c->id] = n - 1;
+      }
+    }
+    nleaves_ = n;
+    leaves_left_ = n;
+  }
+
+  // This core's leaf.
+  Leaf *my_leaf()
+  {
+    return &leaves_[leaf_of_[myid()]];
+  }
+
+  // Report that this core has reached the current epoch.  If it is the
+  // last core of its leaf to do so, calls leaf_done on its leaf.
+  // Returns true if it is the last core of all, in which case the
+  // caller must end the epoch.
+  template<class F>
+  bool report(F &&leaf_done)
+  {
+    leaf *l = &leaves_[leaf_of_[myid()]];
+    if (--l->left != 0)
+      return false;
+    l->left = l->ncpu;
+    leaf_done(static_cast<Leaf*>(l));
+    if (--leaves_left_ != 0)
+      return false;
+    leaves_left_ = nleaves_;
+    return true;
+  }
+
+  bool report()
+  {
+    return report([](Leaf*) { });
+  }
+};
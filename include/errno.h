@@ -1,3 +1,8 @@
 #define EAGAIN          11      /* Try again */
 #define EWOULDBLOCK     EAGAIN  /* Operation would block */
+#define ESRCH           3       /* No such process */
 #define EINTR           4
+#define ENOMEM          12      /* Out of memory */
+#define EBUSY           16      /* Device or resource busy */
+#define EINVAL          22      /* Invalid argument */
+#define ETIMEDOUT       110     /* Connection timed out */
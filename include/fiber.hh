@@ -0,0 +1,65 @@
+#pragma once
+
+// User-level M:N fibers.
+//
+// fiber::run starts one worker thread per core, pinned with
+// setaffinity, and multiplexes fibers over them.  Each worker keeps a
+// work-stealing deque of runnable fibers.  A worker that runs out
+// steals from the others for a while and then sleeps on a futex
+// until new work shows up.  Switching between fibers never enters the
+// kernel.
+//
+// A fiber may resume on a different worker after it blocks or yields,
+// so it must not keep pointers to thread-local variables across those
+// points.
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <atomic>
+
+namespace fiber {
+  struct task;
+
+  // Run fn(arg) as a fiber on nworkers workers, pinned to CPUs
+  // 0..nworkers-1.  Returns once fn and every fiber started from it
+  // have returned, or -1 if the runtime could not start.
+  int run(int nworkers, void (*fn)(void*), void *arg);
+
+  // Start fn(arg) as a new fiber.  Returns -1 if out of memory.
+  int spawn(void (*fn)(void*), void *arg);
+
+  // Let other runnable fibers run.
+  void yield();
+
+  // The worker running the calling fiber, or -1 outside the runtime.
+  int worker_id();
+
+  // Suspend the calling fiber until fd has one of events (POLL*)
+  // ready, and return the ready events.  Only the fiber waits; its
+  // worker goes on running other fibers.
+  int wait_io(int fd, int events);
+
+  // Blocking I/O that suspends only the calling fiber.
+  ssize_t read(int fd, void *buf, size_t n);
+  ssize_t write(int fd, const void *buf, size_t n);
+  ssize_t recvfrom(int sockfd, void *buf, size_t len, int flags,
+                   struct sockaddr *src_addr, socklen_t *addrlen);
+
+  // A counting semaphore whose waiters are fibers.  post may also be
+  // called from threads outside the runtime.
+  class semaphore {
+  public:
+    semaphore(unsigned count = 0)
+      : lock_(false), count_(count), head_(nullptr), tail_(nullptr) { }
+    semaphore(const semaphore&) = delete;
+    semaphore& operator=(const semaphore&) = delete;
+
+    void wait();
+    void post();
+
+  private:
+    std::atomic<bool> lock_;
+    unsigned count_;
+    task *head_, *tail_;
+  };
+}
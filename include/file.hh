@@ -12,8 +12,10 @@
 #include "mfs.hh"
 #include "sleeplock.hh"
 #include <uk/unistd.h>
+#include <uk/poll.h>
 
 class dirns;
+struct pollqueue;
 
 u64 namehash(const strbuf<DIRSIZ>&);
 
@@ -32,6 +34,15 @@ struct file {
   virtual ssize_t pread(char *addr, size_t n, off_t offset) { return -1; }
   virtual ssize_t pwrite(const char *addr, size_t n, off_t offset) { return -1; }
 
+  // Return the subset of events (POLL* bits), plus POLLHUP or
+  // POLLERR, that are ready now.  This must not block.  Files whose
+  // operations never wait are always ready.
+  virtual int poll(int events) { return events & (POLLIN | POLLOUT); }
+
+  // Return the queue to wait on for poll's result to change, or
+  // nullptr if it never changes.
+  virtual pollqueue* get_pollqueue() { return nullptr; }
+
   // Socket operations
   virtual int bind(const struct sockaddr *addr, size_t addrlen) { return -1; }
   virtual int listen(int backlog) { return -1; }
@@ -59,6 +70,15 @@ struct file {
   virtual void inc() = 0;
   virtual void dec() = 0;
 
+  // Take a reference to a file read from a filetable without holding
+  // one.  The caller must have interrupts disabled from the read
+  // until this returns, and be in a gc epoch.  Returns false if the
+  // file's count has already reached zero.  For refcache-counted
+  // files, disabling interrupts keeps this core's epoch from ending,
+  // so the file can't be freed before our inc lands and a plain inc
+  // is enough.
+  virtual bool tryinc() { inc(); return true; }
+
 protected:
   file() {}
 };
@@ -102,6 +122,8 @@ public:
 
   int stat(struct stat*, enum stat_flags) override;
   ssize_t read(char *addr, size_t n) override;
+  int poll(int events) override;
+  pollqueue* get_pollqueue() override;
   void onzero() override;
 
 private:
@@ -137,13 +159,16 @@ private:
 // and release its reference to the file_pipe_writer (potentially
 // closing the pipe).
 
-struct file_pipe_writer_wrapper : public eager_refcache::referenced, public file {
+struct file_pipe_writer_wrapper : public eager_refcache::referenced, public file,
+                                  public rcu_freed {
 public:
-  file_pipe_writer_wrapper(file* f) : inner(f) {}
+  file_pipe_writer_wrapper(file* f)
+    : rcu_freed("file_pipe_writer_wrapper", this, sizeof(*this)), inner(f) {}
   NEW_DELETE_OPS(file_pipe_writer_wrapper);
 
   void inc() override { referenced::inc(); }
   void dec() override { referenced::dec(); }
+  bool tryinc() override { return referenced::tryinc(); }
 
   file* dup() override {
     return inner->dup();
@@ -157,6 +182,14 @@ public:
     return inner->write(addr, n);
   }
 
+  int poll(int events) override {
+    return inner->poll(events);
+  }
+
+  pollqueue* get_pollqueue() override {
+    return inner->get_pollqueue();
+  }
+
   void pre_close() override {
     // This FD is being closed.  Now we need to know the moment its
     // reference count actually drops to zero so we can immediately
@@ -178,10 +211,14 @@ public:
   }
 
   void onzero() override {
+    // Close the write end now, but keep our memory until lock-free
+    // filetable readers that may have loaded us are done with tryinc.
     inner->dec();
-    delete this;
+    gc_delayed(this);
   }
 
+  void do_gc() override { delete this; }
+
 private:
   file* inner;
 };
@@ -202,6 +239,8 @@ public:
 
   int stat(struct stat*, enum stat_flags) override;
   ssize_t write(const char *addr, size_t n) override;
+  int poll(int events) override;
+  pollqueue* get_pollqueue() override;
   void onzero() override;
 
 private:
@@ -9,39 +9,49 @@ class filetable : public referenced {
 private:
   static const int cpushift = 16;
   static const int fdmask = (1 << cpushift) - 1;
+  static const int nwords = (NOFILE + 63) / 64;
 
 public:
   static sref<filetable> alloc() {
     return sref<filetable>::transfer(new filetable());
   }
 
+  // Copy this table.  This only visits open FDs, so its cost depends
+  // on the number of open FDs, not on NCPU * NOFILE.
   sref<filetable> copy(bool close_cloexec = false) {
-    filetable* t = new filetable(false);
+    filetable* t = new filetable();
 
-    fdinfo init(nullptr, false);
     for(int cpu = 0; cpu < NCPU; cpu++) {
-      for(int fd = 0; fd < NOFILE; fd++) {
-        // XXX Relaxed load?
-        fdinfo info;
-        // Avoid reading info_ altogether if we're closing cloexec FDs
-        // and this is a cloexec FD.
-        if (close_cloexec && cloexec_[cpu][fd])
-          info = init;
-        else
-          info = info_[cpu][fd].load();
-        file *f = info.get_file();
-        if (f && (!close_cloexec || !info.get_cloexec())) {
-          // XXX f's refcount could have dropped to zero between the
-          // load and here
-          file* newf = f->dup();
-          fdinfo newinfo(newf, info.get_cloexec());
-
-          t->info_[cpu][fd].store(newinfo, std::memory_order_relaxed);
-          t->cloexec_[cpu][fd].store(
-            info.get_cloexec(), std::memory_order_relaxed);
-        } else {
-          t->info_[cpu][fd].store(init, std::memory_order_relaxed);
-          t->cloexec_[cpu][fd].store(true, std::memory_order_relaxed);
+      fdarray *a = fds_[cpu].load(std::memory_order_acquire);
+      if (!a)
+        continue;
+      fdarray *ta = nullptr;
+      for (int w = 0; w < nwords; w++) {
+        for (u64 bits = a->used[w].load(std::memory_order_relaxed); bits;
+             bits &= bits - 1) {
+          int fd = w * 64 + __builtin_ctzll(bits);
+          // Avoid reading info altogether if we're closing cloexec FDs
+          // and this is a cloexec FD.
+          if (close_cloexec && a->cloexec[fd])
+            continue;
+          fdinfo info;
+          file *f = ref_fdinfo(&a->info[fd], &info);
+          if (!f)
+            continue;
+          file *newf = nullptr;
+          if (!close_cloexec || !info.get_cloexec())
+            newf = f->dup();
+          f->dec();
+          if (!newf)
+            continue;
+
+          if (!ta)
+            ta = t->get_fdarray(cpu);
+          ta->info[fd].store(fdinfo(newf, info.get_cloexec()),
+                             std::memory_order_relaxed);
+          if (!info.get_cloexec())
+            ta->cloexec[fd].store(false, std::memory_order_relaxed);
+          ta->used[w].fetch_or(1ull << (fd % 64), std::memory_order_relaxed);
         }
       }
     }
@@ -61,34 +71,45 @@ public:
     if (fd < 0 || fd >= NOFILE)
       return sref<file>();
 
-    // XXX This isn't safe: there could be a concurrent close that
-    // drops the reference count to zero.
-    file* f = info_[cpu][fd].load().get_file();
-    return sref<file>::newref(f);
+    fdarray *a = fds_[cpu].load(std::memory_order_acquire);
+    if (!a)
+      return sref<file>();
+
+    fdinfo info;
+    return sref<file>::transfer(ref_fdinfo(&a->info[fd], &info));
   }
 
   // Allocate a FD and point it to f.  This takes over the reference
   // to f from the caller.
   int allocfd(sref<file>&& f, bool percpu = false, bool cloexec = false) {
     int cpu = percpu ? myid() : 0;
+    fdarray *a = get_fdarray(cpu);
     fdinfo none(nullptr, false);
     // Transfer f to manual reference counting since we can't store
     // sref's in the info table.
     file *fptr = f->dup();
     fdinfo newinfo(fptr, cloexec, true);
-    for (int fd = 0; fd < NOFILE; fd++) {
+    for (int w = 0; w < nwords; w++) {
       // Note that we skip over locked FDs because that means they're
-      // either non-null or about to be.
-      if (info_[cpu][fd].load(std::memory_order_relaxed) == none &&
-          cmpxch(&info_[cpu][fd], none, newinfo)) {
-        // The default state of cloexec_ is 'true', so we only need to
-        // write to it if this is a keep-exec FD.
-        if (!cloexec)
-          cloexec_[cpu][fd] = cloexec;
-        // Unlock FD
-        info_[cpu][fd].store(newinfo.with_locked(false),
-                             std::memory_order_release);
-        return (cpu << cpushift) | fd;
+      // either non-null or about to be.  The used bitmap may briefly
+      // lag info, so it's only a hint for finding free FDs.
+      for (u64 free = ~a->used[w].load(std::memory_order_relaxed); free;
+           free &= free - 1) {
+        int fd = w * 64 + __builtin_ctzll(free);
+        if (fd >= NOFILE)
+          break;
+        if (a->info[fd].load(std::memory_order_relaxed) == none &&
+            cmpxch(&a->info[fd], none, newinfo)) {
+          // The default state of cloexec is 'true', so we only need to
+          // write to it if this is a keep-exec FD.
+          if (!cloexec)
+            a->cloexec[fd] = cloexec;
+          a->used[w].fetch_or(1ull << (fd % 64));
+          // Unlock FD
+          a->info[fd].store(newinfo.with_locked(false),
+                            std::memory_order_release);
+          return (cpu << cpushift) | fd;
+        }
       }
     }
     cprintf("filetable::allocfd: failed\n");
@@ -117,13 +138,21 @@ public:
       return;
     }
 
+    fdarray *a = fds_[cpu].load(std::memory_order_acquire);
+    if (!a) {
+      cprintf("filetable::close: bad fd %u\n", fd);
+      return;
+    }
+
     // Lock the FD to prevent concurrent modifications
-    std::atomic<fdinfo> *infop = &info_[cpu][fd];
+    std::atomic<fdinfo> *infop = &a->info[fd];
     fdinfo info = lock_fdinfo(infop);
 
-    // Clear cloexec_ back to default state of 'true'
-    if (!cloexec_[cpu][fd])
-      cloexec_[cpu][fd] = true;
+    // Clear cloexec back to default state of 'true'
+    if (!a->cloexec[fd])
+      a->cloexec[fd] = true;
+    if (info.get_file())
+      a->used[fd / 64].fetch_and(~(1ull << (fd % 64)));
 
     // Update and unlock the FD
     fdinfo newinfo(nullptr, false);
@@ -155,16 +184,19 @@ public:
     }
 
     // Lock the FD to prevent concurrent modifications
-    std::atomic<fdinfo> *infop = &info_[cpu][fd];
+    fdarray *a = get_fdarray(cpu);
+    std::atomic<fdinfo> *infop = &a->info[fd];
     fdinfo oldinfo = lock_fdinfo(infop);
 
-    // Update to new info and unlock.  It's safe to update cloexec_
+    // Update to new info and unlock.  It's safe to update cloexec
     // non-atomically with info even with concurrent lock-free readers
     // because any that care will double-check the fdinfo bit.
     file *newfptr = newf->dup();
     fdinfo newinfo(newfptr, cloexec);
-    if (cloexec != cloexec_[cpu][fd])
-      cloexec_[cpu][fd] = cloexec;
+    if (cloexec != a->cloexec[fd])
+      a->cloexec[fd] = cloexec;
+    if (!oldinfo.get_file())
+      a->used[fd / 64].fetch_or(1ull << (fd % 64));
     infop->store(newinfo, std::memory_order_release);
 
     // Close the old FD
@@ -176,36 +208,6 @@ public:
   }
 
 private:
-  filetable(bool clear = true) {
-    if (!clear)
-      return;
-    fdinfo none(nullptr, false);
-    for(int cpu = 0; cpu < NCPU; cpu++) {
-      for(int fd = 0; fd < NOFILE; fd++) {
-        info_[cpu][fd].store(none, std::memory_order_relaxed);
-        cloexec_[cpu][fd].store(true, std::memory_order_relaxed);
-      }
-    }
-    std::atomic_thread_fence(std::memory_order_release);
-  }
-
-  ~filetable() {
-    // Close all FDs
-    for(int cpu = 0; cpu < NCPU; cpu++){
-      for(int fd = 0; fd < NOFILE; fd++){
-        fdinfo info = info_[cpu][fd].load();
-        if (info.get_file()) {
-          info.get_file()->pre_close();
-          info.get_file()->dec();
-        }
-      }
-    }
-  }
-
-  filetable& operator=(const filetable&);
-  filetable(const filetable& x);
-  NEW_DELETE_OPS(filetable);  
-
   class fdinfo
   {
     uintptr_t data_;
@@ -249,6 +251,103 @@ private:
     }
   };
 
+  // The FDs belonging to one CPU.  These are allocated the first time
+  // a table uses a CPU's FD range, so most tables have just one.
+  struct fdarray
+  {
+    std::atomic<fdinfo> info[NOFILE];
+    // In addition to storing O_CLOEXEC with each fdinfo so it can be
+    // read atomically with the FD, we store it separately so we can
+    // scan for keep-exec FDs without reading from info, which would
+    // cause unnecessary sharing between the scan and creating
+    // O_CLOEXEC FDs.  To avoid unnecessary sharing on this array
+    // itself, the *default* state of this array for closed FDs must
+    // be 'true', so we only have to write to it when opening a
+    // keep-exec FD.  Modifications to this array are protected by
+    // the fdinfo lock.  Lock-free readers should double-check the
+    // O_CLOEXEC bit in fdinfo.
+    std::atomic<bool> cloexec[NOFILE] __mpalign__;
+    // Bit i is set if FD i is open.  Bits are set before the FD is
+    // unlocked after being opened and cleared while the FD is locked
+    // for close, so scans see every FD that was open when the scan
+    // started.
+    std::atomic<u64> used[nwords];
+
+    fdarray() {
+      fdinfo none(nullptr, false);
+      for (int fd = 0; fd < NOFILE; fd++) {
+        info[fd].store(none, std::memory_order_relaxed);
+        cloexec[fd].store(true, std::memory_order_relaxed);
+      }
+      for (int w = 0; w < nwords; w++)
+        used[w].store(0, std::memory_order_relaxed);
+    }
+
+    NEW_DELETE_OPS(fdarray);
+  };
+
+  filetable() {
+    for (int cpu = 0; cpu < NCPU; cpu++)
+      fds_[cpu].store(nullptr, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  ~filetable() {
+    // Close all FDs
+    for (int cpu = 0; cpu < NCPU; cpu++) {
+      fdarray *a = fds_[cpu].load();
+      if (!a)
+        continue;
+      for (int w = 0; w < nwords; w++) {
+        for (u64 bits = a->used[w].load(); bits; bits &= bits - 1) {
+          fdinfo info = a->info[w * 64 + __builtin_ctzll(bits)].load();
+          if (info.get_file()) {
+            info.get_file()->pre_close();
+            info.get_file()->dec();
+          }
+        }
+      }
+      delete a;
+    }
+  }
+
+  filetable& operator=(const filetable&);
+  filetable(const filetable& x);
+  NEW_DELETE_OPS(filetable);  
+
+  fdarray *get_fdarray(int cpu)
+  {
+    fdarray *a = fds_[cpu].load(std::memory_order_acquire);
+    if (a)
+      return a;
+    fdarray *na = new fdarray();
+    if (fds_[cpu].compare_exchange_strong(a, na))
+      return na;
+    // Somebody beat us to it; a is now their array
+    delete na;
+    return a;
+  }
+
+  // Load *infop into *out and take a reference to its file without
+  // locking the FD, so lookups only read the shared FD slot.  A
+  // concurrent close or replace stores the FD's new info before
+  // dropping the table's reference, so the file we load still has
+  // that reference at the time of the load.  Keeping interrupts off
+  // until tryinc returns and staying in a gc epoch make the inc safe
+  // from there (see file::tryinc).  Returns nullptr if the FD is
+  // closed or its file's count has reached zero.
+  static file* ref_fdinfo(std::atomic<fdinfo> *infop, fdinfo *out)
+  {
+    scoped_gc_epoch e;
+    scoped_cli cli;
+    fdinfo info = infop->load(std::memory_order_acquire);
+    file *f = info.get_file();
+    if (f && !f->tryinc())
+      f = nullptr;
+    *out = info;
+    return f;
+  }
+
   fdinfo lock_fdinfo(std::atomic<fdinfo> *infop)
   {
     fdinfo info, newinfo;
@@ -265,16 +364,5 @@ private:
     return info;
   }
 
-  percpu<std::atomic<fdinfo>[NOFILE]> info_;
-  // In addition to storing O_CLOEXEC with each fdinfo so it can be
-  // read atomically with the FD, we store it separately so we can
-  // scan for keep-exec FDs without reading from info_, which would
-  // cause unnecessary sharing between the scan and creating O_CLOEXEC
-  // FDs.  To avoid unnecessary sharing on this array itself, the
-  // *default* state of this array for closed FDs must be 'true', so
-  // we only have to write to it when opening a keep-exec FD.
-  // Modifications to this array are protected by the fdinfo lock.
-  // Lock-free readers should double-check the O_CLOEXEC bit in
-  // fdinfo.
-  percpu<std::atomic<bool>[NOFILE]> cloexec_;
+  std::atomic<fdarray*> fds_[NCPU];
 };
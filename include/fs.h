@@ -55,6 +55,13 @@ struct dirent {
   char name[DIRSIZ];
 };
 
+// Directory entry as returned by getdents.
+struct kdirent {
+  u64 d_ino;                    // Inode number
+  u8 d_type;                    // T_DIR, T_FILE, etc.
+  char d_name[DIRSIZ+1];        // NUL-terminated
+};
+
 // XXX(Austin) PATH_MAX sucks.  It would be nice if we didn't need it
 // to size kernel copy buffers.
 #define PATH_MAX 256
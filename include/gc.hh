@@ -7,12 +7,10 @@
 using std::atomic;
 
 struct gc_handle {
-  std::atomic<u64> epoch;      // low 8 bits are depth count
-  __padout__;
-  int core;
-  struct gc_handle* next;
-  struct gc_handle* prev;
-  gc_handle(void) { core = -1; epoch = 0;};
+  u64 epoch;                   // epoch of the outermost gc_begin_epoch
+  u32 depth;                   // gc_begin_epoch nesting depth
+  int core;                    // core of the outermost gc_begin_epoch
+  gc_handle(void) : epoch(0), depth(0), core(-1) { }
 
   NEW_DELETE_OPS(gc_handle)
 };
@@ -57,3 +55,10 @@ class scoped_gc_epoch {
 void            initgc(void);
 void            gc_delayed(rcu_freed *);
 void            gc_wakeup(void);
+// Called on each timer tick, with interrupts disabled
+void            gc_tick(void);
+// Wait until every process in an epoch has left it, so everything
+// passed to gc_delayed so far can be freed.  This is an expedited
+// grace period: it interrupts every core rather than waiting for
+// their timer ticks.  Must not be called in an epoch.
+void            gc_synchronize(void);
@@ -1,6 +1,9 @@
 #pragma once
 
+// Sampling kernel heap profiler.  See heapprof.cc.
+
 #include <sys/types.h>
+#include <atomic>
 
 enum heap_profile_arena {
   HEAP_PROFILE_KALLOC,
@@ -9,14 +12,31 @@ enum heap_profile_arena {
 
 class print_stream;
 
-#if KERNEL_HEAP_PROFILE
-bool heap_profile_update(heap_profile_arena arena, const void *rip,
-                         ssize_t bytes);
-#else
-static inline bool
-heap_profile_update(heap_profile_arena arena, const void *rip, ssize_t bytes)
+// True while allocations are being sampled
+extern std::atomic<bool> heap_profile_enabled;
+// Number of sampled allocations not yet freed
+extern std::atomic<u64> heap_profile_live;
+
+void heap_profile_alloc_slow(heap_profile_arena arena, void *p,
+                             size_t bytes);
+void heap_profile_free_slow(heap_profile_arena arena, void *p);
+
+// Called by the allocator for arena after it allocates p.
+static inline void
+heap_profile_alloc(heap_profile_arena arena, void *p, size_t bytes)
 {
-  return false;
+  if (heap_profile_enabled.load(std::memory_order_relaxed))
+    heap_profile_alloc_slow(arena, p, bytes);
 }
-#endif
+
+// Called by the allocator for arena before it frees p.
+static inline void
+heap_profile_free(heap_profile_arena arena, void *p)
+{
+  if (heap_profile_live.load(std::memory_order_relaxed))
+    heap_profile_free_slow(arena, p);
+}
+
+// Print the call stacks with the most live bytes, if the profiler has
+// ever run.
 void heap_profile_print(print_stream *s);
@@ -45,6 +45,7 @@ struct irq;
 class print_stream;
 class mnode;
 class buf;
+class page_info;
 
 // acpi.c
 typedef void *ACPI_HANDLE;
@@ -106,6 +107,7 @@ void            iupdate(sref<inode>);
 void            iunlock(sref<inode>);
 void            itrunc(inode*);
 int             readi(sref<inode>, char*, u32, u32);
+sref<page_info> readpage(sref<inode>, u32);
 void            stati(sref<inode>, struct stat*);
 int             writei(sref<inode>, const char*, u32, u32);
 sref<inode>     nameiparent(sref<inode> cwd, const char*, char*);
@@ -136,6 +138,8 @@ void            idlezombie(struct proc*);
 // kalloc.c
 char*           kalloc(const char *name, size_t size = PGSIZE);
 void            kfree(void*, size_t size = PGSIZE);
+char*           kalloc_node(const char *name, size_t node,
+                            size_t size = PGSIZE);
 void*           ksalloc(int slabtype);
 void            ksfree(int slabtype, void*);
 void*           early_kalloc(size_t size, size_t align);
@@ -163,6 +167,10 @@ void            netrx(void *va, u16 len);
 int             nettx(void *va, u16 len);
 void            nethwaddr(u8 *hwaddr);
 
+// numabalance.cc
+void            numa_balance_tick(void);
+int             numa_hint_fault(size_t page_node);
+
 // picirq.c
 void            picenable(int);
 void            piceoi(void);
@@ -173,6 +181,8 @@ int             pipealloc(sref<file>*, sref<file>*, int flags);
 void            pipeclose(struct pipe*, int);
 int             piperead(struct pipe*, char*, int);
 int             pipewrite(struct pipe*, const char*, int);
+int             pipepoll(struct pipe*, int);
+struct pollqueue* pipepollqueue(struct pipe*);
 struct pipe*    pipesockalloc();
 void            pipesockclose(struct pipe *);
 
@@ -185,6 +195,9 @@ enum clone_flags
   CLONE_NO_VMAP = 1<<2,
   CLONE_NO_FTABLE = 1<<3,
   CLONE_NO_RUN = 1<<4,
+  // Don't make the child a child of the caller.  It can't be waited
+  // for and reaps itself when it exits.
+  CLONE_DETACH = 1<<5,
 };
 ENUM_BITSET_OPS(clone_flags);
 void            finishproc(struct proc*, bool removepid = true);
@@ -202,6 +215,7 @@ struct proc*    threadpin(void (*fn)(void*), void *arg, const char *name, int cp
 // sampler.c
 void            sampstart(void);
 int             sampintr(struct trapframe*);
+void            samptick(struct trapframe*);
 void            sampconf(void);
 void            sampidle(bool);
 void            wdpoke(void);
@@ -39,6 +39,15 @@
   X(uint64_t, munmap_count)                     \
   X(uint64_t, munmap_cycles)                    \
 
+#define KSTATS_RMAP(X)                                                 \
+  /* # of reverse map updates logged by map and unmap */               \
+  X(uint64_t, rmap_log_count)                                          \
+  /* # of logged updates applied to a page's shared reverse map.       \
+   * Updates that cancel out in a per-CPU log are never applied. */    \
+  X(uint64_t, rmap_apply_count)                                        \
+  X(uint64_t, rmap_sync_count)                                         \
+  X(uint64_t, rmap_sync_cycles)                                        \
+
 #define KSTATS_KALLOC(X)                        \
   X(uint64_t, kalloc_page_alloc_count)          \
   X(uint64_t, kalloc_page_free_count)           \
@@ -47,6 +56,42 @@
   X(uint64_t, kalloc_hot_list_steal_count)      \
   X(uint64_t, kalloc_hot_list_remote_free_count)        \
 
+// One counter per NUMA node, name_0 through name_15.  The count must
+// match MAX_NUMA_NODES (see numa.hh).
+#define KSTATS_PER_NODE(X, name)                                       \
+  X(uint64_t, name##_0)  X(uint64_t, name##_1)                         \
+  X(uint64_t, name##_2)  X(uint64_t, name##_3)                         \
+  X(uint64_t, name##_4)  X(uint64_t, name##_5)                         \
+  X(uint64_t, name##_6)  X(uint64_t, name##_7)                         \
+  X(uint64_t, name##_8)  X(uint64_t, name##_9)                         \
+  X(uint64_t, name##_10) X(uint64_t, name##_11)                        \
+  X(uint64_t, name##_12) X(uint64_t, name##_13)                        \
+  X(uint64_t, name##_14) X(uint64_t, name##_15)                        \
+
+#define KSTATS_NUMA(X)                                                 \
+  /* # of user pages allocated under each memory policy mode */        \
+  X(uint64_t, numa_local_alloc_count)                                  \
+  X(uint64_t, numa_bind_alloc_count)                                   \
+  X(uint64_t, numa_interleave_alloc_count)                             \
+  /* # of user pages that could not be allocated on the node their     \
+   * policy chose and came from another node instead */                \
+  X(uint64_t, numa_policy_miss_count)                                  \
+  /* # of user pages allocated from each node */                       \
+  KSTATS_PER_NODE(X, numa_node_alloc_count)                            \
+  /* # of pages unmapped by NUMA balancing scans */                    \
+  X(uint64_t, numa_scan_page_count)                                    \
+  /* # of NUMA hinting faults on those pages, and how many found the   \
+   * page on the faulting CPU's node.  local / all is the locality of  \
+   * sampled accesses. */                                              \
+  X(uint64_t, numa_hint_fault_count)                                   \
+  X(uint64_t, numa_hint_fault_local_count)                             \
+  /* # of pages moved to the faulting CPU's node, and # of moves that  \
+   * failed for lack of memory there */                                \
+  X(uint64_t, numa_page_migrate_count)                                 \
+  X(uint64_t, numa_page_migrate_fail_count)                            \
+  /* # of threads moved to the node holding most of their memory */    \
+  X(uint64_t, numa_task_migrate_count)                                 \
+
 #define KSTATS_REFCACHE(X)                      \
   X(uint64_t, refcache_review_count)            \
   X(uint64_t, refcache_review_cycles)           \
@@ -60,8 +105,36 @@
   X(uint64_t, refcache_item_requeued_count)     \
   X(uint64_t, refcache_item_disowned_count)     \
   X(uint64_t, refcache_dirtied_count)           \
+  /* inc/decs of objects not in the local cache */ \
+  X(uint64_t, refcache_miss_count)              \
+  /* Misses that evicted another object */     \
   X(uint64_t, refcache_conflict_count)          \
+  X(uint64_t, refcache_resize_count)            \
   X(uint64_t, refcache_weakref_break_failed)    \
+  X(uint64_t, refcache_epoch_count)             \
+  /* Sum of the epoch lengths, in timer ticks */ \
+  X(uint64_t, refcache_epoch_tick_count)        \
+  X(uint64_t, refcache_sync_count)              \
+  X(uint64_t, refcache_sync_cycles)             \
+  /* Sum of the cycles from when each freed  */ \
+  /* object's count reached zero to onzero    */ \
+  X(uint64_t, refcache_free_latency_cycles)     \
+
+#define KSTATS_ZSWAP(X)                                                \
+  /* # of pages compressed, and their total compressed size */         \
+  X(uint64_t, zswap_store_count)                                       \
+  X(uint64_t, zswap_store_bytes)                                       \
+  X(uint64_t, zswap_store_cycles)                                      \
+  /* # of pages that were all zeroes, so needed no copy */             \
+  X(uint64_t, zswap_zero_count)                                        \
+  /* # of pages that didn't compress to under half a page, or had no  \
+   * memory for their copy */                                         \
+  X(uint64_t, zswap_reject_count)                                      \
+  /* # of pages decompressed by faults */                              \
+  X(uint64_t, zswap_load_count)                                        \
+  X(uint64_t, zswap_load_cycles)                                       \
+  /* # of pages marked cold by reclaim scans */                        \
+  X(uint64_t, zswap_scan_page_count)                                   \
 
 #define KSTATS_SOCKET(X)\
   X(uint64_t, socket_load_balance) \
@@ -84,14 +157,23 @@
   X(uint64_t, sched_blocked_tick_count)         \
   X(uint64_t, sched_delayed_tick_count)         \
 
+#define KSTATS_SAMPLER(X)                              \
+  X(uint64_t, sampler_sample_count)                    \
+  /* Samples dropped because a CPU's ring was full. */ \
+  X(uint64_t, sampler_lost_count)                      \
+
 #define KSTATS_ALL(X)                           \
   KSTATS_TLB(X)                                 \
   KSTATS_VM(X)                                  \
+  KSTATS_RMAP(X)                                \
   KSTATS_KALLOC(X)                              \
+  KSTATS_NUMA(X)                                \
   KSTATS_REFCACHE(X)                            \
+  KSTATS_ZSWAP(X)                               \
   KSTATS_SOCKET(X)                              \
   KSTATS_SCHED(X)                               \
   KSTATS_FILE(X)                                \
+  KSTATS_SAMPLER(X)                             \
 
 struct kstats;
 #ifdef XV6_KERNEL
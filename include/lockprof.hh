@@ -0,0 +1,16 @@
+#pragma once
+
+// Spinlock contention profiler.  See lockprof.cc.
+
+#include <atomic>
+
+struct spinlock;
+
+extern std::atomic<bool> lockprof_enabled;
+
+// Called with interrupts disabled after lk is acquired by the caller
+// at pc.  If contended, start is the rdtsc() before the first attempt.
+void lockprof_acquired(struct spinlock *lk, u64 start, bool contended,
+                       void *pc);
+// Called with interrupts disabled before lk is released.
+void lockprof_releasing(struct spinlock *lk);
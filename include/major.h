@@ -9,3 +9,9 @@
 #define MAJ_KSTATS   9
 #define MAJ_KMEMSTATS 10
 #define MAJ_MFSSTATS 11
+#define MAJ_LOCKPROF 12
+#define MAJ_SYSCALLSTATS 13
+#define MAJ_HEAPPROF 14
+#define MAJ_NUMABALANCE 15
+#define MAJ_REFCACHE 16
+#define MAJ_ZSWAP    17
@@ -0,0 +1,40 @@
+#pragma once
+
+// NUMA memory placement policies.
+//
+// A policy picks the NUMA node each page of user memory is allocated
+// from:
+//
+//   MPOL_DEFAULT     the node of the CPU that first touches the page
+//   MPOL_BIND        one of a set of nodes, preferring the CPU's own
+//   MPOL_INTERLEAVE  a set of nodes in turn, by page index
+//
+// Each process has a policy, set with set_mempolicy and inherited
+// across fork.  mbind overrides it for a range of the address space;
+// range policies live in the flags of that range's vmdescs (see
+// vm.hh), so ranges with the same policy still compress in the radix
+// tree.  A policy only affects pages allocated after it is set.
+
+#include "types.h"
+#include <uk/mman.h>
+
+struct mempolicy
+{
+  // MPOL_*
+  u8 mode;
+  // Bit n is set if node n may be used.  Zero for MPOL_DEFAULT.
+  u16 nodes;
+
+  constexpr mempolicy() : mode(MPOL_DEFAULT), nodes(0) { }
+  constexpr mempolicy(u8 mode, u16 nodes) : mode(mode), nodes(nodes) { }
+
+  // Construct the policy for a set_mempolicy or mbind mode and node
+  // mask in *out.  Nodes that don't exist are dropped from the mask.
+  // Returns false if mode is unknown or the mask has no nodes.
+  static bool make(int mode, u64 nodemask, mempolicy *out);
+};
+
+// Allocate a zeroed page of user memory under pol.  index is the page
+// index interleaving is based on, such as the virtual page number.
+// Returns nullptr if no allowed node has free memory.
+char* mempolicy_zalloc(const char *name, const mempolicy &pol, u64 index);
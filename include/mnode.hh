@@ -2,7 +2,7 @@
 
 #include "kernel.hh"
 #include "refcache.hh"
-#include "chainhash.hh"
+#include "splithash.hh"
 #include "radix_array.hh"
 #include "page_info.hh"
 #include "kalloc.hh"
@@ -51,6 +51,7 @@ public:
 
   void cache_pin(bool flag);
   u8 type() const { return inumber(inum_).type(); }
+  static u8 type_of(u64 inum) { return inumber(inum).type(); }
 
   mdir* as_dir();
   const mdir* as_dir() const;
@@ -149,17 +150,15 @@ public:
 
 class mdir : public mnode {
 private:
-  // ~32K cache
-  mdir(mfs* fs, u64 inum) : mnode(fs, inum), map_(1367) {}
+  mdir(mfs* fs, u64 inum) : mnode(fs, inum) {}
   NEW_DELETE_OPS(mdir);
   friend class mnode;
   friend class mfs;
 
-  // XXX We should deal with varying directory sizes better.  One way
-  // would be to make this a resizable hash table.  Linux uses a
-  // unified directory cache hash table, but that would make
-  // serializing a directory much harder for us.
-  chainhash<strbuf<DIRSIZ>, u64> map_;
+  // Starts with a few buckets and grows and shrinks with the
+  // directory.  Linux uses a unified directory cache hash table, but
+  // that would make serializing a directory much harder for us.
+  splithash<strbuf<DIRSIZ>, u64> map_;
 
 public:
   bool insert(const strbuf<DIRSIZ>& name, mlinkref* ilink) {
@@ -288,6 +287,23 @@ public:
     return map_.enumerate(prev, name);
   }
 
+  /*
+   * Call cb(name, inum) for each entry after *prev, or from the first
+   * entry if prev is nullptr, in the same order as enumerate, until cb
+   * returns false.  Returns false if it ran out of entries.
+   */
+  template<class CB>
+  bool enumerate_from(const strbuf<DIRSIZ>* prev, CB cb) const {
+    if (!prev) {
+      if (!cb(strbuf<DIRSIZ>("."), inum_))
+        return true;
+    } else if (*prev == ".") {
+      prev = nullptr;
+    }
+
+    return map_.enumerate_from(prev, cb);
+  }
+
   bool kill(sref<mnode> parent) {
     if (!map_.remove_and_kill("..", parent->inum_))
       return false;
@@ -43,12 +43,12 @@ struct xbucket {
   std::atomic<xelem<K, V>*> volatile chain;
 } ; // __attribute__((aligned (CACHELINE)));
 
-template<class K, class V, u64 (*HF)(const K&)>
+template<class K, class V, u64 (*HF)(const K&), u64 NH = NHASH>
 class xns : public rcu_freed {
  private:
   bool allowdup;
   std::atomic<u64> nextkey;
-  xbucket<K, V> table[NHASH];
+  xbucket<K, V> table[NH];
   std::atomic<xelem<K, V>*> percore[NCPU];
   spinlock percore_lock[NCPU];
 
@@ -56,7 +56,7 @@ class xns : public rcu_freed {
   xns(bool dup) : rcu_freed("xns", this, sizeof(*this)) {
     allowdup = dup;
     nextkey = 1;
-    for (int i = 0; i < NHASH; i++)
+    for (u64 i = 0; i < NH; i++)
       table[i].chain = 0;
     for (int i = 0; i < NCPU; i++) {
       percore[i] = nullptr;
@@ -65,7 +65,7 @@ class xns : public rcu_freed {
   }
 
   ~xns() {
-    for (int i = 0; i < NHASH; i++)
+    for (u64 i = 0; i < NH; i++)
       if (table[i].chain)
         panic("~xns: not empty");
   }
@@ -79,7 +79,7 @@ class xns : public rcu_freed {
   }
 
   u64 h(const K &key) {
-    return HF(key) % NHASH;
+    return HF(key) % NH;
   }
 
   bool insert(const K &key, const V &val) {
@@ -221,22 +221,22 @@ class xns : public rcu_freed {
 
   class iterator : public scoped_gc_epoch {
   private:
-    xns<K, V, HF> *ns_;
+    xns<K, V, HF, NH> *ns_;
     xelem<K, V> *chain_;
     int ndx_;
 
   public:
-    iterator(xns<K, V, HF> *ns) {
+    iterator(xns<K, V, HF, NH> *ns) {
       ns_ = ns;
       ndx_ = 0;
       chain_ = ns->table[ndx_++].chain;
-      for (; chain_ == 0 && ndx_ < NHASH; ndx_++)
+      for (; chain_ == 0 && ndx_ < NH; ndx_++)
         chain_ = ns_->table[ndx_].chain;
     }
 
     iterator() {
       ns_ = 0;
-      ndx_ = NHASH;
+      ndx_ = NH;
       chain_ = 0;
     }
 
@@ -245,7 +245,7 @@ class xns : public rcu_freed {
     }
 
     iterator& operator ++() {
-      for (chain_ = chain_->next; chain_ == 0 && ndx_ < NHASH; ndx_++)
+      for (chain_ = chain_->next; chain_ == 0 && ndx_ < NH; ndx_++)
         chain_ = ns_->table[ndx_].chain;
       return *this;
     }
@@ -266,18 +266,18 @@ class xns : public rcu_freed {
   NEW_DELETE_OPS(xns)
 };
 
-template<class K, class V, u64 (*HF)(const K&)>
+template<class K, class V, u64 (*HF)(const K&), u64 NH>
 static inline
-typename xns<K, V, HF>::iterator
-begin(xns<K, V, HF> *&ns)
+typename xns<K, V, HF, NH>::iterator
+begin(xns<K, V, HF, NH> *&ns)
 {
   return ns->begin();
 }
 
-template<class K, class V, u64 (*HF)(const K&)>
+template<class K, class V, u64 (*HF)(const K&), u64 NH>
 static inline
-typename xns<K, V, HF>::iterator
-end(xns<K, V, HF> *&ns)
+typename xns<K, V, HF, NH>::iterator
+end(xns<K, V, HF, NH> *&ns)
 {
   return ns->end();
 }
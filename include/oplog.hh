@@ -1,4 +1,6 @@
-// XXX This compiles, but is completely untested
+// XXX tsc_logged_object compiles, but is untested and its
+// flush_finish is unimplemented.  logged_object is used by the page
+// reverse map (see rmap.cc).
 
 #pragma once
 
@@ -43,7 +45,9 @@ namespace oplog {
   // may be many Logger instances created per logged_object.  Logger
   // must have a default constructor, but there are no other
   // requirements.
-  template<typename Logger>
+  // @tparam Slots The number of cached loggers per CPU.  This bounds
+  // the per-CPU memory spent on Logger instances of this type.
+  template<typename Logger, std::size_t Slots = CACHE_SLOTS>
   class logged_object
   {
   public:
@@ -60,6 +64,8 @@ namespace oplog {
       locked_logger(lock_guard<spinlock> &&lock, Logger *logger)
         : lock_(std::move(lock)), logger_(logger) { }
 
+      friend class logged_object;
+
     public:
       locked_logger(locked_logger &&o)
         : lock_(std::move(o.lock_)), logger_(o.logger_)
@@ -72,6 +78,7 @@ namespace oplog {
         lock_ = std::move(o.lock_);
         logger_ = o.logger_;
         o.logger_ = nullptr;
+        return *this;
       }
 
       // Return the protected Logger instance.  Note that there is no
@@ -150,7 +157,11 @@ namespace oplog {
           auto way_guard = way->lock_.guard();
           auto cur_obj = way->obj_.load(std::memory_order_relaxed);
           assert(cur_obj == this);
-          flush_logger(way->logger_);
+          flush_logger(&way->logger_);
+          // Untag the way, so the next get_logger on this CPU sets
+          // our bit in cpus_ again, and so an object may be freed
+          // once it has been synchronized.
+          way->obj_.store(nullptr, std::memory_order_relaxed);
           cpus_.atomic_reset(cpu);
           any = true;
         }
@@ -164,7 +175,7 @@ namespace oplog {
       // loggers and should do any final flushing.
       flush_finish();
 
-      return std::move(guard);
+      return guard;
     }
 
     // Flush one logger, resetting it to its initial state.  This may
@@ -191,15 +202,15 @@ namespace oplog {
 
     struct cache
     {
-      way ways_[CACHE_SLOTS];
+      way ways_[Slots];
 
-      way *hash_way(logged_object *obj) const
+      way *hash_way(logged_object *obj)
       {
         // Hash based on Java's HashMap re-hashing function.
         uint64_t wayno = (uintptr_t)obj;
         wayno ^= (wayno >> 32) ^ (wayno >> 20) ^ (wayno >> 12);
         wayno ^= (wayno >> 7) ^ (wayno >> 4);
-        wayno %= CACHE_SLOTS;
+        wayno %= Slots;
         return &ways_[wayno];
       }
     };
@@ -217,6 +228,10 @@ namespace oplog {
     spinlock sync_lock_;
   };
 
+  template<typename Logger, std::size_t Slots>
+  percpu<typename logged_object<Logger, Slots>::cache, NO_CRITICAL>
+  logged_object<Logger, Slots>::cache_;
+
   // The logger class used by tsc_logged_object.
   class tsc_logger
   {
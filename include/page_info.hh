@@ -6,29 +6,9 @@
 #include "gc.hh"
 #include "types.h"
 
+#include <atomic>
 #include <cstddef>
 
-// Per-allocation debug information
-struct alloc_debug_info
-{
-#if KERNEL_HEAP_PROFILE
-  // Instruction pointer of allocation
-  const void *kalloc_rip_, *kmalloc_rip_;
-  void set_kalloc_rip(const void *kalloc_rip) { kalloc_rip_ = kalloc_rip; }
-  const void *kalloc_rip() const { return kalloc_rip_; }
-  void set_kmalloc_rip(const void *kmalloc_rip) { kmalloc_rip_ = kmalloc_rip; }
-  const void *kmalloc_rip() const { return kmalloc_rip_; }
-#else
-  void set_kalloc_rip(const void *kalloc_rip) { }
-  const void *kalloc_rip() const { return nullptr; }
-  void set_kmalloc_rip(const void *kmalloc_rip) { }
-  const void *kmalloc_rip() const { return nullptr; }
-#endif
-
-  static size_t expand_size(size_t size);
-  static alloc_debug_info *of(void *p, size_t size);
-};
-
 // The page_info_map maps from physical address to page_info array.
 // The map is indexed by
 //   ((phys + page_info_map_add) >> page_info_map_shift)
@@ -41,6 +21,8 @@ struct page_info_map_entry
   paddr phys_base;
   // The page_info array, indexed by (phys - phys_base) / PGSIZE.
   class page_info *array;
+  // The NUMA node (index in numa_nodes) of the pages in array.
+  std::size_t node;
 };
 extern page_info_map_entry page_info_map[256];
 extern size_t page_info_map_add, page_info_map_shift;
@@ -48,20 +30,25 @@ extern size_t page_info_map_add, page_info_map_shift;
 // One past the last used entry of page_info_map.
 extern page_info_map_entry *page_info_map_end;
 
+void rmap_free(class page_rmap *rmap);
+
 // Physical page metadata
-//
-// This inherits from alloc_debug_info to exploit empty base class
-// optimization.
-class page_info : public PAGE_REFCOUNT referenced, public alloc_debug_info
+class page_info : public PAGE_REFCOUNT referenced
 {
 protected:
   void onzero()
   {
+    if (page_rmap *r = rmap.load(std::memory_order_relaxed))
+      rmap_free(r);
     kfree(va());
   }
 
 public:
-  page_info() { }
+  page_info() : rmap(nullptr) { }
+
+  // The address spaces that map this page, allocated when the page is
+  // first mapped.  See rmap.hh.
+  std::atomic<class page_rmap*> rmap;
 
   // Only placement new is allowed, because page_info must only be
   // constructed in the page_info_array.
@@ -84,6 +71,17 @@ public:
     return &entry->array[index];
   }
 
+  // Return the NUMA node of the page containing the given physical
+  // address.
+  static std::size_t
+  node_of(paddr pa)
+  {
+    page_info_map_entry *entry =
+      &page_info_map[(pa + page_info_map_add) >> page_info_map_shift];
+    assert(entry < page_info_map_end);
+    return entry->node;
+  }
+
   // Return the page_info for the page at direct-mapped virtual
   // address va.
   static page_info *
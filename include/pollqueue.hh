@@ -0,0 +1,81 @@
+#pragma once
+
+// Wait queues for poll.
+//
+// A process can only sleep on one condvar, but poll waits on many
+// files at once.  So a poll sleeps on the condvar of its own poller,
+// and each file whose poll result can change keeps a pollqueue of the
+// pollers waiting on it.  The file wakes its pollqueue whenever its
+// poll result may have changed, which wakes every poller on it.
+
+#include "spinlock.hh"
+#include "condvar.hh"
+#include "ilist.hh"
+#include <atomic>
+
+// One process waiting in poll.
+struct poller
+{
+  spinlock lock;
+  condvar cv;
+  // Set when any file this poller waits on may have become ready.
+  // Protected by lock.
+  bool woken;
+
+  poller() : lock("poller"), cv("poller"), woken(false) { }
+
+  poller(const poller &o) = delete;
+  poller &operator=(const poller &o) = delete;
+
+  // Start a round of polling.  The caller should poll its files after
+  // this and, if none are ready, call sleep_to, which returns at once
+  // if any of them may have become ready in between.
+  void arm();
+
+  // Sleep until woken or until nsectime() reaches deadline.
+  void sleep_to(u64 deadline);
+
+  void wake();
+};
+
+// A poller's place in one pollqueue.  Destroying an entry removes it
+// from its queue, so a poll that's killed while it sleeps still
+// unregisters.
+struct pollentry
+{
+  poller *p;
+  struct pollqueue *q;
+  ilink<pollentry> link;
+
+  pollentry() : p(nullptr), q(nullptr) { }
+  ~pollentry();
+
+  pollentry(const pollentry &o) = delete;
+  pollentry &operator=(const pollentry &o) = delete;
+
+  NEW_DELETE_OPS(pollentry);
+};
+
+struct pollqueue
+{
+  spinlock lock;
+  ilist<pollentry, &pollentry::link> entries;
+  // The number of entries, so wake can skip the lock when there are
+  // no pollers.
+  std::atomic<unsigned> nentries;
+
+  pollqueue() : lock("pollqueue"), nentries(0) { }
+
+  pollqueue(const pollqueue &o) = delete;
+  pollqueue &operator=(const pollqueue &o) = delete;
+
+  // Add e to this queue on behalf of p.
+  void add(pollentry *e, poller *p);
+
+  // Remove e from this queue.
+  void remove(pollentry *e);
+
+  // Wake every poller on this queue.  Call this after any change that
+  // may make a poll of this queue's file return something new.
+  void wake();
+};
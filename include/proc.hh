@@ -7,6 +7,8 @@
 #include "sched.hh"
 #include <uk/signal.h>
 #include "ilist.hh"
+#include "mempolicy.hh"
+#include "numa.hh"
 #include <stdexcept>
 
 struct pgmap;
@@ -98,6 +100,8 @@ struct proc {
   int in_exec_;
   int uaccess_;
   bool yield_;                 // yield cpu up when returning to user space
+  bool vfork_;                 // Parent is suspended until we exec or exit
+  userptr<u64> clear_tid_;     // Zeroed and futex-woken when we exit or exec
 
   userptr_str upath;
   userptr<userptr_str> uargv;
@@ -108,6 +112,9 @@ struct proc {
   u8 exception_buf[256];
   u64 magic;
   uptr unmapped_hint;
+  struct mempolicy mpol;       // NUMA policy for user memory
+  u32 numa_faults[MAX_NUMA_NODES]; // NUMA hinting faults by page node
+  int numa_pref;               // Node holding most of our memory, or -1
   sigaction sig[NSIG];
 
   static proc* alloc();
@@ -126,6 +133,8 @@ struct proc {
   static u64   hash(const u32& p);
 
   bool deliver_signal(int signo);
+  void vfork_release();
+  void release_tid(struct vmap *vm);
 
   ~proc(void);
   NEW_DELETE_OPS(proc);
@@ -29,7 +29,7 @@
 // reference count deltas in its cache, applying these updates to the
 // global reference count of each object.  The last core in an epoch
 // to finish flushing its cache ends the epoch and after some delay
-// (our implementation uses 10ms) all of the cores repeat this
+// (see "epoch management" below) all of the cores repeat this
 // process.  Since these flushes occur in no particular order and the
 // caches batch reference count changes, updates to the reference
 // count can be reordered.  As a result, a zero global reference count
@@ -94,8 +94,10 @@
 // bit first.
 //
 // The pseudocode for refcache is given below.  Each core maintains a
-// hash table storing its reference delta cache and a "review" queue
-// that tracks objects whose global reference counts reached zero.  A
+// set-associative hash table storing its reference delta cache (an
+// object that misses in a full set evicts the set's least recently
+// used delta) and a "review" queue that tracks objects whose global
+// reference counts reached zero.  A
 // core reviews an object once it can guarantee that all cores have
 // flushed their reference caches after it put the object in its
 // review queue.
@@ -140,13 +142,29 @@
 //       inc(weakref.pointer)
 //     return weakref.pointer
 //
-// For epoch management, our current implementation uses a simple
-// barrier scheme that tracks a global epoch counter, per-core epochs,
-// and a count of how many per-core epochs have reached the current
-// global epoch.  This scheme suffices for our benchmarks, but more
-// scalable schemes are possible, such as the tree-based quiescent
-// state detection scheme used by Linux's hierarchical RCU
-// implementation [http://lwn.net/Articles/305782/].
+// For epoch management, we track a global epoch counter, per-core
+// epochs, and a two-level combining tree that counts how many
+// per-core epochs have reached the current global epoch, much like
+// the quiescent state detection of Linux's hierarchical RCU
+// [http://lwn.net/Articles/305782/].  Each leaf of the tree covers
+// up to REFCACHE_EPOCH_FANOUT cores of one NUMA node and counts the
+// cores that have yet to flush; the last core of a leaf to flush
+// decrements the root's count of unfinished leaves, and the last
+// leaf ends the epoch.  Thus a flush only writes shared state
+// within its own socket, except once per leaf per epoch.
+//
+// Epochs are adaptive.  A core flushes at most once every
+// epoch_ticks timer ticks.  As they finish flushing, the cores sum
+// the lengths of their review queues up the tree, and the core that
+// ends an epoch uses the total to adjust epoch_ticks: it halves it
+// (down to one tick) if at least REFCACHE_BACKLOG objects await
+// review, and otherwise lengthens it by a tick, up to
+// REFCACHE_MAX_EPOCH_TICKS.  Thus an idle system flushes rarely,
+// while one that's freeing many objects reviews them quickly.  When
+// memory is short, synchronize() forces epochs to end immediately
+// by having every core flush from an IPI, and waits until every
+// object whose true count was zero when it was called has been
+// reviewed.
 
 #pragma once
 
@@ -168,8 +186,15 @@
 
 namespace refcache {
   enum {
-    CACHE_SLOTS = 4096
+    // The most ways each core's cache can have.  The number in use
+    // can be changed at run time by writing to /dev/refcache.
+    CACHE_SLOTS = 4096,
+    // The cache's associativity.  At most 4, so a set's LRU order
+    // fits in a byte.
+    CACHE_WAYS = 4,
   };
+  static_assert(CACHE_WAYS <= 4 && CACHE_SLOTS % CACHE_WAYS == 0,
+                "bad refcache geometry");
 
   template<class T> class weakref;
 
@@ -207,6 +232,10 @@ namespace refcache {
     // list.
     uint64_t review_epoch_;
 
+    // The TSC when the global count last dropped to zero, for
+    // measuring how long objects take to be freed.
+    uint64_t zero_tsc_;
+
     // True if this object's refcount was non-zero and then zero again
     // since it was last reviewed.
     bool dirty_ : 1;
@@ -221,6 +250,7 @@ namespace refcache {
         refcount_(refcount),
         next_(),
         review_epoch_(0),
+        zero_tsc_(0),
         dirty_(false),
         weak_(false) { }
     virtual ~referenced() { }
@@ -402,11 +432,19 @@ namespace refcache {
       constexpr way() : obj(), delta() { }
     };
 
-    // The ways of the cache.  This must be accessed with interrupts
-    // disabled to prevent interference between a review process and
-    // capacity evictions.
+    // The ways of the cache, in sets of CACHE_WAYS consecutive ways.
+    // This must be accessed with interrupts disabled to prevent
+    // interference between a review process and capacity evictions.
     way ways_[CACHE_SLOTS];
 
+    // The recency order of each set's ways.  Bits 2i+1..2i hold the
+    // i'th most recently used way of the set.
+    uint8_t lru_[CACHE_SLOTS / CACHE_WAYS];
+
+    // The number of sets in use.  This only changes in flush, when
+    // the cache is empty.
+    std::size_t nsets_;
+
     // The list of objects to review in increasing epoch order.  This
     // must be accessed only by the local core and there must be at
     // most one reviewer at a time per core.
@@ -419,42 +457,73 @@ namespace refcache {
     spinlock reap_lock_;
     condvar reap_cv_;
 
+    // The number of objects on review_.  Updated with interrupts
+    // disabled.
+    uint64_t review_len_;
+
     // The last global epoch number observed by this core.
     uint64_t local_epoch;
 
-    // Return the way in which a particular object's delta could be stored.
-    way *hash_way(referenced *obj)
+    // Timer ticks since this core last flushed.
+    uint64_t ticks_;
+
+    // Return the first way of the set in which a particular object's
+    // delta could be stored.
+    way *hash_set(referenced *obj)
     {
       // Hash based on Java's HashMap re-hashing function.
-      std::uint64_t wayno = (uintptr_t)obj;
-      wayno ^= (wayno >> 32) ^ (wayno >> 20) ^ (wayno >> 12);
-      wayno ^= (wayno >> 7) ^ (wayno >> 4);
-      wayno %= CACHE_SLOTS;
-      struct way *way = &ways_[wayno];
-      // XXX More associativity.  Since this is in the critical path
-      // of every reference operation, perhaps we should do something
-      // like hash-rehash caching?  Would require returning multiple
-      // candidate ways.
-      return way;
+      std::uint64_t setno = (uintptr_t)obj;
+      setno ^= (setno >> 32) ^ (setno >> 20) ^ (setno >> 12);
+      setno ^= (setno >> 7) ^ (setno >> 4);
+      setno %= nsets_;
+      return &ways_[setno * CACHE_WAYS];
+    }
+
+    // Make way w the most recently used way of set setno.
+    void touch(std::size_t setno, unsigned w)
+    {
+      unsigned lru = lru_[setno];
+      if ((lru & 3) == w)
+        return;
+      unsigned pos = 1;
+      while (((lru >> (2 * pos)) & 3) != w)
+        pos++;
+      // Move the ways more recent than w down one place
+      unsigned newer = lru & ((1u << (2 * pos)) - 1);
+      unsigned older = lru & ~((1u << (2 * pos + 2)) - 1);
+      lru_[setno] = older | (newer << 2) | w;
     }
 
     // Place obj in the cache if necessary and return its assigned
     // way.  Interrupts must be disabled.
     way *get_way(referenced *obj)
     {
-      struct way *way = hash_way(obj);
-      if (way->obj != obj) {
-        // This object is not in the cache
-        if (way->obj) {
+      struct way *set = hash_set(obj);
+      std::size_t setno = (set - ways_) / CACHE_WAYS;
+      unsigned w;
+      for (w = 0; w < CACHE_WAYS; w++)
+        if (set[w].obj == obj)
+          break;
+      if (w == CACHE_WAYS) {
+        // This object is not in the cache.  Take an empty way, or
+        // else the set's least recently used way.
+        kstats::inc(&kstats::refcache_miss_count);
+        for (w = 0; w < CACHE_WAYS; w++)
+          if (!set[w].obj)
+            break;
+        if (w == CACHE_WAYS) {
           // Need to evict to free up an entry.  Since this is a
           // capacity eviction, local_epoch may be behind
           // global_epoch.
-          evict(way, false);
+          w = (lru_[setno] >> (2 * (CACHE_WAYS - 1))) & 3;
+          evict(&set[w], false);
           kstats::inc(&kstats::refcache_conflict_count);
         }
         // Take this entry
-        way->obj = obj;
+        set[w].obj = obj;
       }
+      touch(setno, w);
+      struct way *way = &set[w];
       // If the delta is getting close to overflowing, evict.
       if (way->delta == INT_MAX || way->delta == INT_MIN) {
         evict(way, false);
@@ -470,8 +539,9 @@ namespace refcache {
     // global_epoch - 1.
     void evict(struct way *way, bool local_epoch_is_exact);
 
-    // Flush this core's refcache.
-    void flush();
+    // Flush this core's refcache.  Returns false without flushing if
+    // this core has already reached the global epoch.
+    bool flush();
 
     // Scan this core's review list.  The calling thread must be
     // pinned (but interrupts may be enabled).  At most one review
@@ -479,22 +549,42 @@ namespace refcache {
     void review();
 
   public:
-    cache() = default;
+    cache()
+      : ways_(), nsets_(CACHE_SLOTS / CACHE_WAYS), review_len_(0),
+        local_epoch(0), ticks_(0)
+    {
+      // Start each set in way order
+      unsigned lru = 0;
+      for (unsigned w = 0; w < CACHE_WAYS; w++)
+        lru |= w << (2 * w);
+      for (auto &l : lru_)
+        l = lru;
+    }
     cache(const cache &o) = delete;
     cache(cache &&o) = delete;
     cache &operator=(const cache &o) = delete;
     cache &operator=(cache &&o) = delete;
 
-    // Periodic tick handler.  Flushes the refcache and scans review
-    // lists.  The latency of garbage collection is between two and
-    // three times the delay between calls to tic.
-    void tick();
+    // Periodic tick handler.  Flushes the refcache if epoch_ticks
+    // ticks have passed since the last flush, or immediately if
+    // force, and scans review lists.  The latency of garbage
+    // collection is between two and three epochs.  Interrupts must
+    // be disabled.
+    void tick(bool force = false);
 
     // Reap dead objects.  This is done in a dedicated thread to
     // avoid deadlock with threads preempted by the timer interrupt.
     void reaper() __attribute__((noreturn));
   };
 
+  // Force refcache epochs to end and wait until every object whose
+  // true reference count is zero at the time of the call has been
+  // reviewed and, unless it was revived, queued to be reaped.  This
+  // takes a few rounds of IPIs to every core, so it's meant for when
+  // memory is short.  Must be called with interrupts enabled and no
+  // spinlocks held.
+  void synchronize();
+
   // Per-CPU reference delta cache.  In general this has to be
   // accessed with interrupts disabled or by a pinned process to
   // prevent migration.  Some fields of cache specifically require
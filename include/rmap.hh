@@ -0,0 +1,54 @@
+#pragma once
+
+// Physical page reverse maps.
+//
+// A page's reverse map records the address spaces that map it and
+// where, so reclaim and migration can find every mapping of a page
+// without scanning every vmap.  Pages are mapped and unmapped far
+// more often than anyone asks where they are mapped, so the reverse
+// map is an OpLog object (see oplog.hh): rmap_add and rmap_remove
+// append to a per-CPU log, and the logs are applied only when the map
+// is read.  Operations on the same mapping combine in the log, so a
+// page that is mapped and unmapped again on one core, as most
+// anonymous pages are, never touches the page's shared state.
+//
+// vmap maintains the reverse maps of the pages its vmdescs hold,
+// except for private anonymous pages that aren't copy-on-write.  Those
+// are mapped only by their own page frame, so page faults on fresh
+// anonymous memory needn't log anything.  See rmap_tracked in vm.cc.
+
+#include "types.h"
+#include "ref.hh"
+
+class page_info;
+struct vmap;
+
+// Record that vm maps pi at page-aligned address va.
+void rmap_add(page_info *pi, vmap *vm, uptr va);
+
+// Record that vm no longer maps pi at va.
+void rmap_remove(page_info *pi, vmap *vm, uptr va);
+
+// Like rmap_remove, for a vmap being destroyed.  This also waits for
+// any rmap_get that might still be looking at vm.
+void rmap_remove_final(page_info *pi, vmap *vm, uptr va);
+
+struct rmap_entry
+{
+  sref<vmap> vm;
+  uptr va;
+};
+
+// Store up to max of pi's current mappings in out, which must hold
+// null vmap references, and return the total number of mappings.  Each
+// stored entry holds a reference to its vmap.  Mappings by vmaps that
+// are being destroyed may be skipped.  The total may count mappings
+// that weren't stored, so if nstored isn't null, set *nstored to the
+// number of entries stored.
+size_t rmap_get(page_info *pi, rmap_entry *out, size_t max,
+                size_t *nstored = nullptr);
+
+// Remove pi from every address space that maps it and can fault it
+// back in, that is, every mapping of pi as a page of a file.  Returns
+// the number of mappings left.
+size_t rmap_unmap(page_info *pi);
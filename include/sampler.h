@@ -17,32 +17,45 @@ struct perf_selector
   // this measures.
   // XXX Sandy Bridge changed the required selector.
   uint16_t load_latency;
+  // The number of return addresses to record with each sample, at
+  // most NTRACE_MAX.  0 means NTRACE.
+  uint16_t trace_depth;
   // The event selector code.  This is architecture-specific, but
   // generally includes an event number, a unit mask, and various
   // other flags.  Any interrupt flag is ignored.
   uint64_t selector;
   // If non-zero, record the current instruction pointer every
   // 'period' events.
+  //
+  // On machines without a usable PMU (e.g., QEMU TCG), samples are
+  // taken from the timer interrupt instead.  selector and precise are
+  // ignored and period is the sampling interval in nanoseconds,
+  // rounded up to a whole number of timer ticks.  Code running with
+  // interrupts disabled is never sampled in this mode.
   uint64_t period;
 };
 
+// Default and maximum stack trace depth
 #define NTRACE 4
+#define NTRACE_MAX 32
 
+// A sample.  Reading /dev/sampler returns whole samples back to back,
+// each followed by its ntrace return addresses.
 struct pmuevent {
   u8 idle:1;
   u8 ints_disabled:1;
   u8 kernel:1;
+  u8 ntrace;
+  u16 cpu;
   u32 count;
   u64 rip;
-  uptr trace[NTRACE];
   u32 latency, data_source;
   u64 load_address;
+  uptr trace[];
 };
 
-struct logheader {
-  u64 ncpus;
-  struct {
-    u64 offset;
-    u64 size;
-  } cpu[];
-} __attribute__((packed));
+static inline size_t
+pmuevent_size(const struct pmuevent *ev)
+{
+  return sizeof(*ev) + ev->ntrace * sizeof(ev->trace[0]);
+}
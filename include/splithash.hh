@@ -0,0 +1,535 @@
+#pragma once
+
+/*
+ * A resizable bucket-chaining hash table.
+ *
+ * Buckets are selected by the high bits of a mixed hash value, so
+ * doubling the table splits bucket i into buckets 2i and 2i+1, and
+ * halving it merges them back.  Items are therefore ordered by (hash,
+ * key) across buckets no matter how big the table is, which gives
+ * enumerate() a cursor that stays valid across resizes.
+ *
+ * Lookups are lock-free and run in an RCU epoch.  Updates take a
+ * per-bucket spinlock.  A resize allocates a new table, points the
+ * old table's next at it, and migrates one bucket at a time: it copies
+ * the bucket's items into the new table, marks the old bucket as
+ * migrated, and only then unlinks the old items.  Anyone who finds a
+ * migrated bucket follows next, so lookups and updates proceed
+ * throughout.  Old tables and items are freed with gc_delayed.
+ *
+ * Resizing is driven by cheap local signals rather than a shared item
+ * count: an insert that makes a chain longer than max_chain doubles
+ * the table, and a remove that empties a bucket in a sparse
+ * neighborhood halves it.
+ */
+
+#include "spinlock.hh"
+#include "seqlock.hh"
+#include "lockwrap.hh"
+#include "hash.hh"
+#include "ilist.hh"
+#include "atomic_util.hh"
+
+template<class K, class V>
+class splithash {
+private:
+  enum {
+    // Tables start with, and never shrink below, 1 << min_order buckets.
+    min_order = 2,
+    max_order = 20,
+    // Double the table when an insert makes a chain longer than this.
+    max_chain = 8,
+    // Halve the table when a remove empties a bucket and the
+    // surrounding shrink_window buckets hold at most shrink_window/8
+    // items.
+    shrink_window = 16,
+  };
+
+  struct item : public rcu_freed {
+    item(u64 h, const K& k, const V& v)
+      : rcu_freed("splithash::item", this, sizeof(*this)),
+        hash(h), key(k), val(v) {}
+    void do_gc() override { delete this; }
+    NEW_DELETE_OPS(item);
+
+    islink<item> link;
+    seqcount<u32> seq;
+    const u64 hash;
+    const K key;
+    V val;
+  };
+
+  struct bucket {
+    spinlock lock __mpalign__;
+    islist<item, &item::link> chain;
+    // Length of chain.  Protected by lock, but read without it as a
+    // resize hint.
+    u32 length;
+    // Set once this bucket's items have been copied into the next
+    // table.  After that, all operations on its hash range go there.
+    std::atomic<bool> migrated;
+
+    bucket() : length(0), migrated(false) {}
+
+    ~bucket() {
+      while (!chain.empty()) {
+        item *i = &chain.front();
+        chain.pop_front();
+        gc_delayed(i);
+      }
+    }
+  };
+
+  struct table : public rcu_freed {
+    const u32 order;
+    bucket* const buckets;
+    // The table this one is being migrated into, if any.
+    std::atomic<table*> next;
+
+    table(u32 o)
+      : rcu_freed("splithash::table", this, sizeof(*this)), order(o),
+        buckets((bucket*) kmalloc(sizeof(bucket) << o, "splithash")),
+        next(nullptr)
+    {
+      if (!buckets)
+        throw_bad_alloc();
+      for (u64 i = 0; i < size(); i++)
+        new (&buckets[i]) bucket();
+    }
+
+    ~table() {
+      for (u64 i = 0; i < size(); i++)
+        buckets[i].~bucket();
+      kmfree(buckets, sizeof(bucket) << order);
+    }
+
+    void do_gc() override { delete this; }
+    NEW_DELETE_OPS(table);
+
+    u64 size() const { return 1ull << order; }
+    u64 index(u64 h) const { return h >> (64 - order); }
+    bucket* get(u64 h) const { return &buckets[index(h)]; }
+
+    // The first and last hash values that map to bucket idx.
+    u64 first(u64 idx) const { return idx << (64 - order); }
+    u64 last(u64 idx) const { return first(idx) | (~0ull >> order); }
+  };
+
+  std::atomic<table*> cur_;
+  std::atomic<bool> resizing_;
+  bool dead_;
+
+  static u64 mix(const K& k) {
+    // Fibonacci hashing moves the entropy of hash(k) into the high
+    // bits, which are the ones that select a bucket.
+    return hash(k) * 0x9e3779b97f4a7c15ull;
+  }
+
+  static const item* find(const bucket* b, u64 h, const K& k) {
+    for (const item& i: b->chain)
+      if (i.hash == h && i.key == k)
+        return &i;
+    return nullptr;
+  }
+
+  // Return the bucket currently responsible for hash value h, without
+  // locking it.  The caller must be in an RCU epoch.
+  bucket* live_bucket(u64 h, table** tp = nullptr) const {
+    table* t = cur_;
+    for (;;) {
+      bucket* b = t->get(h);
+      if (!b->migrated) {
+        if (tp)
+          *tp = t;
+        return b;
+      }
+      t = t->next;
+    }
+  }
+
+  // Lock the bucket currently responsible for hash value h and return
+  // it in *bp.  The caller must be in an RCU epoch.
+  scoped_acquire lock_bucket(u64 h, bucket** bp, table** tp = nullptr) {
+    for (;;) {
+      bucket* b = live_bucket(h, tp);
+      scoped_acquire l(&b->lock);
+      if (!b->migrated) {
+        *bp = b;
+        return l;
+      }
+    }
+  }
+
+  // Copy the items of t's bucket idx into nt and retire them from t.
+  // The caller holds the bucket's lock.  Returns false, without doing
+  // anything, if one of the destination buckets is busy; the caller
+  // must then drop the source lock and retry, since updates lock
+  // source and destination buckets in address order, not table order.
+  bool migrate_bucket(table* t, u64 idx, table* nt) {
+    bucket* b = &t->buckets[idx];
+    u64 lo = nt->index(t->first(idx)), hi = nt->index(t->last(idx));
+    assert(hi - lo < 2);
+
+    scoped_acquire l0(&nt->buckets[lo].lock, scoped_acquire::try_guard_tag);
+    if (!l0)
+      return false;
+    scoped_acquire l1;
+    if (hi != lo) {
+      l1 = nt->buckets[hi].lock.try_guard();
+      if (!l1)
+        return false;
+    }
+
+    for (const item& i: b->chain) {
+      bucket* nb = nt->get(i.hash);
+      nb->chain.push_front(new item(i.hash, i.key, i.val));
+      nb->length++;
+    }
+
+    // Readers check migrated after scanning a chain, so this must be
+    // visible before the chain empties.
+    b->migrated = true;
+    barrier();
+    while (!b->chain.empty()) {
+      item *i = &b->chain.front();
+      b->chain.pop_front();
+      gc_delayed(i);
+    }
+    b->length = 0;
+    return true;
+  }
+
+  // Replace table t with a table of 1 << order buckets.  Lookups and
+  // updates continue while buckets migrate.
+  void resize(table* t, u32 order) {
+    table* nt = new table(order);
+    t->next = nt;
+    for (u64 idx = 0; idx < t->size(); idx++) {
+      bucket* b = &t->buckets[idx];
+      for (;;) {
+        scoped_acquire l(&b->lock);
+        if (migrate_bucket(t, idx, nt))
+          break;
+        l.release();
+        nop_pause();
+      }
+    }
+    cur_ = nt;
+    gc_delayed(t);
+  }
+
+  // Resize t to 1 << order buckets, unless t has already been replaced
+  // or somebody else is resizing.
+  void maybe_resize(table* t, u32 order) {
+    if (order < min_order || order > max_order)
+      return;
+    if (resizing_ || !cmpxch(&resizing_, false, true))
+      return;
+    if (cur_ == t && !dead_)
+      resize(t, order);
+    resizing_ = false;
+  }
+
+  // Called after removing from t's bucket b.  If b's neighborhood is
+  // sparse, halve the table.
+  void maybe_shrink(table* t, bucket* b) {
+    if (b->length || t->order <= min_order)
+      return;
+    u64 window = t->size() < shrink_window ? t->size() : shrink_window;
+    u64 start = (b - t->buckets) & ~(window - 1);
+    u64 n = 0;
+    for (u64 i = start; i < start + window; i++)
+      n += t->buckets[i].length;
+    if (n * 8 <= window)
+      maybe_resize(t, t->order - 1);
+  }
+
+public:
+  splithash() : cur_(new table(min_order)), resizing_(false), dead_(false) {}
+
+  ~splithash() {
+    delete cur_.load();
+  }
+
+  NEW_DELETE_OPS(splithash);
+
+  bool insert(const K& k, const V& v) {
+    if (dead_ || lookup(k))
+      return false;
+
+    scoped_gc_epoch rcu_read;
+    u64 h = mix(k);
+    bucket* b;
+    table* t;
+    auto l = lock_bucket(h, &b, &t);
+
+    if (dead_ || find(b, h, k))
+      return false;
+
+    b->chain.push_front(new item(h, k, v));
+    u32 len = ++b->length;
+    l.release();
+
+    if (len > max_chain)
+      maybe_resize(t, t->order + 1);
+    return true;
+  }
+
+  bool remove(const K& k, const V& v) {
+    if (!lookup(k))
+      return false;
+
+    scoped_gc_epoch rcu_read;
+    u64 h = mix(k);
+    bucket* b;
+    table* t;
+    auto l = lock_bucket(h, &b, &t);
+
+    auto i = b->chain.before_begin();
+    auto end = b->chain.end();
+    for (;;) {
+      auto prev = i;
+      ++i;
+      if (i == end)
+        return false;
+      if (i->hash == h && i->key == k && i->val == v) {
+        b->chain.erase_after(prev);
+        gc_delayed(&*i);
+        b->length--;
+        break;
+      }
+    }
+    l.release();
+
+    maybe_shrink(t, b);
+    return true;
+  }
+
+  bool replace_from(const K& kdst, const V* vpdst,
+                    splithash* src, const K& ksrc,
+                    const V& vsrc)
+  {
+    /*
+     * A special API used by rename.  Atomically performs the following
+     * steps, returning false if any of the checks fail:
+     *
+     *  - if vpdst!=nullptr, checks this[kdst]==*vpdst
+     *  - if vpdst==nullptr, checks this[kdst] is not set
+     *  - checks src[ksrc]==vsrc
+     *  - removes src[ksrc]
+     *  - sets this[kdst] = vsrc
+     */
+    scoped_gc_epoch rcu_read;
+    u64 hdst = mix(kdst), hsrc = mix(ksrc);
+    bucket *bdst, *bsrc;
+    table *tdst, *tsrc;
+
+    scoped_acquire lsrc, ldst;
+    for (;;) {
+      bdst = live_bucket(hdst, &tdst);
+      bsrc = src->live_bucket(hsrc, &tsrc);
+      if (bsrc == bdst) {
+        lsrc = bsrc->lock.guard();
+      } else if (bsrc < bdst) {
+        lsrc = bsrc->lock.guard();
+        ldst = bdst->lock.guard();
+      } else {
+        ldst = bdst->lock.guard();
+        lsrc = bsrc->lock.guard();
+      }
+      if (!bdst->migrated && !bsrc->migrated)
+        break;
+      lsrc.release();
+      ldst.release();
+    }
+
+    auto srci = bsrc->chain.before_begin();
+    auto srcend = bsrc->chain.end();
+    auto srcprev = srci;
+    for (;;) {
+      ++srci;
+      if (srci == srcend)
+        return false;
+      if (srci->hash != hsrc || srci->key != ksrc) {
+        srcprev = srci;
+        continue;
+      }
+      if (srci->val != vsrc)
+        return false;
+      break;
+    }
+
+    for (item& i: bdst->chain) {
+      if (i.hash == hdst && i.key == kdst) {
+        if (vpdst == nullptr || i.val != *vpdst)
+          return false;
+        auto w = i.seq.write_begin();
+        i.val = vsrc;
+        bsrc->chain.erase_after(srcprev);
+        gc_delayed(&*srci);
+        bsrc->length--;
+        return true;
+      }
+    }
+
+    if (vpdst != nullptr)
+      return false;
+
+    bsrc->chain.erase_after(srcprev);
+    gc_delayed(&*srci);
+    bsrc->length--;
+    bdst->chain.push_front(new item(hdst, kdst, vsrc));
+    u32 len = ++bdst->length;
+    lsrc.release();
+    ldst.release();
+
+    if (len > max_chain)
+      maybe_resize(tdst, tdst->order + 1);
+    src->maybe_shrink(tsrc, bsrc);
+    return true;
+  }
+
+  /*
+   * Call cb(key, value) for each key after *prev, or from the first
+   * key if prev is nullptr, in (hash, key) order until cb returns
+   * false.  Returns false if it ran out of keys.  Since that order
+   * does not depend on the table size, a sequence of calls that each
+   * resume from the last key seen visits every key that is present
+   * throughout the sequence exactly once, even if the table is
+   * resized in between.
+   */
+  template<class CB>
+  bool enumerate_from(const K* prev, CB cb) const {
+    scoped_gc_epoch rcu_read;
+
+    // The cursor.  Items stay allocated until our epoch ends, so we
+    // can point into them.
+    const K* kcur = prev;
+    u64 hcur = prev ? mix(*prev) : 0;
+    u64 pos = hcur;
+    for (;;) {
+      // Scan the bucket responsible for pos.  If it migrates while we
+      // scan it, rescan the part of the next table it covered.
+      table* t = cur_;
+      u64 lo = 0, hi = ~0ull;
+      for (;;) {
+        u64 idx = t->index(pos);
+        const bucket* b = &t->buckets[idx];
+        if (t->first(idx) > lo)
+          lo = t->first(idx);
+        if (t->last(idx) < hi)
+          hi = t->last(idx);
+
+        // Chains are unordered, so select each next item in turn.
+        // Chains are short.
+        for (;;) {
+          const item* best = nullptr;
+          for (const item& i: b->chain) {
+            if (i.hash < lo || i.hash > hi)
+              continue;
+            if (kcur && (i.hash < hcur ||
+                         (i.hash == hcur && !(*kcur < i.key))))
+              continue;
+            if (!best || i.hash < best->hash ||
+                (i.hash == best->hash && i.key < best->key))
+              best = &i;
+          }
+          if (!best)
+            break;
+          if (!cb(best->key, *seq_reader<V>(&best->val, &best->seq)))
+            return true;
+          kcur = &best->key;
+          hcur = best->hash;
+        }
+
+        barrier();
+        if (!b->migrated)
+          break;
+        t = t->next;
+      }
+
+      if (hi == ~0ull)
+        return false;
+      pos = hi + 1;
+    }
+  }
+
+  // Find the first key after *prev, as in enumerate_from.
+  bool enumerate(const K* prev, K* out) const {
+    return enumerate_from(prev, [out](const K& k, const V& v) {
+        *out = k;
+        return false;
+      });
+  }
+
+  bool lookup(const K& k, V* vptr = nullptr) const {
+    scoped_gc_epoch rcu_read;
+
+    u64 h = mix(k);
+    for (table* t = cur_; ; t = t->next) {
+      const bucket* b = t->get(h);
+      const item* i = find(b, h, k);
+      if (i) {
+        if (vptr)
+          *vptr = *seq_reader<V>(&i->val, &i->seq);
+        return true;
+      }
+      barrier();
+      if (!b->migrated)
+        return false;
+    }
+  }
+
+  bool remove_and_kill(const K& k, const V& v) {
+    if (dead_)
+      return false;
+
+    scoped_gc_epoch rcu_read;
+    u64 h = mix(k);
+    for (table* t = cur_; t; t = t->next)
+      for (u64 i = 0; i < t->size(); i++)
+        for (const item& ii: t->buckets[i].chain)
+          if (ii.hash != h || ii.key != k || ii.val != v)
+            return false;
+
+    // Keep the table fixed while we hold all of its bucket locks.
+    while (!cmpxch(&resizing_, false, true))
+      nop_pause();
+    table* t = cur_;
+
+    for (u64 i = 0; i < t->size(); i++)
+      t->buckets[i].lock.acquire();
+
+    bool killed = !dead_;
+    u64 n = 0;
+    for (u64 i = 0; i < t->size(); i++) {
+      for (const item& ii: t->buckets[i].chain) {
+        if (ii.hash != h || ii.key != k || ii.val != v)
+          killed = false;
+        n++;
+      }
+    }
+
+    if (killed && n == 1) {
+      dead_ = true;
+      bucket* b = t->get(h);
+      item* i = &b->chain.front();
+      assert(i->key == k && i->val == v);
+      b->chain.pop_front();
+      b->length--;
+      gc_delayed(i);
+    } else {
+      killed = false;
+    }
+
+    for (u64 i = 0; i < t->size(); i++)
+      t->buckets[i].lock.release();
+
+    resizing_ = false;
+    return killed;
+  }
+
+  bool killed() const {
+    return dead_;
+  }
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+// Per-syscall counters and latency histograms.  See syscallstats.cc.
+
+#include <atomic>
+
+extern std::atomic<bool> syscallstats_enabled;
+
+// Record a call to syscall num that started at rdtsc() start and
+// returned r.
+void syscallstats_record(u64 num, u64 start, u64 r);
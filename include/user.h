@@ -5,6 +5,7 @@
 BEGIN_DECLS
 struct stat;
 struct sockaddr;
+struct pollfd;
 
 #include "sysstubs.h"
 
@@ -12,7 +13,7 @@ struct sockaddr;
 char* gets(char*, int max);
 
 // uthread.S
-int forkt(void *sp, void *pc, void *arg, int forkflags);
+int forkt(void *sp, void *pc, void *arg, int forkflags, u64 *tidptr);
 void forkt_setup(u64 pid);
 
 END_DECLS
@@ -165,10 +165,17 @@ public:
     return (bool)ptr;
   }
 
-  bool load(char *dst, std::size_t size)
+  bool load(char *dst, std::size_t size) const
+  {
+    return load_len(dst, size) >= 0;
+  }
+
+  // Like load, but return the length of the string, or -1 if the
+  // pointer is illegal or the string doesn't fit in size bytes.
+  int load_len(char *dst, std::size_t size) const
   {
     extern int fetchstr(char* dst, const char* usrc, u64 size);
-    return !fetchstr(dst, ptr.unsafe_get(), size);
+    return fetchstr(dst, ptr.unsafe_get(), size);
   }
 
   // Allocate memory for this string and copy into it.  If the pointer
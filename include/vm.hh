@@ -9,6 +9,8 @@
 #include "kalloc.hh"
 #include "page_info.hh"
 #include "mfs.hh"
+#include "mempolicy.hh"
+#include "zswap.hh"
 
 struct padded_length;
 
@@ -48,6 +50,27 @@ struct vmdesc : public mmu::page_tracker
 
     // Set if the page should be shared across fork().
     FLAG_SHARED = 1<<5,
+
+    // Set if NUMA balancing unmapped this page frame's page to sample
+    // accesses to it, so the next fault on it is a hinting fault.
+    FLAG_NUMA_HINT = 1<<6,
+
+    // Set if this anonymous page frame's page was compressed by zswap.
+    // page is null and start points to the zswap_entry.
+    FLAG_ZSWAP = 1<<7,
+
+    // Set if a zswap reclaim scan unmapped this page frame's page and
+    // it hasn't been accessed since.  The next scan compresses it.
+    FLAG_ZSWAP_COLD = 1<<10,
+
+    // The NUMA policy mode (MPOL_*) and node mask of this page frame,
+    // set by mbind.  MPOL_DEFAULT means the page frame has no policy
+    // of its own and follows the faulting process's (see
+    // mempolicy.hh).
+    FLAG_MPOL_SHIFT = 8,
+    FLAG_MPOL = 0x3<<FLAG_MPOL_SHIFT,
+    FLAG_MPOL_NODES_SHIFT = 12,
+    FLAG_MPOL_NODES = 0xffff<<FLAG_MPOL_NODES_SHIFT,
   };
 
   // Flags
@@ -71,7 +94,8 @@ struct vmdesc : public mmu::page_tracker
   // record this instead of the page frame's offset in the file so
   // that a range of page frames mapping a sequence of pages from a
   // file will be identical (and hence compressable in the radix
-  // tree).
+  // tree).  If FLAG_ZSWAP is set, this is instead the compressed
+  // page's zswap_entry.
   intptr_t start;
 
   // Construct a descriptor for unmapped memory.
@@ -97,14 +121,37 @@ struct vmdesc : public mmu::page_tracker
     return flags & FLAG_MAPPED;
   }
 
+  // Return this page frame's NUMA policy.
+  mempolicy policy() const
+  {
+    return mempolicy((flags & FLAG_MPOL) >> FLAG_MPOL_SHIFT,
+                     (flags & FLAG_MPOL_NODES) >> FLAG_MPOL_NODES_SHIFT);
+  }
+
+  // Return the flags that encode NUMA policy pol.
+  static u64 policy_flags(const mempolicy &pol)
+  {
+    return ((u64)pol.mode << FLAG_MPOL_SHIFT) |
+      ((u64)pol.nodes << FLAG_MPOL_NODES_SHIFT);
+  }
+
+  // Return this page frame's compressed page, or null if it has none.
+  zswap_entry *zswapped() const
+  {
+    return (flags & FLAG_ZSWAP) ? (zswap_entry*)start : nullptr;
+  }
+
   // Duplicate this descriptor for use in another vmap.  This copies
   // the descriptor except for its lock bit (since it should be
-  // initially unlocked in the new vmap) and its page tracker (since it is
-  // now associated with a new page_map_cache and hence not cached on
-  // any core).
+  // initially unlocked in the new vmap), its NUMA hint and zswap cold
+  // bits (since the new vmap hasn't been scanned), and its page
+  // tracker (since it is now associated with a new page_map_cache and
+  // hence not cached on any core).  The caller must take a reference
+  // to any compressed page.
   vmdesc dup() const
   {
-    return vmdesc(flags & ~FLAG_LOCK, page, inode, start);
+    return vmdesc(flags & ~(FLAG_LOCK | FLAG_NUMA_HINT | FLAG_ZSWAP_COLD),
+                  page, inode, start);
   }
 
   // We need new/delete so the radix_array can allocate external nodes
@@ -147,12 +194,39 @@ struct vmap : public referenced {
   // Modify protection on a range.  flags must be 0 or FLAG_MAPPED.
   int mprotect(uptr start, uptr len, uint64_t flags);
 
+  // Set the NUMA policy of a range.  Pages already allocated in the
+  // range stay where they are.
+  int set_mempolicy(uptr start, uptr len, const mempolicy &pol);
+
   // XXX(Austin) HACK for benchmarking.  Used to simulate the shared
   // pages we could have if we had a unified buffer cache.
   int dup_page(uptr dest, uptr src);
 
+  // Remove page pi from va if it's mapped there as a page of a file,
+  // so a later fault maps it again.  Returns true if it was removed.
+  // Used by rmap_unmap.
+  bool drop_page(uptr va, page_info *pi);
+
   int pagefault(uptr va, u32 err);
 
+  // If this address space's NUMA balancing scan is due at time now,
+  // unmap up to npages of its resident anonymous pages, continuing
+  // where the last scan stopped, and schedule the next scan period
+  // nanoseconds later.  See numabalance.cc.
+  void numa_scan(u64 now, u64 period, size_t npages);
+
+  // Compress the cold private anonymous pages of this address space
+  // and mark the rest cold, continuing where the last scan stopped,
+  // until npages pages are freed or marked or the scan has been around
+  // the address space once.  A page is cold if it hasn't been accessed
+  // since an earlier scan marked it.  Returns the number of pages
+  // freed.  See zswap.hh.
+  size_t zswap_reclaim(size_t npages);
+
+  // Compress the private anonymous pages from start to start+len
+  // whether they're cold or not.
+  int pageout(uptr start, uptr len);
+
   // Map virtual address va in this address space to a kernel virtual
   // address, performing the equivalent of a read page fault if
   // necessary.  Returns nullptr if va is not mapped.  Needless to
@@ -197,6 +271,14 @@ private:
 
   struct spinlock brklock_;
 
+  // NUMA balancing: when the next scan is due, and the page index it
+  // starts at.  See numa_scan.
+  std::atomic<u64> numa_next_scan_;
+  std::atomic<size_t> numa_scan_pos_;
+
+  // The page index the next zswap reclaim scan starts at
+  std::atomic<size_t> zswap_scan_pos_;
+
   enum class access_type
   {
     READ, WRITE
@@ -208,4 +290,23 @@ private:
   // allocated and cannot be.
   page_info *ensure_page(const vpf_array::iterator &it, access_type type,
                          bool *allocated = nullptr);
+
+  // Replace the page at @c it with a copy on NUMA node @c node.  The
+  // caller must lock vpfs_ at @c it, and the page must not be mapped
+  // in the page tables.  Returns false if the page is not private
+  // anonymous memory or node has no free memory.
+  bool numa_migrate(const vpf_array::iterator &it, size_t node);
+
+  // Compress the cold pages of private anonymous page frames in [begin,
+  // end), and mark the rest cold, unmapping them and adding their
+  // number to *marked.  If force, compress the rest too.  The caller
+  // must lock vpfs_ over the range.  Returns the number of pages
+  // freed.
+  size_t zswap_range(const vpf_array::iterator &begin,
+                     const vpf_array::iterator &end, bool force,
+                     size_t *marked);
+
+  // Compress the page at @c it, which must be cold.  The caller must
+  // lock vpfs_ at @c it.  Returns false if the page was left resident.
+  bool zswap_out(const vpf_array::iterator &it);
 };
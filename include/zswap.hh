@@ -0,0 +1,38 @@
+#pragma once
+
+// Compressed in-memory swap for anonymous memory.
+//
+// When user memory runs out, vmap::zswap_reclaim compresses cold
+// private anonymous pages into small heap objects and frees the pages.
+// A page frame whose page was compressed keeps the compressed copy in
+// its vmdesc (see FLAG_ZSWAP in vm.hh), and the next fault on it
+// decompresses it into a new page.  Pages of zeroes need no copy at
+// all: their frames simply lose their page, and the next fault
+// allocates a zeroed one.
+//
+// zswap is off by default.  Write 1 to /dev/zswap to turn it on, which
+// allocates a page of compression state for each CPU, or 0 to turn it
+// off.  Turning it off stops reclaim; pages already
+// compressed stay that way until they're faulted in.
+
+#include "types.h"
+
+// A compressed page.  Entries are immutable and reference counted, so
+// fork can share them.
+struct zswap_entry;
+
+// Return true if zswap is on.
+bool zswap_enabled(void);
+
+// Compress the page at va.  If the page is all zeroes, sets *out to
+// null.  Otherwise, sets *out to a new entry with one reference.
+// Returns false, and leaves *out alone, if the page doesn't compress
+// well enough to be worth keeping or there's no memory for the entry.
+bool zswap_store(const void *va, zswap_entry **out);
+
+// Decompress e into the page at va.
+void zswap_load(const zswap_entry *e, void *va);
+
+// Add or drop a reference to e.  Dropping the last reference frees e.
+void zswap_get(zswap_entry *e);
+void zswap_put(zswap_entry *e);
@@ -18,7 +18,11 @@ buf::get(u32 dev, u64 block)
       return b;
     }
 
-    sref<buf> nb = sref<buf>::transfer(new buf(dev, block));
+    char* p = kalloc("buf");
+    if (!p)
+      throw_bad_alloc();
+    auto pi = sref<page_info>::transfer(new (page_info::of(p)) page_info());
+    sref<buf> nb = sref<buf>::transfer(new buf(dev, block, std::move(pi)));
     auto locked = nb->write();
     if (bufcache.insert(k, nb.get())) {
       nb->inc();  // keep it in the cache
@@ -1,3 +1,5 @@
+#include "types.h"
+#include "amd64.h"
 #include "eager_refcache.hh"
 
 namespace eager_refcache {
@@ -55,3 +57,44 @@ eager_refcache::referenced::eagerify()
   // count means a zero true count.
   mode_ = mode_eager;
 }
+
+bool
+eager_refcache::referenced::tryinc()
+{
+  if (mode_.load(std::memory_order_relaxed) == mode_scalable) {
+    auto way = mycache->hash_way(this);
+    auto guard = way->lock.guard();
+
+    auto way_obj = way->obj.load(std::memory_order_relaxed);
+    if (way_obj != this) {
+      if (way_obj && way->delta) {
+        way_obj->refcount_ += way->delta;
+      }
+      way->obj.store(this, std::memory_order_relaxed);
+      way->delta = 0;
+    }
+    ++way->delta;
+
+    // If we're still in scalable mode, eagerify hasn't happened, so
+    // it will flush our delta before the count can reach zero.
+    if (mode_ == mode_scalable)
+      return true;
+
+    // Otherwise the count may already have reached zero, and flushing
+    // our delta would revive the object.  Back it out (eagerify will
+    // flush anything left in the way) and try in eager mode.
+    if (--way->delta == 0)
+      way->obj.store(nullptr, std::memory_order_relaxed);
+  }
+
+  // Transitioning is short, and until it's done, the global count
+  // isn't the true count.
+  while (mode_.load(std::memory_order_acquire) != mode_eager)
+    nop_pause();
+
+  auto ref = refcount_.load(std::memory_order_relaxed);
+  while (ref > 0)
+    if (refcount_.compare_exchange_weak(ref, ref + 1))
+      return true;
+  return false;
+}
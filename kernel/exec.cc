@@ -187,9 +187,16 @@ exec(const char *path, const char * const *argv)
     myproc()->ftable = std::move(newftable);
   }
 
+  // A thread that execs no longer runs the library that may join it.
+  // We are still on the old page table, so clear its tid word now.
+  myproc()->release_tid(oldvmap.get());
+
   // Switch to the new address space
   switchvm(myproc());
 
+  // We no longer use a vfork parent's address space
+  myproc()->vfork_release();
+
   // Now it's safe to clean up the old address space
   cleanup_work* w = new cleanup_work(std::move(oldvmap));
   assert(dwork_push(w, myproc()->data_cpuid) >= 0);
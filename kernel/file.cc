@@ -159,6 +159,18 @@ file_pipe_reader::read(char *addr, size_t n)
   return piperead(pipe, addr, n);
 }
 
+int
+file_pipe_reader::poll(int events)
+{
+  return pipepoll(pipe, events & POLLIN);
+}
+
+pollqueue*
+file_pipe_reader::get_pollqueue()
+{
+  return pipepollqueue(pipe);
+}
+
 void
 file_pipe_reader::onzero(void)
 {
@@ -184,6 +196,18 @@ file_pipe_writer::write(const char *addr, size_t n)
   return pipewrite(pipe, addr, n);
 }
 
+int
+file_pipe_writer::poll(int events)
+{
+  return pipepoll(pipe, events & POLLOUT);
+}
+
+pollqueue*
+file_pipe_writer::get_pollqueue()
+{
+  return pipepollqueue(pipe);
+}
+
 void
 file_pipe_writer::onzero(void)
 {
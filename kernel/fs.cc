@@ -870,6 +870,22 @@ readi(sref<inode> ip, char *dst, u32 off, u32 n)
   return n;
 }
 
+// Return the buffer cache page holding block bn of ip.  The caller
+// shares the page rather than copying out of it.
+sref<page_info>
+readpage(sref<inode> ip, u32 bn)
+{
+  scoped_gc_epoch e;
+
+  if(ip->type == T_DEV || bn >= (ip->size + BSIZE - 1) / BSIZE)
+    return sref<page_info>();
+  try {
+    return buf::get(ip->dev, bmap(ip, bn))->page();
+  } catch (out_of_blocks& e) {
+    panic("readpage: out of blocks");
+  }
+}
+
 // PAGEBREAK!
 // Write data to inode.
 int
@@ -12,6 +12,10 @@
 #include "mtrace.h"
 #include "file.hh"
 #include "uk/gcstat.h"
+#include "numa.hh"
+#include "ipi.hh"
+#include "sleeplock.hh"
+#include "epochtree.hh"
 
 using std::atomic;
 
@@ -19,57 +23,69 @@ using std::atomic;
 // - processes can call sleep in an epoch
 // - processes can migrate during an epoch
 //
-// The GC scheme is adopted from Fraser's epoch-based scheme:
-// a machine has a global_epoch
-// a process add to its core global_epoch's delayed freelist on delayed_free()
-// a core maintains an epoch, min_epoch (>= global_epoch)
-//   min_epoch is the lowest epoch # a process on that core is in
-//   a process always ends an epoch on the core it started (even if the
-//   process is migrated)
-// one gc thread and state (e.g., NEPOCH delaylist) per core
-// a gcc thread performs two jobs:
-// 1. in parallel gc threads free the elements on the delayed-free lists
-//   (costs linear in the number of elements to be freed, but a local operation)
-// 2a (global scheme). one gcc thread perform step 1: updates global_epoch
-//   (costs linear in the number of cores, but a global operation)
-// 2b (local scheme). each core reads the global_min and cur_epoch from its
-//   neighbor. it updates its global_min by computing the min(global_min read from
-//   neighbor and its min_epoch). it sets its cur_epoch to the
-//   neighbor's cur_epoch.  core 0 is the ring leader: it increases epoch,
-//   if global_min from last core >= cur_epoch-2.  If local communication scales,
-//   this gc scheme will scale, but the delay to increase cur_epoch is linear
-//   in the number of cores.
+// The GC scheme is adopted from Fraser's epoch-based scheme.  There
+// is a global_epoch, and an object passed to gc_delayed in epoch e
+// can be freed once no process is in an epoch <= e.
 //
-// To limit the number of delayed free lists per core, each core also has a
-// variable nexttofree_epoch, which <= min_epoch. cur_epoch isn't increased
-// unless nexttofree_epoch >= cur_epoch-2, implicitly also ensuring the
-// constraint that cur_epoch is only increases when min_epoch >= cur_epoch-2.
+// Readers never lock or write shared memory.  Each core counts the
+// processes that begin an epoch on it, by epoch % NEPOCH, and the
+// processes that end one there.  A process that migrated during its
+// epoch counts its end on the core where it began, with an atomic
+// add (this is the only time a reader writes another core's memory).
+// A core with equal counts for epoch e has no process in epoch e.
+//
+// global_epoch only advances from g to g+1 once every core has
+// reported that it has no process in epoch g-1.  Each core checks
+// this on its timer tick, and reports up a two-level combining tree:
+// each leaf covers up to GC_EPOCH_FANOUT cores of one NUMA node and
+// counts the cores that have yet to report, and the last core of a
+// leaf to report decrements the root's count of leaves.  The last
+// leaf advances global_epoch.  Since a core only reports after it
+// has seen global_epoch, a process that begins an epoch on that core
+// afterwards can't be in an epoch the core has reported as empty.
+// Thus once global_epoch reaches e+2, no process is in epoch e.
+//
+// gc_delayed adds objects to a per-core list for the current epoch.
+// On its tick, each core moves the lists of epochs <= global_epoch-2
+// to a per-core ready list, and its gc thread frees the ready list
+// every GCINTERVAL or when woken.  Since a core moves its old lists
+// before reporting, NEPOCH lists per core always suffice.
+//
+// gc_synchronize is an expedited grace period: it has every core
+// check and report immediately, from an IPI, rather than waiting
+// for the next tick.
 
-enum { gc_debug = 0, gc_global = GC_GLOBAL };
+enum { gc_debug = 0 };
 
-// Head of a delayed free list. Always read and updated while holding lock_
+// Head of a delayed free list.  Only accessed by its core with
+// interrupts disabled.
 struct headinfo {
   rcu_freed* head;
+  rcu_freed* tail;
   u64 epoch;
 };
 
-// nexttofree_epoch << min_epoch << global_epoch (or cur_epoch)
 struct gc_state {
-  atomic<u64> nexttofree_epoch; // the lowest epoch # to free on this core
-  atomic<u64> min_epoch;        // the lowest epoch # a process on this core is in
-  atomic<u64> cur_epoch;        // the current epoch this core is running in
-  atomic<u64> global_min;       // used to compute global_min over nexttofree
+  // The number of processes that began and ended an epoch on this
+  // core, by epoch % NEPOCH.  Only written by this core.
+  atomic<u64> begins[NEPOCH];
+  atomic<u64> ends[NEPOCH];
+  // Ends of epochs that began on this core, from other cores
+  atomic<u64> remote_ends[NEPOCH] __mpalign__;
+  // The global epoch this core last reported for
+  u64 reported __mpalign__;
+  // The lowest epoch whose delayed list hasn't moved to ready
+  u64 nexttoready_epoch;
+  headinfo delayed[NEPOCH];     // NEPOCH delayed-free lists
+  headinfo ready;               // objects that can be freed now
+  // Protects the gc thread's sleep
   struct spinlock lock_ __mpalign__;
   struct condvar cv;
-  headinfo delayed[NEPOCH];     // NEPOCH delayed-free lists
-  gc_handle proclist;           // list of process in an epoch on this core
 public:
   gc_state();
-  void dequeue(gc_handle *h);
-  void enqueue(gc_handle *h);
-  int gc_free(rcu_freed *r, u64 epoch);
+  int gc_free(rcu_freed *r);
   void do_gc(void);
-  void inc_cur_epoch(void);
+  void tick(void);
 };
 
 DEFINE_PERCPU(gc_state, gc_states, NO_MIGRATE);
@@ -77,129 +93,81 @@ DEFINE_PERCPU(gc_stat, stat, NO_CRITICAL);
 int ngc_cpu;
 int gc_batchsize;
 
-// Increment of global_epoch acquires gc_lock, but processes cannot read it
-// without locks
-static struct gc_lock {
-  struct spinlock l __mpalign__;
-  gc_lock() : l("gc", LOCKSTAT_GC) { }
-} gc_lock;
 atomic<u64> global_epoch __mpalign__;
 
-// Sceheme 2a: Increment global_epoch if (1) each core has freed all epochs <=
-// global-2 and (2) each core has no processes in an epoch <= global - 2 This
-// operation is the only global operation.
-static void
-gc_inc_global_epoch(void)
-{
-  int r = tryacquire(&gc_lock.l);
-  if (r == 0) return;
-  assert(r == 1);
-  u64 t0 = rdtsc();
-  u64 global = global_epoch;  // make "local" copy
-  u64 minfree = global;
-  u64 minepoch = global;
-  for (int c = 0; c < ngc_cpu; c++) {
-    // is reading nexttofree_epoch and min_epoch a single cache miss?
-    if (gc_states[c].nexttofree_epoch < minfree) {
-      minfree = gc_states[c].nexttofree_epoch;
-    }
-    if (gc_states[c].min_epoch < minepoch) {
-      minepoch = gc_states[c].min_epoch;
-    }
-  }
-  if ((minfree < global-2) || (minepoch < global-2))
-    goto done;
-  if (minepoch > global-2) {
-    if (gc_debug) cprintf("update global_epoch to: %lu\n", minepoch+1);
-    global_epoch = global + 1;
-  }
-done:
-  release(&gc_lock.l);
-  u64 t1 = rdtsc();
-  stat[mycpu()->id].ncycles += (t1-t0);
-  stat[mycpu()->id].nop++;
-}
+// Counts the cores that have yet to report for global_epoch.
+static epoch_tree<> tree;
 
-// Scheme 2b: Scalable way of computing global_min by arranging nodes in a
-// virtual ring.
-// XXX ring could follow physical proximity
-void
-gc_state::inc_cur_epoch(void)
-{
-  u64 t0 = rdtsc();
-  if (mycpu()->id == 0) {
-    u64 min = gc_states[ngc_cpu-1].global_min;
-    if (min >= cur_epoch - 2) {
-      if (gc_debug) cprintf("%d: update my epoch to: %lu\n",
-                          mycpu()->id, cur_epoch+1);
-      cur_epoch += 1;
-    }
-    global_min = nexttofree_epoch.load();
-  } else {
-    int neighbor = mycpu()->id - 1;
-    u64 neighbor_global_min = gc_states[neighbor].global_min;
-    u64 e = gc_states[neighbor].cur_epoch.load();
-    assert(cur_epoch <= e);
-    cur_epoch = e;
-    global_min = neighbor_global_min > nexttofree_epoch ?
-      global_min = nexttofree_epoch.load() :  global_min = neighbor_global_min;
-  }
-  u64 t1 = rdtsc();
-  stat[mycpu()->id].ncycles += (t1-t0);
-  stat[mycpu()->id].nop++;
-}
+// Serializes gc_synchronize calls, so they don't send redundant IPIs.
+static sleeplock sync_lock;
 
 gc_state::gc_state() :
+  reported(0), nexttoready_epoch(0),
   lock_("gc_state", LOCKSTAT_GC), cv(condvar("gc_cv"))
 {
-  proclist.next = &proclist;
-  proclist.prev = &proclist;
   for (int i = 0; i < NEPOCH; i++) {
+    begins[i] = ends[i] = remote_ends[i] = 0;
+    delayed[i].head = delayed[i].tail = nullptr;
     delayed[i].epoch = i;
   }
-  cur_epoch = NEPOCH-2;
+  ready.head = ready.tail = nullptr;
 }
 
-// caller should hold lock_
+// Move expired delayed lists to the ready list, and report to the
+// combining tree if this core has no process in the epoch before
+// global_epoch.  Interrupts must be disabled.
 void
-gc_state::enqueue(gc_handle *h)
+gc_state::tick(void)
 {
-  h->next = &this->proclist;
-  h->prev = this->proclist.prev;
-  this->proclist.prev->next = h;
-  this->proclist.prev = h;
-}
-
-// caller should hold lock_
-void
-gc_state::dequeue(gc_handle *h)
-{
-  u64 m = gc_global ? global_epoch : cur_epoch;
-  for (gc_handle* entry = this->proclist.next; entry != &this->proclist;
-       entry = entry->next) {
-    if (entry == h) {
-      entry->next->prev = entry->prev;
-      entry->prev->next = entry->next;
-    } else {
-      if ((entry->epoch >> 8) < m)
-        m = (entry->epoch >> 8);
+  u64 global = global_epoch.load(std::memory_order_acquire);
+
+  // Objects delayed in epochs <= global-2 can be freed now
+  for (; nexttoready_epoch + 2 <= global; nexttoready_epoch++) {
+    headinfo *d = &delayed[nexttoready_epoch % NEPOCH];
+    if (d->head) {
+      if (ready.head)
+        ready.tail->_rcu_next = d->head;
+      else
+        ready.head = d->head;
+      ready.tail = d->tail;
     }
+    d->head = d->tail = nullptr;
+    d->epoch += NEPOCH;
   }
-  if (this->min_epoch != m) {
-    this->min_epoch = m;
+
+  if (reported == global)
+    return;
+  int e = (global - 1) % NEPOCH;
+  u64 ended = ends[e].load(std::memory_order_relaxed) +
+    remote_ends[e].load(std::memory_order_acquire);
+  if (ended != begins[e].load(std::memory_order_relaxed))
+    return;
+
+  // This core has no process in epoch global-1.  It's safe to reset a
+  // counter in the tree as soon as it reaches zero, since no core it
+  // covers reports again until global_epoch advances.
+  u64 t0 = rdtsc();
+  reported = global;
+  if (tree.report()) {
+    if (gc_debug) cprintf("update global_epoch to: %lu\n", global+1);
+    global_epoch.store(global + 1, std::memory_order_release);
   }
+  u64 t1 = rdtsc();
+  stat->ncycles += (t1-t0);
+  stat->nop++;
 }
 
-// Free the elements in delayed-free list r (from epoch epoch).
-// Runs without holding _lock
+// Free the elements in delayed-free list r.  Runs without holding
+// lock_.
 int
-gc_state::gc_free(rcu_freed *r, u64 epoch)
+gc_state::gc_free(rcu_freed *r)
 {
   int nfree = 0;
   rcu_freed *nr;
+  u64 limit = global_epoch - 2;
   for (; r; r = nr) {
-    if (r->_rcu_epoch > epoch) {
-      cprintf("gc_free: r->epoch %ld > epoch %ld\n", r->_rcu_epoch, epoch);
+    if (r->_rcu_epoch > limit) {
+      cprintf("gc_free: r->epoch %ld > epoch %ld\n", r->_rcu_epoch, limit);
 #if RCU_TYPE_DEBUG
       cprintf("gc_free: name %s\n", r->_rcu_type);
 #endif
@@ -212,38 +180,30 @@ gc_state::gc_free(rcu_freed *r, u64 epoch)
   return nfree;
 }
 
-// Caller must hold lock_.  This function cannot be called recursively,
-// but it won't if only gc_worker() runs do_gc.
+// Caller must hold lock_.  Must be called on this gc_state's core.
 void
 gc_state::do_gc(void)
 {
-  u64 i;
-
   stat->nrun++;
 
-  // free all delayed-free lists until min_epoch
-  for (i = nexttofree_epoch; i < min_epoch; i++) {
-    rcu_freed *head = delayed[i%NEPOCH].head;
-
-    // give up lock during free; gc_free() may call gc_begin/end_epoch
-    release(&lock_);
-
-    int nfree = gc_free(head,i);
+  rcu_freed *head;
+  {
+    scoped_cli cli;
+    head = ready.head;
+    ready.head = ready.tail = nullptr;
+  }
+  if (!head)
+    return;
 
-    acquire(&lock_);
-    delayed[i%NEPOCH].head = nullptr;
-    delayed[i%NEPOCH].epoch += NEPOCH;
-    stat->nfree += nfree;
-    if (gc_debug && nfree > 0) {
-      cprintf("%d: epoch %lu freed %d\n", mycpu()->id, i, nfree);
-    }
+  // give up lock during free; gc_free() may call gc_begin/end_epoch
+  release(&lock_);
+  int nfree = gc_free(head);
+  acquire(&lock_);
 
+  stat->nfree += nfree;
+  if (gc_debug && nfree > 0) {
+    cprintf("%d: freed %d\n", mycpu()->id, nfree);
   }
-  nexttofree_epoch = i;
-
-  // try to increment global_epoch
-  if (gc_global) gc_inc_global_epoch();
-  else inc_cur_epoch();
 }
 
 static void
@@ -256,15 +216,7 @@ gc_worker(void *x)
   for (;;) {
     gc_states->cv.sleep_to(&gc_states->lock_,
                           nsectime() + ((u64)GCINTERVAL)*1000000ull);
-
-    // if no processes are running on this core, update min_epoch
-    if (gc_states->proclist.next == &gc_states->proclist) {
-      gc_states->min_epoch = gc_global ? global_epoch.load() :
-        gc_states->cur_epoch.load();
-    }
-
     gc_states->do_gc();
-
   }
 }
 
@@ -297,6 +249,10 @@ writectrl(mdev*, const char *buf, u32 n)
   memcpy(&ngc_cpu, buf, sizeof(int));
   memcpy(&gc_batchsize, buf + sizeof(int), sizeof(int));
   memcpy(&op, buf + 2 * sizeof(int), sizeof(int));
+  if (op == GC_OP_SYNC) {
+    gc_synchronize();
+    gc_wakeup();
+  }
   return n;
 }
 
@@ -311,6 +267,8 @@ initgc(void)
   global_epoch = NEPOCH-2;
   gc_batchsize = 100000000;
 
+  tree.init(GC_EPOCH_FANOUT);
+
   devsw[MAJ_GC].write = writectrl;
   devsw[MAJ_GC].pread = readstat;
 
@@ -331,47 +289,53 @@ gc_delayed(rcu_freed *e)
     panic("double gc_delayed(%p) (of type %s)", e, e->_rcu_type);
 #endif
 
-  int c =  mycpu()->id;
+  scoped_cli cli;
+  int c = myid();
   struct gc_state *gs = &gc_states[c];
 
-  scoped_acquire x(&gs->lock_);
-
-  u64 epoch = gc_global ? global_epoch : gs->cur_epoch;
+  // The caller has unlinked e.  Make sure that's visible before we
+  // read the epoch, or a process that begins an epoch after we read
+  // it could still find e.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  u64 epoch = global_epoch.load(std::memory_order_relaxed);
 
   if (gc_debug)
     cprintf("(%d, %d): gc_delayed: %lu ndelayed %lu\n", c, myproc()->pid,
             epoch, stat[c].ndelay);
 
-  if (epoch != gs->delayed[epoch % NEPOCH].epoch) {
-    cprintf("%d: epoch %lu minepoch %lu my freeto %lu my min %lu\n", c, epoch,
-            gs->delayed[epoch % NEPOCH].epoch, gs->nexttofree_epoch.load(),
-            gs->min_epoch.load());
-    if (c >= ngc_cpu) return;
+  headinfo *d = &gs->delayed[epoch % NEPOCH];
+  if (epoch != d->epoch) {
+    cprintf("%d: epoch %lu list epoch %lu next to ready %lu\n", c, epoch,
+            d->epoch, gs->nexttoready_epoch);
     panic("gc_delayed");
   }
   stat[c].ndelay++;
   e->_rcu_epoch = epoch;
-  e->_rcu_next = gs->delayed[epoch % NEPOCH].head;
-  gs->delayed[epoch % NEPOCH].head = e;
+  e->_rcu_next = d->head;
+  if (!d->head)
+    d->tail = e;
+  d->head = e;
 }
 
 void
 gc_begin_epoch(void)
 {
   if (myproc() == nullptr) return;
-  u64 v = myproc()->gc->epoch++;
-  if (v & 0xff) return;
+  gc_handle *h = myproc()->gc;
+  if (h->depth++)
+    return;
 
-  int c =  mycpu()->id;
+  // Interrupts keep this core from reporting between our reading the
+  // epoch and counting ourselves in it
+  scoped_cli cli;
+  int c = myid();
   struct gc_state *gs = &gc_states[c];
-
-  scoped_acquire x(&gs->lock_);
-  u64 epoch = gc_global ? global_epoch : gs->cur_epoch;
-  myproc()->gc->core = c;
-  cmpxch(&myproc()->gc->epoch, v+1, (epoch<<8)+1);
-  // We effectively need an mfence here, and cmpxch provides one
-  // by virtue of being a LOCK instuction.
-  gs->enqueue(myproc()->gc);
+  u64 epoch = global_epoch.load(std::memory_order_acquire);
+  auto &begins = gs->begins[epoch % NEPOCH];
+  begins.store(begins.load(std::memory_order_relaxed) + 1,
+               std::memory_order_relaxed);
+  h->epoch = epoch;
+  h->core = c;
 
   mtrcubegin();
 }
@@ -380,30 +344,74 @@ void
 gc_end_epoch(void)
 {
   if (myproc() == nullptr) return;
-  u64 e = --myproc()->gc->epoch;
-  if ((e & 0xff) != 0)
+  gc_handle *h = myproc()->gc;
+  if (--h->depth)
     return;
 
-  int c = myproc()->gc->core;
+  int c = h->core;
   assert (c != -1);
   assert (c >= 0 && c < ncpu);
   struct gc_state *gs = &gc_states[c];
 
-  scoped_acquire x(&gs->lock_);
-
   mtrcuend();
-  gc_states[c].dequeue(myproc()->gc);
-  myproc()->gc->core = -1;
+  {
+    scoped_cli cli;
+    int e = h->epoch % NEPOCH;
+    if (c == myid()) {
+      auto &ends = gs->ends[e];
+      ends.store(ends.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_release);
+    } else {
+      gs->remote_ends[e].fetch_add(1, std::memory_order_release);
+    }
+  }
+  h->core = -1;
 
   if (stat[c].ndelay - stat[c].lastwake >= gc_batchsize) {
     stat[c].lastwake = stat[c].ndelay;
     // calling gs->do_gc() works for gcbench, because gcbench threads are pinned
     // to a core.  do_gc is correct when it uses one core's gc_state, so better
     // to wakeup this core's gc thread, and yield the core to it.
+    scoped_acquire x(&gs->lock_);
     gs->cv.wake_all(true);
   }
 }
 
+void
+gc_tick(void)
+{
+  gc_states->tick();
+}
+
+void
+gc_synchronize(void)
+{
+  if (myproc() && myproc()->gc->depth)
+    panic("gc_synchronize in an epoch");
+
+  // Anything delayed before now was delayed in an epoch <= global,
+  // so it can be freed once the epoch reaches global+2
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  u64 target = global_epoch + 2;
+
+  bitset<NCPU> all;
+  for (int i = 0; i < ncpu; i++)
+    all.set(i);
+
+  auto l = sync_lock.guard();
+  while (global_epoch < target) {
+    run_on_cpus(all, []() { gc_tick(); });
+    if (global_epoch >= target)
+      break;
+    // Some process is still in an old epoch, perhaps asleep.  Wait a
+    // tick rather than flood every core with IPIs.
+    struct spinlock lock("gc_sync");
+    struct condvar cv("gc_sync");
+    scoped_acquire x(&lock);
+    cv.sleep_to(&lock, nsectime() + QUANTUM * 1000000ull);
+  }
+}
+
 void
 gc_wakeup(void)
 {
@@ -1,172 +1,395 @@
+// Sampling kernel heap profiler.
+//
+// While running, each CPU samples about one allocation per rate bytes
+// it allocates and records the allocation's call stack.  A sample
+// stands for rate bytes of allocations from its stack (or its own
+// size, if larger), so per-stack totals estimate the whole heap
+// without tracking every block.  Samples that haven't been freed yet
+// live in an open-addressed table keyed by address, so frees can find
+// them: the free path probes that table without the lock and takes it
+// only on a hit.  When the profiler is off and holds no live samples,
+// the allocator hooks cost a load and a branch.
+//
+// The tables are allocated the first time the profiler starts and are
+// never freed, so sampling never allocates.
+
+#include "types.h"
+#include "kernel.hh"
+#include "amd64.h"
+#include "spinlock.hh"
+#include "condvar.hh"
 #include "heapprof.hh"
-#include "ilist.hh"
 #include "kstream.hh"
 #include "percpu.hh"
+#include "fs.h"
+#include "file.hh"
+#include "major.h"
+#include "uk/heapprof.h"
 
-#include <algorithm>
-#include <vector>
+enum {
+  // Call stacks that can be told apart.  Must be a power of 2.
+  NSTACKS = 1024,
+  // Live samples that can be tracked.  Must be a power of 2.
+  NSAMPLES = 8192,
+  // Maximum probes into either table
+  NPROBES = 16,
+  DEFAULT_RATE = 512 * 1024,
+};
 
-struct loc
-{
-  islink<loc> link;
-  const void *rip;
-  ssize_t bytes, count;
+// Sample table keys are the block address with the arena in bit 0.
+enum : u64 { KEY_EMPTY = 0, KEY_DELETED = 2 };
+
+struct sample {
+  u32 stack;
+  u64 bytes, count;
+};
 
-  islink<loc> prlink;
-  ssize_t prbytes, prcount;
+std::atomic<bool> heap_profile_enabled;
+std::atomic<u64> heap_profile_live;
 
-  NEW_DELETE_OPS(loc);
+static spinlock heapprof_lock("heapprof");
+static u64 rate = DEFAULT_RATE;
+static u64 dropped;
+// Indexed by stack hash.  Entries with no allocations are free.
+static struct heapprof_rec *stacks;
+static std::atomic<u64> *sample_keys;
+static struct sample *samples;
+
+struct heapprof_cpu {
+  s64 countdown;
+  u64 rnd;
 };
 
-struct heap_profile
+DEFINE_PERCPU(struct heapprof_cpu, heapprof_cpu, NO_CRITICAL);
+
+// Bytes until this CPU's next sample, uniform in [rate/2, 3*rate/2)
+// so sampling doesn't lock step with periodic allocation patterns.
+static u64
+next_interval(struct heapprof_cpu *c)
 {
-  islist<loc, &loc::link> rip_hash[1024];
-  // A small pool of statically allocated loc's to get us off the
-  // ground so we don't recursively allocate.  We never free loc's, so
-  // we don't have to worry about where they came from.
-  loc prealloc[16];
-  size_t prealloc_pos;
-  bool recursive, initialzed;
-
-  heap_profile() : prealloc_pos(0), recursive(false), initialzed(true) { }
-
-  bool update(const void *rip, ssize_t bytes)
-  {
-    if (!initialzed)
-      return false;
-
-    size_t slot = (uintptr_t)rip % NELEM(rip_hash);
-    for (auto &l : rip_hash[slot]) {
-      if (l.rip == rip) {
-        l.bytes += bytes;
-        if (bytes > 0)
-          l.count++;
-        else if (bytes < 0)
-          l.count--;
-        return true;
-      }
-    }
+  if (!c->rnd)
+    c->rnd = rdtsc() | 1;
+  c->rnd ^= c->rnd << 13;
+  c->rnd ^= c->rnd >> 7;
+  c->rnd ^= c->rnd << 17;
+  return rate / 2 + c->rnd % rate;
+}
 
-    struct loc *loc;
-    if (recursive) {
-      assert(prealloc_pos < NELEM(prealloc));
-      loc = &prealloc[prealloc_pos++];
-    } else {
-      recursive = true;
-      loc = new struct loc;
-      recursive = false;
+static u64
+hash64(u64 x)
+{
+  return (x * 0x9e3779b97f4a7c15ull) >> 32;
+}
+
+// Return the stack table entry for arena and pcs, claiming one if
+// needed, or nullptr if the table is full.  Called with
+// heapprof_lock held.
+static struct heapprof_rec *
+find_stack(heap_profile_arena arena, const uptr *pcs)
+{
+  u64 h = arena;
+  for (int i = 0; i < HEAPPROF_DEPTH; i++)
+    h = hash64(h ^ pcs[i]) + pcs[i];
+  for (int i = 0; i < NPROBES; i++) {
+    struct heapprof_rec *r = &stacks[(h + i) & (NSTACKS - 1)];
+    if (r->alloc_count == 0) {
+      memset(r, 0, sizeof(*r));
+      r->arena = arena;
+      memmove(r->pcs, pcs, sizeof(r->pcs));
+      return r;
     }
-    loc->rip = rip;
-    loc->bytes = bytes;
-    if (bytes > 0)
-      loc->count = 1;
-    else if (bytes < 0)
-      loc->count = -1;
-    rip_hash[slot].push_front(loc);
-    return true;
+    if (r->arena == arena && memcmp(r->pcs, pcs, sizeof(r->pcs)) == 0)
+      return r;
   }
-};
+  return nullptr;
+}
 
-struct heap_profile_array
-{
-#if KERNEL_HEAP_PROFILE
-  heap_profile arena[2];
-#else
-  heap_profile arena[0];
-#endif
-};
-DEFINE_PERCPU(heap_profile_array, heap_profiles);
-
-// (If !KERNEL_HEAP_PROFILE, this is an empty inline function in the
-// header.)
-#if KERNEL_HEAP_PROFILE
-bool
-heap_profile_update(heap_profile_arena arena, const void *rip,
-                    ssize_t bytes)
+// Retire the sample in slot, charging a free to its stack.  Called
+// with heapprof_lock held.
+static void
+retire_sample(int slot)
 {
-  scoped_critical c(NO_SCHED);
-  return heap_profiles->arena[arena].update(rip, bytes);
+  struct sample *s = &samples[slot];
+  struct heapprof_rec *r = &stacks[s->stack];
+  r->live_bytes -= s->bytes;
+  r->live_count -= s->count;
+  r->free_bytes += s->bytes;
+  r->free_count += s->count;
+  sample_keys[slot].store(KEY_DELETED, std::memory_order_relaxed);
+  heap_profile_live--;
 }
-#endif
 
-static void
-heap_profile_print1(print_stream *s, int limit, heap_profile_arena arena)
+void
+heap_profile_alloc_slow(heap_profile_arena arena, void *p, size_t bytes)
 {
-  // Combine per-CPU hash tables.  We do this using the existing loc
-  // structures, but using link and count field dedicated to
-  // printing, so that we don't have to allocate memory.
-  islist<loc, &loc::prlink> chain;
-  for (size_t slot = 0; slot < NELEM(heap_profile::rip_hash); ++slot) {
-    for (int i = 0; i < ncpu; ++i) {
-      auto p = &heap_profiles[i].arena[arena];
-      for (auto &loc : p->rip_hash[slot]) {
-        // Look for an existing entry
-        for (auto &prloc : chain) {
-          if (loc.rip == prloc.rip) {
-            prloc.prbytes += loc.bytes;
-            prloc.prcount += loc.count;
-            goto found;
-          }
-        }
-        // No existing print entry.  Use this loc.
-        loc.prbytes = loc.bytes;
-        loc.prcount = loc.count;
-        chain.push_front(&loc);
-      found:;
-      }
+  // Races with preemption only make sampling a little less regular
+  struct heapprof_cpu *c = heapprof_cpu.get();
+  c->countdown -= bytes;
+  if (c->countdown > 0)
+    return;
+  c->countdown = next_interval(c);
+
+  // Start at the allocator's frame, so pcs[0] is its caller
+  uptr pcs[HEAPPROF_DEPTH];
+  getcallerpcs(*(void**)__builtin_frame_address(0), pcs, HEAPPROF_DEPTH);
+
+  u64 wbytes = bytes, wcount = 1;
+  if (bytes < rate) {
+    wbytes = rate;
+    wcount = bytes ? rate / bytes : 1;
+  }
+
+  u64 key = (u64)p | arena;
+  u64 h = hash64(key >> 3);
+  auto l = heapprof_lock.guard();
+  struct heapprof_rec *r = find_stack(arena, pcs);
+  int slot = -1;
+  for (int i = 0; r && i < NPROBES; i++) {
+    int s = (h + i) & (NSAMPLES - 1);
+    u64 k = sample_keys[s].load(std::memory_order_relaxed);
+    if (k == key) {
+      // The block was freed behind our back; forget the old sample
+      retire_sample(s);
+      k = KEY_DELETED;
+    }
+    if (k == KEY_EMPTY || k == KEY_DELETED) {
+      slot = s;
+      break;
     }
   }
+  if (slot < 0) {
+    dropped++;
+    return;
+  }
 
-  // Sort (the slow way that doesn't require memory allocation)
-  islist<loc, &loc::prlink> sorted;
-  while (!chain.empty()) {
-    struct loc *loc = &chain.front();
-    chain.pop_front();
+  samples[slot].stack = r - stacks;
+  samples[slot].bytes = wbytes;
+  samples[slot].count = wcount;
+  sample_keys[slot].store(key, std::memory_order_release);
+  r->live_bytes += wbytes;
+  r->live_count += wcount;
+  r->alloc_bytes += wbytes;
+  r->alloc_count += wcount;
+  heap_profile_live++;
+}
 
-    if (sorted.empty() || sorted.front().prbytes < loc->prbytes) {
-      sorted.push_front(loc);
+void
+heap_profile_free_slow(heap_profile_arena arena, void *p)
+{
+  u64 key = (u64)p | arena;
+  u64 h = hash64(key >> 3);
+  for (int i = 0; i < NPROBES; i++) {
+    int s = (h + i) & (NSAMPLES - 1);
+    u64 k = sample_keys[s].load(std::memory_order_relaxed);
+    if (k == KEY_EMPTY)
+      return;
+    if (k != key)
       continue;
-    }
+    auto l = heapprof_lock.guard();
+    if (sample_keys[s].load(std::memory_order_relaxed) == key)
+      retire_sample(s);
+    return;
+  }
+}
 
-    auto pred = sorted.begin();
-    for (auto succ = sorted.begin(); succ != sorted.end(); ++succ) {
-      if (succ->prbytes < loc->prbytes)
-        break;
-      pred = succ;
+// kmfree each table that isn't null.
+static void
+heapprof_free_tables(struct heapprof_rec *st, std::atomic<u64> *keys,
+                     struct sample *smp)
+{
+  if (st)
+    kmfree(st, NSTACKS * sizeof(struct heapprof_rec));
+  if (keys)
+    kmfree(keys, NSAMPLES * sizeof(std::atomic<u64>));
+  if (smp)
+    kmfree(smp, NSAMPLES * sizeof(struct sample));
+}
+
+static int
+heapprof_start(u64 newrate)
+{
+  // Allocate before taking the lock.  If kmalloc runs out of memory,
+  // its OOM path prints the heap profile, which takes heapprof_lock.
+  // Sampling is off until the tables are published, so this doesn't
+  // reenter the profiler.
+  struct heapprof_rec *st = nullptr;
+  std::atomic<u64> *keys = nullptr;
+  struct sample *smp = nullptr;
+  if (!stacks) {
+    st = (struct heapprof_rec*)
+      kmalloc(NSTACKS * sizeof(struct heapprof_rec), "heapprof");
+    keys = (std::atomic<u64>*)
+      kmalloc(NSAMPLES * sizeof(std::atomic<u64>), "heapprof");
+    smp = (struct sample*)
+      kmalloc(NSAMPLES * sizeof(struct sample), "heapprof");
+    if (!st || !keys || !smp) {
+      heapprof_free_tables(st, keys, smp);
+      return -1;
     }
-    sorted.insert_after(pred, loc);
+    memset(st, 0, NSTACKS * sizeof(struct heapprof_rec));
+    memset(keys, 0, NSAMPLES * sizeof(std::atomic<u64>));
+    memset(smp, 0, NSAMPLES * sizeof(struct sample));
+  }
+
+  // Once published, the tables are never freed
+  auto l = heapprof_lock.guard();
+  if (!stacks) {
+    stacks = st;
+    sample_keys = keys;
+    samples = smp;
+    st = nullptr;
+    keys = nullptr;
+    smp = nullptr;
   }
+  if (newrate)
+    rate = newrate;
+  for (int i = 0; i < ncpu; i++)
+    heapprof_cpu[i].countdown = 0;
+  heap_profile_enabled.store(true, std::memory_order_release);
+  l.release();
+
+  // A concurrent start published its tables first
+  heapprof_free_tables(st, keys, smp);
+  return 0;
+}
 
-  // Print
-  for (auto &loc : sorted) {
-    if (limit-- == 0)
+// Forget all samples and stacks.  Live bytes of blocks allocated
+// before the clear are no longer counted.
+static void
+heapprof_clear(void)
+{
+  auto l = heapprof_lock.guard();
+  if (!stacks)
+    return;
+  heap_profile_live = 0;
+  memset(stacks, 0, NSTACKS * sizeof(struct heapprof_rec));
+  for (int i = 0; i < NSAMPLES; i++)
+    sample_keys[i].store(KEY_EMPTY, std::memory_order_relaxed);
+  dropped = 0;
+}
+
+// A heapprof_hdr at offset 0, followed by the used stack entries.
+static int
+heapprof_read(mdev*, char *dst, u32 off, u32 n)
+{
+  static const u64 hsz = sizeof(struct heapprof_hdr);
+  static const u64 rsz = sizeof(struct heapprof_rec);
+
+  auto l = heapprof_lock.guard();
+  int ret = 0;
+  if (off == 0) {
+    if (n < hsz)
+      return -1;
+    struct heapprof_hdr hdr{};
+    hdr.rate = rate;
+    hdr.nsec = nsectime();
+    hdr.enabled = heap_profile_enabled.load();
+    hdr.dropped = dropped;
+    for (int i = 0; stacks && i < NSTACKS; i++)
+      if (stacks[i].alloc_count)
+        hdr.nrecs++;
+    memmove(dst, &hdr, hsz);
+    ret += hsz;
+  } else if (off < hsz || (off - hsz) % rsz) {
+    return -1;
+  }
+
+  u64 skip = off ? (off - hsz) / rsz : 0;
+  for (int i = 0; stacks && i < NSTACKS; i++) {
+    if (!stacks[i].alloc_count)
+      continue;
+    if (skip) {
+      skip--;
+      continue;
+    }
+    if (n - ret < rsz)
       break;
-    s->println(loc.rip, " ", loc.prbytes, " bytes in ", loc.count,
-               " allocations");
+    memmove(dst + ret, &stacks[i], rsz);
+    ret += rsz;
   }
+  return ret;
+}
+
+// Accepts "start [rate]", "stop", and "clear", with or without a
+// trailing newline.
+static int
+heapprof_write(mdev*, const char *buf, u32 n)
+{
+  char cmd[32];
+  u32 len = n < sizeof(cmd) - 1 ? n : sizeof(cmd) - 1;
+  memmove(cmd, buf, len);
+  cmd[len] = 0;
+  if (len && cmd[len - 1] == '\n')
+    cmd[--len] = 0;
 
-  // Total
-  uintptr_t total_bytes = 0, total_count = 0;
-  for (auto &loc : sorted) {
-    total_bytes += loc.prbytes;
-    total_count += loc.count;
+  if (strncmp(cmd, "start", 5) == 0 && (cmd[5] == 0 || cmd[5] == ' ')) {
+    u64 newrate = 0;
+    for (const char *p = cmd + 5; *p; p++) {
+      if (*p == ' ' && !newrate)
+        continue;
+      if (*p < '0' || *p > '9')
+        return -1;
+      newrate = newrate * 10 + (*p - '0');
+    }
+    if (heapprof_start(newrate) < 0)
+      return -1;
+  } else if (strcmp(cmd, "stop") == 0) {
+    heap_profile_enabled.store(false, std::memory_order_release);
+  } else if (strcmp(cmd, "clear") == 0) {
+    heapprof_clear();
+  } else {
+    return -1;
   }
-  s->println("Total: ", total_bytes, " bytes in ", total_count, " allocations");
+  return n;
 }
 
 void
 heap_profile_print(print_stream *s)
 {
-  static spinlock print_lock("heap_profile_print");
+  enum { TOP = 10 };
 
-  if (KERNEL_HEAP_PROFILE) {
-    scoped_acquire l(&print_lock);
+  // kalloc's OOM path calls this, possibly on a CPU that already holds
+  // heapprof_lock, so never wait for it.
+  auto l = heapprof_lock.try_guard();
+  if (!l) {
+    s->println("Heap profile busy");
+    return;
+  }
+  if (!stacks)
+    return;
 
-    s->println("Top 10 kalloc allocations:");
-    heap_profile_print1(s, 10, HEAP_PROFILE_KALLOC);
-    s->println("Top 10 kmalloc allocations:");
-    heap_profile_print1(s, 10, HEAP_PROFILE_KMALLOC);
-  } else {
-    s->println("KERNEL_HEAP_PROFILE is not set");
+  // Selection of the TOP stacks by live bytes, without allocating
+  struct heapprof_rec *top[TOP] = {};
+  for (int i = 0; i < NSTACKS; i++) {
+    struct heapprof_rec *r = &stacks[i];
+    if (!r->alloc_count || (s64)r->live_bytes <= 0)
+      continue;
+    for (int j = 0; j < TOP; j++) {
+      if (!top[j] || top[j]->live_bytes < r->live_bytes) {
+        memmove(&top[j + 1], &top[j], (TOP - j - 1) * sizeof(top[0]));
+        top[j] = r;
+        break;
+      }
+    }
+  }
+
+  s->println("Top heap profile stacks by live bytes (sampled every ",
+             rate, " bytes):");
+  for (struct heapprof_rec *r : top) {
+    if (!r)
+      break;
+    s->print(r->arena == HEAP_PROFILE_KALLOC ? "kalloc " : "kmalloc ",
+             r->live_bytes, " bytes in ", r->live_count, " allocations:");
+    for (u64 pc : r->pcs)
+      if (pc)
+        s->print(" ", (void*)pc);
+    s->println();
   }
 }
+
+void
+initheapprof(void)
+{
+  devsw[MAJ_HEAPPROF].write = heapprof_write;
+  devsw[MAJ_HEAPPROF].pread = heapprof_read;
+}
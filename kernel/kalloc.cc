@@ -290,6 +290,9 @@ DEFINE_PERCPU_NOINIT(struct cpu_mem, cpu_mem);
 
 static_vector<numa_node, MAX_NUMA_NODES> numa_nodes;
 
+// The buddy allocators of each NUMA node, [low, high).
+static steal_order::segment node_buddy_ranges[MAX_NUMA_NODES];
+
 void *percpu_offsets[NCPU];
 
 static int kinited __mpalign__;
@@ -760,27 +763,49 @@ kalloc(const char *name, size_t size)
     if (!name)
       name = "kmem";
 
-    // Update debug_info
-    alloc_debug_info *adi = alloc_debug_info::of(res, size);
-    if (KERNEL_HEAP_PROFILE) {
-      auto alloc_rip = __builtin_return_address(0);
-      if (heap_profile_update(HEAP_PROFILE_KALLOC, alloc_rip, size))
-        adi->set_kalloc_rip(alloc_rip);
-      else
-        adi->set_kalloc_rip(nullptr);
-    }
+    heap_profile_alloc(HEAP_PROFILE_KALLOC, res, size);
 
     mtlabel(mtrace_label_block, res, size, name, strlen(name));
     return (char*)res;
   } else {
     cprintf("kalloc: out of memory\n");
-    if (KERNEL_HEAP_PROFILE)
-      heap_profile_print(&console);
+    heap_profile_print(&console);
     return nullptr;
   }
 }
 #endif
 
+// Allocate size bytes from NUMA node node, bypassing the per-CPU
+// hot list, which holds pages of the CPU's own node.  Returns nullptr
+// if the node has no free memory; unlike kalloc, this never steals
+// from another node.
+char*
+kalloc_node(const char *name, size_t node, size_t size)
+{
+  if (!kinited)
+    return (char*)early_kalloc(size, size);
+  if (node >= numa_nodes.size())
+    return nullptr;
+
+  void *res = nullptr;
+  auto &range = node_buddy_ranges[node];
+  for (size_t idx = range.low; idx < range.high && !res; ++idx) {
+    auto &lb = buddies[idx];
+    auto l = lb.lock.guard();
+    res = lb.alloc.alloc_nothrow(size);
+  }
+  if (!res)
+    return nullptr;
+
+  if (ALLOC_MEMSET)
+    memset(res, 2, size);
+  if (!name)
+    name = "kmem";
+  heap_profile_alloc(HEAP_PROFILE_KALLOC, res, size);
+  mtlabel(mtrace_label_block, res, size, name, strlen(name));
+  return (char*)res;
+}
+
 void *
 ksalloc(int slab)
 {
@@ -847,6 +872,8 @@ initpageinfo(void)
     paddr base, end;
     // The physical address following the end of the array.
     paddr phys_base;
+    // The NUMA node this area tracks.
+    std::size_t node;
   };
   static_vector<page_info_area, MAX_NUMA_NODES * 2> page_info_areas;
 
@@ -870,7 +897,8 @@ initpageinfo(void)
       size_t count = 1 + (end - base) / (sizeof(page_info) + PGSIZE);
       size_t bytes = PGROUNDUP(count * sizeof(page_info));
       if (base + bytes < PGROUNDDOWN(reg.end)) {
-        page_info_areas.push_back(page_info_area{base, end, base + bytes});
+        page_info_areas.push_back(page_info_area{base, end, base + bytes,
+                                                 node.id});
         verbose.println("kalloc: page_info ", p2v(base),
                         "..", p2v(base+bytes-1), " => ", p2v(base+bytes),
                         "..", p2v(end-1));
@@ -941,6 +969,7 @@ initpageinfo(void)
       assert(!page_info_map[i].array);
       page_info_map[i].phys_base = area.phys_base;
       page_info_map[i].array = (page_info*)p2v(area.base);
+      page_info_map[i].node = area.node;
     }
   }
   page_info_map_add = additive;
@@ -1035,6 +1064,7 @@ initkalloc(void)
       }
     }
     size_t node_buddies = buddies.size() - node_low;
+    node_buddy_ranges[node.id] = steal_order::segment{node_low, buddies.size()};
 
     console.println("kalloc: ", ssize(node_stats.free), " available in node ",
                     node.id,
@@ -1110,16 +1140,17 @@ kfree(void *v, size_t size)
   if (kinited)
     mtunlabel(mtrace_label_block, v);
 
-  // Update debug_info
-  alloc_debug_info *adi = alloc_debug_info::of(v, size);
-  if (KERNEL_HEAP_PROFILE) {
-    auto alloc_rip = adi->kalloc_rip();
-    if (alloc_rip)
-      heap_profile_update(HEAP_PROFILE_KALLOC, alloc_rip, -size);
-  }
+  heap_profile_free(HEAP_PROFILE_KALLOC, v);
 
   auto mem = mycpu()->mem;
-  if (size == PGSIZE) {
+  // The hot list feeds this CPU's allocations, which should come from
+  // its own node, so return pages of other nodes (say, from an
+  // interleaved mapping) straight to their buddy allocator.
+  bool hot = (size == PGSIZE);
+  if (hot && kinited && numa_nodes.size() > 1 &&
+      page_info::node_of(v2p(v)) != mycpu()->node->id)
+    hot = false;
+  if (hot) {
     // Free to the hot list
     scoped_cli cli;
     if (mem->nhot == KALLOC_HOT_PAGES) {
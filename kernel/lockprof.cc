@@ -0,0 +1,288 @@
+// Spinlock contention profiler.
+//
+// A lock is tracked once some CPU finds it contended: that CPU claims
+// a slot for the lock's address in the shared tracked table.  From
+// then on every CPU records its acquires, waits, and hold times for
+// the lock in its own lockprof_rec at the same slot, so acquire and
+// release only write CPU-local memory and read a table that rarely
+// changes.  Hold times come from a short per-CPU stack of held
+// tracked locks.  When profiling is off, acquire and release pay one
+// load and branch.
+//
+// Records are updated without synchronization against readers or
+// clear, so numbers read while profiling is running are approximate.
+
+#include "types.h"
+#include "kernel.hh"
+#include "amd64.h"
+#include "spinlock.hh"
+#include "lockprof.hh"
+#include "percpu.hh"
+#include "fs.h"
+#include "file.hh"
+#include "major.h"
+#include "uk/lockprof.h"
+
+enum {
+  // Number of locks that can be tracked.  Must be a power of 2.
+  NSLOTS = 128,
+  // Maximum probes to find a lock's slot
+  NPROBES = 8,
+  // Depth of the per-CPU held-lock stack
+  NHELD = 8,
+};
+
+std::atomic<bool> lockprof_enabled;
+
+// Address of the lock tracked in each slot, or 0.
+static std::atomic<u64> tracked[NSLOTS];
+
+// start_gen counts starts and clears; clear_gen counts clears.  A CPU
+// that sees start_gen change drops its held-lock stack, and also its
+// records if clear_gen changed.
+static std::atomic<u64> start_gen, clear_gen;
+
+static spinlock lockprof_lock("lockprof");
+
+struct lockprof_cpu {
+  u64 start_gen, clear_gen;
+  struct lockprof_rec *recs;    // NSLOTS, indexed like tracked
+  struct {
+    struct spinlock *lk;
+    int slot;
+    u64 ts;
+  } held[NHELD];
+  int nheld;
+};
+
+DEFINE_PERCPU(struct lockprof_cpu, lockprof_cpu);
+
+static int
+bucket(u64 cycles)
+{
+  if (cycles == 0)
+    return 0;
+  int b = 63 - __builtin_clzll(cycles);
+  return b < LOCKPROF_BUCKETS ? b : LOCKPROF_BUCKETS - 1;
+}
+
+// Return this CPU's state, first catching up with any start or clear
+// since it last looked, or nullptr if the profiler was never started.
+static struct lockprof_cpu *
+mystate(void)
+{
+  struct lockprof_cpu *c = lockprof_cpu.get();
+  if (!c->recs)
+    return nullptr;
+  u64 sg = start_gen.load(std::memory_order_acquire);
+  if (c->start_gen != sg) {
+    u64 cg = clear_gen.load(std::memory_order_acquire);
+    if (c->clear_gen != cg) {
+      memset(c->recs, 0, NSLOTS * sizeof(c->recs[0]));
+      c->clear_gen = cg;
+    }
+    c->nheld = 0;
+    c->start_gen = sg;
+  }
+  return c;
+}
+
+// Find lock's slot in tracked.  If insert, claim a slot for it if it
+// has none.  Returns -1 if lock isn't tracked or the table is full.
+static int
+findslot(u64 lock, bool insert)
+{
+  u64 h = ((lock >> 4) * 0x9e3779b97f4a7c15ull) >> 32;
+  for (int i = 0; i < NPROBES; i++) {
+    int slot = (h + i) & (NSLOTS - 1);
+    u64 cur = tracked[slot].load(std::memory_order_relaxed);
+    if (cur == lock)
+      return slot;
+    if (cur == 0) {
+      if (!insert)
+        return -1;
+      if (tracked[slot].compare_exchange_strong(cur, lock) || cur == lock)
+        return slot;
+    }
+  }
+  return -1;
+}
+
+// Charge a contended acquire to its call site.  When all site entries
+// are taken, pc replaces the entry with the fewest contends and
+// inherits its counts, so heavy sites are never undercounted.
+static void
+note_site(struct lockprof_rec *r, u64 pc, u64 wait)
+{
+  struct lockprof_site *min = &r->sites[0];
+  for (struct lockprof_site &s : r->sites) {
+    if (s.pc == pc || s.pc == 0) {
+      s.pc = pc;
+      s.contends++;
+      s.wait_cycles += wait;
+      return;
+    }
+    if (s.contends < min->contends)
+      min = &s;
+  }
+  min->pc = pc;
+  min->contends++;
+  min->wait_cycles += wait;
+}
+
+void
+lockprof_acquired(struct spinlock *lk, u64 start, bool contended, void *pc)
+{
+  struct lockprof_cpu *c = mystate();
+  if (!c)
+    return;
+  int slot = findslot((u64)lk, contended);
+  if (slot < 0)
+    return;
+
+  u64 now = rdtsc();
+  struct lockprof_rec *r = &c->recs[slot];
+  if (r->lock != (u64)lk) {
+    // First use of this slot since the last clear
+    memset(r, 0, sizeof(*r));
+    r->lock = (u64)lk;
+    r->cpu = myid();
+#if SPINLOCK_DEBUG
+    if (lk->name)
+      strncpy(r->name, lk->name, sizeof(r->name) - 1);
+#endif
+  }
+  r->acquires++;
+  if (contended) {
+    u64 wait = now - start;
+    r->contends++;
+    r->wait_cycles += wait;
+    r->wait_hist[bucket(wait)]++;
+    note_site(r, (u64)pc, wait);
+  }
+
+  if (c->nheld == NHELD) {
+    // Forget the oldest hold.  This can happen if a lock is released
+    // on a different CPU than it was acquired on.
+    memmove(&c->held[0], &c->held[1], (NHELD - 1) * sizeof(c->held[0]));
+    c->nheld--;
+  }
+  c->held[c->nheld].lk = lk;
+  c->held[c->nheld].slot = slot;
+  c->held[c->nheld].ts = now;
+  c->nheld++;
+}
+
+void
+lockprof_releasing(struct spinlock *lk)
+{
+  struct lockprof_cpu *c = mystate();
+  if (!c)
+    return;
+  for (int i = c->nheld - 1; i >= 0; i--) {
+    if (c->held[i].lk != lk)
+      continue;
+    u64 hold = rdtsc() - c->held[i].ts;
+    struct lockprof_rec *r = &c->recs[c->held[i].slot];
+    r->hold_cycles += hold;
+    r->hold_hist[bucket(hold)]++;
+    c->nheld--;
+    memmove(&c->held[i], &c->held[i + 1], (c->nheld - i) * sizeof(c->held[0]));
+    return;
+  }
+}
+
+static void
+lockprof_clear(void)
+{
+  for (auto &t : tracked)
+    t.store(0, std::memory_order_relaxed);
+  clear_gen++;
+  start_gen++;
+}
+
+static int
+lockprof_start(void)
+{
+  auto l = lockprof_lock.guard();
+  for (int i = 0; i < ncpu; i++) {
+    struct lockprof_cpu *c = &lockprof_cpu[i];
+    if (c->recs)
+      continue;
+    auto recs = (struct lockprof_rec*)
+      kmalloc(NSLOTS * sizeof(struct lockprof_rec), "lockprof");
+    if (!recs)
+      return -1;
+    memset(recs, 0, NSLOTS * sizeof(*recs));
+    c->clear_gen = clear_gen.load();
+    c->start_gen = start_gen.load();
+    __atomic_store_n(&c->recs, recs, __ATOMIC_RELEASE);
+  }
+  start_gen++;
+  lockprof_enabled.store(true, std::memory_order_release);
+  return 0;
+}
+
+// Return the records of every (lock, CPU) pair with at least one
+// acquire, in slot order.
+static int
+lockprof_read(mdev*, char *dst, u32 off, u32 n)
+{
+  static const u64 sz = sizeof(struct lockprof_rec);
+
+  if (off % sz || n < sz)
+    return -1;
+
+  u64 skip = off / sz;
+  u64 cg = clear_gen.load(std::memory_order_acquire);
+  int ret = 0;
+  for (int slot = 0; slot < NSLOTS; slot++) {
+    for (int i = 0; i < ncpu; i++) {
+      struct lockprof_cpu *c = &lockprof_cpu[i];
+      struct lockprof_rec *recs = __atomic_load_n(&c->recs, __ATOMIC_ACQUIRE);
+      if (!recs || c->clear_gen != cg || !recs[slot].acquires)
+        continue;
+      if (skip) {
+        skip--;
+        continue;
+      }
+      if (n - ret < sz)
+        return ret;
+      memmove(dst + ret, &recs[slot], sz);
+      ret += sz;
+    }
+  }
+  return ret;
+}
+
+// Accepts "start", "stop", and "clear", with or without a trailing
+// newline.
+static int
+lockprof_write(mdev*, const char *buf, u32 n)
+{
+  u32 len = n;
+  if (len && buf[len - 1] == '\n')
+    len--;
+  auto is = [&](const char *cmd) {
+    return strlen(cmd) == len && memcmp(buf, cmd, len) == 0;
+  };
+
+  if (is("start")) {
+    if (lockprof_start() < 0)
+      return -1;
+  } else if (is("stop")) {
+    lockprof_enabled.store(false, std::memory_order_release);
+  } else if (is("clear")) {
+    lockprof_clear();
+  } else {
+    return -1;
+  }
+  return n;
+}
+
+void
+initlockprof(void)
+{
+  devsw[MAJ_LOCKPROF].write = lockprof_write;
+  devsw[MAJ_LOCKPROF].pread = lockprof_read;
+}
@@ -43,6 +43,11 @@ void initpci(void);
 void initnet(void);
 void initsched(void);
 void initlockstat(void);
+void initlockprof(void);
+void initsyscallstats(void);
+void initheapprof(void);
+void initnumabalance(void);
+void initzswap(void);
 void initidle(void);
 void initcpprt(void);
 void initfutex(void);
@@ -225,6 +230,11 @@ cmain(u64 mbmagic, u64 mbaddr)
   initfutex();
   initsamp();
   initlockstat();
+  initlockprof();
+  initsyscallstats();
+  initheapprof();
+  initnumabalance();
+  initzswap();
   initacpi();              // Requires initacpitables, initkalloc?
   inite1000();             // Before initpci
   initpci();               // Suggests initacpi
@@ -0,0 +1,111 @@
+#include "types.h"
+#include "kernel.hh"
+#include "amd64.h"
+#include "cpu.hh"
+#include "numa.hh"
+#include "page_info.hh"
+#include "mempolicy.hh"
+#include "kstats.hh"
+
+extern "C" void zpage(void*);
+
+// Per-node allocation counters, indexed by node
+static uint64_t kstats::* const node_alloc_count[] = {
+#define X(type, name) &kstats::name,
+  KSTATS_PER_NODE(X, numa_node_alloc_count)
+#undef X
+};
+static_assert(sizeof(node_alloc_count) / sizeof(node_alloc_count[0]) ==
+              MAX_NUMA_NODES, "KSTATS_PER_NODE doesn't match MAX_NUMA_NODES");
+
+bool
+mempolicy::make(int mode, u64 nodemask, mempolicy *out)
+{
+  switch (mode) {
+  case MPOL_DEFAULT:
+    *out = mempolicy();
+    return true;
+  case MPOL_BIND:
+  case MPOL_INTERLEAVE:
+    nodemask &= (1ull << numa_nodes.size()) - 1;
+    if (!nodemask)
+      return false;
+    *out = mempolicy(mode, nodemask);
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Return the number of nodes set in nodes.  (__builtin_popcount would
+// need libgcc without -mpopcnt.)
+static unsigned
+count_nodes(u16 nodes)
+{
+  unsigned n = 0;
+  for (; nodes; nodes &= nodes - 1)
+    n++;
+  return n;
+}
+
+// Return the n'th node set in nodes.
+static size_t
+nth_node(u16 nodes, unsigned n)
+{
+  for (; n; n--)
+    nodes &= nodes - 1;
+  return __builtin_ctz(nodes);
+}
+
+// Allocate a zeroed page from node.
+static char*
+zalloc_on(const char *name, size_t node)
+{
+  char *p = kalloc_node(name, node);
+  if (p)
+    zpage(p);
+  return p;
+}
+
+char*
+mempolicy_zalloc(const char *name, const mempolicy &pol, u64 index)
+{
+  size_t local = mycpu()->node->id;
+  size_t node = local;
+  switch (pol.mode) {
+  case MPOL_BIND:
+    if (!(pol.nodes & (1 << local)))
+      node = nth_node(pol.nodes, 0);
+    kstats::inc(&kstats::numa_bind_alloc_count);
+    break;
+  case MPOL_INTERLEAVE:
+    node = nth_node(pol.nodes, index % count_nodes(pol.nodes));
+    kstats::inc(&kstats::numa_interleave_alloc_count);
+    break;
+  default:
+    kstats::inc(&kstats::numa_local_alloc_count);
+    break;
+  }
+
+  // Local pages come from the per-CPU pool of zeroed pages, which
+  // steals from other nodes once this one runs out.
+  char *p = node == local ? zalloc(name) : zalloc_on(name, node);
+  if (pol.mode == MPOL_BIND) {
+    if (p && !(pol.nodes & (1 << page_info::node_of(v2p(p))))) {
+      kfree(p);
+      p = nullptr;
+    }
+    for (u16 left = pol.nodes; !p && left; left &= left - 1)
+      p = zalloc_on(name, nth_node(left, 0));
+  } else if (!p) {
+    p = zalloc(name);
+  }
+  if (!p)
+    return nullptr;
+
+  size_t actual = page_info::node_of(v2p(p));
+  if (actual != node)
+    kstats::inc(&kstats::numa_policy_miss_count);
+  kstats::inc(node_alloc_count[actual]);
+  return p;
+}
@@ -30,20 +30,23 @@ load_dir(sref<inode> i, sref<mnode> m)
   }
 }
 
+// Give m the buffer cache's pages for i's blocks, rather than copies
+// of them, so the disk cache and the file (and any mappings of it)
+// share one copy of the data.  mfs never writes back to disk, so
+// writes to the file change the cached blocks but do not dirty them.
 static void
 load_file(sref<inode> i, sref<mnode> m)
 {
   for (size_t pos = 0; pos < i->size; pos += PGSIZE) {
-    char* p = zalloc("load_file");
-    assert(p);
-
-    auto pi = sref<page_info>::transfer(new (page_info::of(p)) page_info());
+    sref<page_info> pi = readpage(i, pos / BSIZE);
+    assert(pi);
 
     size_t nbytes = i->size - pos;
     if (nbytes > PGSIZE)
       nbytes = PGSIZE;
+    // mfs expects the tail of a partial page to be zero
+    memset((char*)pi->va() + nbytes, 0, PGSIZE - nbytes);
 
-    assert(nbytes == readi(i, p, pos, nbytes));
     auto resize = m->as_file()->write_size();
     resize.resize_append(pos + nbytes, pi);
   }
@@ -0,0 +1,130 @@
+// Automatic NUMA balancing.
+//
+// Each period, the first thread of an address space to take a timer
+// tick in user space scans it: vmap::numa_scan unmaps a sample of its
+// resident anonymous pages, so the next access to each takes a
+// hinting fault.  A hinting fault tells us which node a page is on
+// and which node's CPU uses it.
+//
+// Each thread counts its hinting faults by the node of the page, and
+// the node with the most is the thread's preferred node.  A page the
+// thread touches from its preferred node moves to that node, and a
+// thread most of whose sampled memory is on another node moves there.
+//
+// Balancing is off by default.  Write a scan period in milliseconds
+// to /dev/numabalance to turn it on, or 0 to turn it off.
+
+#include "types.h"
+#include "kernel.hh"
+#include "amd64.h"
+#include "cpu.hh"
+#include "proc.hh"
+#include "vm.hh"
+#include "numa.hh"
+#include "file.hh"
+#include "major.h"
+#include "kstream.hh"
+#include "kstats.hh"
+
+enum {
+  // Hinting faults a thread takes between placement decisions
+  PLACE_FAULTS = 32,
+};
+
+// Scan period in milliseconds, or 0 if balancing is off
+static std::atomic<u64> scan_period_ms;
+
+int
+numa_hint_fault(size_t page_node)
+{
+  proc *p = myproc();
+  size_t node = mycpu()->node->id;
+
+  kstats::inc(&kstats::numa_hint_fault_count);
+  if (page_node == node)
+    kstats::inc(&kstats::numa_hint_fault_local_count);
+  p->numa_faults[page_node]++;
+
+  // Pull the page to us only if we're where our memory is.  If we're
+  // not, numa_place will move us instead.
+  if (page_node != node && p->numa_pref == (int)node)
+    return node;
+  return -1;
+}
+
+// Update p's preferred node and, if most of its sampled memory is on
+// another node, set it to run there.
+static void
+numa_place(proc *p)
+{
+  u64 total = 0;
+  size_t pref = 0;
+  for (size_t n = 0; n < numa_nodes.size(); n++) {
+    total += p->numa_faults[n];
+    if (p->numa_faults[n] > p->numa_faults[pref])
+      pref = n;
+  }
+  if (total < PLACE_FAULTS)
+    return;
+
+  bool dominant = p->numa_faults[pref] * 3 >= total * 2;
+  // Decay the counts, so placement follows recent accesses
+  for (size_t n = 0; n < numa_nodes.size(); n++)
+    p->numa_faults[n] /= 2;
+  p->numa_pref = pref;
+
+  auto &cpus = numa_nodes[pref].cpus;
+  if (!dominant || p->cpu_pin || pref == mycpu()->node->id || cpus.empty())
+    return;
+  // sched will put us on the new CPU's run queue when we next yield
+  acquire(&p->lock);
+  p->cpuid = cpus[p->pid % cpus.size()]->id;
+  release(&p->lock);
+  kstats::inc(&kstats::numa_task_migrate_count);
+}
+
+// Called on each timer tick that interrupts user space.
+void
+numa_balance_tick(void)
+{
+  u64 period = scan_period_ms.load(std::memory_order_relaxed);
+  if (!period || numa_nodes.size() < 2)
+    return;
+
+  proc *p = myproc();
+  // Scanning may shoot down TLBs, which needs interrupts
+  sti();
+  p->vmap->numa_scan(nsectime(), period * 1000000, NUMA_BALANCE_SCAN_PAGES);
+  cli();
+  numa_place(p);
+}
+
+static int
+numabalance_read(mdev*, char *dst, u32 off, u32 n)
+{
+  window_stream s(dst, off, n);
+  s.println("period ", scan_period_ms.load(), " ms");
+  s.println("scan ", NUMA_BALANCE_SCAN_PAGES, " pages");
+  s.println("nodes ", numa_nodes.size());
+  return s.get_used();
+}
+
+static int
+numabalance_write(mdev*, const char *buf, u32 n)
+{
+  u64 period = 0;
+  u32 i = 0;
+  for (; i < n && buf[i] >= '0' && buf[i] <= '9'; i++)
+    period = period * 10 + (buf[i] - '0');
+  if (i == 0 || (i < n && buf[i] != '\n'))
+    return -1;
+  scan_period_ms.store(period, std::memory_order_relaxed);
+  return n;
+}
+
+void
+initnumabalance(void)
+{
+  devsw[MAJ_NUMABALANCE].write = numabalance_write;
+  devsw[MAJ_NUMABALANCE].pread = numabalance_read;
+}
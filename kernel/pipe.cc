@@ -7,6 +7,7 @@
 #include "fs.h"
 #include "file.hh"
 #include "cpu.hh"
+#include "pollqueue.hh"
 #include "uk/unistd.h"
 #include "uk/fcntl.h"
 
@@ -17,6 +18,8 @@ struct pipe {
   virtual int write(const char *addr, int n) = 0;
   virtual int read(char *addr, int n) = 0;
   virtual int close(int writable) = 0;
+  virtual int poll(int events) = 0;
+  virtual pollqueue *get_pollqueue() = 0;
   NEW_DELETE_OPS(pipe);
 };
 
@@ -25,6 +28,7 @@ struct ordered : pipe {
   struct spinlock lock_close;
   struct condvar  empty;
   struct condvar  full;
+  struct pollqueue pollq;
   std::atomic<bool> readopen;   // read fd is still open
   int writeopen;  // write fd is still open
   std::atomic<size_t> nread;  // number of bytes read
@@ -74,8 +78,10 @@ struct ordered : pipe {
       }
       data[nwrite++ % PIPESIZE] = addr[i];
     }
-    if (n > 0)
+    if (n > 0) {
       empty.wake_all();
+      pollq.wake();
+    }
     return n;
   }
 
@@ -108,11 +114,35 @@ struct ordered : pipe {
         break;
       addr[i] = data[nread++ % PIPESIZE];
     }
-    if (i > 0)
+    if (i > 0) {
       full.wake_all();
+      pollq.wake();
+    }
     return i;
   }
 
+  // Like the nonblocking paths above, this reads nread and nwrite
+  // without the lock, so the answer may be stale by the time the
+  // caller acts on it.
+  virtual int poll(int events) override {
+    size_t nr = nread;
+    size_t nw = nwrite;
+    int revents = 0;
+    if ((events & POLLIN) && nw != nr)
+      revents |= POLLIN;
+    if ((events & POLLIN) && writeopen == 0)
+      revents |= POLLHUP;
+    if ((events & POLLOUT) && nw != nr + PIPESIZE)
+      revents |= POLLOUT;
+    if ((events & POLLOUT) && !readopen)
+      revents |= POLLERR;
+    return revents;
+  }
+
+  virtual pollqueue *get_pollqueue() override {
+    return &pollq;
+  }
+
   virtual int close(int writable) override {
     scoped_acquire l(&lock_close);
     if(writable){
@@ -121,6 +151,7 @@ struct ordered : pipe {
       readopen = 0;
     }
     empty.wake_all();
+    pollq.wake();
     if(readopen == 0 && writeopen == 0){
       return 1;
     }
@@ -163,3 +194,15 @@ piperead(struct pipe *p, char *addr, int n)
 {
   return p->read(addr, n);
 }
+
+int
+pipepoll(struct pipe *p, int events)
+{
+  return p->poll(events);
+}
+
+pollqueue*
+pipepollqueue(struct pipe *p)
+{
+  return p->get_pollqueue();
+}
@@ -0,0 +1,66 @@
+#include "types.h"
+#include "kernel.hh"
+#include "pollqueue.hh"
+
+void
+poller::arm()
+{
+  scoped_acquire l(&lock);
+  woken = false;
+}
+
+void
+poller::sleep_to(u64 deadline)
+{
+  scoped_acquire l(&lock);
+  while (!woken && nsectime() < deadline)
+    cv.sleep_to(&lock, deadline == ~0ull ? 0 : deadline);
+}
+
+void
+poller::wake()
+{
+  scoped_acquire l(&lock);
+  woken = true;
+  cv.wake_all();
+}
+
+pollentry::~pollentry()
+{
+  if (q)
+    q->remove(this);
+}
+
+void
+pollqueue::add(pollentry *e, poller *p)
+{
+  scoped_acquire l(&lock);
+  e->p = p;
+  e->q = this;
+  entries.push_back(e);
+  nentries.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+pollqueue::remove(pollentry *e)
+{
+  scoped_acquire l(&lock);
+  entries.erase(entries.iterator_to(e));
+  nentries.fetch_sub(1, std::memory_order_relaxed);
+  e->q = nullptr;
+}
+
+void
+pollqueue::wake()
+{
+  // Order the caller's state change before our check for pollers.  A
+  // poller adds itself and then arms, which takes a lock, before it
+  // polls, so either it sees the change or we see it.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!nentries.load(std::memory_order_relaxed))
+    return;
+
+  scoped_acquire l(&lock);
+  for (auto &e : entries)
+    e.p->wake();
+}
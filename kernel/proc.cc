@@ -13,6 +13,7 @@
 #include "ns.hh"
 #include "work.hh"
 #include "filetable.hh"
+#include "percpu.hh"
 #include <uk/fcntl.h>
 #include <uk/unistd.h>
 #include <uk/wait.h>
@@ -23,9 +24,30 @@ proc::hash(const u32 &p)
   return p;
 }
 
-xns<u32, proc*, proc::hash> *xnspid __mpalign__;
+xns<u32, proc*, proc::hash, NPIDHASH> *xnspid __mpalign__;
 struct proc *bootproc __mpalign__;
 
+// Pids are handed out in per-core ranges of PIDBATCH so that fork
+// doesn't bounce a global counter between cores.  Pids are only
+// unique, not dense or ordered across cores.
+struct pid_range
+{
+  u32 next;
+  u32 end;
+};
+DEFINE_PERCPU(struct pid_range, pid_ranges);
+static std::atomic<u32> nextpid_batch __mpalign__;
+
+// Kernel stacks are larger than a page, so they bypass the per-core
+// hot page lists in kalloc and would otherwise hit a buddy lock on
+// every fork and exit.  Keep a few free stacks on each core instead.
+struct kstack_cache
+{
+  char *stacks[KSTACK_CACHE];
+  size_t n;
+};
+DEFINE_PERCPU(struct kstack_cache, kstack_caches);
+
 #if MTRACE
 struct kstack_tag kstack_tag[NCPU];
 #endif
@@ -38,9 +60,10 @@ proc::proc(int npid) :
   cpu_pin(0), oncv(0), cv_wakeup(0),
   futex_lock("proc::futex_lock", LOCKSTAT_PROC),
   user_fs_(0), unmap_tlbreq_(0), data_cpuid(-1), in_exec_(0), 
-  uaccess_(0), yield_(false),
+  uaccess_(0), yield_(false), vfork_(false), clear_tid_(nullptr),
   upath(nullptr), uargv(nullptr),
-  exception_inuse(0), magic(PROC_MAGIC), unmapped_hint(0), state_(EMBRYO)
+  exception_inuse(0), magic(PROC_MAGIC), unmapped_hint(0),
+  numa_faults{}, numa_pref(-1), state_(EMBRYO)
 {
   snprintf(lockname, sizeof(lockname), "cv:proc:%d", pid);
   lock = spinlock(lockname+3, LOCKSTAT_PROC);
@@ -141,6 +164,36 @@ forkret(void)
   // Return to "caller", actually trapret (see allocproc).
 }
 
+// If this process was created by vfork, let the parent resume.  The
+// parent can't exit while it is suspended, so parent is stable.
+void
+proc::vfork_release()
+{
+  if (!vfork_)
+    return;
+  acquire(&parent->lock);
+  vfork_ = false;
+  release(&parent->lock);
+  parent->cv->wake_all();
+}
+
+// If this is a library thread, tell anyone joining it that it is
+// gone: zero the tid word it registered in vm and wake any waiters.
+// After this, the library may reuse the thread's stack.
+void
+proc::release_tid(struct vmap *vm)
+{
+  if (!clear_tid_)
+    return;
+  userptr<u64> tid = clear_tid_;
+  clear_tid_ = nullptr;
+
+  u64 zero = 0;
+  futexkey_t key;
+  if (tid.store(&zero) && futexkey(tid.unsafe_get(), vm, &key) == 0)
+    futexwake(key, ~0ull >> 1);
+}
+
 // Exit the current process.  Does not return.
 // An exited process remains in the zombie state
 // until its parent calls wait() to find out it exited.
@@ -152,6 +205,11 @@ exit(int status)
   if(myproc() == bootproc)
     panic("init exiting");
 
+  myproc()->vfork_release();
+
+  if (myproc()->vmap != nullptr)
+    myproc()->release_tid(myproc()->vmap.get());
+
   myproc()->ftable.reset();
 
   myproc()->cwd.reset();
@@ -212,9 +270,50 @@ exit(int status)
   panic("zombie exit");
 }
 
+static u32
+allocpid(void)
+{
+  scoped_critical c(NO_SCHED);
+  pid_range *r = pid_ranges.get();
+  if (r->next == r->end) {
+    // Pid 0 is never handed out.
+    r->next = nextpid_batch.fetch_add(PIDBATCH) + 1;
+    r->end = r->next + PIDBATCH;
+  }
+  return r->next++;
+}
+
+static char *
+kstack_alloc(void)
+{
+  {
+    scoped_critical c(NO_SCHED);
+    kstack_cache *kc = kstack_caches.get();
+    if (kc->n)
+      return kc->stacks[--kc->n];
+  }
+  return (char*) ksalloc(slab_stack);
+}
+
+static void
+kstack_free(char *kstack)
+{
+  {
+    scoped_critical c(NO_SCHED);
+    kstack_cache *kc = kstack_caches.get();
+    if (kc->n < KSTACK_CACHE) {
+      kc->stacks[kc->n++] = kstack;
+      return;
+    }
+  }
+  ksfree(slab_stack, kstack);
+}
+
 static void
 freeproc(struct proc *p)
 {
+  if (p->kstack)
+    kstack_free(p->kstack);
   delete p;
 }
 
@@ -224,7 +323,7 @@ proc::alloc(void)
   char *sp;
   proc* p;
 
-  p = new proc(xnspid->allockey());
+  p = new proc(allocpid());
   if (p == nullptr)
     throw_bad_alloc();
 
@@ -237,7 +336,7 @@ proc::alloc(void)
     panic("allocproc: ns_insert");
 
   // Allocate kernel stack if possible.
-  if((p->kstack = (char*) ksalloc(slab_stack)) == 0){
+  if((p->kstack = kstack_alloc()) == 0){
     if (!xnspid->remove(p->pid, &p))
       panic("allocproc: ns_remove");
     freeproc(p);
@@ -271,7 +370,7 @@ proc::alloc(void)
 void
 initproc(void)
 {
-  xnspid = new xns<u32, proc*, proc::hash>(false);
+  xnspid = new xns<u32, proc*, proc::hash, NPIDHASH>(false);
   if (xnspid == 0)
     panic("pinit");
 }
@@ -382,12 +481,13 @@ doclone(clone_flags flags)
     np->vmap = myproc()->vmap->copy();
   }
 
-  np->parent = myproc();
+  np->parent = (flags & CLONE_DETACH) ? nullptr : myproc();
   *np->tf = *myproc()->tf;
   np->cpu_pin = myproc()->cpu_pin;
   np->data_cpuid = myproc()->data_cpuid;
   np->run_cpuid_ = myproc()->run_cpuid_;
   np->user_fs_ = myproc()->user_fs_;
+  np->mpol = myproc()->mpol;
   memcpy(np->sig, myproc()->sig, sizeof(np->sig));
 
   // Clear %eax so that fork returns 0 in the child.
@@ -402,9 +502,11 @@ doclone(clone_flags flags)
   np->cwd = myproc()->cwd;
   np->cwd_m = myproc()->cwd_m;
   safestrcpy(np->name, myproc()->name, sizeof(myproc()->name));
-  acquire(&myproc()->lock);
-  myproc()->childq.push_back(np);
-  release(&myproc()->lock);
+  if (np->parent) {
+    acquire(&myproc()->lock);
+    myproc()->childq.push_back(np);
+    release(&myproc()->lock);
+  }
 
   np->cpuid = mycpu()->id;
   if (!(flags & CLONE_NO_RUN)) {
@@ -422,8 +524,6 @@ finishproc(struct proc *p, bool removepid)
 {
   if (removepid && !xnspid->remove(p->pid, &p))
     panic("finishproc: ns_remove");
-  if (p->kstack)
-    ksfree(slab_stack, p->kstack);
 
   p->pid = 0;
   p->parent = 0;
@@ -1,6 +1,12 @@
 #include "refcache.hh"
 #include "proc.hh"
 #include "kstream.hh"
+#include "numa.hh"
+#include "ipi.hh"
+#include "sleeplock.hh"
+#include "file.hh"
+#include "major.h"
+#include "epochtree.hh"
 
 #include <atomic>
 #include <iterator>
@@ -29,12 +35,33 @@ namespace refcache {
   // having to read it.
   static std::atomic<uint64_t> global_epoch __mpalign__;
 
-  // The number of cores where the local epoch is < global_epoch.
-  // Once this reaches zero, it is reset to ncpus and the global_epoch
-  // incremented.
-  static std::atomic<size_t> global_epoch_left __mpalign__;
+  // The per-leaf state of the epoch combining tree.
+  struct backlog_leaf
+  {
+    // The sum of the review queue lengths of this leaf's cores that
+    // have reached global_epoch.
+    std::atomic<uint64_t> backlog;
+  };
+
+  // Counts the cores where the local epoch is < global_epoch.
+  static epoch_tree<backlog_leaf> tree;
+
+  // The sum of the backlogs of the leaves that have reached
+  // global_epoch.
+  static std::atomic<uint64_t> global_backlog __mpalign__;
+
+  // The number of timer ticks between each core's flushes.  Only
+  // written by the core that ends an epoch.
+  static std::atomic<uint64_t> epoch_ticks __mpalign__;
 
   static __padout__ __attribute__((unused));
+
+  // Serializes synchronize calls, so they don't send redundant IPIs.
+  static sleeplock sync_lock;
+
+  // The number of sets each core's cache should use.  Cores adopt
+  // this when they next flush.
+  static std::atomic<std::size_t> cache_sets(CACHE_SLOTS / CACHE_WAYS);
 }
 
 void
@@ -78,7 +105,9 @@ refcache::cache::evict(struct refcache::cache::way *way,
       // global_epoch if !local_epoch_is_exact.
       obj->review_epoch_ = local_epoch + (local_epoch_is_exact ? 2 : 3);
       obj->dirty_ = false;
+      obj->zero_tsc_ = rdtsc();
       review_.push_back(obj);
+      ++review_len_;
       // If this object has a weak reference, mark it dying.
       if (obj->weak_) {
         weak_referenced *wobj = static_cast<weak_referenced*>(obj);
@@ -93,6 +122,7 @@ refcache::cache::evict(struct refcache::cache::way *way,
         sdebug.println("refcache: CPU ", myid(), " dirtying obj ", obj,
                        " with delta ", delta);
       obj->dirty_ = true;
+      obj->zero_tsc_ = rdtsc();
       kstats::inc(&kstats::refcache_dirtied_count);
     }
   } else {
@@ -112,6 +142,7 @@ refcache::cache::review()
   // may have interrupts enabled, first find the cut-off.
   uint64_t epoch = global_epoch;
   referenced *last_reviewable = nullptr;
+  uint64_t ncut = 0;
   for (referenced &obj : review_) {
     if (REFCACHE_DEBUG) {
       if (!(obj.review_epoch_ <= epoch + 3))
@@ -124,6 +155,7 @@ refcache::cache::review()
     if (obj.review_epoch_ > epoch)
       break;
     last_reviewable = &obj;
+    ++ncut;
   }
 
   if (!last_reviewable)
@@ -135,6 +167,7 @@ refcache::cache::review()
     scoped_cli cli;
     reviewable = std::move(review_);
     review_ = reviewable.cut_after(reviewable.iterator_to(last_reviewable));
+    review_len_ -= ncut;
   }
 
   // Scan reviewable objects.  Objects will either be deleted,
@@ -177,6 +210,7 @@ refcache::cache::review()
         obj->review_epoch_ = epoch + 2;
         scoped_cli cli;
         review_.push_back(&*obj);
+        ++review_len_;
         ++nrequeued;
       } else {
         // It was zero for the whole round.  Free it.
@@ -218,7 +252,24 @@ refcache::cache::review()
   kstats::inc(&kstats::refcache_item_disowned_count, ndisowned);
 }
 
-void
+// Adjust the epoch length for a review backlog of backlog objects.
+// Called by the core that ends each epoch.
+static void
+adapt_epoch(uint64_t backlog)
+{
+  uint64_t ticks = refcache::epoch_ticks.load(std::memory_order_relaxed);
+  // Shorten quickly when objects pile up, so they're freed sooner,
+  // but lengthen slowly, since each lengthening delays frees
+  if (backlog >= REFCACHE_BACKLOG)
+    ticks = ticks > 1 ? ticks / 2 : 1;
+  else if (ticks < REFCACHE_MAX_EPOCH_TICKS)
+    ticks++;
+  refcache::epoch_ticks.store(ticks, std::memory_order_relaxed);
+  kstats::inc(&kstats::refcache_epoch_count);
+  kstats::inc(&kstats::refcache_epoch_tick_count, ticks);
+}
+
+bool
 refcache::cache::flush()
 {
   kstats::inc(&kstats::refcache_flush_count);
@@ -232,8 +283,8 @@ refcache::cache::flush()
     // We've already reached the global epoch.  There's no point in
     // flushing the cache, since it won't help any core progress in
     // its review list, and we must not join the current global epoch
-    // a second time or we'll screw up global_epoch_left.
-    return;
+    // a second time or we'll screw up the combining tree.
+    return false;
   }
   // Update local_epoch so we can tell evict that local_epoch is
   // exact.
@@ -246,7 +297,7 @@ refcache::cache::flush()
   // XXX This can blow through our CPU cache.  Should we keep a
   // summary bitmap of CPU cache lines containing non-zero deltas?
   std::size_t nflushed = 0;
-  for (std::size_t i = 0; i < CACHE_SLOTS; ++i) {
+  for (std::size_t i = 0; i < nsets_ * CACHE_WAYS; ++i) {
     // Since we have the token now, we can put things directly on
     // the review list for next round because we know that we'll
     // have passed through all of the cores when we next get the
@@ -259,24 +310,65 @@ refcache::cache::flush()
   // if (nflushed)
   //   console.println("refcache: CPU ", myid(), " flushed ", nflushed);
 
-  // Announce that we've reached the global epoch
-  if (--global_epoch_left == 0) {
+  // Our cache is empty, so this is when we can resize it
+  std::size_t nsets = cache_sets.load(std::memory_order_relaxed);
+  if (nsets != nsets_) {
+    nsets_ = nsets;
+    kstats::inc(&kstats::refcache_resize_count);
+  }
+
+  // Announce that we've reached the global epoch.  No core can
+  // flush again until global_epoch advances.  The last core in each
+  // leaf adds the leaf's backlog to the global one.
+  tree.my_leaf()->backlog += review_len_;
+  if (tree.report([](backlog_leaf *leaf) {
+        global_backlog += leaf->backlog.exchange(0);
+      })) {
     // We're the last core to reach the global epoch.  Move to the
     // next epoch.
-    global_epoch_left = ncpu;
+    adapt_epoch(global_backlog.exchange(0));
     ++global_epoch;
   }
 
   kstats::inc(&kstats::refcache_item_flushed_count, nflushed);
+  return true;
 }
 
 void
-refcache::cache::tick()
+refcache::cache::tick(bool force)
 {
-  flush();
+  // Once it's been long enough, flush as soon as the global epoch
+  // lets us
+  if (++ticks_ >= epoch_ticks.load(std::memory_order_relaxed) || force)
+    if (flush())
+      ticks_ = 0;
   review();
 }
 
+void
+refcache::synchronize()
+{
+  kstats::inc(&kstats::refcache_sync_count);
+  kstats::timer timer(&kstats::refcache_sync_cycles);
+
+  // Let G be the global epoch now.  Every core flushes after this
+  // point by the end of epoch G+1, which puts any object whose true
+  // count is now zero on a review queue for at most epoch G+3 (or
+  // G+5, if a review before then finds it dirty).  Cores review
+  // right after they flush, so by epoch G+6, it's been reviewed.
+  uint64_t target = global_epoch + 6;
+
+  bitset<NCPU> all;
+  for (int i = 0; i < ncpu; i++)
+    all.set(i);
+
+  // If another synchronize is running, it may well finish our epochs
+  // for us
+  auto l = sync_lock.guard();
+  while (global_epoch < target)
+    run_on_cpus(all, []() { refcache::mycache->tick(true); });
+}
+
 void
 refcache::cache::reaper()
 {
@@ -297,13 +389,16 @@ refcache::cache::reaper()
     auto reap = reapable.begin();
     auto reap_end = reapable.end();
     uint64_t nfreed = 0;
+    uint64_t latency = 0;
     while (reap != reap_end) {
       auto obj = reap++;
+      latency += rdtsc() - obj->zero_tsc_;
       obj->onzero();
       ++nfreed;
     }
 
     kstats::inc(&kstats::refcache_item_freed_count, nfreed);
+    kstats::inc(&kstats::refcache_free_latency_cycles, latency);
   }
 }
 
@@ -314,7 +409,11 @@ refcache::referenced::get_consistent()
     uint64_t count = 0;
     seqcount<uint32_t>::reader r[NCPU+1];
     for (int i = 0; i < ncpu; i++) {
-      auto way = refcache::mycache[i].hash_way(this);
+      auto set = refcache::mycache[i].hash_set(this);
+      auto way = set;
+      for (std::size_t w = 0; w < CACHE_WAYS; w++)
+        if (set[w].obj == this)
+          way = &set[w];
       r[i] = way->seq.read_begin();
       if (way->obj == this)
         count += way->delta;
@@ -373,6 +472,34 @@ test(void *)
 }
 #endif
 
+static int
+refcache_read(mdev*, char *dst, u32 off, u32 n)
+{
+  window_stream s(dst, off, n);
+  s.println("slots ", refcache::cache_sets.load() * refcache::CACHE_WAYS);
+  s.println("ways ", (int)refcache::CACHE_WAYS);
+  s.println("epoch_ticks ", refcache::epoch_ticks.load());
+  return s.get_used();
+}
+
+// Set the number of slots in each core's cache.  This must be a
+// multiple of CACHE_WAYS, up to CACHE_SLOTS.
+static int
+refcache_write(mdev*, const char *buf, u32 n)
+{
+  u64 slots = 0;
+  u32 i = 0;
+  for (; i < n && buf[i] >= '0' && buf[i] <= '9'; i++)
+    slots = slots * 10 + (buf[i] - '0');
+  if (i == 0 || (i < n && buf[i] != '\n'))
+    return -1;
+  if (slots == 0 || slots > refcache::CACHE_SLOTS ||
+      slots % refcache::CACHE_WAYS)
+    return -1;
+  refcache::cache_sets.store(slots / refcache::CACHE_WAYS);
+  return n;
+}
+
 static void
 refcache_reaper(void*)
 {
@@ -386,11 +513,16 @@ initrefcache(void)
   // We use referenced::review_epoch_ == 0 to indicate that there is
   // no reviewer, so start the global epoch count at 1.
   refcache::global_epoch = 1;
-  refcache::global_epoch_left = ncpu;
+  refcache::epoch_ticks = 1;
+
+  refcache::tree.init(REFCACHE_EPOCH_FANOUT);
 
   for (int i = 0; i < NCPU; i++)
     threadpin(refcache_reaper, nullptr, "refcache reaper", i);
 
+  devsw[MAJ_REFCACHE].write = refcache_write;
+  devsw[MAJ_REFCACHE].pread = refcache_read;
+
 #ifdef TEST
   threadpin(test, nullptr, "refcache test", 0);
 #endif
@@ -0,0 +1,254 @@
+#include "types.h"
+#include "kernel.hh"
+#include "amd64.h"
+#include "oplog.hh"
+#include "rmap.hh"
+#include "vm.hh"
+#include "kstats.hh"
+
+enum {
+  // Operations a per-CPU log holds before the page's logs are applied
+  NLOG = 4,
+  // Per-CPU logs.  Each holds the operations of one page.
+  NSLOTS = 256,
+  // Mappings a page_rmap holds before it spills to the heap
+  NINLINE = 2,
+};
+
+// A map (delta 1) or unmap (delta -1) of a page by vm at va, or the
+// sum of several.
+struct rmap_op
+{
+  vmap *vm;
+  uptr va;
+  s64 delta;
+};
+
+// The number of rmap_get calls in progress.  See rmap_remove_final.
+static std::atomic<u64> nreaders;
+
+class rmap_logger
+{
+public:
+  rmap_op ops[NLOG];
+  u32 n;
+
+  constexpr rmap_logger() : ops{}, n(0) { }
+
+  // Log delta for vm at va, combining it with an earlier operation on
+  // the same mapping.  Returns false if the log is full.
+  bool push(vmap *vm, uptr va, s64 delta)
+  {
+    for (u32 i = 0; i < n; i++) {
+      if (ops[i].vm != vm || ops[i].va != va)
+        continue;
+      ops[i].delta += delta;
+      if (ops[i].delta == 0)
+        ops[i] = ops[--n];
+      return true;
+    }
+    if (n == NLOG)
+      return false;
+    ops[n++] = rmap_op{vm, va, delta};
+    return true;
+  }
+};
+
+class page_rmap : public oplog::logged_object<rmap_logger, NSLOTS>
+{
+public:
+  page_rmap() : map_(inline_), n_(0), cap_(NINLINE), lost_(false) { }
+
+  ~page_rmap()
+  {
+    // Flush and untag this object's cached loggers, so no CPU's log
+    // cache points at it once it's gone
+    synchronize();
+    if (map_ != inline_)
+      kmfree(map_, cap_ * sizeof(*map_));
+  }
+
+  NEW_DELETE_OPS(page_rmap);
+
+  void log(vmap *vm, uptr va, s64 delta)
+  {
+    kstats::inc(&kstats::rmap_log_count);
+    for (;;) {
+      {
+        auto l = get_logger();
+        if (l->push(vm, va, delta))
+          return;
+      }
+      // Our log is full.  Apply it and try again.
+      sync();
+    }
+  }
+
+  lock_guard<spinlock> sync()
+  {
+    kstats::inc(&kstats::rmap_sync_count);
+    kstats::timer timer(&kstats::rmap_sync_cycles);
+    return synchronize();
+  }
+
+  size_t get(rmap_entry *out, size_t max, size_t *nstored)
+  {
+    auto l = sync();
+    size_t total = 0;
+    for (u32 i = 0; i < n_; i++) {
+      // Once synchronized, every count is positive.  Skip vmaps being
+      // destroyed.  Don't take references past max: dropping one here
+      // could destroy the vmap, which waits for the sync lock (see
+      // rmap_remove_final).
+      if (total < max) {
+        if (!map_[i].vm->tryinc())
+          continue;
+        out[total].vm = sref<vmap>::transfer(map_[i].vm);
+        out[total].va = map_[i].va;
+      }
+      total++;
+    }
+    *nstored = total < max ? total : max;
+    // Never let a caller conclude that a page with a forgotten mapping
+    // is unmapped
+    if (lost_)
+      total++;
+    return total;
+  }
+
+private:
+  struct mapping
+  {
+    vmap *vm;
+    uptr va;
+    s64 count;
+  };
+
+  mapping inline_[NINLINE];
+  mapping *map_;
+  u32 n_, cap_;
+  // Set if a mapping could not be recorded for lack of memory
+  bool lost_;
+
+  void apply(const rmap_op &op)
+  {
+    for (u32 i = 0; i < n_; i++) {
+      if (map_[i].vm != op.vm || map_[i].va != op.va)
+        continue;
+      map_[i].count += op.delta;
+      if (map_[i].count == 0)
+        map_[i] = map_[--n_];
+      return;
+    }
+    if (n_ == cap_) {
+      mapping *nmap = (mapping*)kmalloc(2 * cap_ * sizeof(*nmap), "rmap");
+      if (!nmap) {
+        lost_ = true;
+        return;
+      }
+      memmove(nmap, map_, n_ * sizeof(*nmap));
+      if (map_ != inline_)
+        kmfree(map_, cap_ * sizeof(*map_));
+      map_ = nmap;
+      cap_ *= 2;
+    }
+    map_[n_++] = mapping{op.vm, op.va, op.delta};
+  }
+
+  void flush_logger(rmap_logger *l) override
+  {
+    kstats::inc(&kstats::rmap_apply_count, (u64)l->n);
+    for (u32 i = 0; i < l->n; i++)
+      apply(l->ops[i]);
+    l->n = 0;
+  }
+
+  void flush_finish() override { }
+};
+
+// Return pi's reverse map, allocating it if needed.
+static page_rmap *
+get_rmap(page_info *pi)
+{
+  page_rmap *r = pi->rmap.load(std::memory_order_acquire);
+  if (r)
+    return r;
+  r = new page_rmap();
+  page_rmap *expected = nullptr;
+  if (!pi->rmap.compare_exchange_strong(expected, r)) {
+    delete r;
+    r = expected;
+  }
+  return r;
+}
+
+void
+rmap_add(page_info *pi, vmap *vm, uptr va)
+{
+  get_rmap(pi)->log(vm, va, 1);
+}
+
+void
+rmap_remove(page_info *pi, vmap *vm, uptr va)
+{
+  // Every mapping was added, which allocated the rmap
+  page_rmap *r = pi->rmap.load(std::memory_order_acquire);
+  assert(r);
+  r->log(vm, va, -1);
+}
+
+void
+rmap_remove_final(page_info *pi, vmap *vm, uptr va)
+{
+  page_rmap *r = pi->rmap.load(std::memory_order_acquire);
+  assert(r);
+  r->log(vm, va, -1);
+  // An rmap_get that started before the log above may have found vm,
+  // and holds the sync lock until it's done with it.  Any later one
+  // applies the log first and doesn't see vm.  Usually there are no
+  // readers, and vmap teardown needn't touch the shared state.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (nreaders.load())
+    r->sync();
+}
+
+size_t
+rmap_get(page_info *pi, rmap_entry *out, size_t max, size_t *nstored)
+{
+  size_t stored;
+  if (!nstored)
+    nstored = &stored;
+  page_rmap *r = pi->rmap.load(std::memory_order_acquire);
+  if (!r) {
+    *nstored = 0;
+    return 0;
+  }
+  nreaders++;
+  size_t total = r->get(out, max, nstored);
+  nreaders--;
+  return total;
+}
+
+size_t
+rmap_unmap(page_info *pi)
+{
+  enum { BATCH = 8 };
+
+  for (;;) {
+    rmap_entry ents[BATCH];
+    size_t n;
+    size_t total = rmap_get(pi, ents, BATCH, &n);
+    size_t dropped = 0;
+    for (size_t i = 0; i < n; i++)
+      if (ents[i].vm->drop_page(ents[i].va, pi))
+        dropped++;
+    if (!dropped || dropped == total)
+      return total - dropped;
+  }
+}
+
+void
+rmap_free(page_rmap *r)
+{
+  delete r;
+}
@@ -15,24 +15,17 @@
 #include "percpu.hh"
 #include "kstream.hh"
 #include "cpuid.hh"
+#include "kstats.hh"
+#include "log2.hh"
 
 #include <algorithm>
+#include <atomic>
 
-#define LOGHEADER_SZ (sizeof(struct logheader) + \
-                      sizeof(((struct logheader*)0)->cpu[0])*NCPU)
-
-// Maximum bytes in a log segment
-#define LOG_SEGMENT_MAX (1024*1024)
-// The total number of log segments
-#define LOG_SEGMENTS (PERFSIZE / LOG_SEGMENT_MAX)
-// The number of log segments per CPU
-#define LOG_SEGMENTS_PER_CPU (LOG_SEGMENTS < NCPU ? 1 : LOG_SEGMENTS / NCPU)
-// The number of pmuevents in a log segment
-#define LOG_SEGMENT_COUNT (LOG_SEGMENT_MAX / sizeof(struct pmuevent))
-// The byte size of a log segment
-#define LOG_SEGMENT_SZ (LOG_SEGMENT_COUNT * sizeof(struct pmuevent))
-
-#define LOG2_HASH_BUCKETS 12
+// Maximum bytes in a CPU's sample ring
+#define LOG_RING_MAX (1024*1024)
+// Bytes in each CPU's sample ring.  This is a power of two.
+#define LOG_RING_SZ (PERFSIZE / NCPU >= LOG_RING_MAX ? LOG_RING_MAX : \
+                     round_down_to_pow2_const(PERFSIZE / NCPU))
 
 #define MAX_PMCS 2
 
@@ -67,26 +60,37 @@ public:
   // Enable all enabled counters
   virtual void resume() = 0;
   virtual void dump() { }
+  // Called from every timer interrupt
+  virtual void tick(struct trapframe *tf) { }
 };
 
 class pmu *pmu;
 
+// A CPU's sample ring.  The CPU's own sampling interrupts are the
+// only producer and never wait for readers: a sample that doesn't fit
+// is dropped and counted.  Readers of /dev/sampler consume whole
+// samples from the tail under readlock, so user space can drain the
+// ring while collection continues.  head and tail are byte counts
+// that only grow.
 struct pmulog {
-  u64 count;
-  struct pmuevent *segments[LOG_SEGMENTS_PER_CPU];
-  struct pmuevent *hash;
+  char *ring;
+  std::atomic<u64> head;
+  std::atomic<u64> tail;
 
 private:
-  bool dirty;
-  bool evict(struct pmuevent *event, size_t reserve);
+  void put(u64 pos, const void *src, size_t n);
+  void get(u64 pos, void *dst, size_t n) const;
 
 public:
-  bool log(const struct pmuevent &ev);
-  void flush();
+  bool log(struct pmuevent *ev, const uptr *trace);
+  size_t read(char *dst, size_t n);
 } __mpalign__;
 
 DEFINE_PERCPU(struct pmulog, pmulog);
 
+// Serializes readers of the sample rings.
+static spinlock readlock("sampler");
+
 //
 // AMD PMU
 //
@@ -436,7 +440,7 @@ private:
         ev.data_source = record->data_source;
         ev.load_address = record->data_linear_address;
       }
-      pmulog->log(ev);
+      pmulog->log(&ev, nullptr);
       pos += pebs_record_size;
     }
 
@@ -446,20 +450,38 @@ private:
 };
 
 //
-// No PMU
+// Timer interrupt "PMU"
 //
 
-class no_pmu : public pmu
+// Used when there is no usable PMU, such as under QEMU TCG.  Each
+// CPU's timer interrupt counts down the enabled selectors, which
+// "overflow" every period nanoseconds, rounded up to whole ticks.
+class timer_pmu : public pmu
 {
+  struct local
+  {
+    u64 interval[MAX_PMCS];
+    u64 left[MAX_PMCS];
+  };
+
+  percpu<struct local> local;
+
+public:
   bool
   try_init() override
   {
+    console.println("sampler: No PMU, sampling timer interrupts");
     return true;
   }
 
-  void 
+  void
   configure(int ctr, const perf_selector &selector) override
   {
+    const u64 tick = QUANTUM * 1000000ull;
+    u64 ticks = 0;
+    if (selector.enable && selector.period)
+      ticks = std::max((selector.period + tick - 1) / tick, (u64)1);
+    local->interval[ctr] = local->left[ctr] = ticks;
   }
 
   uint64_t
@@ -482,92 +504,83 @@ class no_pmu : public pmu
   resume() override
   {
   }
+
+  void
+  tick(struct trapframe *tf) override
+  {
+    for (int i = 0; i < MAX_PMCS; ++i) {
+      if (local->interval[i] && --local->left[i] == 0) {
+        local->left[i] = local->interval[i];
+        selectors[i].on_overflow(i, tf);
+      }
+    }
+  }
 };
 
 //
 // Event log
 //
 
-static uintptr_t
-samphash(const struct pmuevent *ev)
+void
+pmulog::put(u64 pos, const void *src, size_t n)
 {
-  struct pmuevent ev2 = *ev;
-  ev2.count = 0;
-  uintptr_t h = 0;
-  for (uintptr_t *word = (uintptr_t*)&ev2, *end = (uintptr_t*)(&ev2 + 1);
-       word < end; ++word)
-    h ^= *word;
-  return h ^ (h >> 32);
+  size_t off = pos & (LOG_RING_SZ - 1);
+  size_t cc = std::min<size_t>(n, LOG_RING_SZ - off);
+  memmove(ring + off, src, cc);
+  memmove(ring, (const char*)src + cc, n - cc);
 }
 
-// Test if two events are the same except for their count.
-static bool
-sampequal(const struct pmuevent *a, const struct pmuevent *b)
+void
+pmulog::get(u64 pos, void *dst, size_t n) const
 {
-  struct pmuevent b2 = *b;
-  b2.count = a->count;
-  return memcmp(a, &b2, sizeof *a) == 0;
+  size_t off = pos & (LOG_RING_SZ - 1);
+  size_t cc = std::min<size_t>(n, LOG_RING_SZ - off);
+  memmove(dst, ring + off, cc);
+  memmove((char*)dst + cc, ring, n - cc);
 }
 
-// Evict an event from the hash table.  Does *not* clear the hash
-// table entry.  Returns true if there is still room in the log, or
-// false if the log is full.
+// Append ev and its ev->ntrace return addresses to this CPU's ring.
+// Returns false if the ring is full.  Must be called on this log's
+// CPU with interrupts disabled.
 bool
-pmulog::evict(struct pmuevent *event, size_t reserve)
+pmulog::log(struct pmuevent *ev, const uptr *trace)
 {
-  if (count == LOG_SEGMENTS_PER_CPU * LOG_SEGMENT_COUNT - reserve)
+  size_t tsz = ev->ntrace * sizeof(uptr);
+  size_t sz = sizeof(*ev) + tsz;
+  u64 h = head.load(std::memory_order_relaxed);
+  if (h + sz - tail.load(std::memory_order_acquire) > LOG_RING_SZ) {
+    kstats::inc(&kstats::sampler_lost_count);
     return false;
-  size_t segment = count / LOG_SEGMENT_COUNT;
-  assert(segment < LOG_SEGMENTS_PER_CPU);
-  segments[segment][count % LOG_SEGMENT_COUNT] = *event;
-  count++;
-  return true;
-}
-
-// Record tf in the log.  Returns true if there is still room in the
-// log, or false if the log is full.
-bool
-pmulog::log(const struct pmuevent &ev)
-{
-  // Put event in the hash table
-  auto bucket = &hash[samphash(&ev) % (1 << LOG2_HASH_BUCKETS)];
-  if (bucket->count) {
-    // Bucket is in use.  Is it the same sample?
-    if (sampequal(&ev, bucket)) {
-      bucket->count += ev.count;
-      return true;
-    } else {
-      // Evict the sample currently in the hash table.  Reserve enough
-      // space in the log that we can flush the whole hash table when
-      // the sampler is disabled.
-      if (!evict(bucket, 1 << LOG2_HASH_BUCKETS))
-        return false;
-    }
   }
-  *bucket = ev;
-  dirty = true;
+  ev->cpu = myid();
+  put(h, ev, sizeof(*ev));
+  if (tsz)
+    put(h + sizeof(*ev), trace, tsz);
+  head.store(h + sz, std::memory_order_release);
+  kstats::inc(&kstats::sampler_sample_count);
   return true;
 }
 
-// Flush everything from the hash table in l.
-void
-pmulog::flush()
+// Consume whole samples from the ring into dst, up to n bytes.
+// Returns the number of bytes copied.  The caller must hold readlock.
+size_t
+pmulog::read(char *dst, size_t n)
 {
-  if (!dirty)
-    return;
-  size_t failed = 0;
-  for (int i = 0; i < 1<<LOG2_HASH_BUCKETS; ++i) {
-    if (hash[i].count) {
-      if (!evict(&hash[i], 0))
-        ++failed;
-      hash[i].count = 0;
-    }
-  }
-  if (failed)
-    // This shouldn't happen because we reserved enough space for a
-    // full flush while we were running.
-    swarn.println("sampler: Failed to flush ", failed, " event(s)");
-  dirty = false;
+  u64 t = tail.load(std::memory_order_relaxed);
+  u64 h = head.load(std::memory_order_acquire);
+  size_t cc = 0;
+  while (t < h) {
+    struct pmuevent ev;
+    get(t, &ev, sizeof(ev));
+    size_t sz = pmuevent_size(&ev);
+    if (cc + sz > n)
+      break;
+    get(t, dst + cc, sz);
+    t += sz;
+    cc += sz;
+  }
+  tail.store(t, std::memory_order_release);
+  return cc;
 }
 
 //
@@ -578,8 +591,6 @@ void
 sampconf(void)
 {
   pushcli();
-  if (selectors[0].period)
-    pmulog[myid()].count = 0;
   pmu->configure(0, selectors[0]);
   popcli();
 }
@@ -629,6 +640,13 @@ sampintr(struct trapframe *tf)
   return r;
 }
 
+void
+samptick(struct trapframe *tf)
+{
+  if (pmu)
+    pmu->tick(tf);
+}
+
 static void
 samplog(int pmc, struct trapframe *tf)
 {
@@ -638,96 +656,43 @@ samplog(int pmc, struct trapframe *tf)
   ev.kernel = tf->rip >= KCODE;
   ev.count = 1;
   ev.rip = tf->rip;
-  getcallerpcs((void*)tf->rbp, ev.trace, NELEM(ev.trace));
-
-  if (!pmulog->log(ev)) {
-    selectors[pmc].enable = false;
-    pmu->configure(pmc, selectors[pmc]);
-  }
-}
-
-static int
-readlog(char *dst, u32 off, u32 n)
-{
-  int ret = 0;
-  u64 cur = 0;
-
-  for (int i = 0; i < ncpu && n != 0; i++) {
-    struct pmulog *p = &pmulog[i];
-    p->flush();
-    u64 len = p->count * sizeof(struct pmuevent);
-    if (cur <= off && off < cur+len) {
-      u64 boff = off-cur;
-      u64 cc = MIN(len-boff, n);
-      while (cc) {
-        size_t segment = boff / LOG_SEGMENT_SZ;
-        size_t segoff = boff % LOG_SEGMENT_SZ;
-        char *buf = (char*)p->segments[segment];
-        size_t segcc = MIN(cc, LOG_SEGMENT_SZ - segoff);
-        memmove(dst, buf + segoff, segcc);
-        cc -= segcc;
-        n -= segcc;
-        ret += segcc;
-        off += segcc;
-        dst += segcc;
-      }
-    }
-    cur += len;
-  }
-
-  return ret;
+  ev.ntrace = selectors[pmc].trace_depth;
+  uptr trace[NTRACE_MAX];
+  getcallerpcs((void*)tf->rbp, trace, ev.ntrace);
+  while (ev.ntrace && !trace[ev.ntrace - 1])
+    --ev.ntrace;
+  pmulog->log(&ev, trace);
 }
 
 static void
 sampstat(mdev*, struct stat *st)
 {
   u64 sz = 0;
-  
-  sz += LOGHEADER_SZ;
+
   for (int i = 0; i < ncpu; ++i) {
     struct pmulog *p = &pmulog[i];
-    p->flush();
-    sz += p->count * sizeof(struct pmuevent);
+    sz += p->head.load(std::memory_order_acquire) -
+      p->tail.load(std::memory_order_relaxed);
   }
 
   st->st_size = sz;
 }
 
+// Return the samples collected since the last read, as back-to-back
+// pmuevents.  This never blocks and never stops collection; a return
+// of 0 just means there's nothing new (or n is too small to hold the
+// next sample).
 static int
-sampread(mdev*, char *dst, u32 off, u32 n)
+sampread(mdev*, char *dst, u32 n)
 {
-  struct logheader *hdr;
-  int ret;
-  int i;
-  
-  ret = 0;
-  if (off < LOGHEADER_SZ) {
-    u64 len = LOGHEADER_SZ;
-    u64 cc;
-    
-    hdr = (logheader*) kmalloc(len, "logheader");
-    if (hdr == nullptr)
-      return -1;
-    hdr->ncpus = NCPU;
-    for (i = 0; i < NCPU; ++i) {
-      u64 sz = i < ncpu ? pmulog[i].count * sizeof(struct pmuevent) : 0;
-      hdr->cpu[i].offset = len;
-      hdr->cpu[i].size = sz;
-      len += sz;
-    }
-
-    cc = MIN(LOGHEADER_SZ-off, n);
-    memmove(dst, (char*)hdr + off, cc);
-    kmfree(hdr, LOGHEADER_SZ);
-
-    n -= cc;
-    ret += cc;
-    off += cc;
-    dst += cc;
-  }
+  // Rotate the starting CPU so one busy CPU can't starve the others.
+  static int next;
+  auto l = readlock.guard();
+  int ret = 0;
 
-  if (off >= LOGHEADER_SZ)
-    ret += readlog(dst, off-LOGHEADER_SZ, n);
+  for (int i = 0; i < ncpu; i++)
+    ret += pmulog[(next + i) % ncpu].read(dst + ret, n - ret);
+  next = (next + 1) % ncpu;
   return ret;
 }
 
@@ -737,6 +702,8 @@ sampwrite(mdev*, const char *buf, u32 n)
   if (n != sizeof(perf_selector))
     return -1;
   auto ps = (struct perf_selector*)buf;
+  if (ps->trace_depth > NTRACE_MAX)
+    return -1;
   if (ps->enable && selectors[0].enable) {
     // We disallow this to avoid races with reconfiguring counters
     // during sampler interrupts.  We could first disable and quiesce
@@ -745,7 +712,16 @@ sampwrite(mdev*, const char *buf, u32 n)
     console.println("sampler: Cannot re-enable enabled counter");
     return -1;
   }
+  if (ps->enable) {
+    // Start from empty rings
+    auto l = readlock.guard();
+    for (int i = 0; i < ncpu; ++i)
+      pmulog[i].tail.store(pmulog[i].head.load(std::memory_order_acquire),
+                           std::memory_order_release);
+  }
   *static_cast<perf_selector*>(&selectors[0]) = *ps;
+  if (!selectors[0].trace_depth)
+    selectors[0].trace_depth = NTRACE;
   selectors[0].on_overflow = samplog;
   sampstart();
   return n;
@@ -795,7 +771,7 @@ initsamp(void)
 {
   static class amd_pmu amd_pmu;
   static class intel_pmu intel_pmu;
-  static class no_pmu no_pmu;
+  static class timer_pmu timer_pmu;
 
   if (myid() == 0) {
     if (cpuid::vendor_is_amd() && amd_pmu.try_init())
@@ -803,35 +779,28 @@ initsamp(void)
     else if (cpuid::vendor_is_intel() && intel_pmu.try_init())
       pmu = &intel_pmu;
     else {
-      cprintf("initsamp: Unknown manufacturer\n");
-      pmu = &no_pmu;
-      return;
+      timer_pmu.try_init();
+      pmu = &timer_pmu;
     }
   }
 
-  if (pmu == &no_pmu)
-    return;
-
-  // enable RDPMC at CPL > 0
-  u64 cr4 = rcr4();
-  lcr4(cr4 | CR4_PCE);
-
-  for (int i = 0; i < LOG_SEGMENTS_PER_CPU; ++i) {
-    auto l = &pmulog[myid()];
-    l->segments[i] = (pmuevent*)kmalloc(LOG_SEGMENT_SZ, "perf");
-    if (!l->segments[i])
-      panic("initsamp: kalloc");
-    l->hash = (pmuevent*)kmalloc((1<<LOG2_HASH_BUCKETS) * sizeof(pmuevent),
-                                 "perfhash");
-    if (!l->hash)
-      panic("initsamp: kalloc hash");
-    memset(l->hash, 0, (1<<LOG2_HASH_BUCKETS) * sizeof(pmuevent));
+  if (pmu != &timer_pmu) {
+    // enable RDPMC at CPL > 0
+    u64 cr4 = rcr4();
+    lcr4(cr4 | CR4_PCE);
   }
 
+  auto l = &pmulog[myid()];
+  l->ring = (char*)kmalloc(LOG_RING_SZ, "perf");
+  if (!l->ring)
+    panic("initsamp: kalloc");
+  l->head.store(0);
+  l->tail.store(0);
+
   pmu->initcore();
 
   devsw[MAJ_SAMPLER].write = sampwrite;
-  devsw[MAJ_SAMPLER].pread = sampread;
+  devsw[MAJ_SAMPLER].read = sampread;
   devsw[MAJ_SAMPLER].stat = sampstat;
 }
 
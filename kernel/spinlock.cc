@@ -6,6 +6,7 @@
 #include "cpu.hh"
 #include "bits.hh"
 #include "spinlock.hh"
+#include "lockprof.hh"
 #include "mtrace.h"
 #include "condvar.hh"
 #include "fs.h"
@@ -379,6 +380,8 @@ spinlock::try_acquire()
       return false;
   }
   ::locked(this, 0);
+  if (lockprof_enabled.load(std::memory_order_relaxed))
+    lockprof_acquired(this, 0, false, __builtin_return_address(0));
   return true;
 }
 
@@ -390,9 +393,13 @@ void
 spinlock::acquire()
 {
   u64 retries;
+  u64 start = 0;
+  bool prof = lockprof_enabled.load(std::memory_order_relaxed);
 
   pushcli();
   locking(this);
+  if (prof)
+    start = rdtsc();
 
   retries = 0;
   while (locked.exchange(1, std::memory_order_acquire) != 0) {
@@ -400,6 +407,8 @@ spinlock::acquire()
     nop_pause();
   }
   ::locked(this, retries);
+  if (prof)
+    lockprof_acquired(this, start, retries > 0, __builtin_return_address(0));
 }
 
 // Release the lock.
@@ -407,6 +416,8 @@ void
 spinlock::release()
 {
   releasing(this);
+  if (lockprof_enabled.load(std::memory_order_relaxed))
+    lockprof_releasing(this);
 
   locked.store(0, std::memory_order_release);
 
@@ -8,15 +8,31 @@
 #include "cpu.hh"
 #include "kmtrace.hh"
 #include "errno.h"
+#include "syscallstats.hh"
+#include "cpuid.hh"
+#include "refcache.hh"
 
 extern "C" int __uaccess_mem(void* dst, const void* src, u64 size);
-extern "C" int __uaccess_str(char* dst, const char* src, u64 size);
+extern "C" int __uaccess_mem8(void* dst, const void* src, u64 size);
+extern "C" char* __uaccess_str(char* dst, const char* src, u64 size);
 extern "C" uptr __uaccess_strend(uptr src, u64 limit);
 extern "C" int __uaccess_int64(uptr addr, u64* ip);
 
 // XXX(austin) Many of these functions should take userptr<void>
 // instead of regular pointers
 
+// Copies at least this big use rep movsb, if the CPU has ERMS
+enum { UACCESS_ERMS_THRESHOLD = 512 };
+
+// Copy to or from user space, picking the copy loop by size and CPU.
+static int
+uaccess_copy(void *dst, const void *src, u64 size)
+{
+  if (size >= UACCESS_ERMS_THRESHOLD && cpuid::features().erms)
+    return __uaccess_mem(dst, src, size);
+  return __uaccess_mem8(dst, src, size);
+}
+
 int
 fetchmem(void* dst, const void* usrc, u64 size)
 {
@@ -27,7 +43,7 @@ fetchmem(void* dst, const void* usrc, u64 size)
   // __uaccess_mem can't handle size == 0
   if(size == 0)
     return 0;
-  return __uaccess_mem(dst, usrc, size);
+  return uaccess_copy(dst, usrc, size);
 }
 
 int
@@ -39,9 +55,11 @@ putmem(void *udst, const void *src, u64 size)
     return -1;
   if(size == 0)
     return 0;
-  return __uaccess_mem(udst, src, size);
+  return uaccess_copy(udst, src, size);
 }
 
+// Copy a NUL-terminated string of at most size bytes, including the
+// NUL, from user space.  Returns its length, or -1.
 int
 fetchstr(char* dst, const char* usrc, u64 size)
 {
@@ -52,7 +70,10 @@ fetchstr(char* dst, const char* usrc, u64 size)
   // non-canonical addresses, resulting in a GPF.
   if ((uintptr_t)usrc >= USERTOP)
     return -1;
-  return __uaccess_str(dst, usrc, size);
+  char *nul = __uaccess_str(dst, usrc, size);
+  if (nul == (char*)-1)
+    return -1;
+  return nul - dst;
 }
 
 int
@@ -110,6 +131,10 @@ syscall(u64 a0, u64 a1, u64 a2, u64 a3, u64 a4, u64 a5, u64 num)
 #endif
       if(num < nsyscalls && syscalls[num]) {
         u64 r;
+        u64 start = 0;
+        if (SYSCALL_STATS &&
+            syscallstats_enabled.load(std::memory_order_relaxed))
+          start = rdtsc();
         mtstart(syscalls[num], myproc());
         mtrec();
         {
@@ -118,6 +143,8 @@ syscall(u64 a0, u64 a1, u64 a2, u64 a3, u64 a4, u64 a5, u64 num)
         }
         mtstop(myproc());
         mtign();
+        if (start)
+          syscallstats_record(num, start, r);
         return r;
       } else {
         cprintf("%d %s: unknown sys call %ld\n",
@@ -128,6 +155,7 @@ syscall(u64 a0, u64 a1, u64 a2, u64 a3, u64 a4, u64 a5, u64 num)
     } catch (std::bad_alloc& e) {
       cprintf("%d: syscall retry\n", myproc()->pid);
       gc_wakeup();
+      refcache::synchronize();
       yield();
     } catch (kill_exception &e) {
       return -1;
@@ -0,0 +1,171 @@
+// Per-syscall counters and latency histograms.
+//
+// Each CPU counts the system calls dispatched on it in its own
+// cache-line-aligned array, indexed by syscall number, so recording a
+// call writes only CPU-local memory.  The only shared state on the
+// syscall path is syscallstats_enabled, which is read-mostly.  Like
+// kstats, updates don't disable preemption, so a call preempted in
+// the middle of recording can rarely lose an update.
+//
+// Readers sum the per-CPU arrays without synchronizing with writers,
+// so numbers read while recording is on are approximate.
+
+#include "types.h"
+#include "kernel.hh"
+#include "amd64.h"
+#include "spinlock.hh"
+#include "syscallstats.hh"
+#include "percpu.hh"
+#include "fs.h"
+#include "file.hh"
+#include "major.h"
+#include "uk/syscallstats.h"
+
+extern const char* syscall_names[];
+extern const int nsyscalls;
+
+std::atomic<bool> syscallstats_enabled;
+
+// Bumped by clear.  A CPU that sees it change zeroes its array before
+// recording again, and readers skip CPUs that haven't yet.
+static std::atomic<u64> clear_gen;
+
+struct sysstat {
+  u64 count;
+  u64 errors;
+  u64 cycles;
+  u64 hist[SYSCALLSTATS_BUCKETS];
+};
+
+struct syscallstats_cpu {
+  u64 clear_gen;
+  struct sysstat *stats;        // nsyscalls entries
+};
+
+DEFINE_PERCPU(struct syscallstats_cpu, syscallstats_cpu, NO_CRITICAL);
+
+static u64
+stats_size(void)
+{
+  u64 sz = nsyscalls * sizeof(struct sysstat);
+  return (sz + CACHELINE - 1) & ~(u64)(CACHELINE - 1);
+}
+
+static int
+bucket(u64 cycles)
+{
+  if (cycles == 0)
+    return 0;
+  int b = 63 - __builtin_clzll(cycles);
+  return b < SYSCALLSTATS_BUCKETS ? b : SYSCALLSTATS_BUCKETS - 1;
+}
+
+void
+syscallstats_record(u64 num, u64 start, u64 r)
+{
+  u64 cycles = rdtsc() - start;
+  struct syscallstats_cpu *c = syscallstats_cpu.get();
+  if (!c->stats)
+    return;
+  u64 cg = clear_gen.load(std::memory_order_acquire);
+  if (c->clear_gen != cg) {
+    memset(c->stats, 0, stats_size());
+    c->clear_gen = cg;
+  }
+
+  struct sysstat *s = &c->stats[num];
+  s->count++;
+  if ((s64)r < 0)
+    s->errors++;
+  s->cycles += cycles;
+  s->hist[bucket(cycles)]++;
+}
+
+// Return one record per syscall with at least one call, in syscall
+// number order.
+static int
+syscallstats_read(mdev*, char *dst, u32 off, u32 n)
+{
+  static const u64 sz = sizeof(struct syscallstats_rec);
+
+  if (off % sz || n < sz)
+    return -1;
+
+  u64 skip = off / sz;
+  u64 cg = clear_gen.load(std::memory_order_acquire);
+  int ret = 0;
+  for (int num = 0; num < nsyscalls; num++) {
+    struct syscallstats_rec rec{};
+    for (int i = 0; i < ncpu; i++) {
+      struct syscallstats_cpu *c = &syscallstats_cpu[i];
+      if (!c->stats || c->clear_gen != cg)
+        continue;
+      struct sysstat *s = &c->stats[num];
+      rec.count += s->count;
+      rec.errors += s->errors;
+      rec.cycles += s->cycles;
+      for (int b = 0; b < SYSCALLSTATS_BUCKETS; b++)
+        rec.hist[b] += s->hist[b];
+    }
+    if (!rec.count)
+      continue;
+    if (skip) {
+      skip--;
+      continue;
+    }
+    if (n - ret < sz)
+      return ret;
+
+    const char *name = syscall_names[num];
+    if (strncmp(name, "sys_", 4) == 0)
+      name += 4;
+    strncpy(rec.name, name, sizeof(rec.name) - 1);
+    rec.num = num;
+    memmove(dst + ret, &rec, sz);
+    ret += sz;
+  }
+  return ret;
+}
+
+// Accepts "start", "stop", and "clear", with or without a trailing
+// newline.
+static int
+syscallstats_write(mdev*, const char *buf, u32 n)
+{
+  u32 len = n;
+  if (len && buf[len - 1] == '\n')
+    len--;
+  auto is = [&](const char *cmd) {
+    return strlen(cmd) == len && memcmp(buf, cmd, len) == 0;
+  };
+
+  if (is("start")) {
+    syscallstats_enabled.store(true, std::memory_order_release);
+  } else if (is("stop")) {
+    syscallstats_enabled.store(false, std::memory_order_release);
+  } else if (is("clear")) {
+    clear_gen++;
+  } else {
+    return -1;
+  }
+  return n;
+}
+
+void
+initsyscallstats(void)
+{
+  if (!SYSCALL_STATS)
+    return;
+
+  for (int i = 0; i < ncpu; i++) {
+    void *p;
+    if (kmalign(&p, CACHELINE, stats_size(), "syscallstats") != 0)
+      panic("initsyscallstats: out of memory");
+    memset(p, 0, stats_size());
+    syscallstats_cpu[i].stats = (struct sysstat*)p;
+  }
+
+  devsw[MAJ_SYSCALLSTATS].write = syscallstats_write;
+  devsw[MAJ_SYSCALLSTATS].pread = syscallstats_read;
+  syscallstats_enabled = true;
+}
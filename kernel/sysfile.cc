@@ -6,6 +6,7 @@
 #include "proc.hh"
 #include "fs.h"
 #include "file.hh"
+#include "pollqueue.hh"
 #include "cpu.hh"
 #include "net.hh"
 #include "kmtrace.hh"
@@ -15,6 +16,7 @@
 #include <uk/stat.h>
 #include "kstats.hh"
 #include <vector>
+#include <algorithm>
 #include "kstream.hh"
 #include <uk/spawn.h>
 #include "filetable.hh"
@@ -444,6 +446,31 @@ create(sref<mnode> cwd, const char *path, short type, short major, short minor,
   }
 }
 
+// Open path relative to cwd.  Returns a null sref on failure.
+static sref<file>
+openfile(sref<mnode> cwd, const char *path, int omode)
+{
+  sref<mnode> m;
+  if (omode & O_CREAT)
+    m = create(cwd, path, T_FILE, 0, 0, omode & O_EXCL);
+  else
+    m = namei(cwd, path);
+
+  if (!m)
+    return sref<file>();
+
+  int rwmode = omode & (O_RDONLY|O_WRONLY|O_RDWR);
+  if (m->type() == mnode::types::dir && (rwmode != O_RDONLY))
+    return sref<file>();
+
+  if (m->type() == mnode::types::file && (omode & O_TRUNC))
+    if (*m->as_file()->read_size())
+      m->as_file()->write_size().resize_nogrow(0);
+
+  return make_sref<file_inode>(
+    m, !(rwmode == O_WRONLY), !(rwmode == O_RDONLY), !!(omode & O_APPEND));
+}
+
 //SYSCALL
 int
 sys_openat(int dirfd, userptr_str path, int omode, ...)
@@ -466,26 +493,7 @@ sys_openat(int dirfd, userptr_str path, int omode, ...)
   if (!path.load(path_copy, sizeof(path_copy)))
     return -1;
 
-  sref<mnode> m;
-  if (omode & O_CREAT)
-    m = create(cwd, path_copy, T_FILE, 0, 0, omode & O_EXCL);
-  else
-    m = namei(cwd, path_copy);
-
-  if (!m)
-    return -1;
-
-  int rwmode = omode & (O_RDONLY|O_WRONLY|O_RDWR);
-  if (m->type() == mnode::types::dir && (rwmode != O_RDONLY))
-    return -1;
-
-  if (m->type() == mnode::types::file && (omode & O_TRUNC))
-    if (*m->as_file()->read_size())
-      m->as_file()->write_size().resize_nogrow(0);
-
-  sref<file> f = make_sref<file_inode>(
-    m, !(rwmode == O_WRONLY), !(rwmode == O_RDONLY), !!(omode & O_APPEND));
-  return fdalloc(std::move(f), omode);
+  return fdalloc(openfile(cwd, path_copy, omode), omode);
 }
 
 //SYSCALL
@@ -547,27 +555,43 @@ sys_chdir(userptr_str path)
 }
 
 // Load NULL-terminated char** list, such as the argv argument to
-// exec.
+// exec.  The strings are packed into *buf, and *out gets pointers to
+// them, followed by nullptr.
 static int
 load_str_list(userptr<userptr_str> list, size_t listmax, size_t strmax,
-              std::vector<std::unique_ptr<char[]> > *out)
+              std::unique_ptr<char[]> *buf, std::vector<char*> *out)
 {
-  std::vector<std::unique_ptr<char[]> > argv;
-  for (int i = 0; ; ++i) {
+  enum { BATCH = 16 };
+
+  std::unique_ptr<char[]> strs(new char[listmax * strmax]);
+  std::vector<char*> argv;
+  char *pos = strs.get();
+  userptr_str batch[BATCH];
+  for (size_t i = 0; ; ) {
     if (i == listmax)
       return -1;
-    userptr_str uarg;
-    if (!(list + (ptrdiff_t)i).load(&uarg))
-      return -1;
-    if (!uarg)
-      break;
-    auto arg = uarg.load_alloc(strmax);
-    if (!arg)
+    // Fetch a batch of pointers, but not past the end of the page,
+    // which may be unmapped if the list ends first
+    auto uarg = list + (ptrdiff_t)i;
+    size_t n = (PGSIZE - (uptr)uarg % PGSIZE) / sizeof(userptr_str);
+    n = std::max(n, (size_t)1);
+    n = std::min(n, std::min((size_t)BATCH, listmax - i));
+    if (!uarg.load(batch, n))
       return -1;
-    argv.push_back(std::move(arg));
+    for (size_t j = 0; j < n; j++, i++) {
+      if (!batch[j]) {
+        argv.push_back(nullptr);
+        *buf = std::move(strs);
+        *out = std::move(argv);
+        return 0;
+      }
+      int len = batch[j].load_len(pos, strmax);
+      if (len < 0)
+        return -1;
+      argv.push_back(pos);
+      pos += len + 1;
+    }
   }
-  *out = std::move(argv);
-  return 0;
 }
 
 int
@@ -577,14 +601,10 @@ doexec(userptr_str upath, userptr<userptr_str> uargv)
   if (!(path = upath.load_alloc(DIRSIZ+1)))
     return -1;
 
-  std::vector<std::unique_ptr<char[]> > xargv;
-  if (load_str_list(uargv, MAXARG, MAXARGLEN, &xargv) < 0)
-    return -1;
-
+  std::unique_ptr<char[]> argbuf;
   std::vector<char*> argv;
-  for (auto &p : xargv)
-    argv.push_back(p.get());
-  argv.push_back(nullptr);
+  if (load_str_list(uargv, MAXARG, MAXARGLEN, &argbuf, &argv) < 0)
+    return -1;
 
   return exec(path.get(), argv.data());
 }
@@ -623,6 +643,65 @@ sys_pipe(userptr<int> fd)
   return sys_pipe2(fd, 0);
 }
 
+// timeout is in milliseconds; -1 waits forever and 0 doesn't wait.
+//SYSCALL
+int
+sys_poll(userptr<struct pollfd> ufds, unsigned int nfds, int timeout)
+{
+  if (nfds > NOFILE)
+    return -1;
+  std::unique_ptr<struct pollfd[]> fds;
+  if (nfds) {
+    fds = ufds.load_alloc(nfds);
+    if (!fds)
+      return -1;
+  }
+
+  std::unique_ptr<sref<file>[]> files(new sref<file>[nfds]);
+  for (unsigned int i = 0; i < nfds; i++)
+    if (fds[i].fd >= 0)
+      files[i] = getfile(fds[i].fd);
+
+  // Wait on every file whose readiness can change.  The entries
+  // unregister themselves when they're destroyed, before the files
+  // and poller go.
+  poller p;
+  std::unique_ptr<pollentry[]> entries;
+  if (timeout != 0) {
+    entries.reset(new pollentry[nfds]);
+    for (unsigned int i = 0; i < nfds; i++)
+      if (files[i])
+        if (pollqueue *q = files[i]->get_pollqueue())
+          q->add(&entries[i], &p);
+  }
+
+  u64 deadline = timeout < 0 ? ~0ull : nsectime() + (u64)timeout * 1000000;
+  for (;;) {
+    p.arm();
+    int nready = 0;
+    for (unsigned int i = 0; i < nfds; i++) {
+      if (fds[i].fd < 0)
+        fds[i].revents = 0;
+      else if (!files[i])
+        fds[i].revents = POLLNVAL;
+      else
+        fds[i].revents = files[i]->poll(fds[i].events);
+      if (fds[i].revents)
+        nready++;
+    }
+
+    if (nready || nsectime() >= deadline) {
+      if (nfds && !ufds.store(fds.get(), nfds))
+        return -1;
+      return nready;
+    }
+    if (myproc()->killed)
+      return -1;
+
+    p.sleep_to(deadline);
+  }
+}
+
 //SYSCALL
 int
 sys_readdir(int dirfd, const userptr<char> prevptr, userptr<char> nameptr)
@@ -653,6 +732,67 @@ sys_readdir(int dirfd, const userptr<char> prevptr, userptr<char> nameptr)
   return 1;
 }
 
+// Fill ents with up to nents entries of directory dirfd, starting
+// after the name in cookie, or at the beginning if cookie is the
+// empty string.  On return, cookie holds the last name returned, so
+// the next call picks up where this one left off.  Returns the number
+// of entries, 0 at the end of the directory, or -1 on error.
+//SYSCALL
+int
+sys_getdents(int dirfd, userptr<char> cookieptr, userptr<struct kdirent> ents,
+             size_t nents)
+{
+  sref<file> df = getfile(dirfd);
+  if (!df)
+    return -1;
+
+  file* dff = df.get();
+  if (&typeid(*dff) != &typeid(file_inode))
+    return -1;
+
+  file_inode* dfi = static_cast<file_inode*>(dff);
+  if (dfi->ip->type() != mnode::types::dir)
+    return -1;
+  mdir* md = dfi->ip->as_dir();
+
+  strbuf<DIRSIZ> cookie;
+  if (!cookieptr.load(cookie.buf_, sizeof(cookie.buf_)))
+    return -1;
+  bool start = !cookie.buf_[0];
+
+  // Collect entries in batches so that we never touch user memory
+  // from inside the directory's RCU read section.  Each batch resumes
+  // from the previous batch's last name in O(1).
+  kdirent batch[16];
+  size_t n = 0;
+  while (n < nents) {
+    size_t want = nents - n < NELEM(batch) ? nents - n : NELEM(batch);
+    size_t got = 0;
+    md->enumerate_from(start ? nullptr : &cookie,
+                       [&](const strbuf<DIRSIZ>& name, u64 inum) {
+      kdirent* e = &batch[got++];
+      e->d_ino = inum;
+      e->d_type = mnode::type_of(inum);
+      strncpy(e->d_name, name.buf_, DIRSIZ);
+      e->d_name[DIRSIZ] = 0;
+      return got < want;
+    });
+    if (got == 0)
+      break;
+    if (!(ents + n).store(batch, got))
+      return -1;
+    strncpy(cookie.buf_, batch[got - 1].d_name, DIRSIZ);
+    start = false;
+    n += got;
+    if (got < want)
+      break;
+  }
+
+  if (n && !cookieptr.store(cookie.buf_, sizeof(cookie.buf_)))
+    return -1;
+  return n;
+}
+
 //SYSCALL {"uargs":["const char *upath", "char * const uargv[]", "const void *actions", "size_t actions_len"]}
 int
 sys_sys_spawn(userptr_str upath, userptr<userptr_str> uargv,
@@ -691,19 +831,50 @@ sys_sys_spawn(userptr_str upath, userptr<userptr_str> uargv,
     // not fall back to the parent table; 2) if an open action
     // specifies O_CLOEXEC and that flag isn't overwritten by a later
     // action, we must close it before the exec.
-    //
-    // Since we only support dup2 actions at the moment, we don't have
-    // to deal with either subtle case.
-
     newftable = myproc()->ftable->copy(true);
+    std::vector<int> closed;
+    bool opened_cloexec = false;
+    auto unclose = [&closed](int fd) {
+      for (auto it = closed.begin(); it != closed.end(); ++it) {
+        if (*it == fd) {
+          closed.erase(it);
+          return;
+        }
+      }
+    };
     while (actions < actions_end) {
+      if ((size_t)(actions_end - actions) <
+          sizeof(__posix_spawn_file_action_hdr)) {
+        uerr.println(__func__, ": truncated action");
+        return -1;
+      }
       auto hdr = (__posix_spawn_file_action_hdr*)actions;
+      // Each action must cover at least its own fixed fields
+      size_t minlen = sizeof(*hdr);
+      if (hdr->type == __posix_spawn_file_action_hdr::TYPE_DUP2)
+        minlen = sizeof(__posix_spawn_file_action_dup2);
+      else if (hdr->type == __posix_spawn_file_action_hdr::TYPE_CLOSE)
+        minlen = sizeof(__posix_spawn_file_action_close);
+      else if (hdr->type == __posix_spawn_file_action_hdr::TYPE_OPEN)
+        minlen = sizeof(__posix_spawn_file_action_open);
+      if (hdr->len < minlen ||
+          hdr->len > (size_t)(actions_end - actions)) {
+        uerr.println(__func__, ": bad action length ", hdr->len);
+        return -1;
+      }
       if (hdr->type == __posix_spawn_file_action_hdr::TYPE_DUP2) {
         auto a = (__posix_spawn_file_action_dup2*)actions;
 
         sref<file> f = newftable->getfile(a->fildes);
         if (!f) {
-          // Try the parent FD table
+          // Try the parent FD table, unless an earlier action closed
+          // this FD.
+          for (int fd : closed) {
+            if (fd == a->fildes) {
+              uerr.println(__func__, ": dup2 failed, closed FD ", a->fildes);
+              return -1;
+            }
+          }
           f = getfile(a->fildes);
           if (!f) {
             uerr.println(__func__, ": dup2 failed, unknown FD ", a->fildes);
@@ -715,12 +886,50 @@ sys_sys_spawn(userptr_str upath, userptr<userptr_str> uargv,
           uerr.println(__func__, ": dup2 failed to replace FD ", a->newfildes);
           return -1;
         }
+        unclose(a->newfildes);
+      } else if (hdr->type == __posix_spawn_file_action_hdr::TYPE_CLOSE) {
+        auto a = (__posix_spawn_file_action_close*)actions;
+
+        // The FD may legitimately be missing from the clone if it
+        // was O_CLOEXEC in the parent.
+        if (newftable->getfile(a->fildes))
+          newftable->close(a->fildes);
+        closed.push_back(a->fildes);
+      } else if (hdr->type == __posix_spawn_file_action_hdr::TYPE_OPEN) {
+        auto a = (__posix_spawn_file_action_open*)actions;
+
+        // The path isn't NUL-terminated; its length is implied by
+        // the action length.
+        size_t pathlen = hdr->len - sizeof(*a);
+        char path[PATH_MAX];
+        if (pathlen >= sizeof(path)) {
+          uerr.println(__func__, ": open path too long");
+          return -1;
+        }
+        memmove(path, a->path, pathlen);
+        path[pathlen] = 0;
+
+        sref<file> f = openfile(myproc()->cwd_m, path, a->oflag);
+        if (!f) {
+          uerr.println(__func__, ": open ", path, " failed");
+          return -1;
+        }
+        if (!newftable->replace(a->fildes, std::move(f),
+                                a->oflag & O_CLOEXEC)) {
+          uerr.println(__func__, ": open failed to replace FD ", a->fildes);
+          return -1;
+        }
+        if (a->oflag & O_CLOEXEC)
+          opened_cloexec = true;
+        unclose(a->fildes);
       } else {
         uerr.println(__func__, ": unimplemented action type");
         return -1;
       }
       actions += hdr->len;
     }
+    if (opened_cloexec)
+      newftable = newftable->copy(true);
   } else {
     newftable = myproc()->ftable->copy(true);
   }
@@ -735,13 +944,10 @@ sys_sys_spawn(userptr_str upath, userptr<userptr_str> uargv,
     std::unique_ptr<char[]> path;
     if (!(path = upath.load_alloc(DIRSIZ+1)))
       return -1;
-    std::vector<std::unique_ptr<char[]> > xargv;
-    if (load_str_list(uargv, MAXARG, MAXARGLEN, &xargv) < 0)
-      return -1;
+    std::unique_ptr<char[]> argbuf;
     std::vector<char*> argv;
-    for (auto &p : xargv)
-      argv.push_back(p.get());
-    argv.push_back(nullptr);
+    if (load_str_list(uargv, MAXARG, MAXARGLEN, &argbuf, &argv) < 0)
+      return -1;
     if (load_image(p, path.get(), argv.data(), nullptr) < 0)
       return -1;
   }
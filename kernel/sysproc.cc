@@ -31,6 +31,65 @@ sys_fork_flags(int flags)
   return p->pid;
 }
 
+// Create a library thread.  The kernel stores the child's pid in
+// *tidptr before the child can run, and on exit the child zeroes
+// *tidptr and wakes futex waiters on it, so pthread_join can wait for
+// it without the parent calling wait().  The child reaps itself.
+//SYSCALL
+int
+sys_fork_thread(int flags, userptr<u64> tidptr)
+{
+  if (!(flags & FORK_SHARE_VMAP) || !tidptr)
+    return -1;
+  // Check that tidptr is writable before there's a child to undo.
+  u64 tid = 0;
+  if (!tidptr.store(&tid))
+    return -1;
+
+  clone_flags cflags = CLONE_SHARE_VMAP | CLONE_DETACH | CLONE_NO_RUN;
+  if (flags & FORK_SHARE_FD)
+    cflags |= CLONE_SHARE_FTABLE;
+  proc *p = doclone(cflags);
+  if (!p)
+    return -1;
+
+  tid = p->pid;
+  tidptr.store(&tid);
+  p->clear_tid_ = tidptr;
+
+  scoped_acquire l(&p->lock);
+  addrun(p);
+  return tid;
+}
+
+// vfork's child runs on its parent's stack until it execs or exits,
+// so neither can return through a return address stored there.
+// Instead, the user stub pops its return address and passes it as
+// retip, and both processes resume directly at retip.
+//SYSCALL {"uargs":["void *retip"]}
+int
+sys_vfork_at(uptr retip)
+{
+  proc *me = myproc();
+  me->tf->rip = retip;
+
+  proc *p = doclone(CLONE_SHARE_VMAP | CLONE_NO_RUN);
+  if (!p)
+    return -1;
+  p->vfork_ = true;
+  {
+    scoped_acquire l(&p->lock);
+    addrun(p);
+  }
+
+  // Sleep until the child execs or exits.  This isn't interruptible
+  // by kill, since the child is still using our address space.
+  scoped_acquire l(&me->lock);
+  while (p->vfork_)
+    me->cv->sleep(&me->lock);
+  return p->pid;
+}
+
 //SYSCALL {"noret":true}
 void
 sys_exit(int status)
@@ -124,8 +183,11 @@ sys_mmap(userptr<void> addr, size_t len, int prot, int flags, int fd,
     if (flags & MAP_SHARED) {
       m = anon_fs->alloc(mnode::types::file).mn();
       auto resizer = m->as_file()->write_size();
+      // Shared pages are allocated now, under the process's policy,
+      // and interleave by their offset in the mapping.
       for (size_t i = 0; i < len; i += PGSIZE) {
-        void* p = zalloc("MAP_ANON|MAP_SHARED");
+        void* p = mempolicy_zalloc("MAP_ANON|MAP_SHARED", myproc()->mpol,
+                                   i / PGSIZE);
         if (!p)
           throw_bad_alloc();
         auto pi = sref<page_info>::transfer(new (page_info::of(p)) page_info());
@@ -189,6 +251,13 @@ sys_madvise(userptr<void> addr, size_t len, int advice)
       return -1;
     return 0;
 
+  case MADV_PAGEOUT:
+    if (!zswap_enabled())
+      return -1;
+    if (myproc()->vmap->pageout(align_addr, align_len) < 0)
+      return -1;
+    return 0;
+
   case MADV_INVALIDATE_CACHE:
     if (myproc()->vmap->invalidate_cache(align_addr, align_len) < 0)
       return -1;
@@ -221,6 +290,34 @@ sys_mprotect(userptr<void> addr, size_t len, int prot)
   return myproc()->vmap->mprotect(align_addr, align_len, flags);
 }
 
+//SYSCALL
+int
+sys_set_mempolicy(int mode, u64 nodemask)
+{
+  mempolicy pol;
+  if (!mempolicy::make(mode, nodemask, &pol))
+    return -1;                  // EINVAL
+  myproc()->mpol = pol;
+  return 0;
+}
+
+//SYSCALL
+int
+sys_mbind(userptr<void> addr, size_t len, int mode, u64 nodemask)
+{
+  if ((uptr)addr % PGSIZE)
+    return -1;                  // EINVAL
+  if ((uptr)addr + len >= USERTOP || (uptr)addr + (uptr)len < (uptr)addr)
+    return -1;                  // EFAULT
+  mempolicy pol;
+  if (!mempolicy::make(mode, nodemask, &pol))
+    return -1;                  // EINVAL
+
+  uptr align_addr = PGROUNDDOWN((uptr)addr);
+  uptr align_len = PGROUNDUP((uptr)addr + len) - align_addr;
+  return myproc()->vmap->set_mempolicy(align_addr, align_len, pol);
+}
+
 //SYSCALL
 long
 sys_pt_pages(void)
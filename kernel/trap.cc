@@ -15,6 +15,7 @@
 #include "kstream.hh"
 #include "hwvm.hh"
 #include "refcache.hh"
+#include "gc.hh"
 #include "cpuid.hh"
 
 extern "C" void __uaccess_end(void);
@@ -186,6 +187,8 @@ trap(struct trapframe *tf)
     if (mycpu()->id == 0)
       timerintr();
     refcache::mycache->tick();
+    gc_tick();
+    samptick(tf);
     lapiceoi();
     if (mycpu()->no_sched_count) {
       kstats::inc(&kstats::sched_blocked_tick_count);
@@ -307,6 +310,11 @@ trap(struct trapframe *tf)
   if(myproc() && myproc()->killed && (tf->cs&3) == 0x3)
     exit(-1);
 
+  // Sample memory accesses for NUMA balancing.  This may move us to
+  // another CPU at the yield below.
+  if(myproc() && tf->trapno == T_IRQ0+IRQ_TIMER && (tf->cs&3) == 0x3)
+    numa_balance_tick();
+
   // Force process to give up CPU on clock tick.
   // If interrupts were on while locks held, would need to check nlock.
   if(myproc() && myproc()->get_state() == RUNNING &&
@@ -7,6 +7,7 @@
 #include "atomic_util.hh"
 #include "proc.hh"
 #include "file.hh"
+#include "pollqueue.hh"
 #include <uk/socket.h>
 #include <uk/un.h>
 
@@ -76,6 +77,8 @@ struct localsock {
   atomic<coresocket*> pipes[NCPU];
   balancer<localsock, coresocket> b;
   atomic<int> nreader;
+  // Woken whenever a message is queued, for poll
+  struct pollqueue pollq;
 
   localsock(bool ordered) : ordered_(ordered), b(this), nreader(0) {
     for (int i = 0; i < NCPU; i++)
@@ -123,6 +126,26 @@ struct localsock {
     }
   }
 
+  // Whether read() would find a message without waiting.  Like the
+  // queue lengths it reads, the answer may be stale.
+  bool readable() const {
+    if (ordered_) {
+      coresocket* c = pipes[0];
+      return c->len > 0;
+    }
+#if LB
+    for (int i = 0; i < NCPU; i++) {
+      coresocket* c = pipes[i];
+      if (c && c->len > 0)
+        return true;
+    }
+    return false;
+#else
+    coresocket* c = pipes[myid()];
+    return c && c->len > 0;
+#endif
+  }
+
   coresocket* balance_get(int id) const {
     return pipes[id];
   }
@@ -169,6 +192,8 @@ struct localsock {
         // cprintf("w %d(%d): coresocket %p\n", myproc()->pid, myproc()->cpuid, cp);
         cp->messages.push_back(m);
         cp->len++;
+        l.release();
+        pollq.wake();
         return 0;
       }
     }
@@ -305,6 +330,22 @@ public:
     return len;
   }
 
+  pollqueue*
+  get_pollqueue() override
+  {
+    return &localsock_->pollq;
+  }
+
+  int
+  poll(int events) override
+  {
+    // sendto doesn't wait for a receiver, so always report POLLOUT.
+    int revents = events & POLLOUT;
+    if ((events & POLLIN) && localsock_->readable())
+      revents |= POLLIN;
+    return revents;
+  }
+
   ssize_t
   recvfrom(userptr<void> buf, size_t len, int flags,
            struct sockaddr_storage *src_addr, size_t *addrlen) override
@@ -336,6 +377,8 @@ public:
   void
   onzero() override
   {
+    // Let any poller still on the queue see the socket close
+    localsock_->pollq.wake();
     delete this;
   }
 };
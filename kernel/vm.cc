@@ -14,6 +14,8 @@
 #include "kmtrace.hh"
 #include "kstream.hh"
 #include "page_info.hh"
+#include "rmap.hh"
+#include "refcache.hh"
 #include <algorithm>
 #include "kstats.hh"
 
@@ -37,9 +39,13 @@ void to_stream(class print_stream *s, const vmdesc &vmd)
         {"ANON", vmdesc::FLAG_ANON},
         {"WRITE", vmdesc::FLAG_WRITE},
         {"SHARED", vmdesc::FLAG_SHARED},
+        {"ZSWAP", vmdesc::FLAG_ZSWAP},
+        {"ZSWAP_COLD", vmdesc::FLAG_ZSWAP_COLD},
       }), " ");
   if (vmd.page)
     s->print((void*)vmd.page->pa(), "}");
+  else if (vmd.zswapped())
+    s->print("zswap ", (void*)vmd.zswapped(), "}");
   else
     s->print("null}");
 }
@@ -110,6 +116,19 @@ public:
  * vmap
  */
 
+// Return true if a page frame with flags records its mapping of its
+// page in the page's reverse map.  A private anonymous page that
+// isn't copy-on-write is mapped only at its own page frame, and
+// nothing needs to find where it's mapped, so faults on fresh
+// anonymous memory skip the reverse map.  copy adds the mapping when
+// it makes the page copy-on-write.
+static bool
+rmap_tracked(u64 flags)
+{
+  return !(flags & vmdesc::FLAG_ANON) ||
+    (flags & (vmdesc::FLAG_COW | vmdesc::FLAG_SHARED));
+}
+
 sref<vmap>
 vmap::alloc(void)
 {
@@ -117,12 +136,22 @@ vmap::alloc(void)
 }
 
 vmap::vmap() : 
-  brk_(0), brklock_("brk_lock", LOCKSTAT_VM)
+  brk_(0), brklock_("brk_lock", LOCKSTAT_VM), numa_next_scan_(0),
+  numa_scan_pos_(0), zswap_scan_pos_(0)
 {
 }
 
 vmap::~vmap()
 {
+  for (auto it = vpfs_.begin(), end = vpfs_.end(); it < end; it += it.span()) {
+    if (!it.is_set())
+      continue;
+    if (it->page) {
+      if (rmap_tracked(it->flags))
+        rmap_remove_final(it->page.get(), this, it.index() * PGSIZE);
+    } else if (it->zswapped())
+      zswap_put(it->zswapped());
+  }
 }
 
 sref<vmap>
@@ -154,6 +183,9 @@ vmap::copy()
       if (it->page && !(it->flags & vmdesc::FLAG_SHARED) && !(it->flags & vmdesc::FLAG_COW)) {
         if (SDEBUG)
           sdebug.println("vm: mark COW");
+        // The page is about to be shared
+        if (!rmap_tracked(it->flags))
+          rmap_add(it->page.get(), this, it.index() * PGSIZE);
         it->flags |= vmdesc::FLAG_COW;
         // XXX(Austin) Should we try to invalidate in larger chunks?
         cache.invalidate(it.index() * PGSIZE, PGSIZE, it, &shootdown);
@@ -161,6 +193,10 @@ vmap::copy()
 
       // Copy the descriptor
       nm->vpfs_.fill(out, it->dup());
+      if (it->page)
+        rmap_add(it->page.get(), nm.get(), it.index() * PGSIZE);
+      else if (it->zswapped())
+        zswap_get(it->zswapped());
 
       // Next page
       ++out;
@@ -212,6 +248,11 @@ again:
       // Verify unmapped region now that we hold the lock
       if (!fixed)
         goto again;
+      if (it->page) {
+        if (rmap_tracked(it->flags))
+          rmap_remove(it->page.get(), this, it.index() * PGSIZE);
+      } else if (it->zswapped())
+        zswap_put(it->zswapped());
       pages.add(std::move(it->page));
     }
 
@@ -249,9 +290,16 @@ vmap::remove(uptr start, uptr len)
     auto begin = vpfs_.find(start / PGSIZE);
     auto end = vpfs_.find((start + len) / PGSIZE);
     auto lock = vpfs_.acquire(begin, end);
-    for (auto it = begin; it < end; it += it.span())
-      if (it.is_set())
-        pages.add(std::move(it->page));
+    for (auto it = begin; it < end; it += it.span()) {
+      if (!it.is_set())
+        continue;
+      if (it->page) {
+        if (rmap_tracked(it->flags))
+          rmap_remove(it->page.get(), this, it.index() * PGSIZE);
+      } else if (it->zswapped())
+        zswap_put(it->zswapped());
+      pages.add(std::move(it->page));
+    }
     cache.invalidate(start, len, begin, &shootdown);
     // XXX If this is a large unset, we could actively re-fold already
     // expanded regions.
@@ -355,6 +403,24 @@ vmap::mprotect(uptr start, uptr len, uint64_t flags)
   return 0;
 }
 
+int
+vmap::set_mempolicy(uptr start, uptr len, const mempolicy &pol)
+{
+  auto begin = vpfs_.find(start / PGSIZE);
+  auto end = vpfs_.find((start + len) / PGSIZE);
+  auto lock = vpfs_.acquire(begin, end);
+
+  u64 pflags = vmdesc::policy_flags(pol);
+  for (auto it = begin; it < end; it += it.span()) {
+    if (!it.is_set())
+      return -1;                // EFAULT
+
+    it->flags = (it->flags & ~(vmdesc::FLAG_MPOL | vmdesc::FLAG_MPOL_NODES)) |
+      pflags;
+  }
+  return 0;
+}
+
 int
 vmap::dup_page(uptr dest, uptr src)
 {
@@ -365,10 +431,30 @@ vmap::dup_page(uptr dest, uptr src)
   // atomically, but we can't take a lock here on srcit or it would
   // defeat the benchmark.  Fixing this is pointless because we're
   // trying to simulate a unified buffer cache, which would hand us a
-  // physical page directly.
+  // physical page directly.  Files loaded from disk now share the
+  // buffer cache's pages (see mfsload), so mmap of such a file gets
+  // that for real; this remains for countbench's sake.
   if (!srcit.is_set())
     return -1;
   desc = srcit->dup();
+  if (!rmap_tracked(desc.flags)) {
+    // A private anonymous page.  Share it between the two frames,
+    // as with MAP_SHARED, and put the source in the reverse map too,
+    // so numa_migrate and zswap_out no longer treat it as exclusive.
+    // This takes src's lock, but only the first dup of a page does.
+    // zswap may also have compressed the page, and a fault could free
+    // the compressed copy under us, so fault it in with src locked.
+    auto lock = vpfs_.acquire(srcit);
+    if (!srcit.is_set())
+      return -1;
+    if (!srcit->page && !ensure_page(srcit, access_type::READ))
+      return -1;
+    if (!rmap_tracked(srcit->flags)) {
+      srcit->flags |= vmdesc::FLAG_SHARED;
+      rmap_add(srcit->page.get(), this, PGROUNDDOWN(src));
+    }
+    desc = srcit->dup();
+  }
 
   auto destit = vpfs_.find(dest / PGSIZE);
 
@@ -376,11 +462,226 @@ vmap::dup_page(uptr dest, uptr src)
     auto lock = vpfs_.acquire(destit);
     assert(!destit.is_set());
     vpfs_.fill(destit, desc);
+    if (desc.page && rmap_tracked(desc.flags))
+      rmap_add(desc.page.get(), this, PGROUNDDOWN(dest));
+  }
+
+  return 0;
+}
+
+bool
+vmap::drop_page(uptr va, page_info *pi)
+{
+  mmu::shootdown shootdown;
+  // Hold the page until after the shootdown
+  sref<page_info> old;
+
+  {
+    auto it = vpfs_.find(va / PGSIZE);
+    auto lock = vpfs_.acquire(it);
+    if (!it.is_set() || it->page.get() != pi ||
+        (it->flags & vmdesc::FLAG_ANON))
+      return false;
+    // A MAP_PRIVATE mapping may hold a private copy instead
+    u64 page_idx = (it.index() * PGSIZE - it->start) / PGSIZE;
+    if (it->inode->as_file()->get_page(page_idx).get_page_info().get() != pi)
+      return false;
+
+    cache.invalidate(va, PGSIZE, it, &shootdown);
+    rmap_remove(pi, this, va);
+    if (it.base_span() == 1) {
+      old = std::move(it->page);
+    } else {
+      vmdesc n(*it);
+      old = std::move(n.page);
+      vpfs_.fill(it, std::move(n));
+    }
+    shootdown.perform();
+  }
+  return true;
+}
+
+void
+vmap::numa_scan(u64 now, u64 period, size_t npages)
+{
+  u64 next = numa_next_scan_.load(std::memory_order_relaxed);
+  if (now < next || !numa_next_scan_.compare_exchange_strong(next, now + period))
+    return;
+
+  const size_t top = USERTOP / PGSIZE;
+  size_t idx = numa_scan_pos_.load(std::memory_order_relaxed);
+  size_t marked = 0, visited = 0;
+  auto end = vpfs_.find(top);
+  while (marked < npages && visited < 8 * npages) {
+    // Skip unmapped space without locking, as unmapped_area does
+    auto it = vpfs_.find(idx);
+    for (; it < end && !it.is_set(); it += it.span())
+      ;
+    if (!(it < end)) {
+      // Start over next time
+      idx = 0;
+      break;
+    }
+
+    // Sample the next window of at most npages pages
+    idx = it.index();
+    size_t wtop = std::min(idx + npages, top);
+    auto begin = vpfs_.find(idx), wend = vpfs_.find(wtop);
+    auto lock = vpfs_.acquire(begin, wend);
+    mmu::shootdown shootdown;
+    for (it = begin; it < wend && marked < npages; it += it.span()) {
+      ++visited;
+      // Only sample resident private anonymous pages, one frame at a
+      // time so the flag doesn't cover other frames
+      if (!it.is_set() || !it->page || it.base_span() != 1 ||
+          (it->flags & (vmdesc::FLAG_ANON | vmdesc::FLAG_NUMA_HINT)) !=
+          vmdesc::FLAG_ANON)
+        continue;
+      it->flags |= vmdesc::FLAG_NUMA_HINT;
+      cache.invalidate(it.index() * PGSIZE, PGSIZE, it, &shootdown);
+      ++marked;
+    }
+    shootdown.perform();
+    idx = it < wend ? it.index() : wtop;
   }
+  numa_scan_pos_.store(idx, std::memory_order_relaxed);
+  kstats::inc(&kstats::numa_scan_page_count, (u64)marked);
+}
+
+bool
+vmap::numa_migrate(const vpf_array::iterator &it, size_t node)
+{
+  auto &desc = *it;
+  // Only move pages mapped nowhere else: private anonymous pages that
+  // aren't copy-on-write, which are also the pages the reverse map
+  // doesn't track
+  if (rmap_tracked(desc.flags) || !desc.page || it.base_span() != 1)
+    return false;
+
+  char *p = kalloc_node("(vmap::numa_migrate)", node);
+  if (!p) {
+    kstats::inc(&kstats::numa_page_migrate_fail_count);
+    return false;
+  }
+  memmove(p, desc.page->va(), PGSIZE);
+  desc.page = sref<page_info>::transfer(new(page_info::of(p)) page_info());
+  kstats::inc(&kstats::numa_page_migrate_count);
+  return true;
+}
+
+size_t
+vmap::zswap_reclaim(size_t npages)
+{
+  const size_t top = USERTOP / PGSIZE;
+  const size_t first = zswap_scan_pos_.load(std::memory_order_relaxed);
+  size_t idx = first, freed = 0, marked = 0;
+  bool wrapped = false;
+  // Go around the address space at most once, so a page this call
+  // marks cold is only compressed by a later call, and has until then
+  // to be touched.  Stop once we've freed npages pages or marked as
+  // many for next time.
+  while (freed < npages && marked < npages) {
+    // Skip unmapped space without locking, as unmapped_area does
+    size_t stop = wrapped ? first : top;
+    auto it = vpfs_.find(idx), send = vpfs_.find(stop);
+    for (; it < send && !it.is_set(); it += it.span())
+      ;
+    if (!(it < send)) {
+      idx = stop;
+      if (wrapped)
+        break;
+      wrapped = true;
+      idx = 0;
+      continue;
+    }
+
+    // Lock only the next window, so faults elsewhere in the address
+    // space proceed while we compress
+    idx = it.index();
+    size_t wtop = std::min(idx + ZSWAP_RECLAIM_PAGES, stop);
+    auto begin = vpfs_.find(idx), wend = vpfs_.find(wtop);
+    auto lock = vpfs_.acquire(begin, wend);
+    freed += zswap_range(begin, wend, false, &marked);
+    idx = wtop;
+  }
+  zswap_scan_pos_.store(idx, std::memory_order_relaxed);
+  return freed;
+}
 
+int
+vmap::pageout(uptr start, uptr len)
+{
+  auto begin = vpfs_.find(start / PGSIZE);
+  auto end = vpfs_.find((start + len) / PGSIZE);
+  auto lock = vpfs_.acquire(begin, end);
+  size_t marked = 0;
+  zswap_range(begin, end, true, &marked);
   return 0;
 }
 
+size_t
+vmap::zswap_range(const vpf_array::iterator &begin,
+                  const vpf_array::iterator &end, bool force,
+                  size_t *marked)
+{
+  // Only compress resident private anonymous pages, one frame at a
+  // time so the flags don't cover other frames.  Leave pages NUMA
+  // balancing is sampling alone.
+  auto candidate = [](const vpf_array::iterator &it) {
+    return it.is_set() && it->page && it.base_span() == 1 &&
+      (it->flags & (vmdesc::FLAG_ANON | vmdesc::FLAG_COW |
+                    vmdesc::FLAG_SHARED | vmdesc::FLAG_NUMA_HINT)) ==
+      vmdesc::FLAG_ANON;
+  };
+
+  size_t freed = 0, nmarked = 0;
+  mmu::shootdown shootdown;
+  for (auto it = begin; it < end; it += it.span()) {
+    if (!candidate(it))
+      continue;
+    if (it->flags & vmdesc::FLAG_ZSWAP_COLD) {
+      if (zswap_out(it))
+        ++freed;
+    } else {
+      // Unmap the page, so an access clears the cold bit before it
+      // can change the page
+      it->flags |= vmdesc::FLAG_ZSWAP_COLD;
+      cache.invalidate(it.index() * PGSIZE, PGSIZE, it, &shootdown);
+      ++nmarked;
+    }
+  }
+  shootdown.perform();
+  *marked += nmarked;
+  kstats::inc(&kstats::zswap_scan_page_count, (u64)nmarked);
+
+  if (force)
+    for (auto it = begin; it < end; it += it.span())
+      if (candidate(it) && (it->flags & vmdesc::FLAG_ZSWAP_COLD) &&
+          zswap_out(it))
+        ++freed;
+  return freed;
+}
+
+bool
+vmap::zswap_out(const vpf_array::iterator &it)
+{
+  auto &desc = *it;
+  zswap_entry *e;
+  // The page is unmapped, and zswap_range only passes private
+  // anonymous pages that aren't copy-on-write, which aren't mapped
+  // anywhere else and aren't in the reverse map
+  desc.flags &= ~vmdesc::FLAG_ZSWAP_COLD;
+  if (!zswap_store(desc.page->va(), &e))
+    return false;
+
+  desc.page = sref<page_info>();
+  if (e) {
+    desc.flags |= vmdesc::FLAG_ZSWAP;
+    desc.start = (intptr_t)e;
+  }
+  return true;
+}
+
 /*
  * pagefault handling code on vmap
  */
@@ -421,6 +722,16 @@ vmap::pagefault(uptr va, u32 err)
       return -1;
     }
 
+    // NUMA balancing unmapped this page to see who uses it.  This may
+    // move the page to our node; it isn't mapped anywhere, so there's
+    // nothing to shoot down.
+    if ((desc.flags & vmdesc::FLAG_NUMA_HINT) && desc.page) {
+      desc.flags &= ~vmdesc::FLAG_NUMA_HINT;
+      int node = numa_hint_fault(page_info::node_of(desc.page->pa()));
+      if (node >= 0)
+        numa_migrate(it, node);
+    }
+
     // If this is a COW fault, we need to hold a reference to the old
     // physical page until we've cleared the PTE and done TLB shoot
     // down.
@@ -474,7 +785,11 @@ pagefault(vmap *vmap, uptr va, u32 err)
 #if EXCEPTIONS
     } catch (std::bad_alloc& e) {
       cprintf("%d: pagefault retry\n", myproc()->pid);
+      // Compressing pages frees them once refcache catches up
+      if (zswap_enabled())
+        vmap->zswap_reclaim(ZSWAP_RECLAIM_PAGES);
       gc_wakeup();
+      refcache::synchronize();
       yield();
     }
 #endif
@@ -522,7 +837,11 @@ pagelookup(vmap* vmap, uptr va)
 #if EXCEPTIONS
     } catch (std::bad_alloc& e) {
       cprintf("%d: pagelookup retry\n", myproc()->pid);
+      // Compressing pages frees them once refcache catches up
+      if (zswap_enabled())
+        vmap->zswap_reclaim(ZSWAP_RECLAIM_PAGES);
       gc_wakeup();
+      refcache::synchronize();
       yield();
     }
 #endif
@@ -567,6 +886,7 @@ vmap::set_write_permission(uptr start, uptr len, bool is_readonly, bool is_cow)
     if (!it.is_set())
       return -1;
     auto &desc = *it;
+    bool tracked = rmap_tracked(desc.flags);
     if (is_readonly)
       desc.flags &= ~vmdesc::FLAG_WRITE;
     else
@@ -575,6 +895,12 @@ vmap::set_write_permission(uptr start, uptr len, bool is_readonly, bool is_cow)
       desc.flags |= vmdesc::FLAG_COW;
     else
       desc.flags &= ~vmdesc::FLAG_COW;
+    if (desc.page && tracked != rmap_tracked(desc.flags)) {
+      if (tracked)
+        rmap_remove(desc.page.get(), this, it.index() * PGSIZE);
+      else
+        rmap_add(desc.page.get(), this, it.index() * PGSIZE);
+    }
   }
   return 0;
 }
@@ -615,6 +941,15 @@ vmap::sbrk(ssize_t n, uptr *addr)
     auto begin = vpfs_.find(newend / PGSIZE),
       end = vpfs_.find(newstart / PGSIZE);
     auto rlock = vpfs_.acquire(begin, end);
+    for (auto it = begin; it < end; it += it.span()) {
+      if (!it.is_set())
+        continue;
+      if (it->page) {
+        if (rmap_tracked(it->flags))
+          rmap_remove(it->page.get(), this, it.index() * PGSIZE);
+      } else if (it->zswapped())
+        zswap_put(it->zswapped());
+    }
     vpfs_.unset(begin, end);
   } else if (newstart < newend) {
     // Adjust break up by mapping pages
@@ -656,6 +991,17 @@ vmap::unmapped_area(size_t npages)
   return 0;
 }
 
+// Return the NUMA policy to allocate desc's page under: desc's own
+// if it has one, or else the faulting process's.
+static mempolicy
+alloc_policy(const vmdesc &desc)
+{
+  mempolicy pol = desc.policy();
+  if (pol.mode == MPOL_DEFAULT && myproc())
+    pol = myproc()->mpol;
+  return pol;
+}
+
 page_info *
 vmap::ensure_page(const vmap::vpf_array::iterator &it, vmap::access_type type,
                   bool *allocated)
@@ -664,20 +1010,30 @@ vmap::ensure_page(const vmap::vpf_array::iterator &it, vmap::access_type type,
     *allocated = false;
 
   auto &desc = *it;
+  // Any access makes the page hot again.  Only single page frames are
+  // marked cold, so this doesn't touch other frames.
+  if (desc.flags & vmdesc::FLAG_ZSWAP_COLD)
+    desc.flags &= ~vmdesc::FLAG_ZSWAP_COLD;
+
   bool need_copy = (type == access_type::WRITE &&
                     (desc.flags & vmdesc::FLAG_COW));
   if (desc.page && !need_copy)
     return desc.page.get();
 
   sref<page_info> page = desc.page;
+  zswap_entry *swapped = nullptr;
   if (!page) {
     if (desc.flags & vmdesc::FLAG_ANON) {
       assert(!(desc.flags & vmdesc::FLAG_COW));
       if (allocated)
         *allocated = true;
-      char *p = zalloc("(vmap::pagelookup)");
+      char *p = mempolicy_zalloc("(vmap::pagelookup)", alloc_policy(desc),
+                                 it.index());
       if (!p)
         throw_bad_alloc();
+      swapped = desc.zswapped();
+      if (swapped)
+        zswap_load(swapped, p);
       page = sref<page_info>::transfer(new(page_info::of(p)) page_info());
     } else {
       u64 page_idx = (it.index() * PGSIZE - desc.start) / PGSIZE;
@@ -691,7 +1047,8 @@ vmap::ensure_page(const vmap::vpf_array::iterator &it, vmap::access_type type,
     // This is a COW fault; copy in to a new page
     if (allocated)
       *allocated = true;
-    char *p = zalloc("(vmap::pagelookup)");
+    char *p = mempolicy_zalloc("(vmap::pagelookup)", alloc_policy(desc),
+                               it.index());
     if (!p)
       throw_bad_alloc();
 
@@ -702,21 +1059,35 @@ vmap::ensure_page(const vmap::vpf_array::iterator &it, vmap::access_type type,
     page = sref<page_info>::transfer(new(page_info::of(p)) page_info());
   }
 
+  u64 nflags = desc.flags;
+  if (need_copy)
+    nflags &= ~vmdesc::FLAG_COW;
+  if (swapped)
+    nflags &= ~vmdesc::FLAG_ZSWAP;
+
   // Install the page in the canonical page table
+  if (desc.page && rmap_tracked(desc.flags))
+    rmap_remove(desc.page.get(), this, it.index() * PGSIZE);
+  if (rmap_tracked(nflags))
+    rmap_add(page.get(), this, it.index() * PGSIZE);
   if (it.base_span() == 1) {
     // Safe to update in place
     desc.page = page;
-    if (need_copy)
-      desc.flags &= ~vmdesc::FLAG_COW;
+    desc.flags = nflags;
+    if (swapped)
+      desc.start = 0;
   } else {
     vmdesc n(desc);
     n.page = page;
-    if (need_copy)
-      n.flags &= ~vmdesc::FLAG_COW;
+    n.flags = nflags;
+    if (swapped)
+      n.start = 0;
     // XXX(austin) Fill could do a move in this case, which would
     // save extraneous reference counting
     vpfs_.fill(it, std::move(n));
   }
+  if (swapped)
+    zswap_put(swapped);
   return page.get();
 }
 
@@ -0,0 +1,337 @@
+// Compressed in-memory swap.  See zswap.hh.
+//
+// Pages are compressed with a byte-oriented LZ77 in the style of LZ4's
+// block format, which is fast enough to run in the page fault path.
+// A compressed page is a series of sequences, each of which is
+//
+//   token      literal length (high nibble), match length - 4 (low)
+//   [length]   more literal length, if the nibble was 15
+//   literals
+//   offset     how far back the match starts, two bytes little endian
+//   [length]   more match length, if the nibble was 15
+//
+// and the last sequence has only literals.  A nibble of 15 is followed
+// by bytes that add to it, up to and including the first that isn't
+// 255.
+//
+// The compressor finds matches with a hash table of the last position
+// each 4-byte string occurred at.  Each CPU has its own table and
+// output buffer, which share one page.  The pages are allocated when
+// zswap is turned on, since reclaim runs once memory has run out.
+
+#include "types.h"
+#include "kernel.hh"
+#include "amd64.h"
+#include "cpu.hh"
+#include "percpu.hh"
+#include "zswap.hh"
+#include "file.hh"
+#include "major.h"
+#include "kstream.hh"
+#include "kstats.hh"
+#include "spinlock.hh"
+#include <atomic>
+
+enum {
+  // Bits of the compressor's hash of each 4-byte string
+  LZ_HASH_BITS = 10,
+  // The shortest match a sequence can encode
+  LZ_MIN_MATCH = 4,
+};
+
+struct zswap_entry
+{
+  std::atomic<u32> ref;
+  // Bytes in data
+  u16 len;
+  u8 data[];
+};
+
+enum {
+  // The most compressed bytes worth keeping.  Entries come from
+  // kmalloc, and anything bigger would take a whole page.
+  ZSWAP_MAX_LEN = PGSIZE / 2 - sizeof(zswap_entry),
+};
+
+struct zswap_ctx
+{
+  u16 table[1 << LZ_HASH_BITS];
+  u8 buf[ZSWAP_MAX_LEN];
+};
+static_assert(sizeof(zswap_ctx) <= PGSIZE, "zswap_ctx doesn't fit in a page");
+
+// Each CPU's context, or null if zswap was never turned on
+DEFINE_PERCPU(zswap_ctx*, zswap_ctxs);
+
+static std::atomic<bool> enabled;
+// Serializes turning zswap on
+static spinlock enable_lock("zswap_enable");
+
+// Pages stored, and the bytes they take
+static std::atomic<u64> stored_pages, stored_bytes;
+
+static inline u32
+lz_load32(const u8 *p)
+{
+  u32 v;
+  __builtin_memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline u32
+lz_hash(u32 seq)
+{
+  return (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Write the rest of a length whose nibble was 15.
+static inline u8 *
+lz_put_len(u8 *op, size_t len)
+{
+  for (; len >= 255; len -= 255)
+    *op++ = 255;
+  *op++ = len;
+  return op;
+}
+
+// Read the rest of a length whose nibble was 15 into *len.  Returns
+// nullptr if the input ends first.
+static inline const u8 *
+lz_get_len(const u8 *ip, const u8 *iend, size_t *len)
+{
+  u8 b;
+  do {
+    if (ip == iend)
+      return nullptr;
+    b = *ip++;
+    *len += b;
+  } while (b == 255);
+  return ip;
+}
+
+// Append a sequence of nlit literals at lit and a match of mlen bytes
+// (0 for none) at offset off.  Returns nullptr if it doesn't fit
+// before oend.
+static u8 *
+lz_put_seq(u8 *op, u8 *oend, const u8 *lit, size_t nlit, size_t off,
+           size_t mlen)
+{
+  // Bound the sequence's size before writing any of it
+  if ((size_t)(oend - op) < 1 + nlit / 255 + 1 + nlit + 2 + mlen / 255 + 1)
+    return nullptr;
+
+  u8 *token = op++;
+  *token = (nlit < 15 ? nlit : 15) << 4;
+  if (nlit >= 15)
+    op = lz_put_len(op, nlit - 15);
+  memmove(op, lit, nlit);
+  op += nlit;
+  if (!mlen)
+    return op;
+
+  *op++ = off;
+  *op++ = off >> 8;
+  mlen -= LZ_MIN_MATCH;
+  *token |= mlen < 15 ? mlen : 15;
+  if (mlen >= 15)
+    op = lz_put_len(op, mlen - 15);
+  return op;
+}
+
+// Compress n bytes at src into at most cap bytes at dst.  Returns the
+// compressed size, or 0 if it's more than cap.
+static size_t
+lz_compress(const u8 *src, size_t n, u8 *dst, size_t cap, u16 *table)
+{
+  // Table entries are positions plus one, so 0 means none
+  memset(table, 0, sizeof(u16) << LZ_HASH_BITS);
+
+  const u8 *ip = src, *anchor = src, *end = src + n;
+  const u8 *mflimit = end - LZ_MIN_MATCH;
+  u8 *op = dst, *oend = dst + cap;
+  while (ip < mflimit) {
+    u32 seq = lz_load32(ip);
+    u16 *slot = &table[lz_hash(seq)];
+    const u8 *ref = src + *slot - 1;
+    bool hit = *slot && lz_load32(ref) == seq;
+    *slot = ip - src + 1;
+    if (!hit) {
+      // Like LZ4, skip faster the longer we go without a match, so
+      // incompressible data costs little
+      ip += 1 + ((ip - anchor) >> 6);
+      continue;
+    }
+
+    const u8 *mp = ip + LZ_MIN_MATCH, *rp = ref + LZ_MIN_MATCH;
+    while (mp < end && *mp == *rp)
+      mp++, rp++;
+    op = lz_put_seq(op, oend, anchor, ip - anchor, ip - ref, mp - ip);
+    if (!op)
+      return 0;
+    ip = anchor = mp;
+  }
+
+  op = lz_put_seq(op, oend, anchor, end - anchor, 0, 0);
+  if (!op)
+    return 0;
+  return op - dst;
+}
+
+// Decompress n bytes at src into exactly cap bytes at dst.  Returns
+// false if src is malformed or doesn't decompress to cap bytes.
+static bool
+lz_decompress(const u8 *src, size_t n, u8 *dst, size_t cap)
+{
+  const u8 *ip = src, *iend = src + n;
+  u8 *op = dst, *oend = dst + cap;
+  while (ip < iend) {
+    u8 token = *ip++;
+    size_t nlit = token >> 4;
+    if (nlit == 15 && !(ip = lz_get_len(ip, iend, &nlit)))
+      return false;
+    if (nlit > (size_t)(iend - ip) || nlit > (size_t)(oend - op))
+      return false;
+    memmove(op, ip, nlit);
+    op += nlit;
+    ip += nlit;
+    // The last sequence has no match
+    if (ip == iend)
+      break;
+
+    if (iend - ip < 2)
+      return false;
+    size_t off = ip[0] | (ip[1] << 8);
+    ip += 2;
+    size_t mlen = token & 15;
+    if (mlen == 15 && !(ip = lz_get_len(ip, iend, &mlen)))
+      return false;
+    mlen += LZ_MIN_MATCH;
+    if (off == 0 || off > (size_t)(op - dst) || mlen > (size_t)(oend - op))
+      return false;
+    // Matches may overlap their own output, so copy forward a byte at
+    // a time
+    for (const u8 *rp = op - off; mlen; mlen--)
+      *op++ = *rp++;
+  }
+  return op == oend;
+}
+
+static bool
+page_is_zero(const void *va)
+{
+  const u64 *p = (const u64*)va;
+  for (size_t i = 0; i < PGSIZE / sizeof(*p); i++)
+    if (p[i])
+      return false;
+  return true;
+}
+
+bool
+zswap_enabled(void)
+{
+  return enabled.load(std::memory_order_acquire);
+}
+
+bool
+zswap_store(const void *va, zswap_entry **out)
+{
+  if (page_is_zero(va)) {
+    kstats::inc(&kstats::zswap_zero_count);
+    *out = nullptr;
+    return true;
+  }
+
+  kstats::timer timer(&kstats::zswap_store_cycles);
+  scoped_no_sched no_sched;
+  zswap_ctx *ctx = *zswap_ctxs;
+  if (!ctx) {
+    kstats::inc(&kstats::zswap_reject_count);
+    return false;
+  }
+
+  size_t len = lz_compress((const u8*)va, PGSIZE, ctx->buf, sizeof(ctx->buf),
+                           ctx->table);
+  zswap_entry *e = nullptr;
+  if (len)
+    e = (zswap_entry*)kmalloc(sizeof(*e) + len, "zswap_entry");
+  if (!e) {
+    kstats::inc(&kstats::zswap_reject_count);
+    return false;
+  }
+  new (&e->ref) std::atomic<u32>(1);
+  e->len = len;
+  memmove(e->data, ctx->buf, len);
+
+  stored_pages++;
+  stored_bytes += len;
+  kstats::inc(&kstats::zswap_store_count);
+  kstats::inc(&kstats::zswap_store_bytes, (u64)len);
+  *out = e;
+  return true;
+}
+
+void
+zswap_load(const zswap_entry *e, void *va)
+{
+  kstats::timer timer(&kstats::zswap_load_cycles);
+  if (!lz_decompress(e->data, e->len, (u8*)va, PGSIZE))
+    panic("zswap_load: corrupt entry %p", e);
+  kstats::inc(&kstats::zswap_load_count);
+}
+
+void
+zswap_get(zswap_entry *e)
+{
+  e->ref.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+zswap_put(zswap_entry *e)
+{
+  if (e->ref.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+  stored_pages--;
+  stored_bytes -= e->len;
+  kmfree(e, sizeof(*e) + e->len);
+}
+
+static int
+zswap_read(mdev*, char *dst, u32 off, u32 n)
+{
+  window_stream s(dst, off, n);
+  u64 pages = stored_pages.load(), bytes = stored_bytes.load();
+  s.println("enabled ", zswap_enabled() ? 1 : 0);
+  s.println("stored ", pages, " pages");
+  s.println("compressed ", bytes, " bytes");
+  if (bytes)
+    s.println("ratio ", pages * PGSIZE * 100 / bytes, "%");
+  return s.get_used();
+}
+
+static int
+zswap_write(mdev*, const char *buf, u32 n)
+{
+  if (n < 1 || (buf[0] != '0' && buf[0] != '1') ||
+      (n > 1 && buf[1] != '\n'))
+    return -1;
+  bool on = buf[0] == '1';
+  if (on) {
+    scoped_acquire l(&enable_lock);
+    for (int i = 0; i < ncpu; i++) {
+      if (zswap_ctxs[i])
+        continue;
+      zswap_ctxs[i] = (zswap_ctx*)kalloc("zswap_ctx");
+      if (!zswap_ctxs[i])
+        return -1;
+    }
+  }
+  enabled.store(on, std::memory_order_release);
+  return n;
+}
+
+void
+initzswap(void)
+{
+  devsw[MAJ_ZSWAP].write = zswap_write;
+  devsw[MAJ_ZSWAP].pread = zswap_read;
+}
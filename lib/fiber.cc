@@ -0,0 +1,618 @@
+#include "types.h"
+#include "user.h"
+#include "pthread.h"
+#include "futex.h"
+#include "fiber.hh"
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <new>
+
+extern "C" void fiber_swtch(void **oldsp, void *newsp);
+extern "C" void fiber_entry(void);
+extern "C" void fiber_main(fiber::task *t) __attribute__((noreturn));
+
+namespace fiber {
+
+enum { stack_size = 64 * 1024 };
+// Capacity of each worker's deque.  Must be a power of two.
+enum { deque_size = 1024 };
+// Sweeps over the other workers' deques before an idle worker
+// sleeps.
+enum { steal_rounds = 64 };
+// How long a sleeping worker that has fibers waiting for I/O sleeps
+// before polling their files again.
+enum { io_poll_ns = 100000 };
+
+struct task {
+  void *sp;                     // Saved stack pointer when switched out
+  void (*fn)(void*);
+  void *arg;
+  char *stack;
+  task *next;                   // In a semaphore, inject, or free list
+  struct pollfd io;             // While waiting in wait_io
+};
+
+// What a worker does with the task that just switched back to it.
+// The task can't do these itself, since another worker could resume
+// it before it had finished switching out.
+enum class after {
+  ready,                        // Yielded; make it runnable again
+  unlock,                       // Release after_lock; it is on a wait list
+  io,                           // Add it to this worker's I/O waiters
+  exit,                         // It returned; free it
+};
+
+// A Chase-Lev work-stealing deque.  The owning worker pushes and pops
+// at the bottom and other workers steal from the top.
+class deque {
+  std::atomic<long> top_ __mpalign__;
+  std::atomic<long> bottom_ __mpalign__;
+  std::atomic<task*> buf_[deque_size];
+
+public:
+  deque() : top_(0), bottom_(0) { }
+
+  bool push(task *t)
+  {
+    long b = bottom_.load(std::memory_order_relaxed);
+    long tp = top_.load(std::memory_order_acquire);
+    if (b - tp >= deque_size)
+      return false;
+    buf_[b & (deque_size - 1)].store(t, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  task *pop()
+  {
+    long b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long tp = top_.load(std::memory_order_relaxed);
+    if (tp > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    task *t = buf_[b & (deque_size - 1)].load(std::memory_order_relaxed);
+    if (tp == b) {
+      // Last one; race with stealers for it.
+      if (!top_.compare_exchange_strong(tp, tp + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed))
+        t = nullptr;
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return t;
+  }
+
+  task *steal()
+  {
+    long tp = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long b = bottom_.load(std::memory_order_acquire);
+    if (tp >= b)
+      return nullptr;
+    task *t = buf_[tp & (deque_size - 1)].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(tp, tp + 1,
+                                      std::memory_order_seq_cst,
+                                      std::memory_order_relaxed))
+      return nullptr;
+    return t;
+  }
+
+  bool empty() const
+  {
+    return top_.load(std::memory_order_relaxed) >=
+      bottom_.load(std::memory_order_relaxed);
+  }
+};
+
+struct worker {
+  deque runq;
+  int id;
+  pthread_t thread;
+  void *sched_sp;               // Scheduler context
+  task *current;
+  after next;
+  std::atomic<bool> *after_lock;
+  u64 rnd;
+
+  // Tasks that yielded, run once nothing else is runnable here.
+  task *yield_head, *yield_tail;
+
+  // Tasks waiting in wait_io, and the pollfds for them.
+  task **io_tasks;
+  struct pollfd *io_fds;
+  int nio, io_cap;
+};
+
+static struct {
+  worker **workers;
+  char *worker_mem;             // Cache-line aligned storage for workers
+  int nworkers;
+
+  std::atomic<long> live;       // Fibers that have not returned
+  u64 done;                     // Futex word: set when live drops to 0
+  volatile bool stop;
+
+  // Sleeping workers wait on park_seq; waking one bumps it.
+  u64 park_seq __mpalign__;
+  std::atomic<int> idle;
+
+  // Runnable tasks from outside the workers, or from a full deque.
+  pthread_mutex_t inject_lock __mpalign__;
+  task *inject_head, *inject_tail;
+  std::atomic<int> ninject;
+
+  pthread_mutex_t free_lock;
+  task *free_tasks;
+} rt;
+
+static __thread worker *me;
+
+static inline void
+cpu_relax(void)
+{
+  __asm volatile("pause" ::: "memory");
+}
+
+// Fibers migrate between workers, so every use of me after a switch
+// must reload it.  Keeping the load out of line stops the compiler
+// from reusing a value loaded before the switch.
+static __attribute__((noinline)) worker *
+current_worker(void)
+{
+  return me;
+}
+
+static void
+task_init(task *t, void (*fn)(void*), void *arg)
+{
+  t->fn = fn;
+  t->arg = arg;
+  t->next = nullptr;
+
+  // Build the frame fiber_swtch pops: MXCSR and x87 control word,
+  // r15, r14, r13, r12, rbx, rbp, and the return address.  This
+  // leaves the stack 16-byte aligned at fiber_entry, as a call would.
+  uptr top = ((uptr)t->stack + stack_size) & ~(uptr)15;
+  u64 *frame = (u64*)(top - 80);
+  frame[0] = 0x1f80 | ((u64)0x37f << 32);
+  frame[1] = frame[2] = frame[3] = 0;
+  frame[4] = (u64)t;
+  frame[5] = frame[6] = 0;
+  frame[7] = (u64)fiber_entry;
+  t->sp = frame;
+}
+
+static task *
+task_alloc(void (*fn)(void*), void *arg)
+{
+  pthread_mutex_lock(&rt.free_lock);
+  task *t = rt.free_tasks;
+  if (t)
+    rt.free_tasks = t->next;
+  pthread_mutex_unlock(&rt.free_lock);
+
+  if (!t) {
+    t = (task*)malloc(sizeof(*t));
+    if (!t)
+      return nullptr;
+    t->stack = (char*)malloc(stack_size);
+    if (!t->stack) {
+      free(t);
+      return nullptr;
+    }
+  }
+  task_init(t, fn, arg);
+  return t;
+}
+
+static void
+task_free(task *t)
+{
+  pthread_mutex_lock(&rt.free_lock);
+  t->next = rt.free_tasks;
+  rt.free_tasks = t;
+  pthread_mutex_unlock(&rt.free_lock);
+}
+
+static void
+inject(task *t)
+{
+  pthread_mutex_lock(&rt.inject_lock);
+  t->next = nullptr;
+  if (rt.inject_tail)
+    rt.inject_tail->next = t;
+  else
+    rt.inject_head = t;
+  rt.inject_tail = t;
+  rt.ninject++;
+  pthread_mutex_unlock(&rt.inject_lock);
+}
+
+static task *
+take_injected(void)
+{
+  if (rt.ninject.load(std::memory_order_relaxed) == 0)
+    return nullptr;
+  pthread_mutex_lock(&rt.inject_lock);
+  task *t = rt.inject_head;
+  if (t) {
+    rt.inject_head = t->next;
+    if (!rt.inject_head)
+      rt.inject_tail = nullptr;
+    rt.ninject--;
+  }
+  pthread_mutex_unlock(&rt.inject_lock);
+  return t;
+}
+
+// Wake one sleeping worker, if any, after making a task runnable.
+static void
+wake_idle(void)
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (rt.idle.load(std::memory_order_relaxed) == 0)
+    return;
+  __atomic_fetch_add(&rt.park_seq, 1, __ATOMIC_SEQ_CST);
+  futex(&rt.park_seq, FUTEX_WAKE, 1, 0);
+}
+
+static void
+make_ready(task *t)
+{
+  worker *w = current_worker();
+  if (!w || !w->runq.push(t))
+    inject(t);
+  wake_idle();
+}
+
+static task *
+steal_any(worker *w)
+{
+  int n = rt.nworkers;
+  if (n == 1)
+    return nullptr;
+  w->rnd = w->rnd * 6364136223846793005ull + 1442695040888963407ull;
+  int start = (w->rnd >> 33) % n;
+  for (int i = 0; i < n; i++) {
+    worker *v = rt.workers[(start + i) % n];
+    if (v == w)
+      continue;
+    task *t = v->runq.steal();
+    if (t)
+      return t;
+  }
+  return nullptr;
+}
+
+static bool
+work_available(worker *w)
+{
+  if (w->yield_head || rt.ninject.load(std::memory_order_relaxed))
+    return true;
+  for (int i = 0; i < rt.nworkers; i++)
+    if (!rt.workers[i]->runq.empty())
+      return true;
+  return false;
+}
+
+// Check this worker's I/O waiters and make the ready ones runnable.
+static bool
+poll_io(worker *w)
+{
+  if (w->nio == 0 || poll(w->io_fds, w->nio, 0) <= 0)
+    return false;
+  bool any = false;
+  for (int i = 0; i < w->nio; ) {
+    if (w->io_fds[i].revents) {
+      task *t = w->io_tasks[i];
+      t->io.revents = w->io_fds[i].revents;
+      w->nio--;
+      w->io_tasks[i] = w->io_tasks[w->nio];
+      w->io_fds[i] = w->io_fds[w->nio];
+      make_ready(t);
+      any = true;
+    } else {
+      i++;
+    }
+  }
+  return any;
+}
+
+static void
+add_io_waiter(worker *w, task *t)
+{
+  if (w->nio == w->io_cap) {
+    int cap = w->io_cap ? w->io_cap * 2 : 16;
+    task **tasks = (task**)malloc(cap * sizeof(*tasks));
+    struct pollfd *fds = (struct pollfd*)malloc(cap * sizeof(*fds));
+    if (!tasks || !fds)
+      die("fiber: out of memory for I/O waiters");
+    memcpy(tasks, w->io_tasks, w->nio * sizeof(*tasks));
+    memcpy(fds, w->io_fds, w->nio * sizeof(*fds));
+    free(w->io_tasks);
+    free(w->io_fds);
+    w->io_tasks = tasks;
+    w->io_fds = fds;
+    w->io_cap = cap;
+  }
+  w->io_tasks[w->nio] = t;
+  w->io_fds[w->nio] = t->io;
+  w->nio++;
+}
+
+static void
+park(worker *w)
+{
+  u64 seq = __atomic_load_n(&rt.park_seq, __ATOMIC_ACQUIRE);
+  rt.idle.fetch_add(1);
+  // Pairs with wake_idle: either a waker sees us idle and bumps
+  // park_seq, or we see its task here.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!work_available(w) && !rt.stop)
+    futex(&rt.park_seq, FUTEX_WAIT, seq, w->nio ? io_poll_ns : 0);
+  rt.idle.fetch_sub(1);
+}
+
+// Find the next task to run, sleeping if there is none.  Returns
+// null when the runtime is stopping.
+static task *
+find_work(worker *w)
+{
+  for (int round = 0; ; round++) {
+    task *t;
+    if ((t = w->runq.pop()) || (t = take_injected()) || (t = steal_any(w)))
+      return t;
+    if ((t = w->yield_head)) {
+      w->yield_head = t->next;
+      if (!w->yield_head)
+        w->yield_tail = nullptr;
+      return t;
+    }
+    if (poll_io(w))
+      continue;
+    if (rt.stop)
+      return nullptr;
+    if (round < steal_rounds) {
+      cpu_relax();
+      continue;
+    }
+    park(w);
+    round = 0;
+  }
+}
+
+static void
+finish_switch(worker *w, task *t)
+{
+  switch (w->next) {
+  case after::ready:
+    t->next = nullptr;
+    if (w->yield_tail)
+      w->yield_tail->next = t;
+    else
+      w->yield_head = t;
+    w->yield_tail = t;
+    break;
+  case after::unlock:
+    w->after_lock->store(false, std::memory_order_release);
+    break;
+  case after::io:
+    add_io_waiter(w, t);
+    break;
+  case after::exit:
+    task_free(t);
+    if (--rt.live == 0) {
+      __atomic_store_n(&rt.done, 1, __ATOMIC_RELEASE);
+      futex(&rt.done, FUTEX_WAKE, 1, 0);
+    }
+    break;
+  }
+}
+
+static void*
+worker_main(void *arg)
+{
+  worker *w = (worker*)arg;
+  me = w;
+  if (setaffinity(w->id) < 0)
+    die("fiber: setaffinity %d", w->id);
+
+  task *t;
+  while ((t = find_work(w))) {
+    w->current = t;
+    fiber_swtch(&w->sched_sp, t->sp);
+    w->current = nullptr;
+    finish_switch(w, t);
+  }
+  return nullptr;
+}
+
+// Switch from the calling fiber back to its worker's scheduler, which
+// then handles the task as next says.
+static void
+switch_out(after next, std::atomic<bool> *lock = nullptr)
+{
+  worker *w = current_worker();
+  task *t = w->current;
+  w->next = next;
+  w->after_lock = lock;
+  fiber_swtch(&t->sp, w->sched_sp);
+}
+
+int
+run(int nworkers, void (*fn)(void*), void *arg)
+{
+  if (nworkers < 1)
+    return -1;
+
+  pthread_mutex_init(&rt.inject_lock, nullptr);
+  pthread_mutex_init(&rt.free_lock, nullptr);
+  rt.nworkers = nworkers;
+  rt.workers = new worker*[nworkers];
+  // worker is cache-line aligned, which plain new doesn't honor
+  rt.worker_mem = new char[nworkers * sizeof(worker) + CACHELINE];
+  char *mem = rt.worker_mem;
+  mem += CACHELINE - ((uintptr_t)mem & (CACHELINE - 1));
+  for (int i = 0; i < nworkers; i++) {
+    worker *w = new (mem + i * sizeof(worker)) worker();
+    w->id = i;
+    w->rnd = i + 1;
+    rt.workers[i] = w;
+  }
+  rt.stop = false;
+  rt.done = 0;
+  rt.live = 1;
+
+  task *t = task_alloc(fn, arg);
+  if (!t)
+    return -1;
+  inject(t);
+
+  for (int i = 0; i < nworkers; i++)
+    if (xthread_create(&rt.workers[i]->thread, 0, worker_main,
+                       rt.workers[i]) < 0)
+      die("fiber: xthread_create");
+
+  while (__atomic_load_n(&rt.done, __ATOMIC_ACQUIRE) == 0)
+    futex(&rt.done, FUTEX_WAIT, 0, 0);
+
+  rt.stop = true;
+  __atomic_fetch_add(&rt.park_seq, 1, __ATOMIC_SEQ_CST);
+  futex(&rt.park_seq, FUTEX_WAKE, nworkers, 0);
+  for (int i = 0; i < nworkers; i++) {
+    pthread_join(rt.workers[i]->thread, nullptr);
+    free(rt.workers[i]->io_tasks);
+    free(rt.workers[i]->io_fds);
+    rt.workers[i]->~worker();
+  }
+  delete[] rt.worker_mem;
+  delete[] rt.workers;
+  rt.workers = nullptr;
+  return 0;
+}
+
+int
+spawn(void (*fn)(void*), void *arg)
+{
+  task *t = task_alloc(fn, arg);
+  if (!t)
+    return -1;
+  rt.live++;
+  make_ready(t);
+  return 0;
+}
+
+void
+yield()
+{
+  switch_out(after::ready);
+}
+
+int
+worker_id()
+{
+  worker *w = current_worker();
+  return w ? w->id : -1;
+}
+
+int
+wait_io(int fd, int events)
+{
+  task *t = current_worker()->current;
+  t->io.fd = fd;
+  t->io.events = events;
+  t->io.revents = 0;
+  if (poll(&t->io, 1, 0) > 0)
+    return t->io.revents;
+  switch_out(after::io);
+  return t->io.revents;
+}
+
+ssize_t
+read(int fd, void *buf, size_t n)
+{
+  if (wait_io(fd, POLLIN) & POLLNVAL)
+    return -1;
+  return ::read(fd, buf, n);
+}
+
+ssize_t
+write(int fd, const void *buf, size_t n)
+{
+  if (wait_io(fd, POLLOUT) & POLLNVAL)
+    return -1;
+  return ::write(fd, buf, n);
+}
+
+ssize_t
+recvfrom(int sockfd, void *buf, size_t len, int flags,
+         struct sockaddr *src_addr, socklen_t *addrlen)
+{
+  if (wait_io(sockfd, POLLIN) & POLLNVAL)
+    return -1;
+  return ::recvfrom(sockfd, buf, len, flags, src_addr, addrlen);
+}
+
+static void
+spin_lock(std::atomic<bool> *lock)
+{
+  while (lock->exchange(true, std::memory_order_acquire))
+    while (lock->load(std::memory_order_relaxed))
+      cpu_relax();
+}
+
+void
+semaphore::wait()
+{
+  spin_lock(&lock_);
+  if (count_) {
+    count_--;
+    lock_.store(false, std::memory_order_release);
+    return;
+  }
+  task *t = current_worker()->current;
+  t->next = nullptr;
+  if (tail_)
+    tail_->next = t;
+  else
+    head_ = t;
+  tail_ = t;
+  // The scheduler drops lock_ once we've switched out, so post can't
+  // resume us before then.
+  switch_out(after::unlock, &lock_);
+}
+
+void
+semaphore::post()
+{
+  spin_lock(&lock_);
+  task *t = head_;
+  if (t) {
+    head_ = t->next;
+    if (!head_)
+      tail_ = nullptr;
+  } else {
+    count_++;
+  }
+  lock_.store(false, std::memory_order_release);
+  if (t)
+    make_ready(t);
+}
+
+}
+
+void
+fiber_main(fiber::task *t)
+{
+  t->fn(t->arg);
+  fiber::switch_out(fiber::after::exit);
+  __builtin_unreachable();
+}
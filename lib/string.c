@@ -1,8 +1,87 @@
+// String and memory routines.
+//
+// The hot routines work 16 bytes at a time with SSE2, which every
+// x86-64 CPU has.  Large copies are dispatched on what CPUID reports
+// at startup (see __string_init): CPUs with enhanced rep movsb (ERMS)
+// copy mid-sized blocks with rep movsb, and copies too big to stay in
+// the cache use non-temporal stores so they don't evict the working
+// set.  We don't use AVX: the kernel saves only FXSAVE state, so YMM
+// registers wouldn't survive a context switch.
+//
+// Scans that look for a terminating NUL (strlen, strchr) read whole
+// aligned 16-byte blocks, which may extend past the end of the string
+// but never into another page.
+//
+// The kernel also builds this file, with SSE disabled (it doesn't
+// save FPU state on entry), and gets the plain versions instead.
+
 #include "amd64.h"
 
 #include <ctype.h>
 #include <string.h>
 #include <strings.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+enum {
+  // Copies at least this big use rep movsb, if the CPU has ERMS
+  ERMS_THRESHOLD = 2048,
+  // Default for nt_threshold if CPUID doesn't describe the caches
+  NT_THRESHOLD_DEFAULT = 1024 * 1024,
+};
+
+static int have_erms;
+// Copies at least this big use non-temporal stores
+static size_t nt_threshold = NT_THRESHOLD_DEFAULT;
+
+static void
+cpuid_count(uint32_t leaf, uint32_t subleaf, uint32_t r[4])
+{
+  __asm volatile("cpuid"
+                 : "=a" (r[0]), "=b" (r[1]), "=c" (r[2]), "=d" (r[3])
+                 : "a" (leaf), "c" (subleaf));
+}
+
+// Called by __crt_main before anything else runs.  Until then, the
+// routines below stick to SSE2 paths.
+void
+__string_init(void)
+{
+  uint32_t r[4];
+  cpuid_count(0, 0, r);
+  uint32_t maxleaf = r[0];
+
+  if (maxleaf >= 7) {
+    cpuid_count(7, 0, r);
+    have_erms = (r[1] >> 9) & 1;
+  }
+
+  // Size the non-temporal threshold from the largest cache, using
+  // the deterministic cache parameters leaf (Intel), or AMD's
+  // equivalent.
+  uint32_t cacheleaf = 0;
+  if (maxleaf >= 4) {
+    cacheleaf = 4;
+  } else {
+    cpuid_count(0x80000000, 0, r);
+    if (r[0] >= 0x8000001d)
+      cacheleaf = 0x8000001d;
+  }
+  size_t largest = 0;
+  for (uint32_t i = 0; cacheleaf && i < 16; i++) {
+    cpuid_count(cacheleaf, i, r);
+    if ((r[0] & 0x1f) == 0)
+      break;
+    size_t size = (size_t)((r[1] >> 22) + 1) * (((r[1] >> 12) & 0x3ff) + 1) *
+      ((r[1] & 0xfff) + 1) * (r[2] + 1);
+    if (size > largest)
+      largest = size;
+  }
+  // Leave room for the rest of the working set
+  if (largest)
+    nt_threshold = largest * 3 / 4;
+}
 
 void*
 memset(void *dst, int c, size_t n)
@@ -11,6 +90,157 @@ memset(void *dst, int c, size_t n)
   return dst;
 }
 
+#ifdef __SSE2__
+int
+memcmp(const void* s1, const void* s2, size_t n)
+{
+  const uint8_t* p1 = s1;
+  const uint8_t* p2 = s2;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(p1 + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(p2 + i));
+    unsigned diff = _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) ^ 0xffff;
+    if (diff) {
+      i += __builtin_ctz(diff);
+      return p1[i] - p2[i];
+    }
+  }
+  for (; i < n; i++)
+    if (p1[i] != p2[i])
+      return p1[i] - p2[i];
+  return 0;
+}
+
+// Copy n <= 64 bytes.  Everything is loaded before anything is
+// stored, so this is safe for overlapping buffers.
+static inline void
+copy_small(char *d, const char *s, size_t n)
+{
+  if (n >= 32) {
+    __m128i a = _mm_loadu_si128((const __m128i*)s);
+    __m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+    __m128i c = _mm_loadu_si128((const __m128i*)(s + n - 32));
+    __m128i e = _mm_loadu_si128((const __m128i*)(s + n - 16));
+    _mm_storeu_si128((__m128i*)d, a);
+    _mm_storeu_si128((__m128i*)(d + 16), b);
+    _mm_storeu_si128((__m128i*)(d + n - 32), c);
+    _mm_storeu_si128((__m128i*)(d + n - 16), e);
+  } else if (n >= 16) {
+    __m128i a = _mm_loadu_si128((const __m128i*)s);
+    __m128i b = _mm_loadu_si128((const __m128i*)(s + n - 16));
+    _mm_storeu_si128((__m128i*)d, a);
+    _mm_storeu_si128((__m128i*)(d + n - 16), b);
+  } else if (n >= 8) {
+    uint64_t a = *(const uint64_t*)s, b = *(const uint64_t*)(s + n - 8);
+    *(uint64_t*)d = a;
+    *(uint64_t*)(d + n - 8) = b;
+  } else if (n >= 4) {
+    uint32_t a = *(const uint32_t*)s, b = *(const uint32_t*)(s + n - 4);
+    *(uint32_t*)d = a;
+    *(uint32_t*)(d + n - 4) = b;
+  } else if (n) {
+    // 1 to 3 bytes
+    uint8_t a = s[0], b = s[n / 2], c = s[n - 1];
+    d[0] = a;
+    d[n / 2] = b;
+    d[n - 1] = c;
+  }
+}
+
+// Copy n > 64 bytes, low addresses first, with stores aligned to 16
+// bytes.  Safe if d <= s, even if the buffers overlap.  The unaligned
+// head and tail are loaded up front and stored last.
+static void
+copy_fwd(char *d, const char *s, size_t n, int nt)
+{
+  __m128i head = _mm_loadu_si128((const __m128i*)s);
+  __m128i tail = _mm_loadu_si128((const __m128i*)(s + n - 16));
+  char *end = d + n - 16;
+  size_t skew = 16 - ((uintptr_t)d & 15);
+  char *dp = d + skew;
+  const char *sp = s + skew;
+
+  if (nt) {
+    for (; dp + 64 <= end; dp += 64, sp += 64) {
+      __m128i a = _mm_loadu_si128((const __m128i*)sp);
+      __m128i b = _mm_loadu_si128((const __m128i*)(sp + 16));
+      __m128i c = _mm_loadu_si128((const __m128i*)(sp + 32));
+      __m128i e = _mm_loadu_si128((const __m128i*)(sp + 48));
+      _mm_stream_si128((__m128i*)dp, a);
+      _mm_stream_si128((__m128i*)(dp + 16), b);
+      _mm_stream_si128((__m128i*)(dp + 32), c);
+      _mm_stream_si128((__m128i*)(dp + 48), e);
+    }
+    // Order the streaming stores before anything that follows
+    _mm_sfence();
+  }
+  for (; dp + 64 <= end; dp += 64, sp += 64) {
+    __m128i a = _mm_loadu_si128((const __m128i*)sp);
+    __m128i b = _mm_loadu_si128((const __m128i*)(sp + 16));
+    __m128i c = _mm_loadu_si128((const __m128i*)(sp + 32));
+    __m128i e = _mm_loadu_si128((const __m128i*)(sp + 48));
+    _mm_store_si128((__m128i*)dp, a);
+    _mm_store_si128((__m128i*)(dp + 16), b);
+    _mm_store_si128((__m128i*)(dp + 32), c);
+    _mm_store_si128((__m128i*)(dp + 48), e);
+  }
+  for (; dp < end; dp += 16, sp += 16)
+    _mm_store_si128((__m128i*)dp, _mm_loadu_si128((const __m128i*)sp));
+  _mm_storeu_si128((__m128i*)end, tail);
+  _mm_storeu_si128((__m128i*)d, head);
+}
+
+// Like copy_fwd, but high addresses first, so it is safe if d >= s.
+static void
+copy_bwd(char *d, const char *s, size_t n)
+{
+  __m128i head = _mm_loadu_si128((const __m128i*)s);
+  __m128i tail = _mm_loadu_si128((const __m128i*)(s + n - 16));
+  size_t skew = (uintptr_t)(d + n) & 15;
+  char *dp = d + n - skew;
+  const char *sp = s + n - skew;
+
+  for (; dp - 64 >= d + 16; dp -= 64, sp -= 64) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(sp - 16));
+    __m128i b = _mm_loadu_si128((const __m128i*)(sp - 32));
+    __m128i c = _mm_loadu_si128((const __m128i*)(sp - 48));
+    __m128i e = _mm_loadu_si128((const __m128i*)(sp - 64));
+    _mm_store_si128((__m128i*)(dp - 16), a);
+    _mm_store_si128((__m128i*)(dp - 32), b);
+    _mm_store_si128((__m128i*)(dp - 48), c);
+    _mm_store_si128((__m128i*)(dp - 64), e);
+  }
+  for (; dp - 16 > d; dp -= 16, sp -= 16)
+    _mm_store_si128((__m128i*)(dp - 16),
+                    _mm_loadu_si128((const __m128i*)(sp - 16)));
+  _mm_storeu_si128((__m128i*)d, head);
+  _mm_storeu_si128((__m128i*)(d + n - 16), tail);
+}
+
+void *
+memmove(void *dst, const void *src, size_t n)
+{
+  char *d = dst;
+  const char *s = src;
+
+  if (n <= 64) {
+    copy_small(d, s, n);
+  } else if ((size_t)(d - s) >= n) {
+    // d is below s or past the end of s (the subtraction is
+    // unsigned), so a forward copy is safe
+    int overlap = (size_t)(s - d) < n;
+    if (have_erms && !overlap && n >= ERMS_THRESHOLD && n < nt_threshold)
+      __asm volatile("cld; rep movsb\n"
+                     : "+D" (d), "+S" (s), "+c" (n) :: "cc", "memory");
+    else
+      copy_fwd(d, s, n, !overlap && n >= nt_threshold);
+  } else {
+    copy_bwd(d, s, n);
+  }
+  return dst;
+}
+#else
 int
 memcmp(const void* s1, const void* s2, size_t n)
 {
@@ -51,6 +281,7 @@ memmove(void *dst, const void *src, size_t n)
   }
   return dst;
 }
+#endif
 
 // memcpy exists to placate GCC.  Use memmove.
 void*
@@ -68,9 +299,24 @@ mempcpy(void *dst, const void *src, size_t n)
 void*
 memchr(const void *s, int c, size_t n)
 {
+#ifdef __SSE2__
+  const unsigned char *p = s;
+  __m128i needle = _mm_set1_epi8((char)c);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+    unsigned m = _mm_movemask_epi8(_mm_cmpeq_epi8(a, needle));
+    if (m)
+      return (void*)(p + i + __builtin_ctz(m));
+  }
+  for (; i < n; ++i)
+    if (p[i] == (unsigned char)c)
+      return (void*)&p[i];
+#else
   for (size_t i = 0; i < n; ++i)
     if (((unsigned char*)s)[i] == c)
       return &((unsigned char*)s)[i];
+#endif
   return NULL;
 }
 
@@ -117,6 +363,80 @@ strcpy(char *s, const char *t)
   return os;
 }
 
+#ifdef __SSE2__
+char*
+strchr(const char *s, int c)
+{
+  __m128i needle = _mm_set1_epi8((char)c), zero = _mm_setzero_si128();
+  const char *p = (const char*)((uintptr_t)s & ~15);
+  // Ignore matches before s in the first block
+  unsigned skip = (uintptr_t)s & 15;
+  for (;;) {
+    __m128i a = _mm_load_si128((const __m128i*)p);
+    unsigned m = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(a, needle),
+                                                _mm_cmpeq_epi8(a, zero)));
+    m = (m >> skip) << skip;
+    if (m) {
+      p += __builtin_ctz(m);
+      return *p == (char)c ? (char*)p : 0;
+    }
+    p += 16;
+    skip = 0;
+  }
+}
+
+size_t
+strlen(const char *s)
+{
+  __m128i zero = _mm_setzero_si128();
+  const char *p = (const char*)((uintptr_t)s & ~15);
+  unsigned skip = (uintptr_t)s & 15;
+  unsigned m = _mm_movemask_epi8(
+    _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)p), zero)) >> skip;
+  if (m)
+    return __builtin_ctz(m);
+  for (;;) {
+    p += 16;
+    m = _mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)p), zero));
+    if (m)
+      return p + __builtin_ctz(m) - s;
+  }
+}
+
+// True if an unaligned 16-byte load from p would cross into the next
+// page, which might not be mapped.
+static inline int
+near_page_end(const char *p)
+{
+  return ((uintptr_t)p & 4095) > 4096 - 16;
+}
+
+int
+strcmp(const char *p, const char *q)
+{
+  __m128i zero = _mm_setzero_si128();
+  for (;;) {
+    if (near_page_end(p) || near_page_end(q)) {
+      // Step bytewise until both are clear of the page end
+      for (int i = 0; i < 16; i++, p++, q++)
+        if (!*p || *p != *q)
+          return (uint8_t)*p - (uint8_t)*q;
+      continue;
+    }
+    __m128i a = _mm_loadu_si128((const __m128i*)p);
+    __m128i b = _mm_loadu_si128((const __m128i*)q);
+    unsigned m = (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) ^ 0xffff) |
+      _mm_movemask_epi8(_mm_cmpeq_epi8(a, zero));
+    if (m) {
+      int i = __builtin_ctz(m);
+      return (uint8_t)p[i] - (uint8_t)q[i];
+    }
+    p += 16;
+    q += 16;
+  }
+}
+#else
 char*
 strchr(const char *s, int c)
 {
@@ -143,6 +463,7 @@ strcmp(const char *p, const char *q)
     p++, q++;
   return (uint8_t)*p - (uint8_t)*q;
 }
+#endif
 
 char*
 strstr(const char *str, const char *needle) 
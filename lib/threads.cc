@@ -1,12 +1,16 @@
 #include "types.h"
 #include "pthread.h"
 #include "user.h"
+#include "futex.h"
+#include "errno.h"
 #include <atomic>
 #include "elfuser.hh"
 #include <unistd.h>
 #include <sched.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 enum { stack_size = 8192 };
 static std::atomic<int> nextkey;
@@ -18,95 +22,198 @@ struct tlsdata {
   void* buf[max_keys];
 };
 
-void
-forkt_setup(u64 pid)
-{
-  static size_t memsz;
-  static size_t filesz;
-  static size_t align;
-  static void* initimage;
+static struct {
+  size_t memsz;
+  size_t filesz;
+  size_t align;
+  void* initimage;
+  bool found;
+} tls_image;
 
-  if (initimage == 0 && _dl_phdr) {
+// Size of a thread's TLS block: the ELF TLS image followed by our
+// tlsdata.
+static size_t
+tls_size(void)
+{
+  if (!tls_image.found && _dl_phdr) {
     for (proghdr* p = _dl_phdr; p < &_dl_phdr[_dl_phnum]; p++) {
       if (p->type == ELF_PROG_TLS) {
-        memsz = p->memsz;
-        filesz = p->filesz;
-        initimage = (void *) p->vaddr;
-        align = p->align;
+        tls_image.memsz = p->memsz;
+        tls_image.filesz = p->filesz;
+        tls_image.initimage = (void *) p->vaddr;
+        tls_image.align = p->align;
         break;
       }
     }
+    tls_image.found = true;
   }
 
-  u64 memsz_align = (memsz+align-1) & ~(align-1);
-
-  s64 tptr = (s64) sbrk(sizeof(tlsdata) + memsz_align);
-  assert(tptr != -1);
+  size_t align = tls_image.align ? tls_image.align : 1;
+  return ((tls_image.memsz+align-1) & ~(align-1)) + sizeof(tlsdata);
+}
 
-  memcpy((void*)tptr, initimage, filesz);
-  tlsdata* t = (tlsdata*) (tptr + memsz_align);
+// Initialize a TLS block, which may have been used by an earlier
+// thread, and switch the calling thread to it.
+static void
+tls_setup(char* block)
+{
+  size_t size = tls_size();
+  memcpy(block, tls_image.initimage, tls_image.filesz);
+  memset(block + tls_image.filesz, 0, size - tls_image.filesz);
+  tlsdata* t = (tlsdata*) (block + size - sizeof(tlsdata));
   t->tlsptr[0] = t;
   setfs((u64) t);
 }
 
-int
-pthread_create(pthread_t* tid, const pthread_attr_t* attr,
-               void* (*start)(void*), void* arg)
+void
+forkt_setup(u64 pid)
+{
+  char* block = (char*) sbrk(tls_size());
+  assert(block != (char*)-1);
+  tls_setup(block);
+}
+
+// A library thread.  Its stack and TLS block are allocated together
+// and reused once the thread has been joined.  tid is the futex word
+// the kernel zeroes when the thread exits (see sys_fork_thread).
+struct uthread {
+  u64 tid;
+  pthread_t id;
+  void* (*start)(void*);
+  void* arg;
+  void* retval;
+  char* stack;                  // Top of stack
+  char* tls;
+  uthread* next;                // In threads.hash or threads.free
+};
+
+enum { thread_buckets = 64 };
+
+static struct {
+  pthread_mutex_t lock;
+  uthread* hash[thread_buckets]; // Unjoined threads by tid
+  uthread* free;
+} threads = { PTHREAD_MUTEX_INITIALIZER };
+
+static __thread uthread* self;
+
+static uthread*
+thread_alloc(void)
 {
-  char* base = (char*) sbrk(stack_size);
-  assert(base != (char*)-1);
-  int t = forkt(base + stack_size, (void*) start, arg, FORK_SHARE_VMAP | FORK_SHARE_FD);
-  if (t < 0)
+  pthread_mutex_lock(&threads.lock);
+  uthread* t = threads.free;
+  if (t)
+    threads.free = t->next;
+  pthread_mutex_unlock(&threads.lock);
+  if (t)
     return t;
 
-  *tid = t;
+  char* base = (char*) sbrk(stack_size + sizeof(uthread) + tls_size());
+  if (base == (char*)-1)
+    return nullptr;
+  t = (uthread*) (base + stack_size);
+  t->stack = base + stack_size;
+  t->tls = (char*) (t + 1);
+  return t;
+}
+
+static void
+thread_free(uthread* t)
+{
+  pthread_mutex_lock(&threads.lock);
+  t->next = threads.free;
+  threads.free = t;
+  pthread_mutex_unlock(&threads.lock);
+}
+
+static void
+thread_start(void* arg)
+{
+  uthread* t = (uthread*) arg;
+  tls_setup(t->tls);
+  self = t;
+  pthread_exit(t->start(t->arg));
+}
+
+static int
+thread_create(pthread_t* tid, void* (*start)(void*), void* arg, int flags)
+{
+  uthread* t = thread_alloc();
+  if (!t)
+    return -1;
+  t->start = start;
+  t->arg = arg;
+  t->retval = nullptr;
+
+  int r = forkt(t->stack, (void*) thread_start, t, flags, &t->tid);
+  if (r < 0) {
+    thread_free(t);
+    return r;
+  }
+
+  t->id = r;
+  pthread_mutex_lock(&threads.lock);
+  t->next = threads.hash[(unsigned)r % thread_buckets];
+  threads.hash[(unsigned)r % thread_buckets] = t;
+  pthread_mutex_unlock(&threads.lock);
+
+  *tid = r;
   return 0;
 }
 
+int
+pthread_create(pthread_t* tid, const pthread_attr_t* attr,
+               void* (*start)(void*), void* arg)
+{
+  return thread_create(tid, start, arg, FORK_SHARE_VMAP | FORK_SHARE_FD);
+}
+
 int
 pthread_createflags(pthread_t* tid, const pthread_attr_t* attr,
                     void* (*start)(void*), void* arg, int flag)
 {
-  char* base = (char*) sbrk(stack_size);
-  assert(base != (char*)-1);
-  int t = forkt(base + stack_size, (void*) start, arg, FORK_SHARE_VMAP);
-  if (t < 0)
-    return t;
-
-  *tid = t;
-  return 0;
+  return thread_create(tid, start, arg, FORK_SHARE_VMAP);
 }
 
 int
 xthread_create(pthread_t* tid, int flags,
                void* (*start)(void*), void* arg)
 {
-  char* base = (char*) sbrk(stack_size);
-  assert(base != (char*)-1);
-  int t = forkt(base + stack_size, (void*) start, arg,
-                FORK_SHARE_VMAP | FORK_SHARE_FD | flags);
-  if (t < 0)
-    return t;
-
-  *tid = t;
-  return 0;
+  return thread_create(tid, start, arg,
+                       FORK_SHARE_VMAP | FORK_SHARE_FD | flags);
 }
 
 void
 pthread_exit(void* retval)
 {
+  if (self)
+    self->retval = retval;
   exit(0);
 }
 
 int
 pthread_join(pthread_t tid, void** retval)
 {
-  if (retval) {
-    printf("XXX join retval\n");
-    *retval = 0;
-  }
+  uthread* t;
+  pthread_mutex_lock(&threads.lock);
+  uthread** pp = &threads.hash[(unsigned)tid % thread_buckets];
+  while ((t = *pp) && t->id != tid)
+    pp = &t->next;
+  if (t)
+    *pp = t->next;
+  pthread_mutex_unlock(&threads.lock);
+  if (!t)
+    return ESRCH;
+
+  // The kernel zeroes tid after the thread has left user space for
+  // good, so it's then safe to reuse its stack.
+  u64 v;
+  while ((v = __atomic_load_n(&t->tid, __ATOMIC_ACQUIRE)) != 0)
+    futex(&t->tid, FUTEX_WAIT, v, 0);
 
-  waitpid(tid, NULL,0);
+  if (retval)
+    *retval = t->retval;
+  thread_free(t);
   return 0;
 }
 
@@ -144,47 +251,542 @@ pthread_setspecific(pthread_key_t key, void* value)
 }
 
 int
-pthread_barrier_init(pthread_barrier_t *b,
-                     const pthread_barrierattr_t *attr, unsigned count)
+sched_setaffinity(int pid, size_t cpusetsize, cpu_set_t *mask)
+{
+  assert(!mask->empty_flag);
+  return setaffinity(mask->the_cpu);
+}
+
+//
+// Futex-based mutexes, condition variables, and reader-writer locks
+//
+
+// How many times to poll a held lock before sleeping on it.  This
+// covers short critical sections whose holder is running, without
+// burning a quantum when the holder has been descheduled.
+enum { spin_budget = 128 };
+
+static inline void
+cpu_relax(void)
 {
-  b->store(count);
+  __asm volatile("pause" ::: "memory");
+}
+
+static inline bool
+cas(unsigned long *p, unsigned long expected, unsigned long desired)
+{
+  return __atomic_compare_exchange_n(p, &expected, desired, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+// Convert an absolute CLOCK_REALTIME deadline into a relative futex
+// timeout.  Returns false if the deadline has passed.  A null abstime
+// means wait forever, which sys_futex spells as 0.
+static bool
+futex_timeout(const struct timespec *abstime, u64 *timeout)
+{
+  if (!abstime) {
+    *timeout = 0;
+    return true;
+  }
+  u64 deadline = (u64)abstime->tv_sec * 1000000000 + abstime->tv_nsec;
+  u64 now = time_nsec();
+  if (now >= deadline)
+    return false;
+  *timeout = deadline - now;
+  return true;
+}
+
+static inline void
+futex_wait(unsigned long *word, unsigned long val, u64 timeout)
+{
+  futex((u64*)word, FUTEX_WAIT, val, timeout);
+}
+
+static inline void
+futex_wake(unsigned long *word, u64 n)
+{
+  futex((u64*)word, FUTEX_WAKE, n, 0);
+}
+
+int       
+pthread_mutex_init(pthread_mutex_t *mutex, const pthread_mutexattr_t *attr)
+{
+  mutex->state = 0;
   return 0;
 }
 
 int
-pthread_barrier_wait(pthread_barrier_t *b)
+pthread_mutex_destroy(pthread_mutex_t *mutex)
 {
-  (*b)--;
-  while (*b != 0)
-    ;   // spin
-  return 0;
+  return mutex->state ? EBUSY : 0;
 }
 
 int
-sched_setaffinity(int pid, size_t cpusetsize, cpu_set_t *mask)
+pthread_mutex_trylock(pthread_mutex_t *mutex)
 {
-  assert(!mask->empty_flag);
-  return setaffinity(mask->the_cpu);
+  return cas(&mutex->state, 0, 1) ? 0 : EBUSY;
 }
 
-int       
-pthread_mutex_init(pthread_mutex_t *mutex, const pthread_mutexattr_t *attr)
+// Acquire mutex, leaving it in the contended state.  This is for
+// callers that know others may be sleeping on it, such as waiters
+// woken from a condition variable.
+static int
+mutex_lock_contended(pthread_mutex_t *mutex, const struct timespec *abstime)
 {
-  *mutex = 0;
+  while (__atomic_exchange_n(&mutex->state, 2, __ATOMIC_ACQUIRE) != 0) {
+    u64 timeout;
+    if (!futex_timeout(abstime, &timeout))
+      return ETIMEDOUT;
+    futex_wait(&mutex->state, 2, timeout);
+  }
   return 0;
 }
 
+static int
+mutex_lock(pthread_mutex_t *mutex, const struct timespec *abstime)
+{
+  if (cas(&mutex->state, 0, 1))
+    return 0;
+
+  for (int i = 0; i < spin_budget; i++) {
+    unsigned long s = __atomic_load_n(&mutex->state, __ATOMIC_RELAXED);
+    if (s == 0 && cas(&mutex->state, 0, 1))
+      return 0;
+    if (s == 2)
+      // Others are already sleeping; don't jump the queue
+      break;
+    cpu_relax();
+  }
+
+  return mutex_lock_contended(mutex, abstime);
+}
+
 int 
 pthread_mutex_lock(pthread_mutex_t *mutex)
 {
-  while(!__sync_bool_compare_and_swap(mutex, 0, 1)) ;
-  return 0;
+  return mutex_lock(mutex, nullptr);
+}
+
+int
+pthread_mutex_timedlock(pthread_mutex_t *mutex,
+                        const struct timespec *abstime)
+{
+  return mutex_lock(mutex, abstime);
 }
 
 int 
 pthread_mutex_unlock(pthread_mutex_t *mutex)
 {
-  int b = __sync_bool_compare_and_swap(mutex, 1, 0);
-  return !b;
+  unsigned long s = __atomic_exchange_n(&mutex->state, 0, __ATOMIC_RELEASE);
+  if (s == 0)
+    return EINVAL;
+  if (s == 2)
+    futex_wake(&mutex->state, 1);
+  return 0;
 }
 
+int
+pthread_cond_init(pthread_cond_t *cond, const pthread_condattr_t *attr)
+{
+  cond->seq = 0;
+  cond->waiters = 0;
+  return 0;
+}
+
+int
+pthread_cond_destroy(pthread_cond_t *cond)
+{
+  return cond->waiters ? EBUSY : 0;
+}
+
+int
+pthread_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                       const struct timespec *abstime)
+{
+  // Sample seq while holding mutex, so a signal issued after we
+  // release mutex changes seq and the futex wait won't sleep.
+  unsigned long seq = __atomic_load_n(&cond->seq, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&cond->waiters, 1, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(mutex);
+
+  int r = 0;
+  u64 timeout;
+  if (!futex_timeout(abstime, &timeout))
+    r = ETIMEDOUT;
+  else
+    futex_wait(&cond->seq, seq, timeout);
+
+  __atomic_fetch_sub(&cond->waiters, 1, __ATOMIC_RELAXED);
+  if (r == 0 && abstime &&
+      __atomic_load_n(&cond->seq, __ATOMIC_RELAXED) == seq &&
+      !futex_timeout(abstime, &timeout))
+    r = ETIMEDOUT;
+
+  // Other waiters may have been woken with us, so take the mutex in
+  // the contended state to make sure our unlock passes it along.
+  mutex_lock_contended(mutex, nullptr);
+  return r;
+}
+
+int
+pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex)
+{
+  return pthread_cond_timedwait(cond, mutex, nullptr);
+}
+
+int
+pthread_cond_signal(pthread_cond_t *cond)
+{
+  __atomic_fetch_add(&cond->seq, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&cond->waiters, __ATOMIC_SEQ_CST))
+    futex_wake(&cond->seq, 1);
+  return 0;
+}
+
+int
+pthread_cond_broadcast(pthread_cond_t *cond)
+{
+  __atomic_fetch_add(&cond->seq, 1, __ATOMIC_SEQ_CST);
+  unsigned long n = __atomic_load_n(&cond->waiters, __ATOMIC_SEQ_CST);
+  if (n)
+    futex_wake(&cond->seq, n);
+  return 0;
+}
+
+// rwlock state bits.  The low bits count readers.
+enum : unsigned long {
+  rw_writer = 1ul << 62,
+  rw_sleepers = 1ul << 63,
+};
+
+int
+pthread_rwlock_init(pthread_rwlock_t *rwlock, const pthread_rwlockattr_t *attr)
+{
+  rwlock->state = 0;
+  rwlock->writers = 0;
+  return 0;
+}
+
+int
+pthread_rwlock_destroy(pthread_rwlock_t *rwlock)
+{
+  return (rwlock->state & ~rw_sleepers) ? EBUSY : 0;
+}
+
+// Sleep until rwlock->state changes from s, first marking that there
+// are sleepers so the releaser will wake us.
+static int
+rwlock_sleep(pthread_rwlock_t *rwlock, unsigned long s,
+             const struct timespec *abstime)
+{
+  u64 timeout;
+  if (!futex_timeout(abstime, &timeout))
+    return ETIMEDOUT;
+  if (!(s & rw_sleepers) && !cas(&rwlock->state, s, s | rw_sleepers))
+    return 0;
+  futex_wait(&rwlock->state, s | rw_sleepers, timeout);
+  return 0;
+}
+
+int
+pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
+{
+  unsigned long s = __atomic_load_n(&rwlock->state, __ATOMIC_RELAXED);
+  while (!(s & rw_writer) &&
+         !__atomic_load_n(&rwlock->writers, __ATOMIC_RELAXED)) {
+    if (__atomic_compare_exchange_n(&rwlock->state, &s, s + 1, true,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return 0;
+  }
+  return EBUSY;
+}
+
+static int
+rwlock_rdlock(pthread_rwlock_t *rwlock, const struct timespec *abstime)
+{
+  for (int i = 0; ; i++) {
+    if (pthread_rwlock_tryrdlock(rwlock) == 0)
+      return 0;
+    if (i < spin_budget) {
+      cpu_relax();
+      continue;
+    }
+    unsigned long s = __atomic_load_n(&rwlock->state, __ATOMIC_RELAXED);
+    if (!(s & rw_writer) &&
+        !__atomic_load_n(&rwlock->writers, __ATOMIC_RELAXED))
+      continue;
+    int r = rwlock_sleep(rwlock, s, abstime);
+    if (r)
+      return r;
+  }
+}
+
+int
+pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
+{
+  return rwlock_rdlock(rwlock, nullptr);
+}
+
+int
+pthread_rwlock_timedrdlock(pthread_rwlock_t *rwlock,
+                           const struct timespec *abstime)
+{
+  return rwlock_rdlock(rwlock, abstime);
+}
+
+int
+pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
+{
+  unsigned long s = __atomic_load_n(&rwlock->state, __ATOMIC_RELAXED);
+  while (!(s & ~rw_sleepers)) {
+    if (__atomic_compare_exchange_n(&rwlock->state, &s, s | rw_writer, true,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return 0;
+  }
+  return EBUSY;
+}
+
+static int
+rwlock_wrlock(pthread_rwlock_t *rwlock, const struct timespec *abstime)
+{
+  // Announce ourselves so new readers hold off and we can't starve
+  __atomic_fetch_add(&rwlock->writers, 1, __ATOMIC_SEQ_CST);
+  int r = 0;
+  for (int i = 0; ; i++) {
+    if (pthread_rwlock_trywrlock(rwlock) == 0)
+      break;
+    if (i < spin_budget) {
+      cpu_relax();
+      continue;
+    }
+    unsigned long s = __atomic_load_n(&rwlock->state, __ATOMIC_RELAXED);
+    if (!(s & ~rw_sleepers))
+      continue;
+    if ((r = rwlock_sleep(rwlock, s, abstime)))
+      break;
+  }
+  if (__atomic_sub_fetch(&rwlock->writers, 1, __ATOMIC_SEQ_CST) == 0 && r) {
+    // Readers may be sleeping only because of us
+    unsigned long s = __atomic_load_n(&rwlock->state, __ATOMIC_RELAXED);
+    if ((s & rw_sleepers) && cas(&rwlock->state, s, s & ~rw_sleepers))
+      futex_wake(&rwlock->state, ~0ull >> 1);
+  }
+  return r;
+}
+
+int
+pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
+{
+  return rwlock_wrlock(rwlock, nullptr);
+}
+
+int
+pthread_rwlock_timedwrlock(pthread_rwlock_t *rwlock,
+                           const struct timespec *abstime)
+{
+  return rwlock_wrlock(rwlock, abstime);
+}
+
+int
+pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
+{
+  unsigned long s = __atomic_load_n(&rwlock->state, __ATOMIC_RELAXED);
+  for (;;) {
+    unsigned long ns;
+    if (s & rw_writer)
+      ns = s & ~rw_writer;
+    else if (s & ~rw_sleepers)
+      ns = s - 1;
+    else
+      return EINVAL;
+    // The last holder out clears the sleepers bit and wakes everyone
+    // to race for the lock again.
+    if (!(ns & ~rw_sleepers))
+      ns = 0;
+    if (__atomic_compare_exchange_n(&rwlock->state, &s, ns, true,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+      if (ns == 0 && (s & rw_sleepers))
+        futex_wake(&rwlock->state, ~0ull >> 1);
+      return 0;
+    }
+  }
+}
+
+//
+// Barriers
+//
+
+// Barrier waiters poll longer than lock waiters before sleeping,
+// since arrival skew between threads is usually larger than a
+// critical section.
+enum { barrier_spin_budget = 4096 };
+// Arrivals combined by each tree node.
+enum { barrier_fanin = 4 };
+
+// A combining tree node.  Leaves take arrivals from threads and pack
+// the low bits of gen into their state alongside the arrival count, so
+// a thread probing for a leaf with room can't count against a leaf
+// that has not been reset since the last round.  Interior nodes take
+// arrivals from the last thread through each child and are reset by
+// the last thread through them, before the barrier can open again.
+struct __pthread_barrier_node {
+  unsigned long state;
+  unsigned capacity;
+  int parent;
+} __mpalign__;
+
+typedef struct __pthread_barrier_node barrier_node;
+
+int
+pthread_barrier_init(pthread_barrier_t *b,
+                     const pthread_barrierattr_t *attr, unsigned count)
+{
+  if (count == 0)
+    return EINVAL;
+  b->gen = 0;
+  b->sleepers = 0;
+  b->arrived = 0;
+  b->count = count;
+  b->nleaves = 0;
+  b->nodes = nullptr;
+  b->alloc = nullptr;
+  if (count <= PTHREAD_BARRIER_TREE_MIN)
+    return 0;
+
+  unsigned nleaves = (count + barrier_fanin - 1) / barrier_fanin;
+  unsigned nnodes = 0;
+  for (unsigned n = nleaves; ; n = (n + barrier_fanin - 1) / barrier_fanin) {
+    nnodes += n;
+    if (n == 1)
+      break;
+  }
+
+  void *alloc = malloc((nnodes + 1) * sizeof(barrier_node));
+  if (!alloc)
+    return ENOMEM;
+  barrier_node *nodes = (barrier_node*)
+    (((uptr)alloc + CACHELINE - 1) & ~(uptr)(CACHELINE - 1));
+
+  // Leaves split count as evenly as possible.  Each level above has
+  // one node per barrier_fanin nodes of the level below.
+  for (unsigned i = 0; i < nleaves; i++) {
+    nodes[i].state = 0;
+    nodes[i].capacity = count / nleaves + (i < count % nleaves);
+  }
+  unsigned lo = 0, n = nleaves;
+  while (n > 1) {
+    unsigned up = lo + n;
+    unsigned nup = (n + barrier_fanin - 1) / barrier_fanin;
+    for (unsigned i = 0; i < nup; i++) {
+      nodes[up + i].state = 0;
+      nodes[up + i].capacity = 0;
+    }
+    for (unsigned i = 0; i < n; i++) {
+      nodes[lo + i].parent = up + i / barrier_fanin;
+      nodes[up + i / barrier_fanin].capacity++;
+    }
+    lo = up;
+    n = nup;
+  }
+  nodes[lo].parent = -1;
+
+  b->nleaves = nleaves;
+  b->nodes = nodes;
+  b->alloc = alloc;
+  return 0;
+}
+
+int
+pthread_barrier_destroy(pthread_barrier_t *b)
+{
+  free(b->alloc);
+  b->alloc = nullptr;
+  b->nodes = nullptr;
+  return 0;
+}
+
+// Wait for the barrier to open from generation g.
+static void
+barrier_sleep(pthread_barrier_t *b, unsigned long g)
+{
+  for (int i = 0; i < barrier_spin_budget; i++) {
+    if (__atomic_load_n(&b->gen, __ATOMIC_ACQUIRE) != g)
+      return;
+    cpu_relax();
+  }
+
+  // Pairs with barrier_open: either the opener sees our sleepers
+  // count and wakes us, or we see its new gen and don't sleep.
+  __atomic_fetch_add(&b->sleepers, 1, __ATOMIC_SEQ_CST);
+  while (__atomic_load_n(&b->gen, __ATOMIC_SEQ_CST) == g)
+    futex_wait(&b->gen, g, 0);
+  __atomic_fetch_sub(&b->sleepers, 1, __ATOMIC_RELAXED);
+}
+
+static void
+barrier_open(pthread_barrier_t *b, unsigned long g)
+{
+  __atomic_store_n(&b->gen, g + 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&b->sleepers, __ATOMIC_SEQ_CST))
+    futex_wake(&b->gen, b->count);
+}
+
+// Arrive at a leaf, starting from one picked by thread ID and probing
+// past full leaves.  Sets *last if this filled the leaf.
+static barrier_node *
+barrier_arrive_leaf(pthread_barrier_t *b, unsigned long g, bool *last)
+{
+  unsigned long tag = (g & 0xffffffff) << 32;
+  unsigned i = (unsigned)pthread_self() % b->nleaves;
+  for (;;) {
+    barrier_node *leaf = &b->nodes[i];
+    unsigned long s = __atomic_load_n(&leaf->state, __ATOMIC_RELAXED);
+    for (;;) {
+      unsigned n = (s & ~0xfffffffful) == tag ? (unsigned)s : 0;
+      if (n == leaf->capacity)
+        break;
+      if (__atomic_compare_exchange_n(&leaf->state, &s, tag | (n + 1), true,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        *last = (n + 1 == leaf->capacity);
+        return leaf;
+      }
+    }
+    if (++i == b->nleaves)
+      i = 0;
+  }
+}
+
+int
+pthread_barrier_wait(pthread_barrier_t *b)
+{
+  // The barrier can't open again until we arrive, so this is the
+  // generation we are arriving in.
+  unsigned long g = __atomic_load_n(&b->gen, __ATOMIC_ACQUIRE);
+
+  if (!b->nodes) {
+    if (__atomic_add_fetch(&b->arrived, 1, __ATOMIC_ACQ_REL) != b->count) {
+      barrier_sleep(b, g);
+      return 0;
+    }
+    __atomic_store_n(&b->arrived, 0, __ATOMIC_RELAXED);
+    barrier_open(b, g);
+    return PTHREAD_BARRIER_SERIAL_THREAD;
+  }
+
+  bool last;
+  barrier_node *node = barrier_arrive_leaf(b, g, &last);
+  while (last && node->parent >= 0) {
+    node = &b->nodes[node->parent];
+    last = (__atomic_add_fetch(&node->state, 1, __ATOMIC_ACQ_REL) ==
+            node->capacity);
+    if (last)
+      __atomic_store_n(&node->state, 0, __ATOMIC_RELAXED);
+  }
+  if (!last) {
+    barrier_sleep(b, g);
+    return 0;
+  }
+  barrier_open(b, g);
+  return PTHREAD_BARRIER_SERIAL_THREAD;
+}
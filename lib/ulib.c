@@ -175,7 +175,9 @@ __crt_main(uint64_t argc, char **argv, uint64_t elf_phdr, uint64_t elf_phnum)
 {
   extern void __cpprt_init(void);
   extern void __cpprt_fini(void);
+  extern void __string_init(void);
 
+  __string_init();
   _dl_phdr = (struct proghdr*) elf_phdr;
   _dl_phnum = elf_phnum;
   forkt_setup(getpid());
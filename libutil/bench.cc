@@ -0,0 +1,356 @@
+// Shared benchmark harness.  See bench.hh.
+
+#include "bench.hh"
+#include "amd64.h"
+#include "histogram.hh"
+#include "libutil.h"
+#include "pmcdb.hh"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+#if defined(XV6_USER)
+#include "pthread.h"
+#include "kstats.hh"
+#include <xv6/perf.h>
+#else
+#include <pthread.h>
+#endif
+
+// The PMC perf_start programs for -e
+#define RECORD_PMC 0
+
+namespace bench {
+
+config::config(const char *name)
+  : name(name), cores{1}, warmup_secs(1), duration_secs(5), trials(1),
+    latency(false), pmc(nullptr)
+{
+}
+
+bool
+config::set_cores(const char *spec)
+{
+  std::vector<int> res;
+  const char *p = spec;
+  while (*p) {
+    char *end;
+    long lo = strtol(p, &end, 10), hi = lo, step = 1;
+    if (end == p || lo < 1)
+      return false;
+    p = end;
+    if (*p == '-') {
+      hi = strtol(p + 1, &end, 10);
+      if (end == p + 1 || hi < lo)
+        return false;
+      p = end;
+      if (*p == ':') {
+        step = strtol(p + 1, &end, 10);
+        if (end == p + 1 || step < 1)
+          return false;
+        p = end;
+      }
+    }
+    for (long c = lo; c <= hi; c += step)
+      res.push_back(c);
+    if (*p == ',')
+      ++p;
+    else if (*p)
+      return false;
+  }
+  if (res.empty())
+    return false;
+  cores = res;
+  return true;
+}
+
+bool
+config::option(int opt, const char *arg)
+{
+  switch (opt) {
+  case 'c':
+    if (!set_cores(arg))
+      die("%s: bad core list '%s'", name, arg);
+    return true;
+  case 'w':
+    warmup_secs = atoi(arg);
+    return true;
+  case 'd':
+    duration_secs = atoi(arg);
+    if (!duration_secs)
+      die("%s: bad duration '%s'", name, arg);
+    return true;
+  case 'n':
+    trials = atoi(arg);
+    if (!trials)
+      die("%s: bad trial count '%s'", name, arg);
+    return true;
+  case 'L':
+    latency = true;
+    return true;
+  case 'e':
+#if !defined(XV6_USER)
+    die("%s: -e not supported on Linux", name);
+#endif
+    pmc = arg;
+    return true;
+  }
+  return false;
+}
+
+void
+config::usage()
+{
+  fprintf(stderr,
+          "  -c cores      Core counts to sweep, e.g. 4, 1,2,4, 1,10-80:10\n"
+          "  -w secs       Warmup time (default 1)\n"
+          "  -d secs       Measurement time (default 5)\n"
+          "  -n trials     Trials per core count (default 1)\n"
+          "  -L            Record per-operation latency histograms\n"
+          "  -e perfevent  Count perfevent\n");
+}
+
+namespace {
+  enum { WARMUP, MEASURE, STOP };
+
+  typedef histogram_log2<uint64_t, (1ull << 40)> latency_hist;
+
+  // What each worker reports at the end of a run
+  struct worker_result
+  {
+    uint64_t ops;
+    uint64_t start_usec, stop_usec;
+    uint64_t start_tsc, stop_tsc;
+    uint64_t pmc;
+    latency_hist latency;
+  };
+
+  std::atomic<int> phase;
+  pthread_barrier_t bar;
+  const config *cur_cfg;
+  benchmark *cur_bench;
+  worker_result *results;
+
+  void
+  worker(int id)
+  {
+    const config &cfg = *cur_cfg;
+    benchmark *b = cur_bench;
+    // Keep everything the loop touches local, so workers don't share
+    // cache lines.
+    worker_result r{};
+    int myphase = WARMUP;
+    uint64_t ops = 0, pmc0 = 0;
+
+    setaffinity(id);
+    b->thread_setup(id);
+    pthread_barrier_wait(&bar);
+
+    for (;;) {
+      int p = phase.load(std::memory_order_relaxed);
+      if (__builtin_expect(p != myphase, 0)) {
+        if (p == STOP)
+          break;
+        myphase = p;
+        ops = 0;
+        r.start_usec = now_usec();
+        r.start_tsc = rdtsc();
+        if (cfg.pmc)
+          pmc0 = rdpmc(RECORD_PMC);
+      }
+      if (cfg.latency && myphase == MEASURE) {
+        uint64_t t0 = rdtsc();
+        b->op(id);
+        r.latency += rdtsc() - t0;
+      } else {
+        b->op(id);
+      }
+      ++ops;
+    }
+
+    r.stop_usec = now_usec();
+    r.stop_tsc = rdtsc();
+    if (myphase != MEASURE) {
+      // The run ended before this worker noticed it started
+      ops = 0;
+      r.start_usec = r.stop_usec;
+      r.start_tsc = r.stop_tsc;
+    } else if (cfg.pmc) {
+      r.pmc = rdpmc(RECORD_PMC) - pmc0;
+    }
+    r.ops = ops;
+    results[id] = r;
+  }
+
+  void
+  print_string(const char *s)
+  {
+    printf("\"");
+    for (; *s; ++s) {
+      if (*s == '"' || *s == '\\')
+        printf("\\");
+      printf("%c", *s);
+    }
+    printf("\"");
+  }
+
+  void
+  print_key(const char *key)
+  {
+    printf(",");
+    print_string(key);
+    printf(":");
+  }
+
+#if defined(XV6_USER)
+  void
+  read_kstats(kstats *out)
+  {
+    int fd = open("/dev/kstats", O_RDONLY);
+    if (fd < 0)
+      die("Couldn't open /dev/kstats");
+    if (xread(fd, out, sizeof *out) != sizeof *out)
+      die("Short read from /dev/kstats");
+    close(fd);
+  }
+#endif
+}
+
+uint64_t
+worker_ops(int id)
+{
+  return results[id].ops;
+}
+
+void
+run(const config &cfg, benchmark *b)
+{
+  struct utsname uts;
+  if (uname(&uts) < 0)
+    die("%s: uname failed", cfg.name);
+
+#if defined(XV6_USER)
+  if (cfg.pmc) {
+    try {
+      perf_start(pmcdb_parse_selector(cfg.pmc), 0);
+    } catch (std::invalid_argument &e) {
+      die("%s", e.what());
+    }
+  }
+#endif
+
+  cur_cfg = &cfg;
+  cur_bench = b;
+  for (int ncores : cfg.cores) {
+    for (unsigned trial = 1; trial <= cfg.trials; ++trial) {
+      b->setup(ncores);
+      results = new worker_result[ncores];
+      phase.store(WARMUP);
+      pthread_barrier_init(&bar, nullptr, ncores + 1);
+
+      std::thread *threads = new std::thread[ncores];
+      for (int i = 0; i < ncores; ++i)
+        threads[i] = std::thread(worker, i);
+
+      pthread_barrier_wait(&bar);
+      sleep(cfg.warmup_secs);
+#if defined(XV6_USER)
+      kstats kstats_before, kstats_after;
+      read_kstats(&kstats_before);
+#endif
+      phase.store(MEASURE);
+      sleep(cfg.duration_secs);
+      phase.store(STOP);
+#if defined(XV6_USER)
+      read_kstats(&kstats_after);
+#endif
+      b->stop();
+      for (int i = 0; i < ncores; ++i)
+        threads[i].join();
+      delete[] threads;
+      pthread_barrier_destroy(&bar);
+      b->teardown();
+
+      // Combine workers
+      uint64_t ops = 0, usec = 0, tsc = 0, pmc = 0;
+      latency_hist latency;
+      for (int i = 0; i < ncores; ++i) {
+        worker_result &r = results[i];
+        ops += r.ops;
+        usec += r.stop_usec - r.start_usec;
+        tsc += r.stop_tsc - r.start_tsc;
+        pmc += r.pmc;
+        latency += r.latency;
+      }
+      double secs = usec / 1e6 / ncores;
+
+      printf("{");
+      print_string("bench");
+      printf(":");
+      print_string(cfg.name);
+      print_key("kernel");
+      print_string(uts.sysname);
+      print_key("host");
+      print_string(uts.nodename);
+      for (auto &p : cfg.params) {
+        print_key(p.key);
+        print_string(p.value);
+      }
+      printf(",\"cores\":%d,\"trial\":%u,\"warmup_secs\":%u"
+             ",\"duration_secs\":%u", ncores, trial, cfg.warmup_secs,
+             cfg.duration_secs);
+      printf(",\"secs\":%f,\"ops\":%lu", secs, ops);
+      if (ops) {
+        printf(",\"ops_per_sec\":%f,\"cycles_per_op\":%lu",
+               secs ? ops / secs : 0.0, tsc / ops);
+      }
+      if (cfg.latency && latency.count()) {
+        printf(",\"latency_cycles\":{\"min\":%lu,\"mean\":%lu,\"p50\":%lu,"
+               "\"p90\":%lu,\"p99\":%lu,\"max\":%lu}",
+               latency.min(), latency.mean(), latency.percentile(0.5),
+               latency.percentile(0.9), latency.percentile(0.99),
+               latency.max());
+      }
+      if (cfg.pmc) {
+        print_key("pmc");
+        printf("{\"event\":");
+        print_string(cfg.pmc);
+        printf(",\"count\":%lu,\"per_op\":%f}", pmc,
+               ops ? pmc / (double)ops : 0.0);
+      }
+#if defined(XV6_USER)
+      // Kernel statistics over the measurement period
+      kstats delta = kstats_after - kstats_before;
+      printf(",\"kstats\":{");
+      const char *sep = "";
+#define X(type, name)                                      \
+      if (delta.name) {                                    \
+        printf("%s\"" #name "\":%lu", sep, delta.name);    \
+        sep = ",";                                         \
+      }
+      KSTATS_ALL(X);
+#undef X
+      printf("}");
+#endif
+      b->report();
+      printf("}\n");
+      delete[] results;
+      results = nullptr;
+    }
+  }
+
+#if defined(XV6_USER)
+  if (cfg.pmc)
+    perf_stop();
+#endif
+}
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+// A shared harness for the benchmarks in bin/.
+//
+// A benchmark subclasses bench::benchmark and passes it to bench::run
+// with a bench::config.  For every core count in the sweep and every
+// trial, run starts one worker per core, pinned with setaffinity, has
+// each call op() in a loop through a warmup period, and then measures
+// them for a fixed duration.  Each run prints one JSON object on its
+// own line.  The format is the same on sv6 and in the HW=linux build,
+// so the two can be compared run for run.
+//
+// Options common to every benchmark, parsed by config::option:
+//   -c cores    Core counts to sweep, e.g. "4", "1,2,4", "1,10-80:10"
+//   -w secs     Warmup time (default 1)
+//   -d secs     Measurement time (default 5)
+//   -n trials   Trials per core count (default 1)
+//   -L          Record a per-operation latency histogram
+//   -e event    Count a PMU event (sv6 only)
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <new>
+#include <vector>
+
+#define BENCH_OPTS "c:w:d:n:Le:"
+
+namespace bench {
+  struct config
+  {
+    struct param
+    {
+      const char *key, *value;
+    };
+
+    const char *name;
+    std::vector<int> cores;
+    unsigned warmup_secs, duration_secs, trials;
+    bool latency;
+    const char *pmc;
+    // Benchmark-specific settings, echoed in every result.
+    std::vector<param> params;
+
+    config(const char *name);
+
+    // Handle a getopt option from BENCH_OPTS.  Returns false if opt
+    // isn't one of them.  Dies on a malformed argument.
+    bool option(int opt, const char *arg);
+
+    // Parse a core count list, e.g. "1,10-80:10", replacing cores.
+    // Returns false if spec is malformed.
+    bool set_cores(const char *spec);
+
+    void add_param(const char *key, const char *value)
+    {
+      params.push_back(param{key, value});
+    }
+
+    // Print the common options to stderr, for usage messages.
+    static void usage();
+  };
+
+  class benchmark
+  {
+  public:
+    virtual ~benchmark() { }
+
+    // Called before each run with the number of workers.
+    virtual void setup(int ncores) { }
+
+    // Called on worker id, already pinned to core id, before the run
+    // starts.
+    virtual void thread_setup(int id) { }
+
+    // Perform one operation on worker id.
+    virtual void op(int id) = 0;
+
+    // Called once the run has ended, while workers may still be in
+    // op.  A benchmark whose op waits on other workers must make any
+    // such wait return here, since the worker it waits for may have
+    // already stopped.
+    virtual void stop() { }
+
+    // Called after each run.
+    virtual void teardown() { }
+
+    // Print benchmark-specific results of the run that just ended,
+    // as JSON members that each start with a comma.  Called after
+    // teardown.
+    virtual void report() { }
+  };
+
+  // Run b for every core count and trial in cfg, printing a result
+  // line after each run.
+  void run(const config &cfg, benchmark *b);
+
+  // Return the number of operations worker id completed during the
+  // measurement period of the run being reported.  Only valid in
+  // benchmark::report.
+  uint64_t worker_ops(int id);
+
+  // Allocate an array of n value-initialized Ts that starts on a cache
+  // line.  Per-worker state is usually __mpalign__ or __padout__, and
+  // plain new doesn't honor that alignment.  Free the array with
+  // delete_array.
+  template<class T>
+  T *
+  new_array(size_t n)
+  {
+    char *mem = new char[n * sizeof(T) + CACHELINE];
+    size_t off = CACHELINE - ((uintptr_t)mem & (CACHELINE - 1));
+    mem += off;
+    // off is between 1 and CACHELINE, so it fits in the byte before
+    // the array
+    mem[-1] = off;
+    T *a = (T*)mem;
+    for (size_t i = 0; i < n; i++)
+      new (&a[i]) T();
+    return a;
+  }
+
+  template<class T>
+  void
+  delete_array(T *a, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+      a[i].~T();
+    char *mem = (char*)a;
+    delete[] (mem - (unsigned char)mem[-1]);
+  }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// An iterator over the entries of an open directory.  Entries are
+// fetched from the kernel in batches with getdents, so a directory
+// with n entries costs about n/nbatch system calls.
+
+#include "types.h"
+#include "fs.h"
+#include "sysstubs.h"
+
+class dirit
+{
+  enum { nbatch = 64 };
+
+  int fd_;
+  char cookie_[DIRSIZ];
+  struct kdirent ents_[nbatch];
+  int n_, pos_;
+  bool end_, failed_;
+
+public:
+  explicit dirit(int fd)
+    : fd_(fd), n_(0), pos_(0), end_(false), failed_(false)
+  {
+    cookie_[0] = 0;
+  }
+
+  dirit(const dirit&) = delete;
+  dirit& operator=(const dirit&) = delete;
+
+  // Return the next entry, or nullptr at the end of the directory or
+  // on error.  The entry is valid until the next call.
+  const struct kdirent* next()
+  {
+    if (pos_ == n_) {
+      if (end_)
+        return nullptr;
+      int r = getdents(fd_, cookie_, ents_, nbatch);
+      if (r <= 0) {
+        end_ = true;
+        failed_ = r < 0;
+        return nullptr;
+      }
+      // A short batch means we've reached the end.
+      end_ = r < nbatch;
+      n_ = r;
+      pos_ = 0;
+    }
+    return &ents_[pos_++];
+  }
+
+  // Return true if getdents failed.
+  bool failed() const
+  {
+    return failed_;
+  }
+};
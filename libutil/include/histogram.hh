@@ -148,6 +148,22 @@ public:
     return sum_ / (double)count();
   }
 
+  // Return an upper bound on the p'th quantile (0 <= p <= 1): the top
+  // of the bucket that holds it, or max() if it falls past Max.
+  T
+  percentile(double p) const
+  {
+    T want = count() * p, seen = zero_;
+    if (seen > want)
+      return 0;
+    for (std::size_t i = 0; i < NBUCKETS; ++i) {
+      seen += buckets_[i];
+      if (seen > want)
+        return ((T)2 << i) - 1 < max_ ? ((T)2 << i) - 1 : max_;
+    }
+    return max_;
+  }
+
   void
   print_stats() const
   {
@@ -627,6 +627,23 @@ struct ilist
     head.prev = head.next = container_from_member(&head, L);
   }
 
+  /**
+   * Move all elements of x into this list before pos, leaving x
+   * empty.  Constant time.
+   */
+  void
+  splice(iterator pos, ilist &&x) noexcept
+  {
+    if (x.empty())
+      return;
+    T *first = x.head.next, *last = x.head.prev;
+    (first->*L).prev = (pos.elem->*L).prev;
+    (last->*L).next = pos.elem;
+    ((pos.elem->*L).prev->*L).next = first;
+    (pos.elem->*L).prev = last;
+    x.clear();
+  }
+
   /**
    * Return an iterator pointing to elem, which must be in this list.
    */
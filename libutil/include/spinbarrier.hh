@@ -5,6 +5,42 @@
 #include <atomic>
 #include <cstdint>
 
+#ifdef XV6_USER
+#include <pthread.h>
+
+// A reusable barrier.  On xv6 this is the library's pthread barrier,
+// which spins for a while and then sleeps on a futex, and combines
+// arrivals in a tree for large thread counts.
+class spin_barrier
+{
+  pthread_barrier_t b_;
+  bool valid_;
+
+public:
+  spin_barrier() : valid_(false) { }
+  spin_barrier(unsigned val) : valid_(false) { init(val); }
+  spin_barrier(const spin_barrier&) = delete;
+  ~spin_barrier()
+  {
+    if (valid_)
+      pthread_barrier_destroy(&b_);
+  }
+
+  void init(unsigned val)
+  {
+    if (valid_)
+      pthread_barrier_destroy(&b_);
+    valid_ = (pthread_barrier_init(&b_, nullptr, val) == 0);
+  }
+
+  void join()
+  {
+    pthread_barrier_wait(&b_);
+  }
+};
+
+#else
+
 // A reusable spinning barrier.
 class spin_barrier
 {
@@ -60,3 +96,5 @@ public:
       entered_ = 0;
   }
 };
+
+#endif
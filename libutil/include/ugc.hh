@@ -1,5 +1,28 @@
+#pragma once
+
+// A mark-sweep garbage collector for graphs of gcptr objects.
+//
+// gcollect frees every gcptr that isn't reachable from the given root
+// through references created with gcptr::ref.  Marking and sweeping
+// run in parallel on the collecting thread and helper threads, and
+// other threads may keep allocating and changing references while a
+// collection runs: ref and uref are write barriers that keep marking
+// correct (snapshot-at-the-beginning, plus shading new targets).
+// Objects allocated during a collection survive it.  An object
+// allocated before a collection starts must be reachable by the time
+// marking starts, or it may be freed; threads that allocate while
+// another thread may be collecting should hold a gcpin from
+// allocation until the new objects are linked in.
+//
+// Each thread allocates into its own list, so allocation doesn't
+// contend, and the sweep works through these lists in parallel while
+// their threads keep allocating.
+
 #include "ilist.hh"
 
+#include <atomic>
+#include <cstdint>
+
 typedef unsigned char mark_sense_t;
 class gcd_memory;
 class gcptr;
@@ -20,6 +43,7 @@ public:
   gcptr();
   virtual ~gcptr();
   gcptr_ref* ref(gcptr* child);
+  // Remove and free a reference returned by ref.
   void uref(gcptr_ref* child);
   static gcptr* new_root();
 
@@ -30,15 +54,44 @@ public:
 
   // Our link in the node list
   ilink<gcptr> node_link_;
-  // Our link in the work list
-  ilink<gcptr> work_link_;
 
 private:
   gcptr(bool track);
-  mark_sense_t mark_;
+  void lock();
+  void unlock();
+
+  std::atomic<mark_sense_t> mark_;
+  // Protects ref_list_ against concurrent markers
+  std::atomic<bool> lock_;
 
   // Everyone that we reference
   ref_list ref_list_;
 };
 
-void gcollect(gcptr* ptr);
+struct gcstats
+{
+  // Cycles the collecting thread spent starting and finishing
+  // marking, which wait for threads inside ref, uref, or a gcpin
+  uint64_t handshake_cycles;
+  uint64_t mark_cycles;
+  uint64_t sweep_cycles;
+  uint64_t marked;
+  uint64_t freed;
+  // Successful steals between mark stacks
+  uint64_t steals;
+};
+
+// While any thread holds a gcpin, collections wait to start marking
+// and to finish it.  Pins nest and are cheap, but should be short,
+// and a thread must not call gcollect while holding one.
+struct gcpin
+{
+  gcpin();
+  ~gcpin();
+  gcpin(const gcpin &o) = delete;
+  gcpin &operator=(const gcpin &o) = delete;
+};
+
+// Free everything not reachable from ptr, using nworkers threads
+// including the caller.  Concurrent calls are serialized.
+void gcollect(gcptr* ptr, int nworkers = 1, gcstats *stats = nullptr);
@@ -34,6 +34,6 @@ static inline void nsleep(unsigned long long nsecs)
 
 #else // Must be xv6
 
-#define xpthread_join(tid) waitpid(tid, NULL,0)
+#define xpthread_join(tid) pthread_join(tid, nullptr)
 
 #endif
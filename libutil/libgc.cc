@@ -1,98 +1,512 @@
+// Parallel, concurrent mark-sweep collector for gcptr graphs.
+//
+// A collection flips the mark sense, so every existing object becomes
+// unmarked, and switches to the mark phase.  Marking is
+// snapshot-at-the-beginning: uref shades the target of a removed
+// reference, so everything reachable when marking started gets
+// marked, and ref shades the target of a new reference, which covers
+// objects allocated just before the flip.  Objects allocated after
+// the flip are born marked.  Threads in ref or uref advertise it in
+// their heap's barrier_seq, and the collector waits for barriers in
+// progress to finish after each phase change, so no barrier straddles
+// a phase change unnoticed.  A gcpin is a long barrier.
+//
+// Each marker works from its own stack and steals half of another's
+// when it runs dry.  Barriers hand the objects they shade to the
+// markers through a shared grey list.  Marking is done when no marker
+// holds work and the grey list is empty.
+//
+// The sweep splits the per-thread heaps among the markers.  Sweeping
+// a heap detaches its list so its thread can keep allocating into the
+// heap meanwhile, then puts the survivors back.
+
 #include "ugc.hh"
+#include "amd64.h"
+#include "compiler.h"
+#include "spinbarrier.hh"
+
 #include <stdio.h>
 
+#include <thread>
+#include <utility>
+#include <vector>
+
+enum gc_phase { GC_IDLE, GC_MARK, GC_SWEEP };
+
+static void
+spin_lock(std::atomic<bool> *lock)
+{
+  while (lock->exchange(true, std::memory_order_acquire))
+    while (lock->load(std::memory_order_relaxed))
+      nop_pause();
+}
+
+static void
+spin_unlock(std::atomic<bool> *lock)
+{
+  lock->store(false, std::memory_order_release);
+}
+
+// A thread's allocation list.  Heaps are never freed, so objects
+// allocated by threads that have exited are still swept.
+struct gcd_heap
+{
+  std::atomic<bool> lock;
+  ilist<gcptr, &gcptr::node_link_> nodes;
+  // Odd while the thread is inside ref, uref, or a gcpin.  Only the
+  // thread writes it.
+  std::atomic<uint64_t> barrier_seq;
+  // Nesting depth of barriers and pins; only touched by the thread
+  int depth;
+  gcd_heap *next;
+  __padout__;
+
+  gcd_heap() : lock(false), barrier_seq(0), depth(0), next(nullptr) { }
+};
+
+// A marker's stack.  The owner pushes and pops at the back; thieves
+// take from the front.
+struct mark_stack
+{
+  std::atomic<bool> lock;
+  std::vector<gcptr*> objs;
+  // objs[head..] are still to be scanned
+  size_t head;
+  // objs.size() - head, for thieves to peek at without the lock
+  std::atomic<size_t> depth;
+  uint64_t marked, steals;
+  __padout__;
+
+  mark_stack() : lock(false), head(0), depth(0), marked(0), steals(0) { }
+};
+
 class gcd_memory
 {
 public:
+  gcd_memory()
+    : current_sense_(0), phase_(GC_IDLE), heaps_(nullptr),
+      collect_lock_(false), greys_lock_(false), nworkers_(0),
+      stacks_mem_(nullptr), stacks_(nullptr), busy_(0), sweep_next_(nullptr), freed_(0) { }
+
   void add(gcptr* ptr);
-  void collect(gcptr* ptr);
-  void collect_work_list();
+  void collect(gcptr* root, int nworkers, gcstats *stats);
+  void helper(int id);
 
-  bool marked(gcptr* ptr);
-  void mark(gcptr* ptr);
+  // Write barrier.  Between enter_barrier and exit_barrier, a thread
+  // may change reference lists and must shade the targets of changed
+  // references if marking().
+  gcd_heap* enter_barrier();
+  void exit_barrier(gcd_heap* heap);
+  bool marking();
+  void shade(gcptr* ptr);
 
-  void sweep();
-  
-  mark_sense_t current_sense_;  
+  std::atomic<mark_sense_t> current_sense_;
 
 private:
-  void collect_ptr(gcptr& ptr);
+  gcd_heap* myheap();
+  void wait_barriers();
+
+  bool try_mark(gcptr* ptr);
+  void push(int id, gcptr* ptr);
+  bool pop(int id, gcptr** ptr);
+  bool steal(int id);
+  bool take_greys(int id);
+  bool find_work(int id);
+  void scan(int id, gcptr* ptr);
+  void mark_worker(int id);
+  void finish_marking();
 
-  ilist<gcptr, &gcptr::node_link_> node_list_;
-  ilist<gcptr, &gcptr::work_link_> work_list_;
+  void sweep_heap(gcd_heap* heap);
+  void sweep_worker();
+
+  std::atomic<int> phase_;
+  std::atomic<gcd_heap*> heaps_;
+  std::atomic<bool> collect_lock_;
+
+  // Objects shaded by write barriers, waiting to be scanned
+  std::atomic<bool> greys_lock_;
+  std::vector<gcptr*> greys_;
+
+  // State of the running collection
+  int nworkers_;
+  char *stacks_mem_;
+  mark_stack *stacks_;
+  // Markers that may hold work
+  std::atomic<int> busy_;
+  spin_barrier phase_barrier_;
+  std::atomic<gcd_heap*> sweep_next_;
+  std::atomic<uint64_t> freed_;
 };
 
 static gcd_memory the_mem;
+static __thread gcd_heap* myheap_;
 
 //
 // gcd_memory
 //
 
+gcd_heap*
+gcd_memory::myheap()
+{
+  if (myheap_)
+    return myheap_;
+
+  // Keep heaps on their own cache lines
+  char *mem = new char[sizeof(gcd_heap) + CACHELINE];
+  mem += CACHELINE - ((uintptr_t)mem & (CACHELINE - 1));
+  gcd_heap *heap = new (mem) gcd_heap();
+  heap->next = heaps_.load();
+  while (!heaps_.compare_exchange_weak(heap->next, heap))
+    ;
+  myheap_ = heap;
+  return heap;
+}
+
 void
-gcd_memory::mark(gcptr* ptr)
+gcd_memory::add(gcptr* ptr)
+{
+  gcd_heap *heap = myheap();
+  spin_lock(&heap->lock);
+  heap->nodes.push_front(ptr);
+  spin_unlock(&heap->lock);
+}
+
+gcd_heap*
+gcd_memory::enter_barrier()
+{
+  gcd_heap *heap = myheap();
+  // Sequentially consistent, paired with the phase_ store in
+  // collect: either the collector sees us in the barrier and waits
+  // for us, or we see the new phase.
+  if (heap->depth++ == 0)
+    heap->barrier_seq.store(heap->barrier_seq.load(std::memory_order_relaxed)
+                            + 1);
+  return heap;
+}
+
+void
+gcd_memory::exit_barrier(gcd_heap* heap)
 {
-  ptr->mark_ = current_sense_;
+  if (--heap->depth == 0)
+    heap->barrier_seq.store(heap->barrier_seq.load(std::memory_order_relaxed)
+                            + 1, std::memory_order_release);
 }
 
 bool
-gcd_memory::marked(gcptr* ptr)
+gcd_memory::marking()
 {
-  return (ptr->mark_ == current_sense_);
+  return phase_.load() == GC_MARK;
 }
 
 void
-gcd_memory::add(gcptr* ptr)
+gcd_memory::shade(gcptr* ptr)
+{
+  if (!try_mark(ptr))
+    return;
+  spin_lock(&greys_lock_);
+  greys_.push_back(ptr);
+  spin_unlock(&greys_lock_);
+}
+
+// Wait until every thread that was inside a write barrier has left
+// it.  Threads may enter new barriers meanwhile.
+void
+gcd_memory::wait_barriers()
+{
+  for (gcd_heap *heap = heaps_.load(); heap; heap = heap->next) {
+    uint64_t seq = heap->barrier_seq.load();
+    if (seq & 1)
+      while (heap->barrier_seq.load() == seq)
+        nop_pause();
+  }
+}
+
+// Mark ptr in the current sense.  Returns true if this call marked
+// it, in which case the caller must see that it gets scanned.
+bool
+gcd_memory::try_mark(gcptr* ptr)
+{
+  mark_sense_t sense = current_sense_.load(std::memory_order_relaxed);
+  return ptr->mark_.load(std::memory_order_relaxed) != sense &&
+    ptr->mark_.exchange(sense) != sense;
+}
+
+void
+gcd_memory::push(int id, gcptr* ptr)
+{
+  mark_stack *s = &stacks_[id];
+  spin_lock(&s->lock);
+  s->objs.push_back(ptr);
+  s->depth.store(s->objs.size() - s->head, std::memory_order_relaxed);
+  spin_unlock(&s->lock);
+}
+
+bool
+gcd_memory::pop(int id, gcptr** ptr)
+{
+  mark_stack *s = &stacks_[id];
+  bool found = false;
+  spin_lock(&s->lock);
+  if (s->objs.size() > s->head) {
+    *ptr = s->objs.back();
+    s->objs.pop_back();
+    found = true;
+  }
+  if (s->objs.size() == s->head) {
+    s->objs.clear();
+    s->head = 0;
+  }
+  s->depth.store(s->objs.size() - s->head, std::memory_order_relaxed);
+  spin_unlock(&s->lock);
+  return found;
+}
+
+// Move half of some other marker's stack to ours.  Called while idle;
+// becomes busy if it returns true.
+bool
+gcd_memory::steal(int id)
+{
+  for (int i = 1; i < nworkers_; i++) {
+    mark_stack *victim = &stacks_[(id + i) % nworkers_];
+    if (!victim->depth.load(std::memory_order_relaxed))
+      continue;
+    // Become busy before taking anything, so find_work never sees
+    // every marker idle while we hold work.
+    busy_++;
+    std::vector<gcptr*> loot;
+    spin_lock(&victim->lock);
+    size_t n = (victim->objs.size() - victim->head + 1) / 2;
+    for (size_t j = 0; j < n; j++)
+      loot.push_back(victim->objs[victim->head + j]);
+    victim->head += n;
+    victim->depth.store(victim->objs.size() - victim->head,
+                        std::memory_order_relaxed);
+    spin_unlock(&victim->lock);
+    if (loot.empty()) {
+      busy_--;
+      continue;
+    }
+    for (gcptr *ptr : loot)
+      push(id, ptr);
+    stacks_[id].steals++;
+    return true;
+  }
+  return false;
+}
+
+// Move the grey list to our stack.  Called while idle; becomes busy
+// if it returns true.
+bool
+gcd_memory::take_greys(int id)
+{
+  std::vector<gcptr*> greys;
+  spin_lock(&greys_lock_);
+  if (!greys_.empty()) {
+    busy_++;
+    greys.swap(greys_);
+  }
+  spin_unlock(&greys_lock_);
+  for (gcptr *ptr : greys)
+    push(id, ptr);
+  return !greys.empty();
+}
+
+// Called when marker id's stack is empty.  Returns true once it has
+// more work, or false when marking is done.
+//
+// A marker's stack is only non-empty while it's busy, so once busy_
+// is zero, the only possible work is on the grey list.  take_greys
+// increments busy_ under greys_lock_, so checking both under the lock
+// is a consistent snapshot.
+bool
+gcd_memory::find_work(int id)
+{
+  busy_--;
+  for (;;) {
+    if (take_greys(id) || steal(id))
+      return true;
+    spin_lock(&greys_lock_);
+    bool done = busy_.load() == 0 && greys_.empty();
+    spin_unlock(&greys_lock_);
+    if (done)
+      return false;
+    nop_pause();
+  }
+}
+
+void
+gcd_memory::scan(int id, gcptr* ptr)
+{
+  ptr->lock();
+  for (gcptr_ref &ref : ptr->ref_list_)
+    if (try_mark(ref.ptr))
+      push(id, ref.ptr);
+  ptr->unlock();
+}
+
+void
+gcd_memory::mark_worker(int id)
 {
-  node_list_.push_front(ptr);  
+  for (;;) {
+    gcptr *ptr;
+    while (pop(id, &ptr)) {
+      scan(id, ptr);
+      stacks_[id].marked++;
+    }
+    if (!find_work(id))
+      return;
+  }
+}
+
+// Called on marker 0 once every marker has finished.  Barriers that
+// were running may still have shaded objects, so scan those until the
+// grey list stays empty, then end the mark phase.  Once marking is
+// complete, barriers only find marked objects, except for objects
+// allocated before the flip and linked in after this point, which
+// this collection may free (see ugc.hh).
+void
+gcd_memory::finish_marking()
+{
+  for (;;) {
+    wait_barriers();
+    spin_lock(&greys_lock_);
+    bool empty = greys_.empty();
+    spin_unlock(&greys_lock_);
+    if (empty)
+      break;
+    busy_ = 1;
+    mark_worker(0);
+  }
+  phase_.store(GC_SWEEP);
+  wait_barriers();
+  busy_ = 1;
+  mark_worker(0);
 }
 
 void
-gcd_memory::sweep()
+gcd_memory::sweep_heap(gcd_heap* heap)
 {
-  auto it = node_list_.begin();
-  while (it != node_list_.end()) {
-    if (!marked(it.elem)) {
+  ilist<gcptr, &gcptr::node_link_> nodes;
+  spin_lock(&heap->lock);
+  nodes = std::move(heap->nodes);
+  spin_unlock(&heap->lock);
+
+  mark_sense_t sense = current_sense_.load(std::memory_order_relaxed);
+  uint64_t freed = 0;
+  auto it = nodes.begin();
+  while (it != nodes.end()) {
+    if (it->mark_.load(std::memory_order_relaxed) != sense) {
       gcptr* ptr = it.elem;
-      it = node_list_.erase(it);
+      it = nodes.erase(it);
       delete ptr;
+      freed++;
     } else {
       it++;
     }
   }
+
+  spin_lock(&heap->lock);
+  heap->nodes.splice(heap->nodes.end(), std::move(nodes));
+  spin_unlock(&heap->lock);
+  freed_ += freed;
 }
 
 void
-gcd_memory::collect_ptr(gcptr& ptr)
+gcd_memory::sweep_worker()
 {
-  for (gcptr_ref &ref : ptr.ref_list_) {
-    if (!marked(ref.ptr)) {
-      mark(ref.ptr);
-      if (!ref.ptr->ref_list_.empty())
-        work_list_.push_back(ref.ptr);
-    }
+  for (;;) {
+    gcd_heap *heap = sweep_next_.load();
+    do {
+      if (!heap)
+        return;
+    } while (!sweep_next_.compare_exchange_weak(heap, heap->next));
+    sweep_heap(heap);
   }
 }
 
 void
-gcd_memory::collect_work_list()
+gcd_memory::helper(int id)
 {
-  while (!work_list_.empty()) {
-    auto it = work_list_.begin();
-    work_list_.pop_front();
-    collect_ptr(*it);
-  }
+  mark_worker(id);
+  phase_barrier_.join();
+  // Marker 0 finishes marking
+  phase_barrier_.join();
+  sweep_worker();
+}
+
+static void
+gc_helper(int id)
+{
+  the_mem.helper(id);
 }
 
 void
-gcd_memory::collect(gcptr* ptr)
+gcd_memory::collect(gcptr* root, int nworkers, gcstats *stats)
 {
-  work_list_.push_back(ptr);
+  if (nworkers < 1)
+    nworkers = 1;
+  spin_lock(&collect_lock_);
+
+  uint64_t t0 = rdtsc();
+  nworkers_ = nworkers;
+  // Keep stacks on their own cache lines
+  stacks_mem_ = new char[nworkers * sizeof(mark_stack) + CACHELINE];
+  char *mem = stacks_mem_;
+  mem += CACHELINE - ((uintptr_t)mem & (CACHELINE - 1));
+  stacks_ = (mark_stack*)mem;
+  for (int i = 0; i < nworkers; i++)
+    new (&stacks_[i]) mark_stack();
+  freed_ = 0;
 
-  while (!work_list_.empty()) {
-    the_mem.current_sense_ = !the_mem.current_sense_;
-    collect_work_list();
-    sweep();
+  // Start marking.  Objects allocated from here on are born marked.
+  current_sense_.store(!current_sense_.load());
+  phase_.store(GC_MARK);
+  wait_barriers();
+  uint64_t t1 = rdtsc();
+
+  if (try_mark(root))
+    push(0, root);
+  busy_ = nworkers;
+  if (nworkers > 1)
+    phase_barrier_.init(nworkers);
+  std::thread *helpers = new std::thread[nworkers - 1];
+  for (int i = 1; i < nworkers; i++)
+    helpers[i - 1] = std::thread(gc_helper, i);
+  mark_worker(0);
+  if (nworkers > 1)
+    phase_barrier_.join();
+
+  uint64_t t2 = rdtsc();
+  finish_marking();
+  uint64_t t3 = rdtsc();
+
+  sweep_next_ = heaps_.load();
+  if (nworkers > 1)
+    phase_barrier_.join();
+  sweep_worker();
+  for (int i = 0; i < nworkers - 1; i++)
+    helpers[i].join();
+  delete[] helpers;
+  phase_.store(GC_IDLE);
+  uint64_t t4 = rdtsc();
+
+  if (stats) {
+    *stats = gcstats{};
+    stats->handshake_cycles = (t1 - t0) + (t3 - t2);
+    stats->mark_cycles = t2 - t1;
+    stats->sweep_cycles = t4 - t3;
+    for (int i = 0; i < nworkers; i++) {
+      stats->marked += stacks_[i].marked;
+      stats->steals += stacks_[i].steals;
+    }
+    stats->freed = freed_;
   }
+  for (int i = 0; i < nworkers; i++)
+    stacks_[i].~mark_stack();
+  delete[] stacks_mem_;
+  stacks_mem_ = nullptr;
+  stacks_ = nullptr;
+  spin_unlock(&collect_lock_);
 }
 
 //
@@ -100,16 +514,18 @@ gcd_memory::collect(gcptr* ptr)
 //
 
 gcptr::gcptr()
-  : mark_(the_mem.current_sense_)
+  : mark_(the_mem.current_sense_.load(std::memory_order_relaxed)),
+    lock_(false)
 {
-  the_mem.add(this);  
+  the_mem.add(this);
 }
 
 gcptr::gcptr(bool track)
-  : mark_(the_mem.current_sense_)
+  : mark_(the_mem.current_sense_.load(std::memory_order_relaxed)),
+    lock_(false)
 {
   if (track)
-    the_mem.add(this);  
+    the_mem.add(this);
 }
 
 gcptr::~gcptr()
@@ -123,13 +539,31 @@ gcptr::~gcptr()
   }
 }
 
+void
+gcptr::lock()
+{
+  spin_lock(&lock_);
+}
+
+void
+gcptr::unlock()
+{
+  spin_unlock(&lock_);
+}
+
 gcptr_ref*
 gcptr::ref(gcptr* child)
 {
   gcptr_ref* ref = new gcptr_ref();
-
   ref->ptr = child;
+
+  gcd_heap *heap = the_mem.enter_barrier();
+  lock();
   ref_list_.push_front(ref);
+  unlock();
+  if (the_mem.marking())
+    the_mem.shade(child);
+  the_mem.exit_barrier(heap);
 
   return ref;
 }
@@ -137,7 +571,25 @@ gcptr::ref(gcptr* child)
 void
 gcptr::uref(gcptr_ref* child)
 {
+  gcd_heap *heap = the_mem.enter_barrier();
+  lock();
   ref_list_.erase(ref_list::iterator(child));
+  unlock();
+  if (the_mem.marking())
+    the_mem.shade(child->ptr);
+  the_mem.exit_barrier(heap);
+
+  delete child;
+}
+
+gcpin::gcpin()
+{
+  the_mem.enter_barrier();
+}
+
+gcpin::~gcpin()
+{
+  the_mem.exit_barrier(myheap_);
 }
 
 gcptr*
@@ -147,7 +599,7 @@ gcptr::new_root()
 }
 
 void
-gcollect(gcptr* ptr)
+gcollect(gcptr* ptr, int nworkers, gcstats *stats)
 {
-  the_mem.collect(ptr);
+  the_mem.collect(ptr, nworkers, stats);
 }
@@ -0,0 +1,2 @@
+const char *xv6_version_string = "Sun Oct 18 23:12:15 UTC 2026";
+const char *xv6_release_string = "";
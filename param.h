@@ -1,11 +1,9 @@
 #pragma once
-#define NPROC        64  // maximum number of processes
 #define KSTACKSIZE 8192  // size of per-process kernel stack
 #define NOFILE      100  // open files per process
-#define NFILE       100  // open files per system
 #define NBUF      10000  // size of disk block cache
 #define NINODE     5000  // maximum number of active i-nodes
-#define NDEV         16  // maximum major device number
+#define NDEV         32  // maximum major device number
 #define ROOTDEV       1  // device number of file system root disk
 #define MAXARG       32  // max exec arguments
 #define MAXARGLEN    64  // max exec argument length
@@ -13,7 +11,6 @@
 #define UNIX_PATH_MAX 128
 #define NEPOCH        4
 #define CACHELINE    64  // cache line size
-#define CPUKSTACKS   (NPROC + NCPU*2)
 #define VICTIMAGE 1000000 // cycles a proc executes before an eligible victim
 #define VERBOSE       0  // print kernel diagnostics
 #define SPINLOCK_DEBUG DEBUG // Debug spin locks
@@ -25,7 +22,7 @@
 #define RADIX_DEBUG   DEBUG
 #define USTACKPAGES   8
 #define GCINTERVAL    10000 // max. time between GC runs (in msec)
-#define GC_GLOBAL     true
+#define GC_EPOCH_FANOUT 16 // max. CPUs per leaf of the GC epoch tree
 // The MMU scheme.  One of:
 //  mmu_shared_page_table
 //  mmu_per_core_page_table
@@ -41,6 +38,12 @@
 #define PAGE_REFCOUNT refcache::
 // The maximum number of recently freed pages to cache per core.
 #define KALLOC_HOT_PAGES 128
+// The maximum number of free kernel stacks to cache per core.
+#define KSTACK_CACHE  16
+// The number of pids a core claims from the global pid counter at once.
+#define PIDBATCH      64
+// The number of buckets in the pid namespace.
+#define NPIDHASH      4099
 // How to balance memory load.  If 1, dynamically load balance pages
 // between buddy allocators.  If 0, directly steal and return memory
 // from remote buddy allocators.
@@ -48,15 +51,28 @@
 // Buddy allocator granularity.  If 0, create a buddy per NUMA node.
 // If 1, create a buddy per CPU.
 #define KALLOC_BUDDY_PER_CPU 1
+// Pages each automatic NUMA balancing scan samples.  Balancing is off
+// until a scan period is written to /dev/numabalance.
+#define NUMA_BALANCE_SCAN_PAGES 256
+// Pages each zswap reclaim scan locks and examines at a time, and the
+// pages a failed allocation tries to reclaim before retrying.
+#define ZSWAP_RECLAIM_PAGES 256
 // Whether or not to load balance in the scheduler.
 #define SCHED_LOAD_BALANCE 0
 // Reference counting scheme for inode's nlink.  One of:
 //  :: for shared reference counters
 //  refcache:: for refcache counters
 #define FS_NLINK_REFCOUNT refcache::
+// The longest refcache epoch, in timer ticks.  Epochs shorten when
+// at least REFCACHE_BACKLOG objects await review and lengthen when
+// fewer do.
+#define REFCACHE_MAX_EPOCH_TICKS 8
+#define REFCACHE_BACKLOG 4096
+// The most CPUs per leaf of refcache's epoch combining tree.
+#define REFCACHE_EPOCH_FANOUT 16
 #define RANDOMIZE_KMALLOC 1
-// Track kernel memory usage
-#define KERNEL_HEAP_PROFILE 0
+// Count system calls and their latencies per CPU (/dev/syscallstats)
+#define SYSCALL_STATS 1
 
 //
 // QEMU-based targets
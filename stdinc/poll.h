@@ -0,0 +1,10 @@
+#pragma once
+
+#include "compiler.h"
+#include <uk/poll.h>
+
+BEGIN_DECLS
+
+int poll(struct pollfd *fds, nfds_t nfds, int timeout);
+
+END_DECLS
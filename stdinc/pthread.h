@@ -12,13 +12,55 @@ typedef int pthread_t;
 typedef int pthread_attr_t;
 typedef int pthread_key_t;
 typedef int pthread_barrierattr_t;
-typedef int pthread_mutex_t;
 typedef int pthread_mutexattr_t;
-#ifdef __cplusplus
-typedef std::atomic<unsigned> pthread_barrier_t;
-#else
-typedef unsigned pthread_barrier_t;
-#endif
+typedef int pthread_condattr_t;
+typedef int pthread_rwlockattr_t;
+
+struct timespec;
+
+// Futex words are 64 bits because sys_futex compares 64-bit values.
+
+// 0 is unlocked, 1 is locked, 2 is locked and may have sleepers.
+typedef struct {
+  unsigned long state;
+} pthread_mutex_t;
+#define PTHREAD_MUTEX_INITIALIZER { 0 }
+
+// seq is the futex word and changes on every signal or broadcast.  It
+// is kept apart from the mutex word, so a requeueing futex operation
+// could move waiters from seq to the mutex.
+typedef struct {
+  unsigned long seq;
+  unsigned long waiters;
+} pthread_cond_t;
+#define PTHREAD_COND_INITIALIZER { 0, 0 }
+
+// state is the futex word: the low bits count readers, plus bits for
+// a writer holding the lock and for sleepers.  writers counts writers
+// waiting to acquire, which holds off new readers.
+typedef struct {
+  unsigned long state;
+  unsigned long writers;
+} pthread_rwlock_t;
+#define PTHREAD_RWLOCK_INITIALIZER { 0, 0 }
+
+// A reusable sense-reversing barrier.  gen is the futex word and
+// advances each time the barrier opens; its low bit is the sense.
+// Small barriers count arrivals in arrived.  Barriers for more than
+// PTHREAD_BARRIER_TREE_MIN threads instead combine arrivals up a tree
+// of cache-line-sized nodes, so no single line takes every arrival.
+struct __pthread_barrier_node;
+typedef struct {
+  unsigned long gen;
+  unsigned long sleepers;
+  unsigned long arrived;
+  unsigned count;
+  unsigned nleaves;
+  struct __pthread_barrier_node *nodes;
+  void *alloc;
+} pthread_barrier_t;
+#define PTHREAD_BARRIER_TREE_MIN 16
+#define PTHREAD_BARRIER_SERIAL_THREAD (-1)
 
 BEGIN_DECLS
 
@@ -36,14 +78,39 @@ int       pthread_barrier_init(pthread_barrier_t *b,
                                const pthread_barrierattr_t *attr,
                                unsigned count);
 int       pthread_barrier_wait(pthread_barrier_t *b);
+int       pthread_barrier_destroy(pthread_barrier_t *b);
 
 int       pthread_mutex_init(pthread_mutex_t *mutex,
                              const pthread_mutexattr_t *attr);
 int       pthread_mutex_destroy(pthread_mutex_t *mutex);
 int       pthread_mutex_lock(pthread_mutex_t *mutex);
 int       pthread_mutex_trylock(pthread_mutex_t *mutex);
+int       pthread_mutex_timedlock(pthread_mutex_t *mutex,
+                                  const struct timespec *abstime);
 int       pthread_mutex_unlock(pthread_mutex_t *mutex);
 
+int       pthread_cond_init(pthread_cond_t *cond,
+                            const pthread_condattr_t *attr);
+int       pthread_cond_destroy(pthread_cond_t *cond);
+int       pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex);
+int       pthread_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                                 const struct timespec *abstime);
+int       pthread_cond_signal(pthread_cond_t *cond);
+int       pthread_cond_broadcast(pthread_cond_t *cond);
+
+int       pthread_rwlock_init(pthread_rwlock_t *rwlock,
+                              const pthread_rwlockattr_t *attr);
+int       pthread_rwlock_destroy(pthread_rwlock_t *rwlock);
+int       pthread_rwlock_rdlock(pthread_rwlock_t *rwlock);
+int       pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock);
+int       pthread_rwlock_timedrdlock(pthread_rwlock_t *rwlock,
+                                     const struct timespec *abstime);
+int       pthread_rwlock_wrlock(pthread_rwlock_t *rwlock);
+int       pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock);
+int       pthread_rwlock_timedwrlock(pthread_rwlock_t *rwlock,
+                                     const struct timespec *abstime);
+int       pthread_rwlock_unlock(pthread_rwlock_t *rwlock);
+
 int       pthread_join(pthread_t tid, void **retvalp);
 void      pthread_exit(void *retval) __noret__;
 
@@ -10,5 +10,7 @@ void *mmap(void *addr, size_t length, int prot, int flags,
 int munmap(void *addr, size_t length);
 int mprotect(void *addr, size_t length, int prot);
 int madvise(void *addr, size_t length, int advice);
+int set_mempolicy(int mode, unsigned long nodemask);
+int mbind(void *addr, size_t length, int mode, unsigned long nodemask);
 
 END_DECLS
@@ -3,6 +3,11 @@
 #include "compiler.h"
 #include <uk/time.h>
 
+struct timespec {
+  time_t tv_sec;
+  long tv_nsec;
+};
+
 BEGIN_DECLS
 
 // See uk/time.h for time math functions shared with the kernel
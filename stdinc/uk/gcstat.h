@@ -7,3 +7,7 @@ struct gc_stat {
   u64 nop;
 };
 
+
+/* Operations, the third int written to /dev/gc */
+#define GC_OP_NONE 0
+#define GC_OP_SYNC 1            /* Run a grace period and free */
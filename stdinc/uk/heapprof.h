@@ -0,0 +1,36 @@
+#pragma once
+
+// Kernel heap profile, read from /dev/heapprof.  Reading returns a
+// heapprof_hdr followed by one heapprof_rec per sampled call stack.
+// Writing "start [rate]", "stop", or "clear" controls the profiler.
+//
+// The profiler samples one allocation about every rate bytes, and
+// scales each sample up to the allocations it stands for, so the byte
+// and count fields are estimates.  Live bytes are kept up to date
+// after "stop" until the sampled allocations are freed.
+
+// Call stack depth recorded per sample
+#define HEAPPROF_DEPTH 8
+
+#define HEAPPROF_ARENA_KALLOC  0
+#define HEAPPROF_ARENA_KMALLOC 1
+
+struct heapprof_hdr {
+  u64 rate;                     // Mean bytes between samples
+  u64 nsec;                     // Kernel time of the snapshot
+  u64 enabled;
+  u64 nrecs;                    // heapprof_recs that follow
+  u64 dropped;                  // Samples lost to full tables
+};
+
+struct heapprof_rec {
+  u32 arena;                    // HEAPPROF_ARENA_*
+  u32 pad;
+  u64 pcs[HEAPPROF_DEPTH];      // Allocation call stack, 0-padded
+  u64 live_bytes;
+  u64 live_count;
+  u64 alloc_bytes;              // Since the profiler was cleared
+  u64 alloc_count;
+  u64 free_bytes;
+  u64 free_count;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+// Spinlock contention profile, read from /dev/lockprof.  Reading
+// returns one lockprof_rec for every (lock, CPU) pair with activity.
+// Writing "start", "stop", or "clear" controls the profiler.
+
+// Histogram buckets.  Bucket i counts times in [2^i, 2^(i+1))
+// cycles; the last bucket also counts everything longer.
+#define LOCKPROF_BUCKETS 32
+// Contending call sites tracked per lock per CPU
+#define LOCKPROF_SITES   4
+
+struct lockprof_site {
+  u64 pc;                       // Return address of acquire
+  u64 contends;
+  u64 wait_cycles;
+};
+
+struct lockprof_rec {
+  u64 lock;                     // Address of the spinlock
+  char name[16];                // Lock name, if SPINLOCK_DEBUG
+  u32 cpu;
+  u32 pad;
+  u64 acquires;
+  u64 contends;
+  u64 wait_cycles;              // Total, over contended acquires
+  u64 hold_cycles;
+  u64 wait_hist[LOCKPROF_BUCKETS];
+  u64 hold_hist[LOCKPROF_BUCKETS];
+  // Call sites with the most contended acquires, approximately.
+  // Unused entries have pc 0.
+  struct lockprof_site sites[LOCKPROF_SITES];
+};
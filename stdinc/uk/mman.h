@@ -14,6 +14,13 @@
 #define MAP_FAILED ((void*)-1)
 
 #define MADV_WILLNEED 3
+#define MADV_PAGEOUT  21
 
 // xv6 extension: invalidate all page tables
 #define MADV_INVALIDATE_CACHE 1000
+
+// NUMA memory policies for set_mempolicy and mbind.  Node masks have
+// one bit per NUMA node.
+#define MPOL_DEFAULT    0       // Allocate on the faulting CPU's node
+#define MPOL_BIND       2       // Allocate only on the given nodes
+#define MPOL_INTERLEAVE 3       // Spread pages across the given nodes
@@ -0,0 +1,15 @@
+#pragma once
+
+struct pollfd {
+  int fd;
+  short events;
+  short revents;
+};
+
+typedef unsigned int nfds_t;
+
+#define POLLIN   0x001
+#define POLLOUT  0x004
+#define POLLERR  0x008
+#define POLLHUP  0x010
+#define POLLNVAL 0x020
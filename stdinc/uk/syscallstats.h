@@ -0,0 +1,20 @@
+#pragma once
+
+// Per-syscall counters and latency histograms, read from
+// /dev/syscallstats.  Reading returns one syscallstats_rec for every
+// system call that has been called, summed over all CPUs.  Writing
+// "start", "stop", or "clear" controls recording.
+
+// Histogram buckets.  Bucket i counts calls that took [2^i, 2^(i+1))
+// cycles; the last bucket also counts everything longer.
+#define SYSCALLSTATS_BUCKETS 40
+
+struct syscallstats_rec {
+  char name[24];                // Without the sys_ prefix
+  u32 num;
+  u32 pad;
+  u64 count;
+  u64 errors;                   // Calls that returned < 0
+  u64 cycles;                   // Total, from dispatch to return
+  u64 hist[SYSCALLSTATS_BUCKETS];
+};
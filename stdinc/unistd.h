@@ -26,6 +26,9 @@ int pipe2(int pipefd[2], int flags);
 unsigned sleep(unsigned);
 pid_t getpid(void);
 pid_t fork(void);
+// The child shares our address space and we are suspended until the
+// child calls execv or exit.
+pid_t vfork(void);
 
 extern char* optarg;
 extern int optind;
@@ -3,36 +3,36 @@ import subprocess
 import bisect
 import collections
 
-SAMP = struct.Struct("IIQ4QIIQ")
+SAMP = struct.Struct("BBHIQIIQ")
 
 class SamplerFile(object):
-    NTRACE = 4
-    FLAGS, COUNT, RIP, TRACE0 = range(4)
-    LATENCY, SOURCE, LOAD_ADDRESS = range(TRACE0+NTRACE, TRACE0+NTRACE+3)
+    """A sample stream read from /dev/sampler.  Each sample is a tuple
+    indexed by the constants below; TRACE is a tuple of return
+    addresses."""
+
+    FLAGS, NTRACE, CPU, COUNT, RIP, LATENCY, SOURCE, LOAD_ADDRESS, TRACE = \
+        range(9)
 
     def __init__(self, fp):
         if isinstance(fp, basestring):
             fp = file(fp, "rb")
-        self.__fp = fp
 
-        # Read CPUs
-        self.ncpu, = struct.unpack("Q", fp.read(8))
-        self.__segments = []
-        cpuinfo = struct.Struct("QQ")
-        for cpu in range(self.ncpu):
-            self.__segments.append(cpuinfo.unpack(fp.read(cpuinfo.size)))
+        self.__cpus = collections.defaultdict(list)
+        data = fp.read()
+        pos = 0
+        while pos + SAMP.size <= len(data):
+            samp = SAMP.unpack_from(data, pos)
+            pos += SAMP.size
+            ntrace = samp[self.NTRACE]
+            if pos + 8 * ntrace > len(data):
+                break
+            trace = struct.unpack_from("%dQ" % ntrace, data, pos)
+            pos += 8 * ntrace
+            self.__cpus[samp[self.CPU]].append(samp + (trace,))
+        self.ncpu = max(self.__cpus) + 1 if self.__cpus else 0
 
     def read_cpu(self, cpu):
-        if cpu < 0 or cpu >= self.ncpu:
-            return []
-        start, length = self.__segments[cpu]
-        fp = self.__fp
-        fp.seek(start)
-        count = length / SAMP.size
-        res = [None] * count
-        for i in xrange(count):
-            res[i] = SAMP.unpack(fp.read(SAMP.size))
-        return res
+        return self.__cpus.get(cpu, [])
 
 class Symbols(object):
     def __init__(self, obj):
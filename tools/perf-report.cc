@@ -189,7 +189,7 @@ struct pmuevent_ops {
     size_t h = std::hash<u64>()(x->rip);
     if (!stacktrace_mode)
       return h;
-    for (int i = 0; i < NTRACE; i++)
+    for (int i = 0; i < x->ntrace; i++)
       h ^= std::hash<u64>()(x->trace[i]);
     return h;
   }
@@ -199,7 +199,9 @@ struct pmuevent_ops {
       return false;
     if (!stacktrace_mode)
       return true;
-    for (int i = 0; i < NTRACE; i++)
+    if (x0->ntrace != x1->ntrace)
+      return false;
+    for (int i = 0; i < x0->ntrace; i++)
       if (x0->trace[i] != x1->trace[i])
         return false;
     return true;
@@ -213,7 +215,7 @@ print_entry(Addr2line &addr2line, uint64_t count, uint64_t total,
   std::vector<line_info> li;
   addr2line.lookup(e->rip, &li);
   if (stacktrace_mode) {
-    for (int i = 0; i < NTRACE; i++) {
+    for (int i = 0; i < e->ntrace; i++) {
       if (e->trace[i] == 0)
         break;
       addr2line.lookup(e->trace[i], &li);
@@ -278,7 +280,6 @@ main(int ac, char **av)
 {
   static const char *sample;
   static const char *elf;
-  struct logheader *header;
   struct stat buf;
   char *x;
   int fd;
@@ -309,33 +310,36 @@ main(int ac, char **av)
     perror("mmap");
     exit(EXIT_FAILURE);
   }
-  header = (struct logheader*)x;
 
+  // The sample file is a stream of variable-length pmuevents, as
+  // read from /dev/sampler.
   uint64_t samples = 0, idle_samples = 0,
     ints_disabled_samples = 0, kernel_samples = 0;
   std::unordered_map<struct pmuevent*, int, pmuevent_ops, pmuevent_ops> map;
-  for (u32 i = 0; i < header->ncpus; i++) {
-    struct pmuevent *p;
-    struct pmuevent *q;
-
-    p = (struct pmuevent*)(x + header->cpu[i].offset);
-    q = (struct pmuevent*)(x + header->cpu[i].offset + header->cpu[i].size);
-    for (; p < q; p++) {
-      if (p->idle)
-        idle_samples += p->count;
-      if (p->ints_disabled)
-        ints_disabled_samples += p->count;
-      if (p->kernel)
-        kernel_samples += p->count;
-      samples += p->count;
-      if (ignoreidle_mode && p->idle)
-        continue;
-      auto it = map.find(p);
-      if (it == map.end())
-        map[p] = p->count;
-      else
-        it->second = it->second + p->count;
-    }
+  char *end = x + buf.st_size;
+  struct pmuevent *p;
+  for (char *pos = x; pos + sizeof(*p) <= end; pos += pmuevent_size(p)) {
+    p = (struct pmuevent*)pos;
+    if (pos + pmuevent_size(p) > end)
+      break;
+    if (p->idle)
+      idle_samples += p->count;
+    if (p->ints_disabled)
+      ints_disabled_samples += p->count;
+    if (p->kernel)
+      kernel_samples += p->count;
+    samples += p->count;
+    if (ignoreidle_mode && p->idle)
+      continue;
+    auto it = map.find(p);
+    if (it == map.end())
+      map[p] = p->count;
+    else
+      it->second = it->second + p->count;
+  }
+  if (!samples) {
+    fprintf(stderr, "%s: no samples\n", sample);
+    exit(EXIT_FAILURE);
   }
   
   std::map<uint64_t, struct pmuevent*, gt> sorted;